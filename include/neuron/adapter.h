@@ -337,7 +337,7 @@ typedef struct neu_req_get_group {
 
 typedef struct neu_resp_group_info {
     char     name[NEU_GROUP_NAME_LEN];
-    uint16_t tag_count;
+    uint32_t tag_count;
     uint32_t interval;
 } neu_resp_group_info_t;
 
@@ -348,7 +348,7 @@ typedef struct neu_resp_get_group {
 typedef struct {
     char     driver[NEU_NODE_NAME_LEN];
     char     group[NEU_GROUP_NAME_LEN];
-    uint16_t tag_count;
+    uint32_t tag_count;
     uint32_t interval;
 } neu_resp_driver_group_info_t;
 
@@ -359,12 +359,12 @@ typedef struct {
 typedef struct {
     char           driver[NEU_NODE_NAME_LEN];
     char           group[NEU_GROUP_NAME_LEN];
-    uint16_t       n_tag;
+    uint32_t       n_tag;
     neu_datatag_t *tags;
 } neu_req_add_tag_t, neu_req_update_tag_t;
 
 typedef struct {
-    uint16_t index;
+    uint32_t index;
     int      error;
 } neu_resp_add_tag_t, neu_resp_update_tag_t;
 
@@ -376,13 +376,21 @@ typedef struct neu_req_del_tag {
 } neu_req_del_tag_t;
 
 typedef struct neu_req_get_tag {
-    char driver[NEU_NODE_NAME_LEN];
-    char group[NEU_GROUP_NAME_LEN];
-    char name[NEU_TAG_NAME_LEN];
+    char     driver[NEU_NODE_NAME_LEN];
+    char     group[NEU_GROUP_NAME_LEN];
+    char     name[NEU_TAG_NAME_LEN];   // substring of the tag name
+    char     prefix[NEU_TAG_NAME_LEN]; // prefix of the tag name
+    char     cursor[NEU_TAG_NAME_LEN]; // `next` of the previous page
+    uint32_t limit;                    // page size, 0 for all tags
+    uint32_t attribute;                // attribute bits a tag must all have
+    uint32_t fields;                   // neu_tag_field_e bits, 0 for all
 } neu_req_get_tag_t;
 
 typedef struct neu_resp_get_tag {
-    UT_array *tags; // array neu_datatag_t
+    UT_array *tags;                   // array neu_datatag_t
+    char      next[NEU_TAG_NAME_LEN]; // cursor of the next page, "" if none
+    uint32_t  total;                  // number of matching tags
+    uint32_t  fields;                 // neu_tag_field_e bits, 0 for all
 } neu_resp_get_tag_t;
 
 typedef struct {
@@ -647,14 +655,15 @@ typedef struct neu_req_write_tags {
 typedef struct {
     char                  driver[NEU_NODE_NAME_LEN];
     char                  group[NEU_GROUP_NAME_LEN];
-    uint16_t              n_tag;
+    uint32_t              n_tag;
     neu_resp_tag_value_t *tags;
 } neu_resp_read_group_t;
 
 typedef struct {
     char                 driver[NEU_NODE_NAME_LEN];
     char                 group[NEU_GROUP_NAME_LEN];
-    uint16_t             n_tag;
+    int64_t              timestamp; // latest cache update among the tags
+    uint32_t             n_tag;
     neu_resp_tag_value_t tags[];
 } neu_reqresp_trans_data_t;
 
@@ -754,6 +763,17 @@ typedef struct neu_req_update_log_level {
 
 void *neu_msg_gen(neu_reqresp_head_t *header, void *data);
 
+/**
+ * Allocate the message of a trans data with room for n_tag tags, for it to
+ * be filled in place rather than copied by neu_msg_gen.
+ *
+ * @param[out] data The trans data in the message body, zeroed but for tags.
+ */
+void *neu_trans_data_msg_alloc(uint32_t                   n_tag,
+                               neu_reqresp_trans_data_t **data);
+// drop the room left after the n_tag tags filled
+void neu_trans_data_msg_trim(void *msg);
+
 inline static void neu_msg_exchange(neu_reqresp_head_t *header)
 {
     char tmp[NEU_NODE_NAME_LEN] = { 0 };
@@ -779,13 +799,16 @@ typedef int (*neu_adapter_register_metric_cb_t)(neu_adapter_t *   adapter,
                                                 const char *      help,
                                                 neu_metric_type_e type,
                                                 uint64_t          init);
+typedef void (*neu_adapter_unregister_metric_cb_t)(neu_adapter_t *adapter,
+                                                   const char *   name);
 
 typedef struct adapter_callbacks {
     int (*command)(neu_adapter_t *adapter, neu_reqresp_head_t head, void *data);
     int (*response)(neu_adapter_t *adapter, neu_reqresp_head_t *head,
                     void *data);
-    neu_adapter_register_metric_cb_t register_metric;
-    neu_adapter_update_metric_cb_t   update_metric;
+    neu_adapter_register_metric_cb_t   register_metric;
+    neu_adapter_unregister_metric_cb_t unregister_metric;
+    neu_adapter_update_metric_cb_t     update_metric;
 
     union {
         struct {
@@ -49,6 +49,14 @@ typedef enum {
 
 typedef struct neu_mqtt_client_s neu_mqtt_client_t;
 
+typedef struct {
+    size_t   msgs;           // messages cached
+    size_t   bytes;          // payload bytes cached
+    uint64_t evicted;        // messages dropped as the cache was full
+    uint64_t replayed_msgs;  // messages replayed
+    uint64_t replayed_bytes; // payload bytes replayed
+} neu_mqtt_client_cache_stats_t;
+
 typedef void (*neu_mqtt_client_connection_cb_t)(void *data);
 typedef void (*neu_mqtt_client_publish_cb_t)(int errcode, neu_mqtt_qos_e qos,
                                              char *topic, uint8_t *payload,
@@ -66,7 +74,11 @@ void               neu_mqtt_client_free(neu_mqtt_client_t *client);
 bool   neu_mqtt_client_is_open(neu_mqtt_client_t *client);
 bool   neu_mqtt_client_is_connected(neu_mqtt_client_t *client);
 size_t neu_mqtt_client_get_cached_msgs_num(neu_mqtt_client_t *client);
+void   neu_mqtt_client_get_cache_stats(neu_mqtt_client_t *            client,
+                                       neu_mqtt_client_cache_stats_t *stats);
 
+int neu_mqtt_client_set_version(neu_mqtt_client_t *client,
+                                neu_mqtt_version_e version);
 int neu_mqtt_client_set_addr(neu_mqtt_client_t *client, const char *host,
                              uint16_t port);
 int neu_mqtt_client_set_id(neu_mqtt_client_t *client, const char *id);
@@ -83,6 +95,20 @@ int neu_mqtt_client_set_tls(neu_mqtt_client_t *client, bool enabled,
                             const char *keypass);
 int neu_mqtt_client_set_cache_size(neu_mqtt_client_t *client,
                                    size_t mem_size_bytes, size_t db_size_bytes);
+
+/** Pace the replay of messages cached while offline.
+ *
+ * Messages published while disconnected are cached, and replayed in order
+ * after reconnection at no more than `rate` payload bytes per second (0 for
+ * unlimited) with at most `inflight` messages in flight, while live messages
+ * are sent right away. If `topic` is not NULL or empty, cached messages are
+ * replayed on it instead of their original topic. With MQTT 5, replayed
+ * messages carry their original timestamp in a `timestamp` user property.
+ */
+int neu_mqtt_client_set_replay(neu_mqtt_client_t *client, size_t rate,
+                               size_t inflight, const char *topic);
+// limit the number of messages in flight, publishing fails beyond it
+int neu_mqtt_client_set_max_inflight(neu_mqtt_client_t *client, size_t n);
 int neu_mqtt_client_set_zlog_category(neu_mqtt_client_t *client,
                                       zlog_category_t *  cat);
 
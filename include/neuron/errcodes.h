@@ -59,6 +59,7 @@ typedef enum {
     NEU_ERR_NODE_NOT_ALLOW_SUBSCRIBE = 2012,
     NEU_ERR_NODE_NOT_ALLOW_UPDATE    = 2013,
     NEU_ERR_NODE_NOT_ALLOW_MAP       = 2014,
+    NEU_ERR_NODE_MEMORY_LIMIT        = 2015,
 
     NEU_ERR_GROUP_ALREADY_SUBSCRIBED = 2101,
     NEU_ERR_GROUP_NOT_SUBSCRIBE      = 2102,
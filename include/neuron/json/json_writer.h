@@ -0,0 +1,120 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#ifndef _NEU_JSON_WRITER_H_
+#define _NEU_JSON_WRITER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "adapter.h"
+
+#define NEU_JSON_WRITER_MAX_DEPTH 32
+
+/**
+ * Streaming JSON writer.
+ *
+ * Values are appended as text straight into a growable buffer, no DOM is
+ * built. The buffer is kept across neu_json_writer_reset so the same writer
+ * can encode message after message without allocation once warmed up.
+ *
+ * Errors, allocation failure or nesting deeper than NEU_JSON_WRITER_MAX_DEPTH,
+ * are sticky: every later call is a no-op and neu_json_writer_str returns
+ * NULL until neu_json_writer_reset.
+ */
+typedef struct {
+    char *   buf;
+    size_t   len;
+    size_t   cap;
+    bool     error;
+    bool     key;   // a key was just written, next value takes no separator
+    int      depth; // current nesting level
+    uint32_t first; // bit i set if nothing written yet at nesting level i
+} neu_json_writer_t;
+
+void neu_json_writer_init(neu_json_writer_t *w, size_t cap);
+void neu_json_writer_fini(neu_json_writer_t *w);
+void neu_json_writer_reset(neu_json_writer_t *w);
+
+/**
+ * @brief Get the encoded text.
+ *
+ * @return NUL terminated text owned by the writer, NULL on allocation failure.
+ */
+const char *neu_json_writer_str(neu_json_writer_t *w);
+size_t      neu_json_writer_len(const neu_json_writer_t *w);
+
+/**
+ * @brief Take over the encoded text.
+ *
+ * The writer forgets the buffer and starts over, but remembers its capacity
+ * so that the next buffer is allocated at the right size at once.
+ *
+ * @return malloc'd NUL terminated text to be freed by the caller, NULL on
+ *         allocation failure.
+ */
+char *neu_json_writer_detach(neu_json_writer_t *w);
+
+void neu_json_writer_object_begin(neu_json_writer_t *w);
+void neu_json_writer_object_end(neu_json_writer_t *w);
+void neu_json_writer_array_begin(neu_json_writer_t *w);
+void neu_json_writer_array_end(neu_json_writer_t *w);
+void neu_json_writer_key(neu_json_writer_t *w, const char *key);
+
+void neu_json_writer_null(neu_json_writer_t *w);
+void neu_json_writer_bool(neu_json_writer_t *w, bool v);
+void neu_json_writer_int(neu_json_writer_t *w, int64_t v);
+void neu_json_writer_uint(neu_json_writer_t *w, uint64_t v);
+void neu_json_writer_str_value(neu_json_writer_t *w, const char *s);
+
+/**
+ * @brief Write a real number.
+ *
+ * @param[in] precision Number of decimal places, 0 means shortest form up to
+ *                      16 significant digits. Non finite values are written
+ *                      as null.
+ */
+void neu_json_writer_double(neu_json_writer_t *w, double v, uint8_t precision);
+
+/**
+ * @brief Write the value of a tag according to its type.
+ *
+ * @return 0 on success, -1 if the type has no JSON representation, in which
+ *         case nothing is written.
+ */
+int neu_json_writer_tag_value(neu_json_writer_t *w, const neu_dvalue_t *value);
+
+// "values": { "tag0": 0 }, "errors": { "tag1": 3000 }
+void neu_json_writer_tags_values(neu_json_writer_t *         w,
+                                 const neu_resp_tag_value_t *tags, uint32_t n);
+
+// "tags": [ { "name": "tag0", "value": 0 }, { "name": "tag1", "error": 3000 } ]
+void neu_json_writer_tags_array(neu_json_writer_t *         w,
+                                const neu_resp_tag_value_t *tags, uint32_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
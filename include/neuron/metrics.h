@@ -79,6 +79,13 @@ typedef enum {
 #define NEU_METRIC_TAG_READ_ERRORS_TOTAL_TYPE NEU_METRIC_TYPE_COUNTER
 #define NEU_METRIC_TAG_READ_ERRORS_TOTAL_HELP "Total number of tag read errors"
 
+// maintained by neuron core
+// bytes held by the groups, tags, cache and queued writes of a driver
+#define NEU_METRIC_MEMORY_BYTES "memory_bytes"
+#define NEU_METRIC_MEMORY_BYTES_TYPE NEU_METRIC_TYPE_GAUAGE
+#define NEU_METRIC_MEMORY_BYTES_HELP \
+    "Bytes held by the groups, tags, value cache and queued writes"
+
 // maintained by neuron core
 // number of tags in group
 #define NEU_METRIC_GROUP_TAGS_TOTAL "group_tags_total"
@@ -166,6 +173,11 @@ typedef struct {
     size_t              south_nodes;
     size_t              south_running_nodes;
     size_t              south_disconnected_nodes;
+    uint64_t            persist_queued_ops;
+    uint64_t            persist_batches_total;
+    uint64_t            persist_errors_total;
+    uint64_t            persist_last_batch_ops;
+    uint64_t            persist_last_latency_ms;
     neu_node_metrics_t *node_metrics;
     neu_metric_entry_t *registered_metrics;
 } neu_metrics_t;
@@ -101,6 +101,30 @@ void neu_persister_destroy();
 
 sqlite3 *neu_persister_get_db();
 
+typedef struct {
+    uint64_t queued_ops;      // operations waiting for the writer
+    uint64_t batches_total;   // transactions committed
+    uint64_t ops_total;       // operations committed or failed
+    uint64_t errors_total;    // operations failed
+    uint64_t last_batch_ops;  // operations of the last transaction
+    uint64_t last_latency_ms; // enqueue to commit of the last transaction
+    uint64_t snapshot_loads;  // loads served by the startup snapshot
+} neu_persist_stats_t;
+
+/**
+ * Wait until every change persisted before is committed.
+ *
+ * Changes are queued and committed in batches by a writer thread, their
+ * functions only fail when the change could not be queued.
+ * @return 0 on success, non-zero if any change since the last flush failed.
+ */
+int neu_persister_flush();
+
+/**
+ * Get statistics of the write queue.
+ */
+void neu_persister_stats(neu_persist_stats_t *stats);
+
 /**
  * Persist nodes.
  * @param node_info                 neu_persist_node_info_t.
@@ -54,12 +54,36 @@ typedef struct neu_plugin neu_plugin_t;
 
 typedef struct neu_plugin_group neu_plugin_group_t;
 typedef void (*neu_plugin_group_free)(neu_plugin_group_t *pgp);
+
+/**
+ * Tags of a group that changed since the last call to group_timer, as
+ * arrays of neu_datatag_t pointers. Added and modified tags point into the
+ * new `tags` of the group, removed ones into the previous tags which are
+ * freed after the update.
+ */
+typedef struct {
+    UT_array *added;
+    UT_array *removed;
+    UT_array *modified;
+} neu_plugin_group_diff_t;
+
+/**
+ * Update `user_data` in place after the tags of the group changed, instead
+ * of having it freed and built again from scratch. `tags` already holds the
+ * new tags, the plugin must not keep pointers to the previous ones.
+ *
+ * @return 0 on success, otherwise group_free is called and user_data reset.
+ */
+typedef int (*neu_plugin_group_update)(neu_plugin_group_t *           pgp,
+                                       const neu_plugin_group_diff_t *diff);
+
 struct neu_plugin_group {
     char *    group_name;
     UT_array *tags;
 
-    void *                user_data;
-    neu_plugin_group_free group_free;
+    void *                  user_data;
+    neu_plugin_group_free   group_free;
+    neu_plugin_group_update group_update; // optional, set with group_free
 };
 
 typedef int (*neu_plugin_tag_validator_t)(const neu_datatag_t *tag);
@@ -83,6 +107,9 @@ typedef struct neu_plugin_intf_funs {
     union {
         struct {
             int (*validate_tag)(neu_plugin_t *plugin, neu_datatag_t *tag);
+            // optional, called once a tag is valid and its address options
+            // parsed, to cache the rest of its address with neu_tag_set_meta
+            int (*parse_tag)(neu_plugin_t *plugin, neu_datatag_t *tag);
             int (*group_timer)(neu_plugin_t *plugin, neu_plugin_group_t *group);
             int (*write_tag)(neu_plugin_t *plugin, void *req,
                              neu_datatag_t *tag, neu_value_u value);
@@ -21,6 +21,7 @@ config_ **/
 #define NEURON_TAG_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #include "type.h"
@@ -75,6 +76,22 @@ typedef union {
     } bit;
 } neu_datatag_addr_option_u;
 
+typedef enum {
+    NEU_DEADBAND_ABSOLUTE = 0,
+    NEU_DEADBAND_PERCENT  = 1, // of the last reported value
+} neu_deadband_type_e;
+
+/**
+ * Report by exception settings of a tag with NEU_ATTRIBUTE_SUBSCRIBE.
+ * All zero reports every change, as before these settings existed.
+ */
+typedef struct {
+    double              deadband; // changes within are not reported
+    neu_deadband_type_e deadband_type;
+    uint32_t            heartbeat;    // ms, resend after silence, 0 never
+    uint32_t            min_interval; // ms, between two reports of the tag
+} neu_tag_report_t;
+
 typedef struct {
     char *                    name;
     char *                    address;
@@ -84,9 +101,27 @@ typedef struct {
     double                    decimal;
     char *                    description;
     neu_datatag_addr_option_u option;
+    neu_tag_report_t          report;
     uint8_t                   meta[NEU_TAG_META_SIZE];
 } neu_datatag_t;
 
+/**
+ * Fields of a tag that a listing may be restricted to, the name is always
+ * included.
+ */
+typedef enum {
+    NEU_TAG_FIELD_NAME        = 1 << 0,
+    NEU_TAG_FIELD_TYPE        = 1 << 1,
+    NEU_TAG_FIELD_ADDRESS     = 1 << 2,
+    NEU_TAG_FIELD_ATTRIBUTE   = 1 << 3,
+    NEU_TAG_FIELD_PRECISION   = 1 << 4,
+    NEU_TAG_FIELD_DECIMAL     = 1 << 5,
+    NEU_TAG_FIELD_DESCRIPTION = 1 << 6,
+    NEU_TAG_FIELD_REPORT      = 1 << 7, // deadband, heartbeat, min_interval
+    NEU_TAG_FIELD_VALUE       = 1 << 8, // value of a static tag
+    NEU_TAG_FIELD_ALL         = 0x1ff,
+} neu_tag_field_e;
+
 UT_icd *neu_tag_get_icd();
 
 neu_datatag_t *neu_tag_dup(const neu_datatag_t *tag);
@@ -124,6 +159,21 @@ int neu_datatag_string_toe(char *str, int len, int buf_len);
 
 int neu_tag_get_static_value(const neu_datatag_t *tag, neu_value_u *value);
 int neu_tag_set_static_value(neu_datatag_t *tag, const neu_value_u *value);
+// free the value of a static tag, leaving the rest of the tag untouched
+void neu_tag_clear_static_value(neu_datatag_t *tag);
+
+/**
+ * The meta bytes of a tag that is not static cache what its driver parsed
+ * from the address, see the parse_tag callback of drivers. They are kept by
+ * groups and copies of the tag, so reads and writes need not parse the
+ * address again. At most NEU_TAG_META_SIZE - 1 bytes.
+ *
+ * @return 0 on success, -1 if the tag is static, the size too large or, when
+ *         getting, nothing was cached.
+ */
+int  neu_tag_set_meta(neu_datatag_t *tag, const void *data, size_t size);
+int  neu_tag_get_meta(const neu_datatag_t *tag, void *data, size_t size);
+void neu_tag_clear_meta(neu_datatag_t *tag);
 
 int neu_tag_get_static_value_json(neu_datatag_t *tag, neu_json_type_e *t,
                                   neu_json_value_u *v);
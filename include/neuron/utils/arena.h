@@ -0,0 +1,56 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#ifndef NEU_UTILS_ARENA_H
+#define NEU_UTILS_ARENA_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+/*
+ * Bump allocator for many small objects sharing a lifetime. Memory comes
+ * from blocks of a fixed size, requests larger than a quarter of a block get
+ * a block of their own. Objects are not freed one by one, only all together
+ * by neu_arena_reset or neu_arena_free.
+ */
+typedef struct neu_arena neu_arena_t;
+
+neu_arena_t *neu_arena_new(size_t block_size);
+void         neu_arena_free(neu_arena_t *arena);
+
+// 8 bytes aligned, NULL on allocation failure
+void *neu_arena_alloc(neu_arena_t *arena, size_t size);
+char *neu_arena_strdup(neu_arena_t *arena, const char *str);
+
+// drop every object, keeping the first block for reuse
+void neu_arena_reset(neu_arena_t *arena);
+
+// bytes handed out since the last reset
+size_t neu_arena_used(const neu_arena_t *arena);
+// bytes of the blocks held
+size_t neu_arena_size(const neu_arena_t *arena);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,59 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#ifndef _NEU_COMPRESS_H_
+#define _NEU_COMPRESS_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#define NEU_DEFLATE_LEVEL_MIN 1
+#define NEU_DEFLATE_LEVEL_MAX 9
+
+/**
+ * Reusable gzip compressor.
+ *
+ * Each call produces a complete gzip member, recognizable by the 0x1f 0x8b
+ * magic, while the zlib state is reset rather than reallocated between
+ * payloads. Not thread safe.
+ */
+typedef struct neu_deflate neu_deflate_t;
+
+neu_deflate_t *neu_deflate_new(int level);
+void           neu_deflate_free(neu_deflate_t *d);
+
+/**
+ * @brief Compress `len` bytes of `in` into a new buffer.
+ *
+ * @param[out] out     malloc'd gzip member, to be freed by the caller.
+ * @param[out] out_len size of the gzip member.
+ * @return 0 on success, -1 on failure.
+ */
+int neu_deflate(neu_deflate_t *d, const void *in, size_t len, uint8_t **out,
+                size_t *out_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
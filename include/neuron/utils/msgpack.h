@@ -0,0 +1,130 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#ifndef _NEU_MSGPACK_H_
+#define _NEU_MSGPACK_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "adapter.h"
+
+/**
+ * Minimal MessagePack writer.
+ *
+ * Like neu_json_writer_t, values are appended to a growable buffer that is
+ * kept across neu_msgpack_writer_reset. Container headers carry the element
+ * count, so callers must know it before writing a map or an array.
+ * Allocation failure is sticky until reset.
+ */
+typedef struct {
+    uint8_t *buf;
+    size_t   len;
+    size_t   cap;
+    bool     error;
+} neu_msgpack_writer_t;
+
+void     neu_msgpack_writer_init(neu_msgpack_writer_t *w, size_t cap);
+void     neu_msgpack_writer_fini(neu_msgpack_writer_t *w);
+void     neu_msgpack_writer_reset(neu_msgpack_writer_t *w);
+size_t   neu_msgpack_writer_len(const neu_msgpack_writer_t *w);
+// transfer the buffer to the caller, NULL on allocation failure
+uint8_t *neu_msgpack_writer_detach(neu_msgpack_writer_t *w);
+
+void neu_msgpack_write_map(neu_msgpack_writer_t *w, uint32_t n);
+void neu_msgpack_write_array(neu_msgpack_writer_t *w, uint32_t n);
+void neu_msgpack_write_nil(neu_msgpack_writer_t *w);
+void neu_msgpack_write_bool(neu_msgpack_writer_t *w, bool v);
+void neu_msgpack_write_int(neu_msgpack_writer_t *w, int64_t v);
+void neu_msgpack_write_uint(neu_msgpack_writer_t *w, uint64_t v);
+void neu_msgpack_write_float(neu_msgpack_writer_t *w, float v);
+void neu_msgpack_write_double(neu_msgpack_writer_t *w, double v);
+void neu_msgpack_write_str(neu_msgpack_writer_t *w, const char *s);
+
+/**
+ * @brief Write the value of a tag in its native type.
+ *
+ * Reals are written in full, `precision` only applies to text formats.
+ *
+ * @return 0 on success, -1 if the type has no MessagePack representation, in
+ *         which case nothing is written.
+ */
+int neu_msgpack_write_tag_value(neu_msgpack_writer_t *w,
+                                const neu_dvalue_t *  value);
+
+// "values": { "tag0": 0 }, "errors": { "tag1": 3000 }, as two map entries
+void neu_msgpack_write_tags_values(neu_msgpack_writer_t *      w,
+                                   const neu_resp_tag_value_t *tags, uint32_t n);
+
+typedef enum {
+    NEU_MSGPACK_NIL,
+    NEU_MSGPACK_BOOL,
+    NEU_MSGPACK_INT,
+    NEU_MSGPACK_UINT,
+    NEU_MSGPACK_DOUBLE,
+    NEU_MSGPACK_STR,
+    NEU_MSGPACK_ARRAY,
+    NEU_MSGPACK_MAP,
+} neu_msgpack_type_e;
+
+typedef struct {
+    neu_msgpack_type_e type;
+    union {
+        bool     boolean;
+        int64_t  i64;
+        uint64_t u64;
+        double   d64;
+        uint32_t n; // number of elements of an array or a map
+        struct {
+            const char *ptr; // not NUL terminated, points into the input
+            uint32_t    len;
+        } str;
+    } v;
+} neu_msgpack_value_t;
+
+typedef struct {
+    const uint8_t *p;
+    const uint8_t *end;
+} neu_msgpack_reader_t;
+
+void neu_msgpack_reader_init(neu_msgpack_reader_t *r, const void *buf,
+                             size_t len);
+
+/**
+ * @brief Read the next value.
+ *
+ * For arrays and maps only the header is consumed, the elements follow.
+ *
+ * @return 0 on success, -1 on malformed or truncated input.
+ */
+int neu_msgpack_read(neu_msgpack_reader_t *r, neu_msgpack_value_t *v);
+
+// skip the next value including all elements of a container
+int neu_msgpack_skip(neu_msgpack_reader_t *r);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -25,11 +25,26 @@ extern "C" {
 
 #include <stdbool.h>
 
+// max number of verified tokens remembered
+#define NEU_JWT_CACHE_SIZE 1024
+
 int  neu_jwt_init(const char *dir_path);
 int  neu_jwt_new(char **token);
 int  neu_jwt_validate(char *b_token);
 void neu_jwt_destroy();
 
+/**
+ * @brief Revoke a token, e.g. on logout.
+ *
+ * The token is rejected with NEU_ERR_INVALID_TOKEN until it expires.
+ */
+int neu_jwt_revoke(char *b_token);
+
+/**
+ * @brief Revoke all tokens issued before now, e.g. on password change.
+ */
+void neu_jwt_revoke_all();
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,99 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#ifndef _NEU_SEG_LOG_H_
+#define _NEU_SEG_LOG_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * Append-only, memory mapped segment log.
+ *
+ * Records are CRC framed and appended to preallocated segment files in a
+ * directory. Only the head and the tail segments are mapped, so at most
+ * two segments count against memory. The total size of the segment files
+ * never exceeds `max_bytes`; when appending would exceed it, the oldest
+ * segment is evicted together with its pending records.
+ *
+ * Consumed records are marked in place and fully consumed segments are
+ * deleted, so reopening the directory after a crash recovers exactly the
+ * records that were appended but not yet popped. A torn record at the tail
+ * is detected by its CRC and discarded.
+ *
+ * Not thread safe.
+ */
+typedef struct neu_seg_log neu_seg_log_t;
+
+neu_seg_log_t *neu_seg_log_open(const char *dir, size_t seg_size,
+                                size_t max_bytes);
+void           neu_seg_log_close(neu_seg_log_t *log);
+
+/**
+ * @brief Append a record, evicting the oldest segments to stay in budget.
+ *
+ * @return 0 on success, -1 if the record is empty, larger than the budget,
+ *         or on I/O failure.
+ */
+int neu_seg_log_append(neu_seg_log_t *log, const void *data, size_t len);
+
+/**
+ * @brief Get the oldest pending record without consuming it.
+ *
+ * The record is valid until the next append or pop.
+ *
+ * @param[out] seq sequence number to pass to neu_seg_log_pop.
+ * @return 0 if a record is returned, -1 if the log is empty.
+ */
+int neu_seg_log_peek(neu_seg_log_t *log, uint64_t *seq, const void **data,
+                     size_t *len);
+
+// consume the oldest record if it is still `seq`, i.e. was not evicted
+void neu_seg_log_pop(neu_seg_log_t *log, uint64_t seq);
+
+/**
+ * @brief Get the record after the last one returned, to have several
+ *        records in flight before popping them in order.
+ *
+ * The cursor stays within the oldest segment, so it returns -1 at the end
+ * of that segment until its records are popped. The record is valid until
+ * the next append or pop.
+ *
+ * @return 0 if a record is returned, -1 otherwise.
+ */
+int neu_seg_log_next(neu_seg_log_t *log, uint64_t *seq, const void **data,
+                     size_t *len);
+
+// move the cursor of neu_seg_log_next back to the oldest pending record
+void neu_seg_log_rewind(neu_seg_log_t *log);
+
+size_t   neu_seg_log_count(const neu_seg_log_t *log);      // pending records
+size_t   neu_seg_log_bytes(const neu_seg_log_t *log);      // pending payload
+size_t   neu_seg_log_disk_bytes(const neu_seg_log_t *log); // segment files
+uint64_t neu_seg_log_evicted(const neu_seg_log_t *log);    // records dropped
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -60,6 +60,7 @@ cp build/plugins/schema/ekuiper.json \
     build/plugins/schema/mqtt.json \
     build/plugins/schema/modbus-tcp.json \
     build/plugins/schema/file.json \
+    build/plugins/schema/probe.json \
     ${package_name}/plugins/schema/
 
 cp build/plugins/libplugin-ekuiper.so \
@@ -67,6 +68,7 @@ cp build/plugins/libplugin-ekuiper.so \
     build/plugins/libplugin-mqtt.so \
     build/plugins/libplugin-modbus-tcp.so \
     build/plugins/libplugin-file.so \
+    build/plugins/libplugin-probe.so \
     ${package_name}/plugins/
 
 tar czf ${package_name}-${arch}.tar.gz ${package_name}/
@@ -0,0 +1,33 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2023 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+BEGIN TRANSACTION;
+
+-- report by exception settings of tags, all zero reports every change.
+ALTER TABLE tags ADD COLUMN deadband REAL NOT NULL DEFAULT 0;
+ALTER TABLE tags ADD COLUMN deadband_type INTEGER NOT NULL DEFAULT 0;
+ALTER TABLE tags ADD COLUMN heartbeat INTEGER NOT NULL DEFAULT 0;
+ALTER TABLE tags ADD COLUMN min_interval INTEGER NOT NULL DEFAULT 0;
+
+ALTER TABLE template_tags ADD COLUMN deadband REAL NOT NULL DEFAULT 0;
+ALTER TABLE template_tags ADD COLUMN deadband_type INTEGER NOT NULL DEFAULT 0;
+ALTER TABLE template_tags ADD COLUMN heartbeat INTEGER NOT NULL DEFAULT 0;
+ALTER TABLE template_tags ADD COLUMN min_interval INTEGER NOT NULL DEFAULT 0;
+
+COMMIT;
@@ -0,0 +1,612 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2023 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#include <string.h>
+
+#include "frame.h"
+
+static int reserve(frame_encoder_t *enc, size_t n)
+{
+    if (enc->error) {
+        return -1;
+    }
+
+    if (enc->len + n <= enc->cap) {
+        return 0;
+    }
+
+    size_t cap = enc->cap > 0 ? enc->cap : 256;
+    while (cap < enc->len + n) {
+        cap *= 2;
+    }
+
+    uint8_t *buf = realloc(enc->buf, cap);
+    if (NULL == buf) {
+        enc->error = true;
+        return -1;
+    }
+
+    enc->buf = buf;
+    enc->cap = cap;
+    return 0;
+}
+
+static inline void put(frame_encoder_t *enc, const void *data, size_t n)
+{
+    if (0 == reserve(enc, n)) {
+        memcpy(enc->buf + enc->len, data, n);
+        enc->len += n;
+    }
+}
+
+static inline void put_u8(frame_encoder_t *enc, uint8_t v)
+{
+    put(enc, &v, 1);
+}
+
+static inline void put_u16(frame_encoder_t *enc, uint16_t v)
+{
+    uint8_t b[2] = { (uint8_t) v, (uint8_t)(v >> 8) };
+    put(enc, b, sizeof(b));
+}
+
+static inline void put_u32(frame_encoder_t *enc, uint32_t v)
+{
+    uint8_t b[4] = { (uint8_t) v, (uint8_t)(v >> 8), (uint8_t)(v >> 16),
+                     (uint8_t)(v >> 24) };
+    put(enc, b, sizeof(b));
+}
+
+static inline void put_u64(frame_encoder_t *enc, uint64_t v)
+{
+    put_u32(enc, (uint32_t) v);
+    put_u32(enc, (uint32_t)(v >> 32));
+}
+
+static inline void put_str8(frame_encoder_t *enc, const char *s, size_t size)
+{
+    size_t n = strnlen(s, size < UINT8_MAX ? size : UINT8_MAX);
+    put_u8(enc, (uint8_t) n);
+    put(enc, s, n);
+}
+
+static inline void put_header(frame_encoder_t *enc, uint8_t version,
+                              frame_type_e type)
+{
+    uint8_t b[FRAME_HEADER_LEN] = { 'N', 'F', version, (uint8_t) type };
+    put(enc, b, sizeof(b));
+}
+
+// bytes of a value in the fixed width section, 0 for strings, -1 if it has
+// no binary representation
+static int type_width(neu_type_e type)
+{
+    switch (type) {
+    case NEU_TYPE_INT8:
+    case NEU_TYPE_UINT8:
+    case NEU_TYPE_BIT:
+    case NEU_TYPE_BOOL:
+        return 1;
+    case NEU_TYPE_INT16:
+    case NEU_TYPE_UINT16:
+    case NEU_TYPE_WORD:
+        return 2;
+    case NEU_TYPE_INT32:
+    case NEU_TYPE_UINT32:
+    case NEU_TYPE_DWORD:
+    case NEU_TYPE_FLOAT:
+        return 4;
+    case NEU_TYPE_INT64:
+    case NEU_TYPE_UINT64:
+    case NEU_TYPE_LWORD:
+    case NEU_TYPE_DOUBLE:
+        return 8;
+    case NEU_TYPE_STRING:
+        return 0;
+    default:
+        return -1;
+    }
+}
+
+static void schema_free(frame_schema_t *schema)
+{
+    HASH_CLEAR(hh, schema->by_name);
+    for (uint16_t i = 0; i < schema->n_col; ++i) {
+        free(schema->cols[i]);
+    }
+    free(schema->cols);
+    free(schema);
+}
+
+static frame_col_t *schema_add_col(frame_schema_t *schema, const char *name,
+                                   neu_type_e type, bool index)
+{
+    if (schema->n_col == schema->cap) {
+        if (UINT16_MAX == schema->n_col) {
+            return NULL;
+        }
+        uint16_t      cap  = schema->cap > 0 ? schema->cap : 16;
+        frame_col_t **cols = NULL;
+
+        cap  = cap > UINT16_MAX / 2 ? UINT16_MAX : cap * 2;
+        cols = realloc(schema->cols, cap * sizeof(*cols));
+        if (NULL == cols) {
+            return NULL;
+        }
+        schema->cols = cols;
+        schema->cap  = cap;
+    }
+
+    frame_col_t *col = calloc(1, sizeof(*col));
+    if (NULL == col) {
+        return NULL;
+    }
+
+    strncpy(col->name, name, sizeof(col->name) - 1);
+    col->type                     = type;
+    col->index                    = schema->n_col;
+    schema->cols[schema->n_col++] = col;
+    if (index) {
+        HASH_ADD_STR(schema->by_name, name, col);
+    }
+
+    return col;
+}
+
+void frame_encoder_init(frame_encoder_t *enc)
+{
+    memset(enc, 0, sizeof(*enc));
+}
+
+void frame_encoder_reset(frame_encoder_t *enc)
+{
+    frame_schema_t *s = NULL, *tmp = NULL;
+
+    // ids keep growing, late notifications of old frames do not match
+    HASH_ITER(hh, enc->schemas, s, tmp)
+    {
+        HASH_DEL(enc->schemas, s);
+        schema_free(s);
+    }
+}
+
+void frame_encoder_fini(frame_encoder_t *enc)
+{
+    frame_encoder_reset(enc);
+    free(enc->buf);
+    free(enc->values);
+    memset(enc, 0, sizeof(*enc));
+}
+
+static frame_schema_t *find_schema(frame_encoder_t *enc, const char *driver,
+                                   const char *group)
+{
+    frame_schema_t *s = NULL;
+    // driver and group are adjacent in frame_schema_t and form the key
+    char key[NEU_NODE_NAME_LEN + NEU_GROUP_NAME_LEN] = { 0 };
+
+    strncpy(key, driver, NEU_NODE_NAME_LEN - 1);
+    strncpy(key + NEU_NODE_NAME_LEN, group, NEU_GROUP_NAME_LEN - 1);
+    HASH_FIND(hh, enc->schemas, key, sizeof(key), s);
+    return s;
+}
+
+static frame_schema_t *get_schema(frame_encoder_t *enc, const char *driver,
+                                  const char *group)
+{
+    frame_schema_t *s = find_schema(enc, driver, group);
+    if (NULL != s) {
+        return s;
+    }
+
+    s = calloc(1, sizeof(*s));
+    if (NULL == s) {
+        return NULL;
+    }
+
+    strncpy(s->driver, driver, sizeof(s->driver) - 1);
+    strncpy(s->group, group, sizeof(s->group) - 1);
+    HASH_ADD(hh, enc->schemas, driver, sizeof(s->driver) + sizeof(s->group),
+             s);
+    return s;
+}
+
+int frame_encode_hello(frame_encoder_t *enc, uint8_t version)
+{
+    enc->len   = 0;
+    enc->error = false;
+    put_header(enc, version, FRAME_HELLO);
+    return enc->error ? -1 : 0;
+}
+
+// map the tags of `data` to the columns of `schema`, adding the new ones
+static int map_columns(frame_encoder_t *enc, frame_schema_t *schema,
+                       const neu_reqresp_trans_data_t *data, bool *changed)
+{
+    size_t   n_max  = (size_t) schema->n_col + data->n_tag;
+    uint16_t cursor = 0;
+
+    if (n_max > enc->n_values) {
+        n_max = n_max > UINT16_MAX ? UINT16_MAX : n_max;
+        const neu_resp_tag_value_t **values =
+            realloc(enc->values, n_max * sizeof(*values));
+        if (NULL == values) {
+            return -1;
+        }
+        enc->values   = values;
+        enc->n_values = (uint16_t) n_max;
+    }
+    memset(enc->values, 0, schema->n_col * sizeof(*enc->values));
+
+    for (uint32_t i = 0; i < data->n_tag; ++i) {
+        const neu_resp_tag_value_t *tag = &data->tags[i];
+        frame_col_t *               col = NULL;
+
+        if (NEU_TYPE_ERROR != tag->value.type &&
+            type_width(tag->value.type) < 0) {
+            continue; // not representable, as in the JSON messages
+        }
+
+        // tags mostly come in the same order as the last time
+        if (cursor < schema->n_col &&
+            0 == strcmp(schema->cols[cursor]->name, tag->tag)) {
+            col = schema->cols[cursor];
+        } else {
+            HASH_FIND_STR(schema->by_name, tag->tag, col);
+        }
+
+        if (NULL == col) {
+            col = schema_add_col(schema, tag->tag, tag->value.type, true);
+            if (NULL == col) {
+                return -1;
+            }
+            enc->values[col->index] = NULL;
+            *changed                = true;
+        } else if (NEU_TYPE_ERROR != tag->value.type &&
+                   col->type != tag->value.type) {
+            col->type = tag->value.type;
+            *changed  = true;
+        }
+
+        enc->values[col->index] = tag;
+        cursor                  = col->index + 1;
+    }
+
+    return 0;
+}
+
+int frame_encode_values(frame_encoder_t *               enc,
+                        const neu_reqresp_trans_data_t *data,
+                        int64_t timestamp, uint32_t *schema_id)
+{
+    bool            changed = false;
+    frame_schema_t *schema  = get_schema(enc, data->driver, data->group);
+
+    if (NULL == schema || 0 != map_columns(enc, schema, data, &changed)) {
+        return -1;
+    }
+
+    if (changed || 0 == schema->id) {
+        if (0 == ++enc->next_id) {
+            ++enc->next_id;
+        }
+        schema->id = enc->next_id;
+    }
+
+    bool     with_schema = schema->delivered != schema->id;
+    uint16_t n_col       = schema->n_col;
+    size_t   n_bitmap    = (n_col + 7) / 8;
+
+    enc->len   = 0;
+    enc->error = false;
+    put_header(enc, FRAME_VERSION, FRAME_VALUES);
+    put_u8(enc, with_schema ? FRAME_FLAG_SCHEMA : 0);
+    put_u32(enc, schema->id);
+    put_u64(enc, (uint64_t) timestamp);
+
+    if (with_schema) {
+        put_str8(enc, schema->driver, sizeof(schema->driver));
+        put_str8(enc, schema->group, sizeof(schema->group));
+        put_u16(enc, n_col);
+        for (uint16_t i = 0; i < n_col; ++i) {
+            put_u8(enc, (uint8_t) schema->cols[i]->type);
+            put_str8(enc, schema->cols[i]->name,
+                     sizeof(schema->cols[i]->name));
+        }
+    }
+
+    put_u16(enc, n_col);
+    if (0 != reserve(enc, 2 * n_bitmap)) {
+        return -1;
+    }
+    uint8_t *present = enc->buf + enc->len;
+    uint8_t *error   = present + n_bitmap;
+    memset(present, 0, 2 * n_bitmap);
+    for (uint16_t i = 0; i < n_col; ++i) {
+        const neu_resp_tag_value_t *v = enc->values[i];
+        if (NULL != v) {
+            present[i / 8] |= 1 << (i % 8);
+            if (NEU_TYPE_ERROR == v->value.type) {
+                error[i / 8] |= 1 << (i % 8);
+            }
+        }
+    }
+    enc->len += 2 * n_bitmap;
+
+    // fixed width values
+    for (uint16_t i = 0; i < n_col; ++i) {
+        const neu_resp_tag_value_t *v = enc->values[i];
+        if (NULL == v || NEU_TYPE_ERROR == v->value.type) {
+            continue;
+        }
+        switch (type_width(v->value.type)) {
+        case 1:
+            put_u8(enc, NEU_TYPE_BOOL == v->value.type ? v->value.value.boolean
+                                                       : v->value.value.u8);
+            break;
+        case 2:
+            put_u16(enc, v->value.value.u16);
+            break;
+        case 4:
+            put_u32(enc, v->value.value.u32);
+            break;
+        case 8:
+            put_u64(enc, v->value.value.u64);
+            break;
+        default:
+            break;
+        }
+    }
+
+    // error codes
+    for (uint16_t i = 0; i < n_col; ++i) {
+        const neu_resp_tag_value_t *v = enc->values[i];
+        if (NULL != v && NEU_TYPE_ERROR == v->value.type) {
+            put_u32(enc, (uint32_t) v->value.value.i32);
+        }
+    }
+
+    // strings
+    for (uint16_t i = 0; i < n_col; ++i) {
+        const neu_resp_tag_value_t *v = enc->values[i];
+        if (NULL != v && NEU_TYPE_STRING == v->value.type) {
+            size_t n = strnlen(v->value.value.str, NEU_VALUE_SIZE);
+            put_u16(enc, (uint16_t) n);
+            put(enc, v->value.value.str, n);
+        }
+    }
+
+    *schema_id = with_schema ? schema->id : 0;
+    return enc->error ? -1 : 0;
+}
+
+void frame_encoder_delivered(frame_encoder_t *enc, const char *driver,
+                             const char *group, uint32_t schema_id)
+{
+    frame_schema_t *schema = find_schema(enc, driver, group);
+    if (NULL != schema && schema->id == schema_id) {
+        schema->delivered = schema_id;
+    }
+}
+
+typedef struct {
+    const uint8_t *p;
+    size_t         left;
+    bool           error;
+} reader_t;
+
+static inline const uint8_t *get(reader_t *r, size_t n)
+{
+    const uint8_t *p = r->p;
+    if (r->error || r->left < n) {
+        r->error = true;
+        return NULL;
+    }
+    r->p += n;
+    r->left -= n;
+    return p;
+}
+
+static inline uint8_t get_u8(reader_t *r)
+{
+    const uint8_t *p = get(r, 1);
+    return p ? p[0] : 0;
+}
+
+static inline uint16_t get_u16(reader_t *r)
+{
+    const uint8_t *p = get(r, 2);
+    return p ? (uint16_t)(p[0] | p[1] << 8) : 0;
+}
+
+static inline uint32_t get_u32(reader_t *r)
+{
+    const uint8_t *p = get(r, 4);
+    return p ? (uint32_t) p[0] | (uint32_t) p[1] << 8 |
+            (uint32_t) p[2] << 16 | (uint32_t) p[3] << 24
+             : 0;
+}
+
+static inline uint64_t get_u64(reader_t *r)
+{
+    uint64_t lo = get_u32(r);
+    uint64_t hi = get_u32(r);
+    return lo | hi << 32;
+}
+
+static inline void get_str8(reader_t *r, char *s, size_t size)
+{
+    uint8_t        n = get_u8(r);
+    const uint8_t *p = get(r, n);
+
+    if (NULL == p || n >= size) {
+        r->error = true;
+        return;
+    }
+    memcpy(s, p, n);
+    s[n] = '\0';
+}
+
+void frame_decoder_init(frame_decoder_t *dec)
+{
+    dec->schemas = NULL;
+}
+
+void frame_decoder_fini(frame_decoder_t *dec)
+{
+    frame_schema_t *s = NULL, *tmp = NULL;
+    HASH_ITER(hh, dec->schemas, s, tmp)
+    {
+        HASH_DEL(dec->schemas, s);
+        schema_free(s);
+    }
+}
+
+static int decode_schema(frame_decoder_t *dec, reader_t *r, uint32_t id)
+{
+    frame_schema_t *schema = calloc(1, sizeof(*schema));
+    if (NULL == schema) {
+        return -1;
+    }
+
+    schema->id = id;
+    get_str8(r, schema->driver, sizeof(schema->driver));
+    get_str8(r, schema->group, sizeof(schema->group));
+    uint16_t n_col = get_u16(r);
+    for (uint16_t i = 0; i < n_col && !r->error; ++i) {
+        char       name[NEU_TAG_NAME_LEN] = { 0 };
+        neu_type_e type                   = get_u8(r);
+        get_str8(r, name, sizeof(name));
+        if (NULL == schema_add_col(schema, name, type, false)) {
+            r->error = true;
+        }
+    }
+
+    if (r->error) {
+        schema_free(schema);
+        return -1;
+    }
+
+    frame_schema_t *old = NULL;
+    HASH_FIND(hh, dec->schemas, &id, sizeof(id), old);
+    if (NULL != old) {
+        HASH_DEL(dec->schemas, old);
+        schema_free(old);
+    }
+    HASH_ADD(hh, dec->schemas, id, sizeof(schema->id), schema);
+    return 0;
+}
+
+int frame_decode_values(frame_decoder_t *dec, const uint8_t *buf, size_t len,
+                        neu_reqresp_trans_data_t *data, uint16_t max_tag)
+{
+    reader_t        r      = { .p = buf, .left = len, .error = false };
+    frame_schema_t *schema = NULL;
+
+    if (!frame_is(buf, len, FRAME_VALUES) || buf[2] > FRAME_VERSION) {
+        return -1;
+    }
+    get(&r, FRAME_HEADER_LEN);
+
+    uint8_t  flags     = get_u8(&r);
+    uint32_t id        = get_u32(&r);
+    int64_t  timestamp = (int64_t) get_u64(&r);
+    if (r.error) {
+        return -1;
+    }
+
+    if ((flags & FRAME_FLAG_SCHEMA) && 0 != decode_schema(dec, &r, id)) {
+        return -1;
+    }
+
+    HASH_FIND(hh, dec->schemas, &id, sizeof(id), schema);
+    uint16_t n_col = get_u16(&r);
+    if (NULL == schema || r.error || n_col != schema->n_col) {
+        return -1;
+    }
+
+    size_t         n_bitmap = (n_col + 7) / 8;
+    const uint8_t *present  = get(&r, n_bitmap);
+    const uint8_t *error    = get(&r, n_bitmap);
+    if (r.error) {
+        return -1;
+    }
+
+    strcpy(data->driver, schema->driver);
+    strcpy(data->group, schema->group);
+    data->timestamp = timestamp;
+    data->n_tag     = 0;
+
+    // present columns, in column order
+    for (uint16_t i = 0; i < n_col; ++i) {
+        if (present[i / 8] & (1 << (i % 8))) {
+            if (data->n_tag == max_tag) {
+                return -1;
+            }
+            neu_resp_tag_value_t *tag = &data->tags[data->n_tag++];
+            memset(tag, 0, sizeof(*tag));
+            strcpy(tag->tag, schema->cols[i]->name);
+            tag->value.type = (error[i / 8] & (1 << (i % 8)))
+                ? NEU_TYPE_ERROR
+                : schema->cols[i]->type;
+        }
+    }
+
+    // one pass for each section
+    for (int section = 0; section < 3; ++section) {
+        for (uint32_t i = 0; i < data->n_tag; ++i) {
+            neu_resp_tag_value_t *tag = &data->tags[i];
+            neu_type_e            t   = tag->value.type;
+
+            if (0 == section && NEU_TYPE_ERROR != t) {
+                switch (type_width(t)) {
+                case 1:
+                    tag->value.value.u8 = get_u8(&r);
+                    break;
+                case 2:
+                    tag->value.value.u16 = get_u16(&r);
+                    break;
+                case 4:
+                    tag->value.value.u32 = get_u32(&r);
+                    break;
+                case 8:
+                    tag->value.value.u64 = get_u64(&r);
+                    break;
+                case 0:
+                    break;
+                default:
+                    r.error = true;
+                    break;
+                }
+            } else if (1 == section && NEU_TYPE_ERROR == t) {
+                tag->value.value.i32 = (int32_t) get_u32(&r);
+            } else if (2 == section && NEU_TYPE_STRING == t) {
+                uint16_t       n = get_u16(&r);
+                const uint8_t *p = get(&r, n);
+                if (NULL == p || n >= NEU_VALUE_SIZE) {
+                    return -1;
+                }
+                memcpy(tag->value.value.str, p, n);
+                tag->value.value.str[n] = '\0';
+            }
+        }
+    }
+
+    return r.error ? -1 : 0;
+}
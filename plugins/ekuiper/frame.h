@@ -0,0 +1,155 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2023 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#ifndef NEURON_PLUGIN_EKUIPER_FRAME_H
+#define NEURON_PLUGIN_EKUIPER_FRAME_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "adapter.h"
+#include "utils/uthash.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Binary frames between neuron and eKuiper, an alternative to the JSON
+ * messages on the same pair socket.
+ *
+ * All integers are little endian, str8 is a u8 length followed by the bytes.
+ *
+ *   header: 'N' 'F' version:u8 type:u8
+ *
+ *   HELLO:  header, sent by eKuiper on connect with the highest version it
+ *           supports, answered by neuron with the version it will use.
+ *           Until then, and after each reconnection, neuron sends JSON.
+ *
+ *   VALUES: header flags:u8 schema_id:u32 timestamp:i64
+ *           [schema, if flags & FRAME_FLAG_SCHEMA:
+ *               node:str8 group:str8 n_col:u16 n_col * (type:u8 name:str8)]
+ *           n_col:u16
+ *           present bitmap, (n_col + 7) / 8 bytes
+ *           error bitmap, (n_col + 7) / 8 bytes
+ *           values of the present columns without error, in column order,
+ *               1, 2, 4 or 8 bytes after the column type
+ *           error codes, i32 for each column with error, in column order
+ *           strings, u16 length and bytes for each string column
+ *
+ * A group keeps its schema, the tag names and types, across frames. The
+ * schema is only sent again inline when it changes, or until a frame
+ * carrying it has been sent, so that it survives dropped or coalesced
+ * frames in the send queue. Tags missing in a report are simply not
+ * present.
+ */
+
+#define FRAME_VERSION 1
+
+typedef enum {
+    FRAME_HELLO  = 1,
+    FRAME_VALUES = 2,
+} frame_type_e;
+
+#define FRAME_FLAG_SCHEMA 0x01
+
+#define FRAME_HEADER_LEN 4
+
+typedef struct frame_col {
+    char           name[NEU_TAG_NAME_LEN];
+    neu_type_e     type;
+    uint16_t       index;
+    UT_hash_handle hh;
+} frame_col_t;
+
+typedef struct frame_schema {
+    char           driver[NEU_NODE_NAME_LEN];
+    char           group[NEU_GROUP_NAME_LEN];
+    uint32_t       id;
+    uint32_t       delivered; // id of the last schema sent, 0 if none
+    frame_col_t ** cols;      // in column order
+    frame_col_t *  by_name;
+    uint16_t       n_col;
+    uint16_t       cap;
+    UT_hash_handle hh; // by driver and group in the encoder, by id in the
+                       // decoder
+} frame_schema_t;
+
+typedef struct {
+    uint8_t *       buf;
+    size_t          len;
+    size_t          cap;
+    bool            error; // sticky allocation failure, until the next frame
+    uint32_t        next_id;
+    frame_schema_t *schemas;
+    // scratch, the value of each column in the current frame
+    const neu_resp_tag_value_t **values;
+    uint16_t                     n_values;
+} frame_encoder_t;
+
+void frame_encoder_init(frame_encoder_t *enc);
+void frame_encoder_fini(frame_encoder_t *enc);
+// forget the schemas sent, on a new connection
+void frame_encoder_reset(frame_encoder_t *enc);
+
+static inline bool frame_is(const uint8_t *buf, size_t len, frame_type_e type)
+{
+    return len >= FRAME_HEADER_LEN && 'N' == buf[0] && 'F' == buf[1] &&
+        buf[2] > 0 && type == buf[3];
+}
+
+int frame_encode_hello(frame_encoder_t *enc, uint8_t version);
+
+/**
+ * @brief Encode a VALUES frame into enc->buf.
+ *
+ * @param[out] schema_id the id of the schema if it is carried inline, else 0.
+ * @return 0 on success, -1 on allocation failure.
+ */
+int frame_encode_values(frame_encoder_t *               enc,
+                        const neu_reqresp_trans_data_t *data,
+                        int64_t timestamp, uint32_t *schema_id);
+
+// the frame carrying `schema_id` inline of the group has been sent
+void frame_encoder_delivered(frame_encoder_t *enc, const char *driver,
+                             const char *group, uint32_t schema_id);
+
+typedef struct {
+    frame_schema_t *schemas; // by id
+} frame_decoder_t;
+
+void frame_decoder_init(frame_decoder_t *dec);
+void frame_decoder_fini(frame_decoder_t *dec);
+
+/**
+ * @brief Decode a VALUES frame, the reference of the format for peers.
+ *
+ * @param[out] data driver, group, timestamp and the present tags, room for
+ *                  the `max_tag` tags must follow.
+ * @return 0 on success, -1 on malformed frame or unknown schema.
+ */
+int frame_decode_values(frame_decoder_t *dec, const uint8_t *buf, size_t len,
+                        neu_reqresp_trans_data_t *data, uint16_t max_tag);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
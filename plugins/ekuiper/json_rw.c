@@ -17,203 +17,24 @@
  * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
  **/
 
-#include <jansson.h>
-
 #include "neuron.h"
 #include "utils/log.h"
 
 #include "json_rw.h"
-#include "plugin_ekuiper.h"
-
-int wrap_tag_data(neu_json_read_resp_tag_t *json_tag,
-                  neu_resp_tag_value_t *    tag_value)
-{
-    if (NULL == json_tag || NULL == tag_value) {
-        return -1;
-    }
-
-    json_tag->name  = tag_value->tag;
-    json_tag->error = NEU_ERR_SUCCESS;
-
-    switch (tag_value->value.type) {
-    case NEU_TYPE_INT8:
-        json_tag->t             = NEU_JSON_INT;
-        json_tag->value.val_int = tag_value->value.value.i8;
-        break;
-    case NEU_TYPE_UINT8:
-        json_tag->t             = NEU_JSON_INT;
-        json_tag->value.val_int = tag_value->value.value.u8;
-        break;
-    case NEU_TYPE_INT16:
-        json_tag->t             = NEU_JSON_INT;
-        json_tag->value.val_int = tag_value->value.value.i16;
-        break;
-    case NEU_TYPE_WORD:
-    case NEU_TYPE_UINT16:
-        json_tag->t             = NEU_JSON_INT;
-        json_tag->value.val_int = tag_value->value.value.u16;
-        break;
-    case NEU_TYPE_INT32:
-        json_tag->t             = NEU_JSON_INT;
-        json_tag->value.val_int = tag_value->value.value.i32;
-        break;
-    case NEU_TYPE_DWORD:
-    case NEU_TYPE_UINT32:
-        json_tag->t             = NEU_JSON_INT;
-        json_tag->value.val_int = tag_value->value.value.u32;
-        break;
-    case NEU_TYPE_INT64:
-        json_tag->t             = NEU_JSON_INT;
-        json_tag->value.val_int = tag_value->value.value.i64;
-        break;
-    case NEU_TYPE_LWORD:
-    case NEU_TYPE_UINT64:
-        json_tag->t             = NEU_JSON_INT;
-        json_tag->value.val_int = tag_value->value.value.u64;
-        break;
-    case NEU_TYPE_FLOAT:
-        json_tag->t               = NEU_JSON_FLOAT;
-        json_tag->value.val_float = tag_value->value.value.f32;
-        break;
-    case NEU_TYPE_DOUBLE:
-        json_tag->t                = NEU_JSON_DOUBLE;
-        json_tag->value.val_double = tag_value->value.value.d64;
-        break;
-    case NEU_TYPE_BIT:
-        json_tag->t             = NEU_JSON_BIT;
-        json_tag->value.val_bit = tag_value->value.value.u8;
-        break;
-    case NEU_TYPE_BOOL:
-        json_tag->t              = NEU_JSON_BOOL;
-        json_tag->value.val_bool = tag_value->value.value.boolean;
-        break;
-    case NEU_TYPE_STRING:
-        json_tag->t             = NEU_JSON_STR;
-        json_tag->value.val_str = tag_value->value.value.str;
-        break;
-    case NEU_TYPE_ERROR:
-        json_tag->t             = NEU_JSON_INT;
-        json_tag->value.val_int = tag_value->value.value.i32;
-        json_tag->error         = tag_value->value.value.i32;
-        break;
-    default:
-        break;
-    }
-
-    return 0;
-}
 
-int json_encode_read_resp_header(void *json_object, void *param)
+void json_encode_read_resp(neu_json_writer_t *       w,
+                           neu_reqresp_trans_data_t *trans_data)
 {
-    int                      ret    = 0;
-    json_read_resp_header_t *header = param;
-
-    neu_json_elem_t resp_elems[] = { {
-                                         .name      = "node_name",
-                                         .t         = NEU_JSON_STR,
-                                         .v.val_str = header->node_name,
-                                     },
-                                     {
-                                         .name      = "group_name",
-                                         .t         = NEU_JSON_STR,
-                                         .v.val_str = header->group_name,
-                                     },
-                                     {
-                                         .name      = "timestamp",
-                                         .t         = NEU_JSON_INT,
-                                         .v.val_int = header->timestamp,
-                                     } };
-    ret = neu_json_encode_field(json_object, resp_elems,
-                                NEU_JSON_ELEM_SIZE(resp_elems));
-
-    return ret;
-}
-
-int json_encode_read_resp_tags(void *json_object, void *param)
-{
-    int                       ret           = 0;
-    json_read_resp_t *        resp          = param;
-    neu_plugin_t *            plugin        = resp->plugin;
-    neu_reqresp_trans_data_t *trans_data    = resp->trans_data;
-    void *                    values_object = NULL;
-    void *                    errors_object = NULL;
-
-    values_object = neu_json_encode_new();
-    if (NULL == values_object) {
-        plog_error(plugin, "ekuiper cannot allocate json object");
-        return -1;
-    }
-    errors_object = neu_json_encode_new();
-    if (NULL == errors_object) {
-        plog_error(plugin, "ekuiper cannot allocate json object");
-        json_decref(values_object);
-        return -1;
-    }
-
-    for (int i = 0; i < trans_data->n_tag; i++) {
-        neu_json_read_resp_tag_t json_tag = { 0 };
-
-        if (0 != wrap_tag_data(&json_tag, &trans_data->tags[i])) {
-            continue; // ignore
-        }
-
-        neu_json_elem_t tag_elem = {
-            .name      = json_tag.name,
-            .t         = json_tag.t,
-            .v         = json_tag.value,
-            .precision = trans_data->tags[i].value.precision,
-        };
-
-        ret = neu_json_encode_field((0 != json_tag.error) ? errors_object
-                                                          : values_object,
-                                    &tag_elem, 1);
-        if (0 != ret) {
-            json_decref(errors_object);
-            json_decref(values_object);
-            return ret;
-        }
-    }
-
-    neu_json_elem_t resp_elems[] = { {
-                                         .name         = "values",
-                                         .t            = NEU_JSON_OBJECT,
-                                         .v.val_object = values_object,
-                                     },
-                                     {
-                                         .name         = "errors",
-                                         .t            = NEU_JSON_OBJECT,
-                                         .v.val_object = errors_object,
-
-                                     } };
-    // steals `values_object` and `errors_object`
-    ret = neu_json_encode_field(json_object, resp_elems,
-                                NEU_JSON_ELEM_SIZE(resp_elems));
-
-    return ret;
-}
-
-int json_encode_read_resp(void *json_object, void *param)
-{
-    int                       ret        = 0;
-    json_read_resp_t *        resp       = param;
-    neu_plugin_t *            plugin     = resp->plugin;
-    neu_reqresp_trans_data_t *trans_data = resp->trans_data;
-
-    json_read_resp_header_t header = { .group_name = trans_data->group,
-                                       .node_name  = trans_data->driver,
-                                       .timestamp  = global_timestamp };
-
-    ret = json_encode_read_resp_header(json_object, &header);
-    if (0 != ret) {
-        plog_error(plugin,
-                   "ekuiper fail encode data header node:%s group:%s, %" PRIu64,
-                   header.node_name, header.group_name, header.timestamp);
-        return ret;
-    }
-
-    ret = json_encode_read_resp_tags(json_object, param);
-
-    return ret;
+    neu_json_writer_reset(w);
+    neu_json_writer_object_begin(w);
+    neu_json_writer_key(w, "node_name");
+    neu_json_writer_str_value(w, trans_data->driver);
+    neu_json_writer_key(w, "group_name");
+    neu_json_writer_str_value(w, trans_data->group);
+    neu_json_writer_key(w, "timestamp");
+    neu_json_writer_int(w, global_timestamp);
+    neu_json_writer_tags_values(w, trans_data->tags, trans_data->n_tag);
+    neu_json_writer_object_end(w);
 }
 
 int json_decode_write_req(char *buf, size_t len, json_write_req_t **result)
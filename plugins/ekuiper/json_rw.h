@@ -23,35 +23,13 @@
 #include <sys/time.h>
 
 #include "neuron.h"
+#include "json/json_writer.h"
 #include "json/neu_json_rw.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-// NOTE: these utilities may better be reused by mqtt and restful plugin
-//       should move to neuron public sources
-
-typedef struct {
-    char *   node_name;
-    char *   group_name;
-    uint64_t timestamp;
-} json_read_resp_header_t;
-
-int wrap_tag_data(neu_json_read_resp_tag_t *json_tag,
-                  neu_resp_tag_value_t *    tag_value);
-
-typedef struct {
-    neu_plugin_t *            plugin;
-    neu_reqresp_trans_data_t *trans_data;
-} json_read_resp_t;
-
-// { "node_name": "node0", "group_name": "grp0", "timestamp": 1649776722631 }
-int json_encode_read_resp_header(void *json_object, void *param);
-
-// { "values": { "tag0": 0 }, "errors": { "tag1": 3000 } }
-int json_encode_read_resp_tags(void *json_object, void *param);
-
 // {
 //    "node_name": "node0",
 //    "group_name": "grp0",
@@ -59,7 +37,8 @@ int json_encode_read_resp_tags(void *json_object, void *param);
 //    "values": { "tag0": 0 },
 //    "errors": { "tag1": 3000 }
 // }
-int json_encode_read_resp(void *json_object, void *param);
+void json_encode_read_resp(neu_json_writer_t *       w,
+                           neu_reqresp_trans_data_t *trans_data);
 
 typedef struct {
     char *               node_name;
@@ -33,6 +33,9 @@ static neu_plugin_t *ekuiper_plugin_open(void)
     neu_plugin_t *plugin = calloc(1, sizeof(neu_plugin_t));
 
     neu_plugin_common_init(&plugin->common);
+    neu_json_writer_init(&plugin->json_writer, 0);
+    frame_encoder_init(&plugin->frame_enc);
+    plugin->queue_size = EKUIPER_QUEUE_SIZE_DEFAULT;
 
     zlog_notice(neuron, "success to create plugin: %s",
                 neu_plugin_module.module_name);
@@ -43,6 +46,8 @@ static int ekuiper_plugin_close(neu_plugin_t *plugin)
 {
     int rv = 0;
 
+    neu_json_writer_fini(&plugin->json_writer);
+    frame_encoder_fini(&plugin->frame_enc);
     free(plugin);
     zlog_notice(neuron, "success to free plugin: %s",
                 neu_plugin_module.module_name);
@@ -66,6 +71,9 @@ static void pipe_rm_cb(nng_pipe p, nng_pipe_ev ev, void *arg)
     neu_plugin_t *plugin = arg;
     nng_mtx_lock(plugin->mtx);
     plugin->common.link_state = NEU_NODE_LINK_STATE_DISCONNECTED;
+    // back to JSON until the next peer says hello
+    plugin->frame_version = 0;
+    plugin->frame_session += 1;
     nng_mtx_unlock(plugin->mtx);
 }
 
@@ -91,6 +99,32 @@ static int ekuiper_plugin_init(neu_plugin_t *plugin)
 
     plugin->recv_aio = recv_aio;
 
+    rv = nng_aio_alloc(&plugin->send_aio, send_data_callback, plugin);
+    if (rv < 0) {
+        plog_error(plugin, "cannot allocate send_aio: %s", nng_strerror(rv));
+        nng_aio_free(plugin->recv_aio);
+        plugin->recv_aio = NULL;
+        nng_mtx_free(plugin->mtx);
+        plugin->mtx = NULL;
+        return rv;
+    }
+
+    neu_adapter_register_metric_cb_t register_metric =
+        plugin->common.adapter_callbacks->register_metric;
+    register_metric(plugin->common.adapter, NEU_METRIC_EKUIPER_QUEUE_DEPTH,
+                    NEU_METRIC_EKUIPER_QUEUE_DEPTH_HELP,
+                    NEU_METRIC_EKUIPER_QUEUE_DEPTH_TYPE, 0);
+    register_metric(plugin->common.adapter,
+                    NEU_METRIC_EKUIPER_QUEUE_DROPS_TOTAL,
+                    NEU_METRIC_EKUIPER_QUEUE_DROPS_TOTAL_HELP,
+                    NEU_METRIC_EKUIPER_QUEUE_DROPS_TOTAL_TYPE, 0);
+    register_metric(plugin->common.adapter, NEU_METRIC_EKUIPER_COALESCED_TOTAL,
+                    NEU_METRIC_EKUIPER_COALESCED_TOTAL_HELP,
+                    NEU_METRIC_EKUIPER_COALESCED_TOTAL_TYPE, 0);
+    register_metric(plugin->common.adapter, NEU_METRIC_EKUIPER_SEND_LATENCY_MS,
+                    NEU_METRIC_EKUIPER_SEND_LATENCY_MS_HELP,
+                    NEU_METRIC_EKUIPER_SEND_LATENCY_MS_TYPE, 0);
+
     plog_notice(plugin, "plugin initialized");
     return rv;
 }
@@ -100,6 +134,8 @@ static int ekuiper_plugin_uninit(neu_plugin_t *plugin)
     int rv = 0;
 
     nng_aio_free(plugin->recv_aio);
+    nng_aio_free(plugin->send_aio); // waits for send_data_callback
+    send_queue_clear(plugin);
     nng_mtx_free(plugin->mtx);
     free(plugin->host);
     free(plugin->url);
@@ -131,7 +167,9 @@ static int ekuiper_plugin_start(neu_plugin_t *plugin)
     }
 
     nng_recv_aio(plugin->sock, plugin->recv_aio);
+    nng_mtx_lock(plugin->mtx);
     plugin->started = true;
+    nng_mtx_unlock(plugin->mtx);
     plog_notice(plugin, "start successfully");
 
     return NEU_ERR_SUCCESS;
@@ -139,20 +177,38 @@ static int ekuiper_plugin_start(neu_plugin_t *plugin)
 
 static int ekuiper_plugin_stop(neu_plugin_t *plugin)
 {
+    nng_mtx_lock(plugin->mtx);
+    plugin->started = false; // a pending send fails, but nothing more is sent
+    nng_mtx_unlock(plugin->mtx);
     nng_close(plugin->sock);
-    plugin->started = false;
+    send_queue_clear(plugin);
     plog_notice(plugin, "stop successfully");
     return NEU_ERR_SUCCESS;
 }
 
 static int parse_config(neu_plugin_t *plugin, const char *setting,
-                        char **host_p, uint16_t *port_p)
+                        char **host_p, uint16_t *port_p, size_t *queue_size_p,
+                        bool *coalesce_p)
 {
-    char *          err_param = NULL;
-    neu_json_elem_t host      = { .name = "host", .t = NEU_JSON_STR };
-    neu_json_elem_t port      = { .name = "port", .t = NEU_JSON_INT };
-
-    if (0 != neu_parse_param(setting, &err_param, 2, &host, &port)) {
+    char *          err_param  = NULL;
+    neu_json_elem_t host       = { .name = "host", .t = NEU_JSON_STR };
+    neu_json_elem_t port       = { .name = "port", .t = NEU_JSON_INT };
+    neu_json_elem_t queue_size = {
+        .name      = "queue-size",
+        .t         = NEU_JSON_INT,
+        .v.val_int = EKUIPER_QUEUE_SIZE_DEFAULT,
+        .attribute = NEU_JSON_ATTRIBUTE_OPTIONAL,
+    };
+    neu_json_elem_t coalesce = {
+        .name       = "coalesce",
+        .t          = NEU_JSON_BOOL,
+        .v.val_bool = false,
+        .attribute  = NEU_JSON_ATTRIBUTE_OPTIONAL,
+    };
+
+    if (0 !=
+        neu_parse_param(setting, &err_param, 4, &host, &port, &queue_size,
+                        &coalesce)) {
         plog_error(plugin, "parsing setting fail, key: `%s`", err_param);
         goto error;
     }
@@ -169,10 +225,22 @@ static int parse_config(neu_plugin_t *plugin, const char *setting,
         goto error;
     }
 
-    *host_p = host.v.val_str;
-    *port_p = port.v.val_int;
+    // queue-size, optional
+    if (queue_size.v.val_int < 1 ||
+        queue_size.v.val_int > EKUIPER_QUEUE_SIZE_MAX) {
+        plog_error(plugin, "setting invalid queue-size: %" PRIi64,
+                   queue_size.v.val_int);
+        goto error;
+    }
+
+    *host_p       = host.v.val_str;
+    *port_p       = port.v.val_int;
+    *queue_size_p = queue_size.v.val_int;
+    *coalesce_p   = coalesce.v.val_bool;
 
     plog_notice(plugin, "config host:%s port:%" PRIu16, *host_p, *port_p);
+    plog_notice(plugin, "config queue-size:%zu coalesce:%d", *queue_size_p,
+                *coalesce_p);
 
     return 0;
 
@@ -184,12 +252,16 @@ error:
 
 static int ekuiper_plugin_config(neu_plugin_t *plugin, const char *setting)
 {
-    int      rv   = 0;
-    char *   url  = NULL;
-    char *   host = NULL;
-    uint16_t port = 0;
-
-    if (0 != parse_config(plugin, setting, &host, &port)) {
+    int      rv         = 0;
+    char *   url        = NULL;
+    char *   host       = NULL;
+    uint16_t port       = 0;
+    size_t   queue_size = 0;
+    bool     coalesce   = false;
+    bool     started    = false;
+
+    if (0 !=
+        parse_config(plugin, setting, &host, &port, &queue_size, &coalesce)) {
         rv = NEU_ERR_NODE_SETTING_INVALID;
         goto error;
     }
@@ -209,7 +281,13 @@ static int ekuiper_plugin_config(neu_plugin_t *plugin, const char *setting)
     free(plugin->url);
     plugin->url = url;
 
-    if (plugin->started) {
+    nng_mtx_lock(plugin->mtx);
+    plugin->queue_size = queue_size;
+    plugin->coalesce   = coalesce;
+    started            = plugin->started;
+    nng_mtx_unlock(plugin->mtx);
+
+    if (started) {
         // restart service
         ekuiper_plugin_stop(plugin);
         ekuiper_plugin_start(plugin);
@@ -27,11 +27,39 @@
 #include <nng/supplemental/util/platform.h>
 
 #include "neuron.h"
+#include "json/json_writer.h"
+
+#include "frame.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#define NEU_METRIC_EKUIPER_QUEUE_DEPTH "ekuiper_queue_depth"
+#define NEU_METRIC_EKUIPER_QUEUE_DEPTH_TYPE NEU_METRIC_TYPE_GAUAGE
+#define NEU_METRIC_EKUIPER_QUEUE_DEPTH_HELP \
+    "Number of messages waiting to be sent to eKuiper"
+
+#define NEU_METRIC_EKUIPER_QUEUE_DROPS_TOTAL "ekuiper_queue_drops_total"
+#define NEU_METRIC_EKUIPER_QUEUE_DROPS_TOTAL_TYPE NEU_METRIC_TYPE_COUNTER
+#define NEU_METRIC_EKUIPER_QUEUE_DROPS_TOTAL_HELP \
+    "Total number of messages dropped because the send queue was full"
+
+#define NEU_METRIC_EKUIPER_COALESCED_TOTAL "ekuiper_coalesced_total"
+#define NEU_METRIC_EKUIPER_COALESCED_TOTAL_TYPE NEU_METRIC_TYPE_COUNTER
+#define NEU_METRIC_EKUIPER_COALESCED_TOTAL_HELP \
+    "Total number of queued messages replaced by a newer one of their group"
+
+#define NEU_METRIC_EKUIPER_SEND_LATENCY_MS "ekuiper_send_latency_ms"
+#define NEU_METRIC_EKUIPER_SEND_LATENCY_MS_TYPE NEU_METRIC_TYPE_GAUAGE
+#define NEU_METRIC_EKUIPER_SEND_LATENCY_MS_HELP \
+    "Time in milliseconds from queueing to sending of the last message"
+
+#define EKUIPER_QUEUE_SIZE_DEFAULT 1024
+#define EKUIPER_QUEUE_SIZE_MAX 65535
+
+typedef struct send_entry send_entry_t;
+
 struct neu_plugin {
     neu_plugin_common_t common;
     nng_socket          sock;
@@ -41,6 +69,22 @@ struct neu_plugin {
     char *              host;
     uint16_t            port;
     char *              url;
+    neu_json_writer_t   json_writer;
+
+    // send queue, guarded by mtx
+    nng_aio *     send_aio;
+    send_entry_t *send_entry;  // the message in send_aio, NULL if idle
+    send_entry_t *hello;       // the answer to the peer, sent before the queue
+    send_entry_t *send_queue;  // oldest first
+    send_entry_t *send_groups; // queued entries by group, to coalesce
+    size_t        queue_len;
+    size_t        queue_size;
+    bool          coalesce;
+
+    // binary frames, guarded by mtx
+    uint8_t         frame_version; // negotiated with the peer, 0 for JSON
+    uint32_t        frame_session; // bumped on each (re)negotiation
+    frame_encoder_t frame_enc;
 };
 
 #ifdef __cplusplus
@@ -20,55 +20,349 @@
 #include <nng/nng.h>
 
 #include "neuron.h"
+#include "utils/time.h"
+#include "utils/utlist.h"
 #include "json/neu_json_fn.h"
 #include "json/neu_json_rw.h"
 
 #include "json_rw.h"
 #include "read_write.h"
 
-void send_data(neu_plugin_t *plugin, neu_reqresp_trans_data_t *trans_data)
+typedef struct {
+    char driver[NEU_NODE_NAME_LEN];
+    char group[NEU_GROUP_NAME_LEN];
+} group_key_t;
+
+struct send_entry {
+    group_key_t    key;
+    nng_msg *      msg;
+    size_t         len;
+    int64_t        ts;        // queueing time
+    bool           binary;    // a frame, else JSON
+    uint32_t       session;   // frame_session at encoding
+    uint32_t       schema_id; // schema carried inline by the frame, or 0
+    bool           hashed;    // in send_groups
+    send_entry_t * prev;
+    send_entry_t * next;
+    UT_hash_handle hh;
+};
+
+// with mtx held
+static void queue_remove(neu_plugin_t *plugin, send_entry_t *entry)
 {
-    int rv = 0;
+    DL_DELETE(plugin->send_queue, entry);
+    if (entry->hashed) {
+        HASH_DEL(plugin->send_groups, entry);
+    }
+    plugin->queue_len -= 1;
+}
 
-    neu_adapter_update_metric_cb_t update_metric =
-        plugin->common.adapter_callbacks->update_metric;
+// send the hello answer or else the oldest queued message if send_aio is
+// idle, with mtx held
+static void send_next(neu_plugin_t *plugin)
+{
+    send_entry_t *entry = NULL;
 
-    char *           json_str = NULL;
-    json_read_resp_t resp     = {
-        .plugin     = plugin,
-        .trans_data = trans_data,
-    };
-    rv = neu_json_encode_by_fn(&resp, json_encode_read_resp, &json_str);
-    if (0 != rv) {
+    while (NULL == plugin->send_entry && plugin->started) {
+        if (NULL != plugin->hello) {
+            entry         = plugin->hello;
+            plugin->hello = NULL;
+        } else if (NULL != (entry = plugin->send_queue)) {
+            queue_remove(plugin, entry);
+        } else {
+            break;
+        }
+
+        if (entry->binary && entry->session != plugin->frame_session) {
+            // the peer it was encoded for is gone
+            nng_msg_free(entry->msg);
+            free(entry);
+            continue;
+        }
+
+        plugin->send_entry = entry;
+        nng_aio_set_msg(plugin->send_aio, entry->msg);
+        entry->msg = NULL; // owned by send_aio
+        nng_send_aio(plugin->sock, plugin->send_aio);
+    }
+}
+
+void send_queue_clear(neu_plugin_t *plugin)
+{
+    send_entry_t *entry = NULL, *tmp = NULL;
+
+    nng_mtx_lock(plugin->mtx);
+    DL_FOREACH_SAFE(plugin->send_queue, entry, tmp)
+    {
+        queue_remove(plugin, entry);
+        nng_msg_free(entry->msg);
+        free(entry);
+    }
+    if (NULL != plugin->hello) {
+        nng_msg_free(plugin->hello->msg);
+        free(plugin->hello);
+        plugin->hello = NULL;
+    }
+    nng_mtx_unlock(plugin->mtx);
+}
+
+static nng_msg *encode_json(neu_plugin_t *            plugin,
+                            neu_reqresp_trans_data_t *trans_data)
+{
+    json_encode_read_resp(&plugin->json_writer, trans_data);
+    const char *json_str = neu_json_writer_str(&plugin->json_writer);
+    if (NULL == json_str) {
         plog_error(plugin, "fail encode trans data to json");
-        return;
+        return NULL;
     }
 
     nng_msg *msg      = NULL;
-    size_t   json_len = strlen(json_str);
-    rv                = nng_msg_alloc(&msg, json_len);
-    if (0 != rv) {
+    size_t   json_len = neu_json_writer_len(&plugin->json_writer);
+    if (0 != nng_msg_alloc(&msg, json_len)) {
         plog_error(plugin, "nng cannot allocate msg");
-        free(json_str);
-        return;
+        return NULL;
     }
 
     memcpy(nng_msg_body(msg), json_str, json_len); // no null byte
     plog_debug(plugin, ">> %s", json_str);
-    free(json_str);
-    rv = nng_sendmsg(plugin->sock, msg,
-                     NNG_FLAG_NONBLOCK); // TODO: use aio to send message
+    return msg;
+}
+
+// with mtx held, the encoder state is shared with send_data_callback
+static nng_msg *encode_frame(neu_plugin_t *            plugin,
+                             neu_reqresp_trans_data_t *trans_data,
+                             uint32_t *                schema_id)
+{
+    frame_encoder_t *enc = &plugin->frame_enc;
+    if (0 !=
+        frame_encode_values(enc, trans_data, global_timestamp,
+                            schema_id)) {
+        plog_error(plugin, "fail encode trans data to frame");
+        return NULL;
+    }
+
+    nng_msg *msg = NULL;
+    if (0 != nng_msg_alloc(&msg, enc->len)) {
+        plog_error(plugin, "nng cannot allocate msg");
+        return NULL;
+    }
+
+    memcpy(nng_msg_body(msg), enc->buf, enc->len);
+    plog_debug(plugin, ">> frame %s:%s, %zu bytes, schema %" PRIu32,
+               trans_data->driver, trans_data->group, enc->len, *schema_id);
+    return msg;
+}
+
+void send_data(neu_plugin_t *plugin, neu_reqresp_trans_data_t *trans_data)
+{
+    size_t depth     = 0;
+    size_t dropped   = 0;
+    bool   coalesced = false;
+    bool   stale     = false;
+
+    neu_adapter_update_metric_cb_t update_metric =
+        plugin->common.adapter_callbacks->update_metric;
+
+    send_entry_t *entry = calloc(1, sizeof(*entry));
+    if (NULL == entry) {
+        plog_error(plugin, "cannot allocate send queue entry");
+        update_metric(plugin->common.adapter, NEU_METRIC_SEND_MSG_ERRORS_TOTAL,
+                      1, NULL);
+        return;
+    }
+    strncpy(entry->key.driver, trans_data->driver, sizeof(entry->key.driver));
+    strncpy(entry->key.group, trans_data->group, sizeof(entry->key.group));
+    entry->ts = neu_time_ms();
+
+    nng_mtx_lock(plugin->mtx);
+    entry->binary  = plugin->frame_version > 0;
+    entry->session = plugin->frame_session;
+    if (entry->binary) {
+        entry->msg = encode_frame(plugin, trans_data, &entry->schema_id);
+    }
+    nng_mtx_unlock(plugin->mtx);
+
+    if (!entry->binary) {
+        entry->msg = encode_json(plugin, trans_data);
+    }
+
+    if (NULL == entry->msg) {
+        free(entry);
+        update_metric(plugin->common.adapter, NEU_METRIC_SEND_MSG_ERRORS_TOTAL,
+                      1, NULL);
+        return;
+    }
+    entry->len = nng_msg_len(entry->msg);
+
+    nng_mtx_lock(plugin->mtx);
+    send_entry_t *find = NULL;
+    if (plugin->coalesce) {
+        HASH_FIND(hh, plugin->send_groups, &entry->key, sizeof(entry->key),
+                  find);
+    }
+    if (!entry->binary && plugin->frame_version > 0) {
+        // the peer said hello while encoding, it reads frames only
+        nng_msg_free(entry->msg);
+        free(entry);
+        stale = true;
+    } else if (NULL != find) {
+        // keep the place in the queue, but only send the latest data, which
+        // carries the schema inline as long as the replaced one did
+        nng_msg_free(find->msg);
+        find->msg       = entry->msg;
+        find->len       = entry->len;
+        find->ts        = entry->ts;
+        find->binary    = entry->binary;
+        find->session   = entry->session;
+        find->schema_id = entry->schema_id;
+        free(entry);
+        coalesced = true;
+    } else {
+        // drop the oldest, the fresher data is worth more
+        while (plugin->queue_len >= plugin->queue_size) {
+            send_entry_t *oldest = plugin->send_queue;
+            queue_remove(plugin, oldest);
+            nng_msg_free(oldest->msg);
+            free(oldest);
+            ++dropped;
+        }
+        DL_APPEND(plugin->send_queue, entry);
+        if (plugin->coalesce) {
+            HASH_ADD(hh, plugin->send_groups, key, sizeof(entry->key), entry);
+            entry->hashed = true;
+        }
+        plugin->queue_len += 1;
+    }
+    send_next(plugin);
+    depth = plugin->queue_len;
+    nng_mtx_unlock(plugin->mtx);
+
+    if (coalesced) {
+        update_metric(plugin->common.adapter,
+                      NEU_METRIC_EKUIPER_COALESCED_TOTAL, 1, NULL);
+    }
+    if (stale) {
+        plog_debug(plugin, "drop json msg, the peer switched to frames");
+        update_metric(plugin->common.adapter, NEU_METRIC_SEND_MSG_ERRORS_TOTAL,
+                      1, NULL);
+    }
+    if (dropped > 0) {
+        plog_warn(plugin, "send queue full, drop %zu oldest msg", dropped);
+        update_metric(plugin->common.adapter,
+                      NEU_METRIC_EKUIPER_QUEUE_DROPS_TOTAL, dropped, NULL);
+        update_metric(plugin->common.adapter, NEU_METRIC_SEND_MSG_ERRORS_TOTAL,
+                      dropped, NULL);
+    }
+    update_metric(plugin->common.adapter, NEU_METRIC_EKUIPER_QUEUE_DEPTH,
+                  depth, NULL);
+}
+
+void send_data_callback(void *arg)
+{
+    neu_plugin_t *plugin = arg;
+    int           rv     = nng_aio_result(plugin->send_aio);
+    send_entry_t *entry  = NULL;
+    size_t        depth  = 0;
+
+    neu_adapter_update_metric_cb_t update_metric =
+        plugin->common.adapter_callbacks->update_metric;
+
+    if (0 != rv) {
+        // the message is still ours on failure
+        nng_msg_free(nng_aio_get_msg(plugin->send_aio));
+        nng_aio_set_msg(plugin->send_aio, NULL);
+    }
+
+    nng_mtx_lock(plugin->mtx);
+    entry              = plugin->send_entry;
+    plugin->send_entry = NULL;
+    if (0 == rv && entry->schema_id > 0 &&
+        entry->session == plugin->frame_session) {
+        // later frames of the group may leave the schema out
+        frame_encoder_delivered(&plugin->frame_enc, entry->key.driver,
+                                entry->key.group, entry->schema_id);
+    }
+    send_next(plugin);
+    depth = plugin->queue_len;
+    nng_mtx_unlock(plugin->mtx);
+
     if (0 == rv) {
-        update_metric(plugin->common.adapter, NEU_METRIC_SEND_BYTES, json_len,
-                      NULL);
+        update_metric(plugin->common.adapter, NEU_METRIC_SEND_BYTES,
+                      entry->len, NULL);
         update_metric(plugin->common.adapter, NEU_METRIC_SEND_MSGS_TOTAL, 1,
                       NULL);
+        update_metric(plugin->common.adapter,
+                      NEU_METRIC_EKUIPER_SEND_LATENCY_MS,
+                      neu_time_ms() - entry->ts, NULL);
     } else {
         plog_error(plugin, "nng cannot send msg: %s", nng_strerror(rv));
-        nng_msg_free(msg);
         update_metric(plugin->common.adapter, NEU_METRIC_SEND_MSG_ERRORS_TOTAL,
                       1, NULL);
     }
+    update_metric(plugin->common.adapter, NEU_METRIC_EKUIPER_QUEUE_DEPTH,
+                  depth, NULL);
+    free(entry);
+}
+
+// answer the HELLO of the peer, binary frames are used from now on
+static void negotiate(neu_plugin_t *plugin, const uint8_t *buf)
+{
+    uint8_t       version = buf[2] < FRAME_VERSION ? buf[2] : FRAME_VERSION;
+    uint8_t       hello[FRAME_HEADER_LEN] = { 'N', 'F', version, FRAME_HELLO };
+    send_entry_t *entry                   = calloc(1, sizeof(*entry));
+    send_entry_t *e = NULL, *tmp = NULL;
+    size_t        dropped = 0;
+    size_t        depth   = 0;
+
+    neu_adapter_update_metric_cb_t update_metric =
+        plugin->common.adapter_callbacks->update_metric;
+
+    if (NULL == entry || 0 != nng_msg_alloc(&entry->msg, sizeof(hello))) {
+        plog_error(plugin, "cannot answer hello");
+        free(entry);
+        return;
+    }
+    memcpy(nng_msg_body(entry->msg), hello, sizeof(hello));
+    entry->len    = sizeof(hello);
+    entry->ts     = neu_time_ms();
+    entry->binary = true;
+
+    nng_mtx_lock(plugin->mtx);
+    plugin->frame_version = version;
+    plugin->frame_session += 1;
+    frame_encoder_reset(&plugin->frame_enc);
+    // the peer reads frames once answered, the JSON queued is not sent
+    DL_FOREACH_SAFE(plugin->send_queue, e, tmp)
+    {
+        if (!e->binary) {
+            queue_remove(plugin, e);
+            nng_msg_free(e->msg);
+            free(e);
+            ++dropped;
+        }
+    }
+    // sent after the message in send_aio, if any, and before any frame
+    entry->session = plugin->frame_session;
+    if (NULL != plugin->hello) {
+        nng_msg_free(plugin->hello->msg);
+        free(plugin->hello);
+    }
+    plugin->hello = entry;
+    send_next(plugin);
+    depth = plugin->queue_len;
+    nng_mtx_unlock(plugin->mtx);
+
+    plog_notice(plugin, "peer hello, use binary frames version %" PRIu8,
+                version);
+    if (dropped > 0) {
+        plog_warn(plugin, "drop %zu queued json msg", dropped);
+        update_metric(plugin->common.adapter,
+                      NEU_METRIC_EKUIPER_QUEUE_DROPS_TOTAL, dropped, NULL);
+        update_metric(plugin->common.adapter, NEU_METRIC_SEND_MSG_ERRORS_TOTAL,
+                      dropped, NULL);
+    }
+    update_metric(plugin->common.adapter, NEU_METRIC_EKUIPER_QUEUE_DEPTH,
+                  depth, NULL);
 }
 
 void recv_data_callback(void *arg)
@@ -96,6 +390,11 @@ void recv_data_callback(void *arg)
     update_metric(plugin->common.adapter, NEU_METRIC_RECV_BYTES, json_len,
                   NULL);
     update_metric(plugin->common.adapter, NEU_METRIC_RECV_MSGS_TOTAL, 1, NULL);
+    if (frame_is((uint8_t *) json_str, json_len, FRAME_HELLO)) {
+        negotiate(plugin, (uint8_t *) json_str);
+        goto recv_data_callback_end;
+    }
+
     if (json_decode_write_req(json_str, json_len, &req) < 0) {
         plog_error(plugin, "fail decode write request json: %.*s",
                    (int) nng_msg_len(msg), json_str);
@@ -29,7 +29,10 @@
 extern "C" {
 #endif
 
+// queue the data for sending, send_data_callback drains the queue
 void send_data(neu_plugin_t *plugin, neu_reqresp_trans_data_t *trans_data);
+void send_data_callback(void *arg);
+void send_queue_clear(neu_plugin_t *plugin);
 
 void recv_data_callback(void *arg);
 int  write_data(neu_plugin_t *plugin, json_write_req_t *write_req);
@@ -27,12 +27,20 @@ struct modbus_sort_ctx {
     uint16_t end;
 };
 
+// what is cached in the meta of a tag once its address is parsed
+typedef struct {
+    uint8_t  slave_id;
+    uint8_t  area;
+    uint16_t start_address;
+    uint16_t n_register;
+} modbus_point_meta_t;
+
 static __thread uint16_t modbus_read_max_byte = 255;
 
 static int  tag_cmp(neu_tag_sort_elem_t *tag1, neu_tag_sort_elem_t *tag2);
 static bool tag_sort(neu_tag_sort_t *sort, void *tag, void *tag_to_be_sorted);
 
-int modbus_tag_to_point(const neu_datatag_t *tag, modbus_point_t *point)
+static int parse_point(const neu_datatag_t *tag, modbus_point_t *point)
 {
     int      ret           = NEU_ERR_SUCCESS;
     uint32_t start_address = 0;
@@ -165,6 +173,43 @@ int modbus_tag_to_point(const neu_datatag_t *tag, modbus_point_t *point)
     return ret;
 }
 
+int modbus_tag_to_point(const neu_datatag_t *tag, modbus_point_t *point)
+{
+    modbus_point_meta_t meta = { 0 };
+
+    // options were parsed along with the meta, by the driver
+    if (neu_tag_get_meta(tag, &meta, sizeof(meta)) == 0) {
+        point->slave_id      = meta.slave_id;
+        point->area          = meta.area;
+        point->start_address = meta.start_address;
+        point->n_register    = meta.n_register;
+        point->type          = tag->type;
+        point->option        = tag->option;
+        strncpy(point->name, tag->name, sizeof(point->name));
+        return NEU_ERR_SUCCESS;
+    }
+
+    return parse_point(tag, point);
+}
+
+int modbus_tag_parse(neu_datatag_t *tag)
+{
+    modbus_point_t point = { 0 };
+    int            ret   = parse_point(tag, &point);
+
+    if (ret == NEU_ERR_SUCCESS) {
+        modbus_point_meta_t meta = {
+            .slave_id      = point.slave_id,
+            .area          = point.area,
+            .start_address = point.start_address,
+            .n_register    = point.n_register,
+        };
+        neu_tag_set_meta(tag, &meta, sizeof(meta));
+    }
+
+    return ret;
+}
+
 modbus_read_cmd_sort_t *modbus_tag_sort(UT_array *tags, uint16_t max_byte)
 {
     modbus_read_max_byte          = max_byte;
@@ -41,6 +41,8 @@ typedef struct modbus_point {
 } modbus_point_t;
 
 int modbus_tag_to_point(const neu_datatag_t *tag, modbus_point_t *point);
+// parse the address of a valid tag and cache the point in its meta
+int modbus_tag_parse(neu_datatag_t *tag);
 
 typedef struct modbus_read_cmd {
     uint8_t       slave_id;
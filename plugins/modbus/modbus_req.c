@@ -27,9 +27,12 @@ struct modbus_group_data {
     UT_array *              tags;
     char *                  group;
     modbus_read_cmd_sort_t *cmd_sort;
+    uint16_t                max_byte;
 };
 
 static void plugin_group_free(neu_plugin_group_t *pgp);
+static int  plugin_group_update(neu_plugin_group_t *           pgp,
+                                const neu_plugin_group_diff_t *diff);
 static int  process_protocol_buf(neu_plugin_t *plugin, uint16_t response_size);
 
 void modbus_conn_connected(void *data, int fd)
@@ -138,8 +141,9 @@ int modbus_group_timer(neu_plugin_t *plugin, neu_plugin_group_t *group,
     if (group->user_data == NULL) {
         gd = calloc(1, sizeof(struct modbus_group_data));
 
-        group->user_data  = gd;
-        group->group_free = plugin_group_free;
+        group->user_data    = gd;
+        group->group_free   = plugin_group_free;
+        group->group_update = plugin_group_update;
         utarray_new(gd->tags, &ut_ptr_icd);
 
         utarray_foreach(group->tags, neu_datatag_t *, tag)
@@ -152,6 +156,7 @@ int modbus_group_timer(neu_plugin_t *plugin, neu_plugin_group_t *group,
         }
 
         gd->group    = strdup(group->group_name);
+        gd->max_byte = max_byte;
         gd->cmd_sort = modbus_tag_sort(gd->tags, max_byte);
     }
 
@@ -409,6 +414,84 @@ static void plugin_group_free(neu_plugin_group_t *pgp)
     free(gd);
 }
 
+typedef struct {
+    const char *   name;
+    UT_hash_handle hh;
+} point_name_t;
+
+// keep the points of unchanged tags, parse the others and plan reads again
+static int plugin_group_update(neu_plugin_group_t *           pgp,
+                               const neu_plugin_group_diff_t *diff)
+{
+    struct modbus_group_data *gd      = NULL;
+    point_name_t *            stale   = NULL;
+    point_name_t *            names   = NULL;
+    UT_array *                points  = NULL;
+    size_t                    n_stale = 0;
+
+    gd      = (struct modbus_group_data *) pgp->user_data;
+    n_stale = utarray_len(diff->removed) + utarray_len(diff->modified);
+    if (0 == n_stale + utarray_len(diff->added)) {
+        return 0;
+    }
+
+    names = calloc(n_stale + 1, sizeof(point_name_t));
+    if (NULL == names) {
+        return -1;
+    }
+
+    n_stale = 0;
+    utarray_foreach(diff->removed, neu_datatag_t **, tag)
+    {
+        names[n_stale].name = (*tag)->name;
+        HASH_ADD_KEYPTR(hh, stale, (*tag)->name, strlen((*tag)->name),
+                        &names[n_stale]);
+        ++n_stale;
+    }
+    utarray_foreach(diff->modified, neu_datatag_t **, tag)
+    {
+        names[n_stale].name = (*tag)->name;
+        HASH_ADD_KEYPTR(hh, stale, (*tag)->name, strlen((*tag)->name),
+                        &names[n_stale]);
+        ++n_stale;
+    }
+
+    utarray_new(points, &ut_ptr_icd);
+    utarray_foreach(gd->tags, modbus_point_t **, point)
+    {
+        point_name_t *find = NULL;
+
+        HASH_FIND_STR(stale, (*point)->name, find);
+        if (NULL == find) {
+            utarray_push_back(points, point);
+        } else {
+            free(*point);
+        }
+    }
+    HASH_CLEAR(hh, stale);
+    free(names);
+
+    UT_array *fresh[] = { diff->added, diff->modified };
+    for (size_t i = 0; i < sizeof(fresh) / sizeof(fresh[0]); ++i) {
+        utarray_foreach(fresh[i], neu_datatag_t **, tag)
+        {
+            modbus_point_t *p   = calloc(1, sizeof(modbus_point_t));
+            int             ret = modbus_tag_to_point(*tag, p);
+            assert(ret == 0);
+
+            utarray_push_back(points, &p);
+        }
+    }
+
+    utarray_free(gd->tags);
+    gd->tags = points;
+
+    modbus_tag_sort_free(gd->cmd_sort);
+    gd->cmd_sort = modbus_tag_sort(gd->tags, gd->max_byte);
+
+    return 0;
+}
+
 static int process_protocol_buf(neu_plugin_t *plugin, uint16_t response_size)
 {
     uint8_t *                 recv_buf = calloc(response_size, 1);
@@ -39,6 +39,7 @@ static int driver_request(neu_plugin_t *plugin, neu_reqresp_head_t *head,
 
 static int driver_tag_validator(const neu_datatag_t *tag);
 static int driver_validate_tag(neu_plugin_t *plugin, neu_datatag_t *tag);
+static int driver_parse_tag(neu_plugin_t *plugin, neu_datatag_t *tag);
 static int driver_group_timer(neu_plugin_t *plugin, neu_plugin_group_t *group);
 static int driver_write(neu_plugin_t *plugin, void *req, neu_datatag_t *tag,
                         neu_value_u value);
@@ -54,6 +55,7 @@ static const neu_plugin_intf_funs_t plugin_intf_funs = {
     .request = driver_request,
 
     .driver.validate_tag  = driver_validate_tag,
+    .driver.parse_tag     = driver_parse_tag,
     .driver.group_timer   = driver_group_timer,
     .driver.write_tag     = driver_write,
     .driver.tag_validator = driver_tag_validator,
@@ -314,6 +316,12 @@ static int driver_validate_tag(neu_plugin_t *plugin, neu_datatag_t *tag)
     return ret;
 }
 
+static int driver_parse_tag(neu_plugin_t *plugin, neu_datatag_t *tag)
+{
+    (void) plugin;
+    return modbus_tag_parse(tag);
+}
+
 static int driver_group_timer(neu_plugin_t *plugin, neu_plugin_group_t *group)
 {
     return modbus_group_timer(plugin, group, 0xfa);
@@ -85,7 +85,22 @@
     "south_running_nodes_total %zu\n"                                            \
     "# HELP south_disconnected_nodes_total Number of south nodes disconnected\n" \
     "# TYPE south_disconnected_nodes_total gauge\n"                              \
-    "south_disconnected_nodes_total %zu\n"
+    "south_disconnected_nodes_total %zu\n"                                       \
+    "# HELP persist_queued_ops Number of config changes waiting to be written\n" \
+    "# TYPE persist_queued_ops gauge\n"                                          \
+    "persist_queued_ops %" PRIu64 "\n"                                           \
+    "# HELP persist_batches_total Number of config transactions committed\n"     \
+    "# TYPE persist_batches_total counter\n"                                     \
+    "persist_batches_total %" PRIu64 "\n"                                        \
+    "# HELP persist_errors_total Number of config changes failed to write\n"     \
+    "# TYPE persist_errors_total counter\n"                                      \
+    "persist_errors_total %" PRIu64 "\n"                                         \
+    "# HELP persist_last_batch_ops Number of changes in the last transaction\n"  \
+    "# TYPE persist_last_batch_ops gauge\n"                                      \
+    "persist_last_batch_ops %" PRIu64 "\n"                                       \
+    "# HELP persist_last_latency_ms Latency of the last transaction in ms\n"     \
+    "# TYPE persist_last_latency_ms gauge\n"                                     \
+    "persist_last_latency_ms %" PRIu64 "\n"
 // clang-format on
 
 static int response(nng_aio *aio, char *content, enum nng_http_status status)
@@ -153,7 +168,9 @@ static inline void gen_global_metrics(const neu_metrics_t *metrics,
             metrics->core_dumped, metrics->uptime_seconds, metrics->north_nodes,
             metrics->north_running_nodes, metrics->north_disconnected_nodes,
             metrics->south_nodes, metrics->south_running_nodes,
-            metrics->south_disconnected_nodes);
+            metrics->south_disconnected_nodes, metrics->persist_queued_ops,
+            metrics->persist_batches_total, metrics->persist_errors_total,
+            metrics->persist_last_batch_ops, metrics->persist_last_latency_ms);
 }
 
 static inline void
@@ -153,7 +153,7 @@ static char *generate_event_json(neu_plugin_t *plugin, neu_reqresp_type_e event,
             plog_error(plugin, "calloc fail");
             break;
         }
-        for (uint16_t i = 0; i < add_tag->n_tag; ++i) {
+        for (uint32_t i = 0; i < add_tag->n_tag; ++i) {
             json_req.add_tags.tags[i].type      = add_tag->tags[i].type;
             json_req.add_tags.tags[i].name      = add_tag->tags[i].name;
             json_req.add_tags.tags[i].attribute = add_tag->tags[i].attribute;
@@ -323,7 +323,7 @@ end:
     } else if (NEU_REQ_ADD_TAG_EVENT == event ||
                NEU_REQ_UPDATE_TAG_EVENT == event) {
         neu_req_add_tag_t *add_tag = data;
-        for (uint16_t i = 0; i < add_tag->n_tag; i++) {
+        for (uint32_t i = 0; i < add_tag->n_tag; i++) {
             neu_tag_fini(&add_tag->tags[i]);
         }
         free(add_tag->tags);
@@ -0,0 +1,252 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#include <string.h>
+
+#include "utils/utlist.h"
+
+#include "mqtt_batch.h"
+
+#define BATCH_MIN_CAP 1024
+// MessagePack array32 header: marker followed by 32 bit big endian count
+#define MSGPACK_ARRAY32_HDR_LEN 5
+
+static int batch_reserve(mqtt_batch_t *batch, size_t n)
+{
+    if (NULL != batch->buf && batch->len + n <= batch->cap) {
+        return 0;
+    }
+
+    size_t cap = batch->cap > BATCH_MIN_CAP ? batch->cap : BATCH_MIN_CAP;
+    while (cap < batch->len + n) {
+        cap *= 2;
+    }
+
+    uint8_t *buf = realloc(batch->buf, cap);
+    if (NULL == buf) {
+        return -1;
+    }
+
+    batch->buf = buf;
+    batch->cap = cap;
+    return 0;
+}
+
+// a batch detached under the lock, handed to the callback once unlocked
+typedef struct batch_ready {
+    struct batch_ready *next;
+    uint8_t *           payload;
+    size_t              len;
+    uint32_t            n_msg;
+    bool                full;
+    char                topic[];
+} batch_ready_t;
+
+static void batch_detach(mqtt_batcher_t *b, mqtt_batch_t *batch, bool full,
+                         batch_ready_t **ready)
+{
+    uint32_t n = batch->n_msg;
+
+    if (0 == n) {
+        return;
+    }
+
+    // the batch may be freed before the callback, the topic is copied
+    size_t         topic_len = strlen(batch->topic) + 1;
+    batch_ready_t *r         = calloc(1, sizeof(*r) + topic_len);
+    if (NULL == r) {
+        // kept pending, tried again on the next flush
+        return;
+    }
+
+    if (b->msgpack) {
+        batch->buf[0] = 0xdd;
+        batch->buf[1] = n >> 24;
+        batch->buf[2] = n >> 16;
+        batch->buf[3] = n >> 8;
+        batch->buf[4] = n;
+    } else {
+        // space reserved when the last payload was added
+        batch->buf[batch->len++] = ']';
+    }
+
+    memcpy(r->topic, batch->topic, topic_len);
+    r->payload = batch->buf;
+    r->len     = batch->len;
+    r->n_msg   = n;
+    r->full    = full;
+    LL_APPEND(*ready, r);
+
+    // keep capacity as a hint for the next buffer
+    batch->buf   = NULL;
+    batch->len   = 0;
+    batch->n_msg = 0;
+}
+
+// called without the lock, so that publishing does not block adding
+static void ready_flush(mqtt_batcher_t *b, batch_ready_t *ready)
+{
+    batch_ready_t *r = NULL, *tmp = NULL;
+
+    LL_FOREACH_SAFE(ready, r, tmp)
+    {
+        LL_DELETE(ready, r);
+        b->flush_cb(b->ctx, r->topic, r->payload, r->len, r->n_msg, r->full);
+        free(r);
+    }
+}
+
+static void batch_free(mqtt_batch_t *batch)
+{
+    free(batch->topic);
+    free(batch->buf);
+    free(batch);
+}
+
+int mqtt_batcher_init(mqtt_batcher_t *b, mqtt_batch_flush_cb cb, void *ctx)
+{
+    memset(b, 0, sizeof(*b));
+    b->flush_cb = cb;
+    b->ctx      = ctx;
+    return pthread_mutex_init(&b->mtx, NULL);
+}
+
+void mqtt_batcher_fini(mqtt_batcher_t *b)
+{
+    mqtt_batch_t *batch = NULL, *tmp = NULL;
+
+    HASH_ITER(hh, b->tbl, batch, tmp)
+    {
+        HASH_DEL(b->tbl, batch);
+        batch_free(batch);
+    }
+    pthread_mutex_destroy(&b->mtx);
+}
+
+void mqtt_batcher_setup(mqtt_batcher_t *b, bool msgpack, int64_t linger,
+                        size_t max_size)
+{
+    mqtt_batch_t * batch = NULL, *tmp = NULL;
+    batch_ready_t *ready = NULL;
+
+    pthread_mutex_lock(&b->mtx);
+    // pending batches are framed with the old format, drop the table as
+    // routes may have changed as well
+    HASH_ITER(hh, b->tbl, batch, tmp)
+    {
+        batch_detach(b, batch, false, &ready);
+        HASH_DEL(b->tbl, batch);
+        batch_free(batch);
+    }
+    b->msgpack  = msgpack;
+    b->linger   = linger;
+    b->max_size = max_size;
+    pthread_mutex_unlock(&b->mtx);
+
+    ready_flush(b, ready);
+}
+
+int mqtt_batcher_add(mqtt_batcher_t *b, const char *topic, const void *payload,
+                     size_t len, int64_t now)
+{
+    int            rv    = 0;
+    mqtt_batch_t * batch = NULL;
+    batch_ready_t *ready = NULL;
+
+    pthread_mutex_lock(&b->mtx);
+
+    HASH_FIND_STR(b->tbl, topic, batch);
+    if (NULL == batch) {
+        batch = calloc(1, sizeof(*batch));
+        if (NULL == batch || NULL == (batch->topic = strdup(topic))) {
+            free(batch);
+            rv = -1;
+            goto end;
+        }
+        HASH_ADD_KEYPTR(hh, b->tbl, batch->topic, strlen(batch->topic),
+                        batch);
+    }
+
+    // flush first if the payload would overflow the batch
+    if (batch->n_msg > 0 && batch->len + len + 1 > b->max_size) {
+        batch_detach(b, batch, true, &ready);
+    }
+
+    // room for the array header or separator, and the closing bracket
+    if (0 != batch_reserve(batch, MSGPACK_ARRAY32_HDR_LEN + len + 1)) {
+        rv = -1;
+        goto end;
+    }
+
+    if (0 == batch->n_msg) {
+        batch->first_ts = now;
+        if (b->msgpack) {
+            batch->len = MSGPACK_ARRAY32_HDR_LEN;
+        } else {
+            batch->buf[batch->len++] = '[';
+        }
+    } else if (!b->msgpack) {
+        batch->buf[batch->len++] = ',';
+    }
+
+    memcpy(batch->buf + batch->len, payload, len);
+    batch->len += len;
+    batch->n_msg += 1;
+
+    if (batch->len >= b->max_size) {
+        batch_detach(b, batch, true, &ready);
+    }
+
+end:
+    pthread_mutex_unlock(&b->mtx);
+    ready_flush(b, ready);
+    return rv;
+}
+
+void mqtt_batcher_expire(mqtt_batcher_t *b, int64_t now)
+{
+    mqtt_batch_t * batch = NULL, *tmp = NULL;
+    batch_ready_t *ready = NULL;
+
+    pthread_mutex_lock(&b->mtx);
+    HASH_ITER(hh, b->tbl, batch, tmp)
+    {
+        if (batch->n_msg > 0 && now - batch->first_ts >= b->linger) {
+            batch_detach(b, batch, false, &ready);
+        }
+    }
+    pthread_mutex_unlock(&b->mtx);
+
+    ready_flush(b, ready);
+}
+
+void mqtt_batcher_flush(mqtt_batcher_t *b)
+{
+    mqtt_batch_t * batch = NULL, *tmp = NULL;
+    batch_ready_t *ready = NULL;
+
+    pthread_mutex_lock(&b->mtx);
+    HASH_ITER(hh, b->tbl, batch, tmp)
+    {
+        batch_detach(b, batch, false, &ready);
+    }
+    pthread_mutex_unlock(&b->mtx);
+
+    ready_flush(b, ready);
+}
@@ -0,0 +1,101 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#ifndef NEURON_PLUGIN_MQTT_BATCH_H
+#define NEURON_PLUGIN_MQTT_BATCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "utils/uthash.h"
+
+/**
+ * Per topic batch of upload payloads.
+ *
+ * JSON payloads are framed as a JSON array of the individual documents,
+ * MessagePack payloads as a MessagePack array, so that a batch is itself a
+ * valid document of the configured format.
+ */
+typedef struct {
+    char *   topic;
+    uint8_t *buf;
+    size_t   len;
+    size_t   cap;
+    uint32_t n_msg;
+    int64_t  first_ts; // time the first payload was added, in milliseconds
+
+    UT_hash_handle hh;
+} mqtt_batch_t;
+
+/**
+ * @brief Called with a complete batch payload.
+ *
+ * The payload ownership is transferred to the callee. Called with the
+ * batcher unlocked, so the callee may take its time or add to the batcher.
+ *
+ * @param full true if the batch reached the size limit, false if it expired.
+ */
+typedef void (*mqtt_batch_flush_cb)(void *ctx, const char *topic,
+                                    uint8_t *payload, size_t len,
+                                    uint32_t n_msg, bool full);
+
+typedef struct {
+    pthread_mutex_t     mtx;
+    mqtt_batch_t *      tbl;
+    bool                msgpack;  // payload framing
+    int64_t             linger;   // max milliseconds a payload is held
+    size_t              max_size; // max batch payload size in bytes
+    mqtt_batch_flush_cb flush_cb;
+    void *              ctx;
+} mqtt_batcher_t;
+
+int  mqtt_batcher_init(mqtt_batcher_t *b, mqtt_batch_flush_cb cb, void *ctx);
+void mqtt_batcher_fini(mqtt_batcher_t *b);
+
+// flush all pending batches, then apply the new limits
+void mqtt_batcher_setup(mqtt_batcher_t *b, bool msgpack, int64_t linger,
+                        size_t max_size);
+
+/**
+ * @brief Append a payload to the batch of the topic.
+ *
+ * The payload is copied. The batch is flushed once it reaches the size limit.
+ *
+ * @return 0 on success, -1 on allocation failure.
+ */
+int mqtt_batcher_add(mqtt_batcher_t *b, const char *topic, const void *payload,
+                     size_t len, int64_t now);
+
+// flush batches older than the linger time
+void mqtt_batcher_expire(mqtt_batcher_t *b, int64_t now);
+
+// flush all pending batches
+void mqtt_batcher_flush(mqtt_batcher_t *b);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
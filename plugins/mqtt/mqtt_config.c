@@ -18,12 +18,14 @@
  **/
 
 #include "utils/asprintf.h"
+#include "utils/compress.h"
 #include "json/json.h"
 #include "json/neu_json_param.h"
 
 #include "mqtt_config.h"
 #include "mqtt_plugin.h"
 
+#define KB 1000
 #define MB 1000000
 
 static inline int decode_b64_param(neu_plugin_t *plugin, neu_json_elem_t *el)
@@ -194,6 +196,104 @@ static int parse_cache_params(neu_plugin_t *plugin, const char *setting,
     return 0;
 }
 
+static int parse_batch_params(neu_plugin_t *plugin, const char *setting,
+                              neu_json_elem_t *batch_linger,
+                              neu_json_elem_t *batch_max_size)
+{
+    char *err_param = NULL;
+
+    // both optional, batching disabled by default
+    int ret = neu_parse_param(setting, &err_param, 2, batch_linger,
+                              batch_max_size);
+    if (0 != ret) {
+        plog_error(plugin, "parsing setting fail, key: `%s`", err_param);
+        free(err_param);
+        return -1;
+    }
+
+    if (batch_linger->v.val_int < 0 || batch_linger->v.val_int > 10000) {
+        plog_error(plugin, "setting invalid batch linger: %" PRIi64,
+                   batch_linger->v.val_int);
+        return -1;
+    }
+
+    if (batch_max_size->v.val_int < 1 || batch_max_size->v.val_int > 1024) {
+        plog_error(plugin, "setting invalid batch max size: %" PRIi64,
+                   batch_max_size->v.val_int);
+        return -1;
+    }
+
+    return 0;
+}
+
+static int parse_replay_params(neu_plugin_t *plugin, const char *setting,
+                               neu_json_elem_t *replay_rate,
+                               neu_json_elem_t *replay_inflight,
+                               neu_json_elem_t *replay_topic)
+{
+    char *err_param = NULL;
+
+    // all optional, replay as fast as possible by default
+    int ret = neu_parse_param(setting, &err_param, 3, replay_rate,
+                              replay_inflight, replay_topic);
+    if (0 != ret) {
+        plog_error(plugin, "parsing setting fail, key: `%s`", err_param);
+        free(err_param);
+        return -1;
+    }
+
+    if (replay_rate->v.val_int < 0 || replay_rate->v.val_int > 1048576) {
+        plog_error(plugin, "setting invalid replay rate: %" PRIi64,
+                   replay_rate->v.val_int);
+        return -1;
+    }
+
+    if (replay_inflight->v.val_int < 1 || replay_inflight->v.val_int > 64) {
+        plog_error(plugin, "setting invalid replay inflight: %" PRIi64,
+                   replay_inflight->v.val_int);
+        return -1;
+    }
+
+    if (NULL != replay_topic->v.val_str &&
+        0 == strlen(replay_topic->v.val_str)) {
+        free(replay_topic->v.val_str);
+        replay_topic->v.val_str = NULL;
+    }
+
+    return 0;
+}
+
+static int parse_conn_params(neu_plugin_t *plugin, const char *setting,
+                             neu_json_elem_t *connections,
+                             neu_json_elem_t *max_inflight)
+{
+    char *err_param = NULL;
+
+    // both optional, a single connection by default
+    int ret = neu_parse_param(setting, &err_param, 2, connections,
+                              max_inflight);
+    if (0 != ret) {
+        plog_error(plugin, "parsing setting fail, key: `%s`", err_param);
+        free(err_param);
+        return -1;
+    }
+
+    if (connections->v.val_int < 1 ||
+        connections->v.val_int > MQTT_CONNECTIONS_MAX) {
+        plog_error(plugin, "setting invalid connections: %" PRIi64,
+                   connections->v.val_int);
+        return -1;
+    }
+
+    if (max_inflight->v.val_int < 1 || max_inflight->v.val_int > 65535) {
+        plog_error(plugin, "setting invalid max inflight: %" PRIi64,
+                   max_inflight->v.val_int);
+        return -1;
+    }
+
+    return 0;
+}
+
 int mqtt_config_parse(neu_plugin_t *plugin, const char *setting,
                       mqtt_config_t *config)
 {
@@ -208,6 +308,12 @@ int mqtt_config_parse(neu_plugin_t *plugin, const char *setting,
         .v.val_int = NEU_MQTT_QOS0,               // default to QoS0
         .attribute = NEU_JSON_ATTRIBUTE_OPTIONAL, // for backward compatibility
     };
+    neu_json_elem_t version         = {
+        .name      = "version",
+        .t         = NEU_JSON_INT,
+        .v.val_int = NEU_MQTT_VERSION_V311,
+        .attribute = NEU_JSON_ATTRIBUTE_OPTIONAL,
+    };
     neu_json_elem_t format          = { .name = "format", .t = NEU_JSON_INT };
     neu_json_elem_t write_req_topic = {
         .name      = "write-req-topic",
@@ -236,14 +342,63 @@ int mqtt_config_parse(neu_plugin_t *plugin, const char *setting,
     neu_json_elem_t cert            = { .name = "cert", .t = NEU_JSON_STR };
     neu_json_elem_t key             = { .name = "key", .t = NEU_JSON_STR };
     neu_json_elem_t keypass         = { .name = "keypass", .t = NEU_JSON_STR };
+    neu_json_elem_t batch_linger    = {
+        .name      = "batch-linger",
+        .t         = NEU_JSON_INT,
+        .v.val_int = 0,
+        .attribute = NEU_JSON_ATTRIBUTE_OPTIONAL,
+    };
+    neu_json_elem_t batch_max_size  = {
+        .name      = "batch-max-size",
+        .t         = NEU_JSON_INT,
+        .v.val_int = 64,
+        .attribute = NEU_JSON_ATTRIBUTE_OPTIONAL,
+    };
+    neu_json_elem_t compress_level  = {
+        .name      = "compression-level",
+        .t         = NEU_JSON_INT,
+        .v.val_int = 0, // no compression
+        .attribute = NEU_JSON_ATTRIBUTE_OPTIONAL,
+    };
+    neu_json_elem_t replay_rate     = {
+        .name      = "replay-rate",
+        .t         = NEU_JSON_INT,
+        .v.val_int = 0, // unlimited
+        .attribute = NEU_JSON_ATTRIBUTE_OPTIONAL,
+    };
+    neu_json_elem_t replay_inflight = {
+        .name      = "replay-inflight",
+        .t         = NEU_JSON_INT,
+        .v.val_int = 1,
+        .attribute = NEU_JSON_ATTRIBUTE_OPTIONAL,
+    };
+    neu_json_elem_t replay_topic    = {
+        .name      = "replay-topic",
+        .t         = NEU_JSON_STR,
+        .v.val_str = NULL,
+        .attribute = NEU_JSON_ATTRIBUTE_OPTIONAL,
+    };
+    neu_json_elem_t connections     = {
+        .name      = "connections",
+        .t         = NEU_JSON_INT,
+        .v.val_int = 1,
+        .attribute = NEU_JSON_ATTRIBUTE_OPTIONAL,
+    };
+    neu_json_elem_t max_inflight    = {
+        .name      = "max-inflight",
+        .t         = NEU_JSON_INT,
+        .v.val_int = 1024,
+        .attribute = NEU_JSON_ATTRIBUTE_OPTIONAL,
+    };
 
     if (NULL == setting || NULL == config) {
         plog_error(plugin, "invalid argument, null pointer");
         return -1;
     }
 
-    ret = neu_parse_param(setting, &err_param, 7, &client_id, &qos, &format,
-                          &write_req_topic, &write_resp_topic, &host, &port);
+    ret = neu_parse_param(setting, &err_param, 8, &client_id, &qos, &version,
+                          &format, &write_req_topic, &write_resp_topic, &host,
+                          &port);
     if (0 != ret) {
         plog_error(plugin, "parsing setting fail, key: `%s`", err_param);
         goto error;
@@ -261,9 +416,18 @@ int mqtt_config_parse(neu_plugin_t *plugin, const char *setting,
         goto error;
     }
 
+    // version, optional, default to 3.1.1
+    if (NEU_MQTT_VERSION_V311 != version.v.val_int &&
+        NEU_MQTT_VERSION_V5 != version.v.val_int) {
+        plog_error(plugin, "setting invalid version: %" PRIi64,
+                   version.v.val_int);
+        goto error;
+    }
+
     // format, required
     if (MQTT_UPLOAD_FORMAT_VALUES != format.v.val_int &&
-        MQTT_UPLOAD_FORMAT_TAGS != format.v.val_int) {
+        MQTT_UPLOAD_FORMAT_TAGS != format.v.val_int &&
+        MQTT_UPLOAD_FORMAT_MSGPACK != format.v.val_int) {
         plog_error(plugin, "setting invalid format: %" PRIi64,
                    format.v.val_int);
         goto error;
@@ -321,7 +485,33 @@ int mqtt_config_parse(neu_plugin_t *plugin, const char *setting,
         goto error;
     }
 
+    ret = parse_batch_params(plugin, setting, &batch_linger, &batch_max_size);
+    if (0 != ret) {
+        goto error;
+    }
+
+    // compression-level, optional
+    ret = neu_parse_param(setting, NULL, 1, &compress_level);
+    if (0 != ret || compress_level.v.val_int < 0 ||
+        compress_level.v.val_int > NEU_DEFLATE_LEVEL_MAX) {
+        plog_error(plugin, "setting invalid compression level: %" PRIi64,
+                   compress_level.v.val_int);
+        goto error;
+    }
+
+    ret = parse_replay_params(plugin, setting, &replay_rate, &replay_inflight,
+                              &replay_topic);
+    if (0 != ret) {
+        goto error;
+    }
+
+    ret = parse_conn_params(plugin, setting, &connections, &max_inflight);
+    if (0 != ret) {
+        goto error;
+    }
+
     config->client_id        = client_id.v.val_str;
+    config->version          = version.v.val_int;
     config->qos              = qos.v.val_int;
     config->format           = format.v.val_int;
     config->write_req_topic  = write_req_topic.v.val_str;
@@ -338,8 +528,17 @@ int mqtt_config_parse(neu_plugin_t *plugin, const char *setting,
     config->cert             = cert.v.val_str;
     config->key              = key.v.val_str;
     config->keypass          = keypass.v.val_str;
+    config->batch_linger     = batch_linger.v.val_int;
+    config->batch_max_size   = batch_max_size.v.val_int * KB;
+    config->compress_level   = compress_level.v.val_int;
+    config->replay_rate      = replay_rate.v.val_int * KB;
+    config->replay_inflight  = replay_inflight.v.val_int;
+    config->replay_topic     = replay_topic.v.val_str;
+    config->connections      = connections.v.val_int;
+    config->max_inflight     = max_inflight.v.val_int;
 
     plog_notice(plugin, "config client-id       : %s", config->client_id);
+    plog_notice(plugin, "config version         : %d", config->version);
     plog_notice(plugin, "config qos             : %d", config->qos);
     plog_notice(plugin, "config format          : %s",
                 mqtt_upload_format_str(config->format));
@@ -374,6 +573,19 @@ int mqtt_config_parse(neu_plugin_t *plugin, const char *setting,
     if (config->keypass) {
         plog_notice(plugin, "config keypass         : %s", placeholder);
     }
+    plog_notice(plugin, "config batch-linger    : %" PRIi64,
+                config->batch_linger);
+    plog_notice(plugin, "config batch-max-size  : %zu", config->batch_max_size);
+    plog_notice(plugin, "config compression-level: %d", config->compress_level);
+    plog_notice(plugin, "config replay-rate     : %zu", config->replay_rate);
+    plog_notice(plugin, "config replay-inflight : %zu",
+                config->replay_inflight);
+    if (config->replay_topic) {
+        plog_notice(plugin, "config replay-topic    : %s",
+                    config->replay_topic);
+    }
+    plog_notice(plugin, "config connections     : %zu", config->connections);
+    plog_notice(plugin, "config max-inflight    : %zu", config->max_inflight);
 
     return 0;
 
@@ -388,6 +600,7 @@ error:
     free(cert.v.val_str);
     free(key.v.val_str);
     free(keypass.v.val_str);
+    free(replay_topic.v.val_str);
     return -1;
 }
 
@@ -403,6 +616,7 @@ void mqtt_config_fini(mqtt_config_t *config)
     free(config->cert);
     free(config->key);
     free(config->keypass);
+    free(config->replay_topic);
 
     memset(config, 0, sizeof(*config));
 }
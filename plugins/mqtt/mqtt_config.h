@@ -30,9 +30,12 @@ extern "C" {
 #include "connection/mqtt_client.h"
 #include "plugin.h"
 
+#define MQTT_CONNECTIONS_MAX 8
+
 typedef enum {
-    MQTT_UPLOAD_FORMAT_VALUES = 0,
-    MQTT_UPLOAD_FORMAT_TAGS   = 1,
+    MQTT_UPLOAD_FORMAT_VALUES  = 0,
+    MQTT_UPLOAD_FORMAT_TAGS    = 1,
+    MQTT_UPLOAD_FORMAT_MSGPACK = 2,
 } mqtt_upload_format_e;
 
 static inline const char *mqtt_upload_format_str(mqtt_upload_format_e f)
@@ -42,6 +45,8 @@ static inline const char *mqtt_upload_format_str(mqtt_upload_format_e f)
         return "format-values";
     case MQTT_UPLOAD_FORMAT_TAGS:
         return "format-tags";
+    case MQTT_UPLOAD_FORMAT_MSGPACK:
+        return "format-msgpack";
     default:
         return NULL;
     }
@@ -49,6 +54,7 @@ static inline const char *mqtt_upload_format_str(mqtt_upload_format_e f)
 
 typedef struct {
     char *               client_id;        // client id
+    neu_mqtt_version_e   version;          // protocol version
     neu_mqtt_qos_e       qos;              // message QoS
     mqtt_upload_format_e format;           // upload format
     char *               write_req_topic;  // write request topic
@@ -65,6 +71,14 @@ typedef struct {
     char *               cert;             // client cert
     char *               key;              // client key
     char *               keypass;          // client key password
+    int64_t              batch_linger;     // batch linger time in ms, 0 off
+    size_t               batch_max_size;   // max batch size in bytes
+    int                  compress_level;   // gzip level, 0 off
+    size_t               replay_rate;      // cache replay bytes/s, 0 no limit
+    size_t               replay_inflight;  // cache replay in-flight messages
+    char *               replay_topic;     // cache replay topic, may be NULL
+    size_t               connections;      // number of broker connections
+    size_t               max_inflight;     // in-flight messages per connection
 } mqtt_config_t;
 
 int  mqtt_config_parse(neu_plugin_t *plugin, const char *setting,
@@ -20,167 +20,205 @@
 #include "connection/mqtt_client.h"
 #include "errcodes.h"
 #include "utils/asprintf.h"
+#include "utils/msgpack.h"
+#include "utils/time.h"
 #include "version.h"
+#include "json/json_writer.h"
 #include "json/neu_json_mqtt.h"
 #include "json/neu_json_rw.h"
 
 #include "mqtt_handle.h"
 #include "mqtt_plugin.h"
+#include "mqtt_upload.h"
 
-static int tag_values_to_json(neu_resp_tag_value_t *tags, uint16_t len,
-                              neu_json_read_resp_t *json)
+static int encode_upload_msgpack(neu_plugin_t *            plugin,
+                                 neu_reqresp_trans_data_t *data)
 {
-    if (0 == len) {
-        return 0;
-    }
-
-    json->n_tag = len;
-    json->tags  = (neu_json_read_resp_tag_t *) calloc(
-        json->n_tag, sizeof(neu_json_read_resp_tag_t));
-    if (NULL == json->tags) {
-        return -1;
-    }
-
-    for (int i = 0; i < json->n_tag; i++) {
-        neu_resp_tag_value_t *tag  = &tags[i];
-        neu_type_e            type = tag->value.type;
-        json->tags[i].name         = tag->tag;
-        json->tags[i].error        = NEU_ERR_SUCCESS;
+    neu_msgpack_writer_t *w = &plugin->msgpack_writer;
+
+    // same layout as the values format
+    neu_msgpack_writer_reset(w);
+    neu_msgpack_write_map(w, 5);
+    neu_msgpack_write_str(w, "node");
+    neu_msgpack_write_str(w, data->driver);
+    neu_msgpack_write_str(w, "group");
+    neu_msgpack_write_str(w, data->group);
+    neu_msgpack_write_str(w, "timestamp");
+    neu_msgpack_write_int(w, global_timestamp);
+    neu_msgpack_write_tags_values(w, data->tags, data->n_tag);
+
+    return w->error ? -1 : 0;
+}
 
-        switch (type) {
-        case NEU_TYPE_ERROR:
-            json->tags[i].t             = NEU_JSON_INT;
-            json->tags[i].value.val_int = tag->value.value.i32;
-            json->tags[i].error         = tag->value.value.i32;
-            break;
-        case NEU_TYPE_UINT8:
-            json->tags[i].t             = NEU_JSON_INT;
-            json->tags[i].value.val_int = tag->value.value.u8;
-            break;
-        case NEU_TYPE_INT8:
-            json->tags[i].t             = NEU_JSON_INT;
-            json->tags[i].value.val_int = tag->value.value.i8;
-            break;
-        case NEU_TYPE_INT16:
-            json->tags[i].t             = NEU_JSON_INT;
-            json->tags[i].value.val_int = tag->value.value.i16;
-            break;
-        case NEU_TYPE_INT32:
-            json->tags[i].t             = NEU_JSON_INT;
-            json->tags[i].value.val_int = tag->value.value.i32;
-            break;
-        case NEU_TYPE_INT64:
-            json->tags[i].t             = NEU_JSON_INT;
-            json->tags[i].value.val_int = tag->value.value.i64;
-            break;
-        case NEU_TYPE_WORD:
-        case NEU_TYPE_UINT16:
-            json->tags[i].t             = NEU_JSON_INT;
-            json->tags[i].value.val_int = tag->value.value.u16;
-            break;
-        case NEU_TYPE_DWORD:
-        case NEU_TYPE_UINT32:
-            json->tags[i].t             = NEU_JSON_INT;
-            json->tags[i].value.val_int = tag->value.value.u32;
-            break;
-        case NEU_TYPE_LWORD:
-        case NEU_TYPE_UINT64:
-            json->tags[i].t             = NEU_JSON_INT;
-            json->tags[i].value.val_int = tag->value.value.u64;
-            break;
-        case NEU_TYPE_FLOAT:
-            json->tags[i].t               = NEU_JSON_FLOAT;
-            json->tags[i].value.val_float = tag->value.value.f32;
-            json->tags[i].precision       = tag->value.precision;
-            break;
-        case NEU_TYPE_DOUBLE:
-            json->tags[i].t                = NEU_JSON_DOUBLE;
-            json->tags[i].value.val_double = tag->value.value.d64;
-            json->tags[i].precision        = tag->value.precision;
-            break;
-        case NEU_TYPE_BOOL:
-            json->tags[i].t              = NEU_JSON_BOOL;
-            json->tags[i].value.val_bool = tag->value.value.boolean;
-            break;
-        case NEU_TYPE_BIT:
-            json->tags[i].t             = NEU_JSON_BIT;
-            json->tags[i].value.val_bit = tag->value.value.u8;
-            break;
-        case NEU_TYPE_STRING:
-            json->tags[i].t             = NEU_JSON_STR;
-            json->tags[i].value.val_str = tag->value.value.str;
-            break;
-        default:
-            break;
+// encode into the writer of the configured format, which keeps the buffer
+static int encode_upload(neu_plugin_t *plugin, neu_reqresp_trans_data_t *data,
+                         const void **buf, size_t *len)
+{
+    if (MQTT_UPLOAD_FORMAT_MSGPACK == plugin->config.format) {
+        if (0 != encode_upload_msgpack(plugin, data)) {
+            return -1;
+        }
+        *buf = plugin->msgpack_writer.buf;
+        *len = neu_msgpack_writer_len(&plugin->msgpack_writer);
+    } else {
+        if (0 !=
+            mqtt_encode_upload_json(&plugin->json_writer, data,
+                                    plugin->config.format)) {
+            plog_warn(plugin, "encode upload format: %d fail",
+                      plugin->config.format);
+            return -1;
         }
+        *buf = plugin->json_writer.buf;
+        *len = neu_json_writer_len(&plugin->json_writer);
     }
 
     return 0;
 }
 
-static char *generate_upload_json(neu_plugin_t *            plugin,
-                                  neu_reqresp_trans_data_t *data,
-                                  mqtt_upload_format_e      format)
+static char *compress_upload(neu_plugin_t *plugin, const void *buf,
+                             size_t *len)
 {
-    neu_resp_tag_value_t *   tags     = data->tags;
-    uint16_t                 len      = data->n_tag;
-    char *                   json_str = NULL;
-    neu_json_read_periodic_t header   = { .group     = (char *) data->group,
-                                        .node      = (char *) data->driver,
-                                        .timestamp = global_timestamp };
-    neu_json_read_resp_t     json     = { 0 };
-
-    if (0 != tag_values_to_json(tags, len, &json)) {
-        plog_error(plugin, "tag_values_to_json fail");
+    uint8_t *out     = NULL;
+    size_t   out_len = 0;
+    int      rv      = 0;
+
+    neu_adapter_update_metric_cb_t update_metric =
+        plugin->common.adapter_callbacks->update_metric;
+
+    // the stream is shared by the adapter thread and the batch timer
+    pthread_mutex_lock(&plugin->deflate_mtx);
+    if (NULL != plugin->deflate) {
+        rv = neu_deflate(plugin->deflate, buf, *len, &out, &out_len);
+    } else if (NULL != (out = malloc(*len))) {
+        // compression disabled by a reconfiguration meanwhile
+        memcpy(out, buf, *len);
+        out_len = *len;
+    }
+    pthread_mutex_unlock(&plugin->deflate_mtx);
+
+    if (0 != rv || NULL == out) {
+        plog_error(plugin, "compress upload payload fail");
         return NULL;
     }
 
-    if (MQTT_UPLOAD_FORMAT_VALUES == format) { // values
-        neu_json_encode_with_mqtt(&json, neu_json_encode_read_resp1, &header,
-                                  neu_json_encode_read_periodic_resp,
-                                  &json_str);
-    } else if (MQTT_UPLOAD_FORMAT_TAGS == format) { // tags
-        neu_json_encode_with_mqtt(&json, neu_json_encode_read_resp, &header,
-                                  neu_json_encode_read_periodic_resp,
-                                  &json_str);
-    } else {
-        plog_warn(plugin, "invalid upload format: %d", format);
+    update_metric(plugin->common.adapter,
+                  NEU_METRIC_MQTT_COMPRESS_IN_BYTES_TOTAL, *len, NULL);
+    update_metric(plugin->common.adapter,
+                  NEU_METRIC_MQTT_COMPRESS_OUT_BYTES_TOTAL, out_len, NULL);
+
+    *len = out_len;
+    return (char *) out;
+}
+
+// take over the buffer of the last encode_upload
+static char *detach_upload(neu_plugin_t *plugin)
+{
+    if (MQTT_UPLOAD_FORMAT_MSGPACK == plugin->config.format) {
+        return (char *) neu_msgpack_writer_detach(&plugin->msgpack_writer);
     }
+    return neu_json_writer_detach(&plugin->json_writer);
+}
+
+// single tag payload for the per tag topics, never batched
+static int encode_tag_upload(neu_plugin_t *              plugin,
+                             neu_reqresp_trans_data_t *  data,
+                             const neu_resp_tag_value_t *tag, const void **buf,
+                             size_t *len)
+{
+    bool is_err = NEU_TYPE_ERROR == tag->value.type;
+
+    if (MQTT_UPLOAD_FORMAT_MSGPACK == plugin->config.format) {
+        neu_msgpack_writer_t *w = &plugin->msgpack_writer;
+
+        neu_msgpack_writer_reset(w);
+        neu_msgpack_write_map(w, 5);
+        neu_msgpack_write_str(w, "node");
+        neu_msgpack_write_str(w, data->driver);
+        neu_msgpack_write_str(w, "group");
+        neu_msgpack_write_str(w, data->group);
+        neu_msgpack_write_str(w, "tag");
+        neu_msgpack_write_str(w, tag->tag);
+        neu_msgpack_write_str(w, "timestamp");
+        neu_msgpack_write_int(w, global_timestamp);
+        neu_msgpack_write_str(w, is_err ? "error" : "value");
+        if (is_err) {
+            neu_msgpack_write_int(w, tag->value.value.i32);
+        } else if (0 != neu_msgpack_write_tag_value(w, &tag->value)) {
+            return -1;
+        }
+        if (w->error) {
+            return -1;
+        }
+
+        *buf = w->buf;
+        *len = neu_msgpack_writer_len(w);
+    } else {
+        neu_json_writer_t *w = &plugin->json_writer;
 
-    if (json.tags) {
-        free(json.tags);
+        if (NEU_TYPE_BYTES == tag->value.type) {
+            return -1;
+        }
+
+        neu_json_writer_reset(w);
+        neu_json_writer_object_begin(w);
+        neu_json_writer_key(w, "node");
+        neu_json_writer_str_value(w, data->driver);
+        neu_json_writer_key(w, "group");
+        neu_json_writer_str_value(w, data->group);
+        neu_json_writer_key(w, "tag");
+        neu_json_writer_str_value(w, tag->tag);
+        neu_json_writer_key(w, "timestamp");
+        neu_json_writer_int(w, global_timestamp);
+        neu_json_writer_key(w, is_err ? "error" : "value");
+        if (0 != neu_json_writer_tag_value(w, &tag->value)) {
+            return -1;
+        }
+        neu_json_writer_object_end(w);
+        if (NULL == neu_json_writer_str(w)) {
+            return -1;
+        }
+
+        *buf = w->buf;
+        *len = neu_json_writer_len(w);
     }
-    return json_str;
+
+    return 0;
 }
 
 static char *generate_read_resp_json(neu_plugin_t *         plugin,
                                      neu_json_mqtt_t *      mqtt,
-                                     neu_resp_read_group_t *data)
+                                     neu_resp_read_group_t *data, size_t *len)
 {
-    neu_resp_tag_value_t *tags     = data->tags;
-    uint16_t              len      = data->n_tag;
-    char *                json_str = NULL;
-    neu_json_read_resp_t  json     = { 0 };
+    neu_json_writer_t *w = &plugin->json_writer;
 
-    if (0 != tag_values_to_json(tags, len, &json)) {
-        plog_error(plugin, "tag_values_to_json fail");
-        return NULL;
-    }
+    neu_json_writer_reset(w);
+    neu_json_writer_object_begin(w);
+    neu_json_writer_key(w, "uuid");
+    neu_json_writer_str_value(w, mqtt->uuid);
+    neu_json_writer_tags_array(w, data->tags, data->n_tag);
+    neu_json_writer_object_end(w);
 
-    neu_json_encode_with_mqtt(&json, neu_json_encode_read_resp, mqtt,
-                              neu_json_encode_mqtt_resp, &json_str);
-
-    if (json.tags) {
-        free(json.tags);
-    }
-    return json_str;
+    *len = neu_json_writer_len(w);
+    return neu_json_writer_detach(w);
 }
 
 static char *generate_write_resp_json(neu_plugin_t *    plugin,
                                       neu_json_mqtt_t * mqtt,
-                                      neu_resp_error_t *data)
+                                      neu_resp_error_t *data, size_t *len)
 {
-    (void) plugin;
+    if (MQTT_UPLOAD_FORMAT_MSGPACK == plugin->config.format) {
+        neu_msgpack_writer_t *w = &plugin->msgpack_writer;
+
+        neu_msgpack_writer_reset(w);
+        neu_msgpack_write_map(w, 2);
+        neu_msgpack_write_str(w, "uuid");
+        neu_msgpack_write_str(w, mqtt->uuid);
+        neu_msgpack_write_str(w, "error");
+        neu_msgpack_write_int(w, data->error);
+
+        *len = neu_msgpack_writer_len(w);
+        return (char *) neu_msgpack_writer_detach(w);
+    }
 
     neu_json_error_resp_t error    = { .error = data->error };
     char *                json_str = NULL;
@@ -188,9 +226,149 @@ static char *generate_write_resp_json(neu_plugin_t *    plugin,
     neu_json_encode_with_mqtt(&error, neu_json_encode_error_resp, mqtt,
                               neu_json_encode_mqtt_resp, &json_str);
 
+    if (NULL != json_str) {
+        *len = strlen(json_str);
+    }
     return json_str;
 }
 
+static inline bool is_msgpack_map(const uint8_t *payload, uint32_t len)
+{
+    // a JSON document never starts with a MessagePack map marker
+    return len > 0 &&
+        (0x80 == (payload[0] & 0xf0) || 0xde == payload[0] ||
+         0xdf == payload[0]);
+}
+
+static inline bool msgpack_key_eq(const neu_msgpack_value_t *key,
+                                  const char *               name)
+{
+    return strlen(name) == key->v.str.len &&
+        0 == memcmp(key->v.str.ptr, name, key->v.str.len);
+}
+
+// read a string value no longer than `max_len - 1` into a new buffer
+static int msgpack_read_str(neu_msgpack_reader_t *r, size_t max_len,
+                            char **dst)
+{
+    neu_msgpack_value_t v = { 0 };
+
+    if (0 != neu_msgpack_read(r, &v) || NEU_MSGPACK_STR != v.type ||
+        v.v.str.len >= max_len || NULL != *dst) {
+        return -1;
+    }
+
+    *dst = strndup(v.v.str.ptr, v.v.str.len);
+    return NULL == *dst ? -1 : 0;
+}
+
+static int msgpack_read_write_value(neu_msgpack_reader_t *r,
+                                    neu_json_write_req_t *req)
+{
+    neu_msgpack_value_t v = { 0 };
+
+    if (NEU_JSON_UNDEFINE != req->t || 0 != neu_msgpack_read(r, &v)) {
+        return -1;
+    }
+
+    switch (v.type) {
+    case NEU_MSGPACK_INT:
+        req->value.val_int = v.v.i64;
+        req->t             = NEU_JSON_INT;
+        break;
+    case NEU_MSGPACK_UINT:
+        if (v.v.u64 > INT64_MAX) {
+            return -1;
+        }
+        req->value.val_int = v.v.u64;
+        req->t             = NEU_JSON_INT;
+        break;
+    case NEU_MSGPACK_DOUBLE:
+        req->value.val_double = v.v.d64;
+        req->t                = NEU_JSON_DOUBLE;
+        break;
+    case NEU_MSGPACK_BOOL:
+        req->value.val_bool = v.v.boolean;
+        req->t              = NEU_JSON_BOOL;
+        break;
+    case NEU_MSGPACK_STR:
+        if (v.v.str.len >= NEU_VALUE_SIZE) {
+            return -1;
+        }
+        req->value.val_str = strndup(v.v.str.ptr, v.v.str.len);
+        if (NULL == req->value.val_str) {
+            return -1;
+        }
+        req->t = NEU_JSON_STR;
+        break;
+    default:
+        return -1;
+    }
+
+    return 0;
+}
+
+// decode {"uuid", "node", "group", "tag", "value"} into the JSON structures
+static int decode_write_req_msgpack(const uint8_t *payload, uint32_t len,
+                                    neu_json_mqtt_t **     mqtt_p,
+                                    neu_json_write_req_t **req_p)
+{
+    int                   rv   = 0;
+    neu_msgpack_reader_t  r    = { 0 };
+    neu_msgpack_value_t   v    = { 0 };
+    neu_json_mqtt_t *     mqtt = calloc(1, sizeof(*mqtt));
+    neu_json_write_req_t *req  = calloc(1, sizeof(*req));
+
+    if (NULL == mqtt || NULL == req) {
+        goto error;
+    }
+
+    neu_msgpack_reader_init(&r, payload, len);
+    if (0 != neu_msgpack_read(&r, &v) || NEU_MSGPACK_MAP != v.type) {
+        goto error;
+    }
+
+    for (uint32_t i = 0, n = v.v.n; i < n; ++i) {
+        if (0 != neu_msgpack_read(&r, &v) || NEU_MSGPACK_STR != v.type) {
+            goto error;
+        }
+
+        if (msgpack_key_eq(&v, "uuid")) {
+            rv = msgpack_read_str(&r, SIZE_MAX, &mqtt->uuid);
+        } else if (msgpack_key_eq(&v, "node")) {
+            rv = msgpack_read_str(&r, NEU_NODE_NAME_LEN, &req->node);
+        } else if (msgpack_key_eq(&v, "group")) {
+            rv = msgpack_read_str(&r, NEU_GROUP_NAME_LEN, &req->group);
+        } else if (msgpack_key_eq(&v, "tag")) {
+            rv = msgpack_read_str(&r, NEU_TAG_NAME_LEN, &req->tag);
+        } else if (msgpack_key_eq(&v, "value")) {
+            rv = msgpack_read_write_value(&r, req);
+        } else {
+            rv = neu_msgpack_skip(&r);
+        }
+
+        if (0 != rv) {
+            goto error;
+        }
+    }
+
+    if (NULL == mqtt->uuid || NULL == req->node || NULL == req->group ||
+        NULL == req->tag || NEU_JSON_UNDEFINE == req->t) {
+        goto error;
+    }
+
+    *mqtt_p = mqtt;
+    *req_p  = req;
+    return 0;
+
+error:
+    neu_json_decode_mqtt_req_free(mqtt);
+    if (NULL != req) {
+        neu_json_decode_write_req_free(req);
+    }
+    return -1;
+}
+
 static inline int send_read_req(neu_plugin_t *plugin, neu_json_mqtt_t *mqtt,
                                 neu_json_read_req_t *req)
 {
@@ -264,7 +442,8 @@ static void publish_cb(int errcode, neu_mqtt_qos_e qos, char *topic,
     (void) topic;
     (void) len;
 
-    neu_plugin_t *plugin = data;
+    mqtt_conn_t * conn   = data;
+    neu_plugin_t *plugin = conn->plugin;
 
     neu_adapter_update_metric_cb_t update_metric =
         plugin->common.adapter_callbacks->update_metric;
@@ -272,23 +451,50 @@ static void publish_cb(int errcode, neu_mqtt_qos_e qos, char *topic,
     if (0 == errcode) {
         update_metric(plugin->common.adapter, NEU_METRIC_SEND_MSGS_TOTAL, 1,
                       NULL);
+        if (conn->send_msgs_metric) {
+            update_metric(plugin->common.adapter, conn->send_msgs_metric, 1,
+                          NULL);
+        }
     } else {
         update_metric(plugin->common.adapter, NEU_METRIC_SEND_MSG_ERRORS_TOTAL,
                       1, NULL);
+        if (conn->send_msg_errors_metric) {
+            update_metric(plugin->common.adapter,
+                          conn->send_msg_errors_metric, 1, NULL);
+        }
     }
 
     free(payload);
 }
 
+// messages on the same topic always go through the same connection,
+// so that they stay in order
+static inline mqtt_conn_t *select_conn(neu_plugin_t *plugin, const char *topic)
+{
+    uint32_t hash = 2166136261u; // FNV-1a
+
+    if (plugin->n_conns <= 1) {
+        return &plugin->conns[0];
+    }
+
+    for (const char *p = topic; *p; ++p) {
+        hash = (hash ^ (uint8_t) *p) * 16777619u;
+    }
+
+    return &plugin->conns[hash % plugin->n_conns];
+}
+
 static inline int publish(neu_plugin_t *plugin, neu_mqtt_qos_e qos, char *topic,
                           char *payload, size_t payload_len)
 {
     neu_adapter_update_metric_cb_t update_metric =
         plugin->common.adapter_callbacks->update_metric;
 
+    mqtt_conn_t *conn = select_conn(plugin, topic);
+
     int rv =
-        neu_mqtt_client_publish(plugin->client, qos, topic, (uint8_t *) payload,
-                                (uint32_t) payload_len, plugin, publish_cb);
+        neu_mqtt_client_publish(conn->client, qos, topic, (uint8_t *) payload,
+                                (uint32_t) payload_len, conn, publish_cb);
     if (0 != rv) {
         plog_error(plugin, "pub [%s, QoS%d] fail", topic, qos);
         update_metric(plugin->common.adapter, NEU_METRIC_SEND_MSG_ERRORS_TOTAL,
@@ -314,6 +520,24 @@ void handle_write_req(neu_mqtt_qos_e qos, const char *topic,
         plugin->common.adapter_callbacks->update_metric;
     update_metric(plugin->common.adapter, NEU_METRIC_RECV_MSGS_TOTAL, 1, NULL);
 
+    neu_json_mqtt_t *mqtt = NULL;
+
+    if (is_msgpack_map(payload, len)) {
+        rv = decode_write_req_msgpack(payload, len, &mqtt, &req);
+        if (0 != rv) {
+            plog_error(plugin, "decode msgpack write req fail");
+            return;
+        }
+
+        rv = send_write_req(plugin, mqtt, req);
+        if (0 != rv) {
+            neu_json_decode_mqtt_req_free(mqtt);
+        }
+
+        neu_json_decode_write_req_free(req);
+        return;
+    }
+
     char *json_str = malloc(len + 1);
     if (NULL == json_str) {
         return;
@@ -322,8 +546,7 @@ void handle_write_req(neu_mqtt_qos_e qos, const char *topic,
     memcpy(json_str, payload, len);
     json_str[len] = '\0';
 
-    neu_json_mqtt_t *mqtt = NULL;
-    rv                    = neu_json_decode_mqtt_req(json_str, &mqtt);
+    rv = neu_json_decode_mqtt_req(json_str, &mqtt);
     if (0 != rv) {
         plog_error(plugin, "neu_json_decode_mqtt_req failed");
         free(json_str);
@@ -350,8 +573,9 @@ void handle_write_req(neu_mqtt_qos_e qos, const char *topic,
 int handle_write_response(neu_plugin_t *plugin, neu_json_mqtt_t *mqtt_json,
                           neu_resp_error_t *data)
 {
-    int   rv       = 0;
-    char *json_str = NULL;
+    int    rv       = 0;
+    char * json_str = NULL;
+    size_t json_len = 0;
 
     if (NULL == plugin->client) {
         rv = NEU_ERR_MQTT_IS_NULL;
@@ -365,7 +589,7 @@ int handle_write_response(neu_plugin_t *plugin, neu_json_mqtt_t *mqtt_json,
         goto end;
     }
 
-    json_str = generate_write_resp_json(plugin, mqtt_json, data);
+    json_str = generate_write_resp_json(plugin, mqtt_json, data, &json_len);
     if (NULL == json_str) {
         plog_error(plugin, "generate write resp json fail, uuid:%s",
                    mqtt_json->uuid);
@@ -375,7 +599,7 @@ int handle_write_response(neu_plugin_t *plugin, neu_json_mqtt_t *mqtt_json,
 
     char *         topic = plugin->config.write_resp_topic;
     neu_mqtt_qos_e qos   = plugin->config.qos;
-    rv       = publish(plugin, qos, topic, json_str, strlen(json_str));
+    rv       = publish(plugin, qos, topic, json_str, json_len);
     json_str = NULL;
 
 end:
@@ -433,8 +657,9 @@ void handle_read_req(neu_mqtt_qos_e qos, const char *topic,
 int handle_read_response(neu_plugin_t *plugin, neu_json_mqtt_t *mqtt_json,
                          neu_resp_read_group_t *data)
 {
-    int   rv       = 0;
-    char *json_str = NULL;
+    int    rv       = 0;
+    char * json_str = NULL;
+    size_t json_len = 0;
 
     if (NULL == plugin->client) {
         rv = NEU_ERR_MQTT_IS_NULL;
@@ -448,7 +673,7 @@ int handle_read_response(neu_plugin_t *plugin, neu_json_mqtt_t *mqtt_json,
         goto end;
     }
 
-    json_str = generate_read_resp_json(plugin, mqtt_json, data);
+    json_str = generate_read_resp_json(plugin, mqtt_json, data, &json_len);
     if (NULL == json_str) {
         plog_error(plugin, "generate read resp json fail");
         rv = NEU_ERR_EINTERNAL;
@@ -457,7 +682,7 @@ int handle_read_response(neu_plugin_t *plugin, neu_json_mqtt_t *mqtt_json,
 
     char *         topic = plugin->read_resp_topic;
     neu_mqtt_qos_e qos   = plugin->config.qos;
-    rv       = publish(plugin, qos, topic, json_str, strlen(json_str));
+    rv       = publish(plugin, qos, topic, json_str, json_len);
     json_str = NULL;
 
 end:
@@ -466,6 +691,38 @@ end:
     return rv;
 }
 
+static void publish_tags(neu_plugin_t *plugin, route_entry_t *route,
+                         neu_reqresp_trans_data_t *trans_data)
+{
+    mqtt_tag_topics_next(&route->tag_topics);
+    for (uint32_t i = 0; i < trans_data->n_tag; ++i) {
+        const neu_resp_tag_value_t *tag = &trans_data->tags[i];
+        const char *topic = mqtt_tag_topics_get(&route->tag_topics, tag->tag);
+        if (NULL == topic) {
+            continue;
+        }
+
+        const void *buf = NULL;
+        size_t      len = 0;
+        if (0 != encode_tag_upload(plugin, trans_data, tag, &buf, &len)) {
+            // tags without a value in the upload format
+            continue;
+        }
+
+        char *payload = NULL;
+        if (NULL != plugin->deflate) {
+            payload = compress_upload(plugin, buf, &len);
+        } else {
+            payload = detach_upload(plugin);
+        }
+        if (NULL == payload) {
+            continue;
+        }
+
+        publish(plugin, plugin->config.qos, (char *) topic, payload, len);
+    }
+}
+
 int handle_trans_data(neu_plugin_t *            plugin,
                       neu_reqresp_trans_data_t *trans_data)
 {
@@ -481,29 +738,93 @@ int handle_trans_data(neu_plugin_t *            plugin,
         return NEU_ERR_MQTT_FAILURE;
     }
 
-    const route_entry_t *route = route_tbl_get(
-        &plugin->route_tbl, trans_data->driver, trans_data->group);
+    route_entry_t *route = route_tbl_get(&plugin->route_tbl,
+                                         trans_data->driver, trans_data->group);
     if (NULL == route) {
         plog_error(plugin, "no route for driver:%s group:%s",
                    trans_data->driver, trans_data->group);
         return NEU_ERR_GROUP_NOT_SUBSCRIBE;
     }
 
-    char *json_str =
-        generate_upload_json(plugin, trans_data, plugin->config.format);
-    if (NULL == json_str) {
-        plog_error(plugin, "generate upload json fail");
+    if (NULL != route->tag_topics.tmpl) {
+        publish_tags(plugin, route, trans_data);
+    }
+
+    if (NULL == route->topic) {
+        return 0;
+    }
+
+    const void *buf = NULL;
+    size_t      len = 0;
+    if (0 != encode_upload(plugin, trans_data, &buf, &len)) {
+        plog_error(plugin, "generate upload payload fail");
+        return NEU_ERR_EINTERNAL;
+    }
+
+    if (plugin->config.batch_linger > 0) {
+        // published by handle_batch_flush
+        if (0 !=
+            mqtt_batcher_add(&plugin->batcher, route->topic, buf, len,
+                             neu_time_ms())) {
+            plog_error(plugin, "batch upload payload fail");
+            return NEU_ERR_EINTERNAL;
+        }
+        return 0;
+    }
+
+    char *payload = NULL;
+    if (NULL != plugin->deflate) {
+        // the encoder keeps its buffer, only the compressed copy is published
+        payload = compress_upload(plugin, buf, &len);
+    } else {
+        payload = detach_upload(plugin);
+    }
+    if (NULL == payload) {
         return NEU_ERR_EINTERNAL;
     }
 
     char *         topic = route->topic;
     neu_mqtt_qos_e qos   = plugin->config.qos;
-    rv       = publish(plugin, qos, topic, json_str, strlen(json_str));
-    json_str = NULL;
+    rv                   = publish(plugin, qos, topic, payload, len);
 
     return rv;
 }
 
+void handle_batch_flush(void *ctx, const char *topic, uint8_t *payload,
+                        size_t len, uint32_t n_msg, bool full)
+{
+    neu_plugin_t *plugin = ctx;
+
+    neu_adapter_update_metric_cb_t update_metric =
+        plugin->common.adapter_callbacks->update_metric;
+
+    update_metric(plugin->common.adapter, NEU_METRIC_MQTT_BATCHES_TOTAL, 1,
+                  NULL);
+    update_metric(plugin->common.adapter, NEU_METRIC_MQTT_BATCH_REPORTS_TOTAL,
+                  n_msg, NULL);
+    update_metric(plugin->common.adapter, NEU_METRIC_MQTT_BATCH_BYTES_TOTAL,
+                  len, NULL);
+    update_metric(plugin->common.adapter, NEU_METRIC_MQTT_BATCH_REPORTS_LAST,
+                  n_msg, NULL);
+    if (full) {
+        update_metric(plugin->common.adapter, NEU_METRIC_MQTT_BATCH_FULL_TOTAL,
+                      1, NULL);
+    }
+
+    char *data = (char *) payload;
+    if (NULL != plugin->deflate) {
+        data = compress_upload(plugin, payload, &len);
+        free(payload);
+        if (NULL == data) {
+            update_metric(plugin->common.adapter,
+                          NEU_METRIC_SEND_MSG_ERRORS_TOTAL, 1, NULL);
+            return;
+        }
+    }
+
+    publish(plugin, plugin->config.qos, (char *) topic, data, len);
+}
+
 static inline char *default_upload_topic(neu_req_subscribe_t *info)
 {
     char *t = NULL;
@@ -511,37 +832,163 @@ static inline char *default_upload_topic(neu_req_subscribe_t *info)
     return t;
 }
 
+// parse the optional list of tags with their own topic
+static int parse_topic_tags(void *json, char ***tags, size_t *n_tag)
+{
+    neu_json_elem_t elem = { .name      = "tags",
+                             .t         = NEU_JSON_OBJECT,
+                             .attribute = NEU_JSON_ATTRIBUTE_OPTIONAL };
+
+    *tags  = NULL;
+    *n_tag = 0;
+
+    if (0 != neu_json_decode_by_json(json, 1, &elem)) {
+        return -1;
+    }
+    if (NULL == elem.v.val_object) {
+        return 0;
+    }
+
+    int n = neu_json_decode_array_size_by_json(json, "tags");
+    if (n < 0) {
+        return -1;
+    }
+    if (0 == n) {
+        return 0;
+    }
+
+    *tags = calloc(n, sizeof(char *));
+    if (NULL == *tags) {
+        return -1;
+    }
+
+    for (int i = 0; i < n; ++i) {
+        neu_json_elem_t tag = { .name = NULL, .t = NEU_JSON_STR };
+        if (0 != neu_json_decode_array_by_json(json, "tags", i, 1, &tag)) {
+            break;
+        }
+        (*tags)[(*n_tag)++] = tag.v.val_str;
+    }
+
+    return *n_tag == (size_t) n ? 0 : -1;
+}
+
+static inline void free_topic_tags(char **tags, size_t n_tag)
+{
+    for (size_t i = 0; i < n_tag; ++i) {
+        free(tags[i]);
+    }
+    free(tags);
+}
+
 int handle_subscribe_group(neu_plugin_t *plugin, neu_req_subscribe_t *sub_info)
 {
-    int rv = 0;
+    int    rv        = 0;
+    void * json      = NULL;
+    char * topic     = NULL;
+    char * tag_topic = NULL;
+    char **tags      = NULL;
+    size_t n_tag     = 0;
+
+    neu_json_elem_t elems[] = {
+        {
+            .name      = "topic",
+            .t         = NEU_JSON_STR,
+            .attribute = NEU_JSON_ATTRIBUTE_OPTIONAL,
+        },
+        {
+            .name      = "tag-topic",
+            .t         = NEU_JSON_STR,
+            .attribute = NEU_JSON_ATTRIBUTE_OPTIONAL,
+        },
+    };
 
-    neu_json_elem_t topic = { .name = "topic", .t = NEU_JSON_STR };
     if (NULL == sub_info->params) {
         // no parameters, try default topic
-        topic.v.val_str = default_upload_topic(sub_info);
-        if (NULL == topic.v.val_str) {
+        topic = default_upload_topic(sub_info);
+        if (NULL == topic) {
+            rv = NEU_ERR_EINTERNAL;
+            goto end;
+        }
+    } else {
+        json = neu_json_decode_new(sub_info->params);
+        if (NULL == json ||
+            0 != neu_json_decode_by_json(json, 2, elems) ||
+            (NULL == elems[0].v.val_str && NULL == elems[1].v.val_str) ||
+            0 != parse_topic_tags(json, &tags, &n_tag)) {
+            plog_error(plugin, "parse `%s` for topic fail", sub_info->params);
+            rv = NEU_ERR_GROUP_PARAMETER_INVALID;
+            goto end;
+        }
+    }
+
+    // expand the templates once here, not for every upload
+    if (NULL != elems[0].v.val_str) {
+        topic = mqtt_topic_expand(elems[0].v.val_str, sub_info->app,
+                                  sub_info->driver, sub_info->group, NULL);
+        if (NULL == topic) {
+            rv = NEU_ERR_EINTERNAL;
+            goto end;
+        }
+        if (mqtt_topic_has_tag(topic)) {
+            plog_error(plugin, "topic `%s` should not contain {tag}", topic);
+            rv = NEU_ERR_GROUP_PARAMETER_INVALID;
+            goto end;
+        }
+    }
+
+    if (NULL != elems[1].v.val_str) {
+        if (!mqtt_topic_has_tag(elems[1].v.val_str)) {
+            plog_error(plugin, "tag-topic `%s` should contain {tag}",
+                       elems[1].v.val_str);
+            rv = NEU_ERR_GROUP_PARAMETER_INVALID;
+            goto end;
+        }
+        tag_topic = mqtt_topic_expand(elems[1].v.val_str, sub_info->app,
+                                      sub_info->driver, sub_info->group, NULL);
+        if (NULL == tag_topic) {
+            rv = NEU_ERR_EINTERNAL;
             goto end;
         }
-    } else if (0 != neu_parse_param(sub_info->params, NULL, 1, &topic)) {
-        plog_error(plugin, "parse `%s` for topic fail", sub_info->params);
-        rv = NEU_ERR_GROUP_PARAMETER_INVALID;
-        goto end;
     }
 
     rv = route_tbl_add_new(&plugin->route_tbl, sub_info->driver,
-                           sub_info->group, topic.v.val_str);
-    // topic.v.val_str ownership moved
+                           sub_info->group, topic);
     if (0 != rv) {
         plog_error(plugin, "route driver:%s group:%s to topic:%s fail, `%s`",
-                   sub_info->driver, sub_info->group, topic.v.val_str,
+                   sub_info->driver, sub_info->group, topic ? topic : "",
                    sub_info->params);
+        topic = NULL; // ownership moved
         goto end;
     }
 
     plog_notice(plugin, "route driver:%s group:%s to topic:%s",
-                sub_info->driver, sub_info->group, topic.v.val_str);
+                sub_info->driver, sub_info->group, topic ? topic : "");
+    topic = NULL; // ownership moved
+
+    if (NULL != tag_topic) {
+        route_entry_t *route = route_tbl_get(
+            &plugin->route_tbl, sub_info->driver, sub_info->group);
+        plog_notice(plugin, "route driver:%s group:%s to tag topic:%s",
+                    sub_info->driver, sub_info->group, tag_topic);
+        rv = mqtt_tag_topics_init(&route->tag_topics, tag_topic, tags, n_tag);
+        tag_topic = NULL; // ownership moved
+        if (0 != rv) {
+            route_tbl_del(&plugin->route_tbl, sub_info->driver,
+                          sub_info->group);
+            rv = NEU_ERR_EINTERNAL;
+        }
+    }
 
 end:
+    free(topic);
+    free(tag_topic);
+    free(elems[0].v.val_str);
+    free(elems[1].v.val_str);
+    free_topic_tags(tags, n_tag);
+    if (json) {
+        neu_json_decode_free(json);
+    }
     free(sub_info->params);
     return rv;
 }
@@ -554,3 +1001,11 @@ int handle_unsubscribe_group(neu_plugin_t *         plugin,
                 unsub_info->group);
     return 0;
 }
+
+// the groups of a deleted driver are unsubscribed without a request
+int handle_del_driver(neu_plugin_t *plugin, neu_reqresp_node_deleted_t *req)
+{
+    route_tbl_del_driver(&plugin->route_tbl, req->node);
+    plog_notice(plugin, "del routes of driver:%s", req->node);
+    return 0;
+}
@@ -42,10 +42,16 @@ int handle_read_response(neu_plugin_t *plugin, neu_json_mqtt_t *mqtt_json,
 int handle_trans_data(neu_plugin_t *            plugin,
                       neu_reqresp_trans_data_t *trans_data);
 
+// mqtt_batch_flush_cb publishing batches of upload payloads
+void handle_batch_flush(void *ctx, const char *topic, uint8_t *payload,
+                        size_t len, uint32_t n_msg, bool full);
+
 int handle_subscribe_group(neu_plugin_t *plugin, neu_req_subscribe_t *sub_info);
 int handle_unsubscribe_group(neu_plugin_t *         plugin,
                              neu_req_unsubscribe_t *unsub_info);
 
+int handle_del_driver(neu_plugin_t *plugin, neu_reqresp_node_deleted_t *req);
+
 #ifdef __cplusplus
 }
 #endif
@@ -41,10 +41,107 @@ static void disconnect_cb(void *data)
                 neu_plugin_module.module_name);
 }
 
+static int batch_timer_cb(void *data)
+{
+    neu_plugin_t *plugin = data;
+
+    mqtt_batcher_expire(&plugin->batcher, neu_time_ms());
+    return 0;
+}
+
+static void stop_batch_timer(neu_plugin_t *plugin)
+{
+    if (plugin->batch_timer) {
+        neu_event_del_timer(plugin->events, plugin->batch_timer);
+        plugin->batch_timer = NULL;
+    }
+}
+
+static int setup_batch(neu_plugin_t *plugin, const mqtt_config_t *config)
+{
+    neu_event_timer_t *timer = NULL;
+
+    stop_batch_timer(plugin);
+    // pending batches are flushed with the framing they were built with
+    mqtt_batcher_setup(&plugin->batcher,
+                       MQTT_UPLOAD_FORMAT_MSGPACK == config->format,
+                       config->batch_linger, config->batch_max_size);
+
+    if (0 == config->batch_linger) {
+        plog_info(plugin, "batching disabled");
+        return 0;
+    }
+
+    if (NULL == plugin->events) {
+        plugin->events = neu_event_new();
+        if (NULL == plugin->events) {
+            plog_error(plugin, "neu_event_new fail");
+            return NEU_ERR_EINTERNAL;
+        }
+    }
+
+    // check a few times per linger period to bound the extra delay
+    int64_t                 period = config->batch_linger / 4;
+    neu_event_timer_param_t param  = {
+        .second      = 0,
+        .millisecond = period > 5 ? period : 5,
+        .cb          = batch_timer_cb,
+        .usr_data    = plugin,
+    };
+
+    timer = neu_event_add_timer(plugin->events, param);
+    if (NULL == timer) {
+        plog_error(plugin, "neu_event_add_timer fail");
+        return NEU_ERR_EINTERNAL;
+    }
+    plugin->batch_timer = timer;
+
+    return 0;
+}
+
+static int setup_compress(neu_plugin_t *plugin, const mqtt_config_t *config)
+{
+    int rv = 0;
+
+    // a batch flush may be compressing on the timer thread
+    pthread_mutex_lock(&plugin->deflate_mtx);
+    neu_deflate_free(plugin->deflate);
+    plugin->deflate = NULL;
+
+    if (0 != config->compress_level) {
+        plugin->deflate = neu_deflate_new(config->compress_level);
+        if (NULL == plugin->deflate) {
+            plog_error(plugin, "neu_deflate_new fail");
+            rv = NEU_ERR_EINTERNAL;
+        }
+    }
+    pthread_mutex_unlock(&plugin->deflate_mtx);
+
+    return rv;
+}
+
+// close and free all connections but the first one
+static void free_extra_conns(neu_plugin_t *plugin)
+{
+    for (size_t i = 1; i < plugin->n_conns; ++i) {
+        neu_mqtt_client_close(plugin->conns[i].client);
+        neu_mqtt_client_free(plugin->conns[i].client);
+        memset(&plugin->conns[i], 0, sizeof(mqtt_conn_t));
+    }
+    plugin->n_conns = NULL != plugin->client ? 1 : 0;
+}
+
 static neu_plugin_t *mqtt_plugin_open(void)
 {
     neu_plugin_t *plugin = (neu_plugin_t *) calloc(1, sizeof(neu_plugin_t));
     neu_plugin_common_init(&plugin->common);
+    neu_json_writer_init(&plugin->json_writer, 0);
+    neu_msgpack_writer_init(&plugin->msgpack_writer, 0);
+    if (0 != mqtt_batcher_init(&plugin->batcher, handle_batch_flush, plugin)) {
+        free(plugin);
+        return NULL;
+    }
+    pthread_mutex_init(&plugin->deflate_mtx, NULL);
     return plugin;
 }
 
@@ -53,6 +150,10 @@ static int mqtt_plugin_close(neu_plugin_t *plugin)
     const char *name = neu_plugin_module.module_name;
     plog_notice(plugin, "success to free plugin:%s", name);
 
+    neu_json_writer_fini(&plugin->json_writer);
+    neu_msgpack_writer_fini(&plugin->msgpack_writer);
+    mqtt_batcher_fini(&plugin->batcher);
+    pthread_mutex_destroy(&plugin->deflate_mtx);
     free(plugin);
     return NEU_ERR_SUCCESS;
 }
@@ -66,12 +167,64 @@ static int mqtt_plugin_init(neu_plugin_t *plugin)
     register_metric(plugin->common.adapter, NEU_METRIC_CACHED_MSGS_NUM,
                     NEU_METRIC_CACHED_MSGS_NUM_HELP,
                     NEU_METRIC_CACHED_MSGS_NUM_TYPE, 0);
+    register_metric(plugin->common.adapter, NEU_METRIC_MQTT_BATCHES_TOTAL,
+                    NEU_METRIC_MQTT_BATCHES_TOTAL_HELP,
+                    NEU_METRIC_MQTT_BATCHES_TOTAL_TYPE, 0);
+    register_metric(plugin->common.adapter, NEU_METRIC_MQTT_BATCH_FULL_TOTAL,
+                    NEU_METRIC_MQTT_BATCH_FULL_TOTAL_HELP,
+                    NEU_METRIC_MQTT_BATCH_FULL_TOTAL_TYPE, 0);
+    register_metric(plugin->common.adapter,
+                    NEU_METRIC_MQTT_BATCH_REPORTS_TOTAL,
+                    NEU_METRIC_MQTT_BATCH_REPORTS_TOTAL_HELP,
+                    NEU_METRIC_MQTT_BATCH_REPORTS_TOTAL_TYPE, 0);
+    register_metric(plugin->common.adapter, NEU_METRIC_MQTT_BATCH_BYTES_TOTAL,
+                    NEU_METRIC_MQTT_BATCH_BYTES_TOTAL_HELP,
+                    NEU_METRIC_MQTT_BATCH_BYTES_TOTAL_TYPE, 0);
+    register_metric(plugin->common.adapter,
+                    NEU_METRIC_MQTT_BATCH_REPORTS_LAST,
+                    NEU_METRIC_MQTT_BATCH_REPORTS_LAST_HELP,
+                    NEU_METRIC_MQTT_BATCH_REPORTS_LAST_TYPE, 0);
+    register_metric(plugin->common.adapter,
+                    NEU_METRIC_MQTT_COMPRESS_IN_BYTES_TOTAL,
+                    NEU_METRIC_MQTT_COMPRESS_IN_BYTES_TOTAL_HELP,
+                    NEU_METRIC_MQTT_COMPRESS_IN_BYTES_TOTAL_TYPE, 0);
+    register_metric(plugin->common.adapter,
+                    NEU_METRIC_MQTT_COMPRESS_OUT_BYTES_TOTAL,
+                    NEU_METRIC_MQTT_COMPRESS_OUT_BYTES_TOTAL_HELP,
+                    NEU_METRIC_MQTT_COMPRESS_OUT_BYTES_TOTAL_TYPE, 0);
+    register_metric(plugin->common.adapter,
+                    NEU_METRIC_MQTT_REPLAY_BACKLOG_BYTES,
+                    NEU_METRIC_MQTT_REPLAY_BACKLOG_BYTES_HELP,
+                    NEU_METRIC_MQTT_REPLAY_BACKLOG_BYTES_TYPE, 0);
+    register_metric(plugin->common.adapter, NEU_METRIC_MQTT_REPLAY_ETA_SECONDS,
+                    NEU_METRIC_MQTT_REPLAY_ETA_SECONDS_HELP,
+                    NEU_METRIC_MQTT_REPLAY_ETA_SECONDS_TYPE, 0);
+    register_metric(plugin->common.adapter,
+                    NEU_METRIC_MQTT_REPLAYED_MSGS_TOTAL,
+                    NEU_METRIC_MQTT_REPLAYED_MSGS_TOTAL_HELP,
+                    NEU_METRIC_MQTT_REPLAYED_MSGS_TOTAL_TYPE, 0);
+    register_metric(plugin->common.adapter,
+                    NEU_METRIC_MQTT_CACHE_EVICTED_TOTAL,
+                    NEU_METRIC_MQTT_CACHE_EVICTED_TOTAL_HELP,
+                    NEU_METRIC_MQTT_CACHE_EVICTED_TOTAL_TYPE, 0);
     return NEU_ERR_SUCCESS;
 }
 
 static int mqtt_plugin_uninit(neu_plugin_t *plugin)
 {
+    stop_batch_timer(plugin);
+    if (NULL != plugin->events) {
+        neu_event_close(plugin->events);
+        plugin->events = NULL;
+    }
+    mqtt_batcher_flush(&plugin->batcher);
+    pthread_mutex_lock(&plugin->deflate_mtx);
+    neu_deflate_free(plugin->deflate);
+    plugin->deflate = NULL;
+    pthread_mutex_unlock(&plugin->deflate_mtx);
+
     mqtt_config_fini(&plugin->config);
+    free_extra_conns(plugin);
     if (plugin->client) {
         neu_mqtt_client_close(plugin->client);
         neu_mqtt_client_free(plugin->client);
@@ -90,10 +243,29 @@ static int mqtt_plugin_uninit(neu_plugin_t *plugin)
     return NEU_ERR_SUCCESS;
 }
 
+#define CONN_METRIC_NAMES(suffix)                   \
+    {                                               \
+        "mqtt_conn0_" suffix, "mqtt_conn1_" suffix, \
+        "mqtt_conn2_" suffix, "mqtt_conn3_" suffix, \
+        "mqtt_conn4_" suffix, "mqtt_conn5_" suffix, \
+        "mqtt_conn6_" suffix, "mqtt_conn7_" suffix, \
+    }
+
+// metric entries keep the name pointers, so the names are static
+static const char *const conn_send_msgs_metrics[MQTT_CONNECTIONS_MAX] =
+    CONN_METRIC_NAMES("send_msgs_total");
+static const char *const conn_send_msg_errors_metrics[MQTT_CONNECTIONS_MAX] =
+    CONN_METRIC_NAMES("send_msg_errors_total");
+static const char *const conn_cached_msgs_metrics[MQTT_CONNECTIONS_MAX] =
+    CONN_METRIC_NAMES("cached_msgs");
+
+// `index` is the index of the connection of the client
 static int config_mqtt_client(neu_plugin_t *plugin, neu_mqtt_client_t *client,
-                              const mqtt_config_t *config)
+                              const mqtt_config_t *config, size_t index)
 {
-    int rv = 0;
+    int    rv        = 0;
+    char * client_id = config->client_id;
+    size_t n         = config->connections > 0 ? config->connections : 1;
 
     if (NULL == client) {
         return 0;
@@ -106,34 +278,67 @@ static int config_mqtt_client(neu_plugin_t *plugin, neu_mqtt_client_t *client,
         return -1;
     }
 
+    rv = neu_mqtt_client_set_version(client, config->version);
+    if (0 != rv) {
+        plog_error(plugin, "neu_mqtt_client_set_version fail");
+        return -1;
+    }
+
     rv = neu_mqtt_client_set_addr(client, config->host, config->port);
     if (0 != rv) {
         plog_error(plugin, "neu_mqtt_client_set_host fail");
         return -1;
     }
 
-    rv = neu_mqtt_client_set_id(client, config->client_id);
+    // client ids should be unique to the broker
+    if (index > 0 &&
+        0 > neu_asprintf(&client_id, "%s-%zu", config->client_id, index)) {
+        plog_error(plugin, "neu_asprintf client id fail");
+        return -1;
+    }
+    rv = neu_mqtt_client_set_id(client, client_id);
+    if (client_id != config->client_id) {
+        free(client_id);
+    }
     if (0 != rv) {
         plog_error(plugin, "neu_mqtt_client_set_id fail");
         return -1;
     }
 
-    rv = neu_mqtt_client_set_connect_cb(client, connect_cb, plugin);
+    // the link state follows the first connection, which also subscribes
+    if (0 == index) {
+        rv = neu_mqtt_client_set_connect_cb(client, connect_cb, plugin);
+        if (0 != rv) {
+            plog_error(plugin, "neu_mqtt_client_set_connect_cb fail");
+            return -1;
+        }
+
+        rv = neu_mqtt_client_set_disconnect_cb(client, disconnect_cb, plugin);
+        if (0 != rv) {
+            plog_error(plugin, "neu_mqtt_client_set_disconnect_cb fail");
+            return -1;
+        }
+    }
+
+    // connections share the cache and replay budgets evenly
+    rv = neu_mqtt_client_set_cache_size(client, config->cache_mem_size / n,
+                                        config->cache_disk_size / n);
     if (0 != rv) {
-        plog_error(plugin, "neu_mqtt_client_set_connect_cb fail");
+        plog_error(plugin, "neu_mqtt_client_set_msg_cache_limit fail");
         return -1;
     }
 
-    rv = neu_mqtt_client_set_disconnect_cb(client, disconnect_cb, plugin);
+    rv = neu_mqtt_client_set_replay(client, config->replay_rate / n,
+                                    config->replay_inflight,
+                                    config->replay_topic);
     if (0 != rv) {
-        plog_error(plugin, "neu_mqtt_client_set_disconnect_cb fail");
+        plog_error(plugin, "neu_mqtt_client_set_replay fail");
         return -1;
     }
 
-    rv = neu_mqtt_client_set_cache_size(client, config->cache_mem_size,
-                                        config->cache_disk_size);
+    rv = neu_mqtt_client_set_max_inflight(client, config->max_inflight);
     if (0 != rv) {
-        plog_error(plugin, "neu_mqtt_client_set_msg_cache_limit fail");
+        plog_error(plugin, "neu_mqtt_client_set_max_inflight fail");
         return -1;
     }
 
@@ -155,6 +360,73 @@ static int config_mqtt_client(neu_plugin_t *plugin, neu_mqtt_client_t *client,
     return rv;
 }
 
+static int setup_conns(neu_plugin_t *plugin, const mqtt_config_t *config,
+                       bool started)
+{
+    neu_adapter_register_metric_cb_t register_metric =
+        plugin->common.adapter_callbacks->register_metric;
+    neu_adapter_unregister_metric_cb_t unregister_metric =
+        plugin->common.adapter_callbacks->unregister_metric;
+
+    // drop the metrics of the connections not kept, a single one has none
+    for (size_t i = 1 == config->connections ? 0 : config->connections;
+         i < MQTT_CONNECTIONS_MAX; ++i) {
+        unregister_metric(plugin->common.adapter, conn_send_msgs_metrics[i]);
+        unregister_metric(plugin->common.adapter,
+                          conn_send_msg_errors_metrics[i]);
+        unregister_metric(plugin->common.adapter, conn_cached_msgs_metrics[i]);
+    }
+
+    free_extra_conns(plugin);
+
+    for (size_t i = 1; i < config->connections; ++i) {
+        // every connection is set up from the same config as the first
+        neu_mqtt_client_t *client = neu_mqtt_client_new(config->version);
+        if (NULL == client) {
+            plog_error(plugin, "neu_mqtt_client_new fail");
+            return NEU_ERR_EINTERNAL;
+        }
+
+        plugin->conns[i].plugin = plugin;
+        plugin->conns[i].client = client;
+        plugin->n_conns += 1;
+
+        if (0 != config_mqtt_client(plugin, client, config, i)) {
+            return NEU_ERR_MQTT_INIT_FAILURE;
+        }
+
+        if (started && 0 != neu_mqtt_client_open(client)) {
+            plog_error(plugin, "neu_mqtt_client_open fail");
+            return NEU_ERR_MQTT_CONNECT_FAILURE;
+        }
+    }
+
+    for (size_t i = 0; i < plugin->n_conns; ++i) {
+        mqtt_conn_t *conn = &plugin->conns[i];
+        if (1 == plugin->n_conns) {
+            conn->send_msgs_metric       = NULL;
+            conn->send_msg_errors_metric = NULL;
+            conn->cached_msgs_metric     = NULL;
+            continue;
+        }
+
+        conn->send_msgs_metric       = conn_send_msgs_metrics[i];
+        conn->send_msg_errors_metric = conn_send_msg_errors_metrics[i];
+        conn->cached_msgs_metric     = conn_cached_msgs_metrics[i];
+        register_metric(plugin->common.adapter, conn->send_msgs_metric,
+                        NEU_METRIC_MQTT_CONN_SEND_MSGS_TOTAL_HELP,
+                        NEU_METRIC_MQTT_CONN_SEND_MSGS_TOTAL_TYPE, 0);
+        register_metric(plugin->common.adapter, conn->send_msg_errors_metric,
+                        NEU_METRIC_MQTT_CONN_SEND_MSG_ERRORS_TOTAL_HELP,
+                        NEU_METRIC_MQTT_CONN_SEND_MSG_ERRORS_TOTAL_TYPE, 0);
+        register_metric(plugin->common.adapter, conn->cached_msgs_metric,
+                        NEU_METRIC_MQTT_CONN_CACHED_MSGS_HELP,
+                        NEU_METRIC_MQTT_CONN_CACHED_MSGS_TYPE, 0);
+    }
+
+    return 0;
+}
+
 static int create_topic(neu_plugin_t *plugin)
 {
     if (plugin->read_req_topic) {
@@ -228,12 +500,15 @@ static int mqtt_plugin_config(neu_plugin_t *plugin, const char *setting)
     }
 
     if (NULL == plugin->client) {
-        plugin->client = neu_mqtt_client_new(NEU_MQTT_VERSION_V311);
+        plugin->client = neu_mqtt_client_new(config.version);
         if (NULL == plugin->client) {
             plog_error(plugin, "neu_mqtt_client_new fail");
             rv = NEU_ERR_EINTERNAL;
             goto error;
         }
+        plugin->conns[0].plugin = plugin;
+        plugin->conns[0].client = plugin->client;
+        plugin->n_conns         = 1;
     } else if (neu_mqtt_client_is_open(plugin->client)) {
         started = true;
         unsubscribe(plugin, &plugin->config);
@@ -245,7 +520,7 @@ static int mqtt_plugin_config(neu_plugin_t *plugin, const char *setting)
         }
     }
 
-    rv = config_mqtt_client(plugin, plugin->client, &config);
+    rv = config_mqtt_client(plugin, plugin->client, &config, 0);
     if (0 != rv) {
         rv = NEU_ERR_MQTT_INIT_FAILURE;
         goto error;
@@ -262,11 +537,30 @@ static int mqtt_plugin_config(neu_plugin_t *plugin, const char *setting)
         }
     }
 
+    // the batch timer reads the config, flush with the old one
+    stop_batch_timer(plugin);
+    mqtt_batcher_flush(&plugin->batcher);
     if (plugin->config.host) {
         // already configured
         mqtt_config_fini(&plugin->config);
     }
     memmove(&plugin->config, &config, sizeof(config));
+    route_tbl_clear_tag_topics(plugin->route_tbl);
+
+    if (0 != (rv = setup_conns(plugin, &plugin->config, started))) {
+        plog_error(plugin, "config plugin `%s` connections fail", plugin_name);
+        return rv;
+    }
+
+    if (0 != (rv = setup_compress(plugin, &plugin->config))) {
+        plog_error(plugin, "config plugin `%s` compression fail", plugin_name);
+        return rv;
+    }
+
+    if (0 != (rv = setup_batch(plugin, &plugin->config))) {
+        plog_error(plugin, "config plugin `%s` batching fail", plugin_name);
+        return rv;
+    }
 
     plog_notice(plugin, "config plugin `%s` success", plugin_name);
     return 0;
@@ -294,6 +588,14 @@ static int mqtt_plugin_start(neu_plugin_t *plugin)
         goto end;
     }
 
+    for (size_t i = 1; i < plugin->n_conns; ++i) {
+        if (0 != neu_mqtt_client_open(plugin->conns[i].client)) {
+            plog_error(plugin, "neu_mqtt_client_open fail");
+            rv = NEU_ERR_MQTT_CONNECT_FAILURE;
+            goto end;
+        }
+    }
+
     rv = subscribe(plugin, &plugin->config);
 
 end:
@@ -302,6 +604,9 @@ end:
     } else {
         plog_error(plugin, "start plugin `%s` failed, error %d", plugin_name,
                    rv);
+        for (size_t i = 1; i < plugin->n_conns; ++i) {
+            neu_mqtt_client_close(plugin->conns[i].client);
+        }
         neu_mqtt_client_close(plugin->client);
     }
     return rv;
@@ -311,6 +616,10 @@ static int mqtt_plugin_stop(neu_plugin_t *plugin)
 {
     if (plugin->client) {
         unsubscribe(plugin, &plugin->config);
+        mqtt_batcher_flush(&plugin->batcher);
+        for (size_t i = 1; i < plugin->n_conns; ++i) {
+            neu_mqtt_client_close(plugin->conns[i].client);
+        }
         neu_mqtt_client_close(plugin->client);
         plog_notice(plugin, "mqtt client closed");
     }
@@ -320,21 +629,71 @@ static int mqtt_plugin_stop(neu_plugin_t *plugin)
     return NEU_ERR_SUCCESS;
 }
 
-static int mqtt_plugin_request(neu_plugin_t *plugin, neu_reqresp_head_t *head,
-                               void *data)
+static void update_cache_metrics(neu_plugin_t *plugin)
 {
-    neu_err_code_e error = NEU_ERR_SUCCESS;
+    neu_mqtt_client_cache_stats_t  stats;
+    neu_mqtt_client_cache_stats_t *last = &plugin->cache_stats;
+    int64_t elapsed = global_timestamp - plugin->cache_metric_update_ts;
+    int64_t eta     = 0;
 
     neu_adapter_update_metric_cb_t update_metric =
         plugin->common.adapter_callbacks->update_metric;
 
-    // update cached messages number per seconds
+    memset(&stats, 0, sizeof(stats));
+    for (size_t i = 0; i < plugin->n_conns; ++i) {
+        neu_mqtt_client_cache_stats_t s;
+        neu_mqtt_client_get_cache_stats(plugin->conns[i].client, &s);
+        stats.msgs += s.msgs;
+        stats.bytes += s.bytes;
+        stats.evicted += s.evicted;
+        stats.replayed_msgs += s.replayed_msgs;
+        stats.replayed_bytes += s.replayed_bytes;
+        if (plugin->conns[i].cached_msgs_metric) {
+            update_metric(plugin->common.adapter,
+                          plugin->conns[i].cached_msgs_metric, s.msgs, NULL);
+        }
+    }
+    if (stats.replayed_msgs < last->replayed_msgs ||
+        stats.evicted < last->evicted) {
+        // client recreated or cache reopened
+        memset(last, 0, sizeof(*last));
+    }
+
+    // estimate from the replay rate observed in the last period,
+    // or from the configured rate if stalled
+    uint64_t rate = (stats.replayed_bytes - last->replayed_bytes) * 1000 /
+        (elapsed > 0 ? elapsed : 1);
+    if (0 == rate && neu_mqtt_client_is_connected(plugin->client)) {
+        rate = plugin->config.replay_rate;
+    }
+    if (rate > 0) {
+        eta = (stats.bytes + rate - 1) / rate;
+    }
+
+    update_metric(plugin->common.adapter, NEU_METRIC_CACHED_MSGS_NUM,
+                  stats.msgs, NULL);
+    update_metric(plugin->common.adapter, NEU_METRIC_MQTT_REPLAY_BACKLOG_BYTES,
+                  stats.bytes, NULL);
+    update_metric(plugin->common.adapter, NEU_METRIC_MQTT_REPLAY_ETA_SECONDS,
+                  eta, NULL);
+    update_metric(plugin->common.adapter, NEU_METRIC_MQTT_REPLAYED_MSGS_TOTAL,
+                  stats.replayed_msgs - last->replayed_msgs, NULL);
+    update_metric(plugin->common.adapter, NEU_METRIC_MQTT_CACHE_EVICTED_TOTAL,
+                  stats.evicted - last->evicted, NULL);
+
+    *last                          = stats;
+    plugin->cache_metric_update_ts = global_timestamp;
+}
+
+static int mqtt_plugin_request(neu_plugin_t *plugin, neu_reqresp_head_t *head,
+                               void *data)
+{
+    neu_err_code_e error = NEU_ERR_SUCCESS;
+
+    // update cache metrics per seconds
     if (NULL != plugin->client &&
         (global_timestamp - plugin->cache_metric_update_ts) >= 1000) {
-        update_metric(plugin->common.adapter, NEU_METRIC_CACHED_MSGS_NUM,
-                      neu_mqtt_client_get_cached_msgs_num(plugin->client),
-                      NULL);
-        plugin->cache_metric_update_ts = global_timestamp;
+        update_cache_metrics(plugin);
     }
 
     switch (head->type) {
@@ -354,6 +713,7 @@ static int mqtt_plugin_request(neu_plugin_t *plugin, neu_reqresp_head_t *head,
         error = handle_unsubscribe_group(plugin, data);
         break;
     case NEU_REQRESP_NODE_DELETED:
+        error = handle_del_driver(plugin, data);
         break;
     case NEU_REQ_UPDATE_LICENSE:
         break;
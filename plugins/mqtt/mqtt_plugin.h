@@ -24,10 +24,95 @@
 extern "C" {
 #endif
 
+#include <pthread.h>
+
 #include "connection/mqtt_client.h"
+#include "event/event.h"
 #include "neuron.h"
+#include "utils/compress.h"
+#include "utils/msgpack.h"
+#include "json/json_writer.h"
 
+#include "mqtt_batch.h"
 #include "mqtt_config.h"
+#include "mqtt_topic.h"
+
+#define NEU_METRIC_MQTT_BATCHES_TOTAL "mqtt_batches_total"
+#define NEU_METRIC_MQTT_BATCHES_TOTAL_TYPE NEU_METRIC_TYPE_COUNTER
+#define NEU_METRIC_MQTT_BATCHES_TOTAL_HELP "Number of batched publishes"
+
+#define NEU_METRIC_MQTT_BATCH_FULL_TOTAL "mqtt_batch_full_total"
+#define NEU_METRIC_MQTT_BATCH_FULL_TOTAL_TYPE NEU_METRIC_TYPE_COUNTER
+#define NEU_METRIC_MQTT_BATCH_FULL_TOTAL_HELP \
+    "Number of batches published on reaching the size limit"
+
+#define NEU_METRIC_MQTT_BATCH_REPORTS_TOTAL "mqtt_batch_reports_total"
+#define NEU_METRIC_MQTT_BATCH_REPORTS_TOTAL_TYPE NEU_METRIC_TYPE_COUNTER
+#define NEU_METRIC_MQTT_BATCH_REPORTS_TOTAL_HELP \
+    "Number of group reports published in batches"
+
+#define NEU_METRIC_MQTT_BATCH_BYTES_TOTAL "mqtt_batch_bytes_total"
+#define NEU_METRIC_MQTT_BATCH_BYTES_TOTAL_TYPE NEU_METRIC_TYPE_COUNTER
+#define NEU_METRIC_MQTT_BATCH_BYTES_TOTAL_HELP \
+    "Total size of batched publishes in bytes"
+
+#define NEU_METRIC_MQTT_BATCH_REPORTS_LAST "mqtt_batch_reports_last"
+#define NEU_METRIC_MQTT_BATCH_REPORTS_LAST_TYPE NEU_METRIC_TYPE_GAUAGE
+#define NEU_METRIC_MQTT_BATCH_REPORTS_LAST_HELP \
+    "Number of group reports in the last batch"
+
+#define NEU_METRIC_MQTT_COMPRESS_IN_BYTES_TOTAL "mqtt_compress_in_bytes_total"
+#define NEU_METRIC_MQTT_COMPRESS_IN_BYTES_TOTAL_TYPE NEU_METRIC_TYPE_COUNTER
+#define NEU_METRIC_MQTT_COMPRESS_IN_BYTES_TOTAL_HELP \
+    "Total size of upload payloads before compression in bytes"
+
+#define NEU_METRIC_MQTT_COMPRESS_OUT_BYTES_TOTAL \
+    "mqtt_compress_out_bytes_total"
+#define NEU_METRIC_MQTT_COMPRESS_OUT_BYTES_TOTAL_TYPE NEU_METRIC_TYPE_COUNTER
+#define NEU_METRIC_MQTT_COMPRESS_OUT_BYTES_TOTAL_HELP \
+    "Total size of upload payloads after compression in bytes"
+
+#define NEU_METRIC_MQTT_REPLAY_BACKLOG_BYTES "mqtt_replay_backlog_bytes"
+#define NEU_METRIC_MQTT_REPLAY_BACKLOG_BYTES_TYPE NEU_METRIC_TYPE_GAUAGE
+#define NEU_METRIC_MQTT_REPLAY_BACKLOG_BYTES_HELP \
+    "Size of cached payloads waiting for replay in bytes"
+
+#define NEU_METRIC_MQTT_REPLAY_ETA_SECONDS "mqtt_replay_eta_seconds"
+#define NEU_METRIC_MQTT_REPLAY_ETA_SECONDS_TYPE NEU_METRIC_TYPE_GAUAGE
+#define NEU_METRIC_MQTT_REPLAY_ETA_SECONDS_HELP \
+    "Estimated time to replay the cached messages in seconds, 0 if unknown"
+
+#define NEU_METRIC_MQTT_REPLAYED_MSGS_TOTAL "mqtt_replayed_msgs_total"
+#define NEU_METRIC_MQTT_REPLAYED_MSGS_TOTAL_TYPE NEU_METRIC_TYPE_COUNTER
+#define NEU_METRIC_MQTT_REPLAYED_MSGS_TOTAL_HELP \
+    "Number of cached messages replayed"
+
+#define NEU_METRIC_MQTT_CACHE_EVICTED_TOTAL "mqtt_cache_evicted_total"
+#define NEU_METRIC_MQTT_CACHE_EVICTED_TOTAL_TYPE NEU_METRIC_TYPE_COUNTER
+#define NEU_METRIC_MQTT_CACHE_EVICTED_TOTAL_HELP \
+    "Number of cached messages dropped as the cache was full"
+
+// per connection metrics, registered as mqtt_conn<index>_<suffix>
+// when there are several connections
+#define NEU_METRIC_MQTT_CONN_SEND_MSGS_TOTAL_TYPE NEU_METRIC_TYPE_COUNTER
+#define NEU_METRIC_MQTT_CONN_SEND_MSGS_TOTAL_HELP \
+    "Number of messages sent on the connection"
+
+#define NEU_METRIC_MQTT_CONN_SEND_MSG_ERRORS_TOTAL_TYPE NEU_METRIC_TYPE_COUNTER
+#define NEU_METRIC_MQTT_CONN_SEND_MSG_ERRORS_TOTAL_HELP \
+    "Number of messages failed to send on the connection"
+
+#define NEU_METRIC_MQTT_CONN_CACHED_MSGS_TYPE NEU_METRIC_TYPE_GAUAGE
+#define NEU_METRIC_MQTT_CONN_CACHED_MSGS_HELP \
+    "Number of messages cached for the connection"
+
+typedef struct {
+    neu_plugin_t *     plugin;
+    neu_mqtt_client_t *client; // the first one is neu_plugin.client
+    const char *       send_msgs_metric;       // NULL for a single connection
+    const char *       send_msg_errors_metric; // NULL for a single connection
+    const char *       cached_msgs_metric;     // NULL for a single connection
+} mqtt_conn_t;
 
 typedef struct {
     char driver[NEU_NODE_NAME_LEN];
@@ -37,24 +122,36 @@ typedef struct {
 typedef struct {
     route_key_t key;
 
-    char *topic;
+    char *            topic; // NULL if the group is only uploaded per tag
+    mqtt_tag_topics_t tag_topics;
 
     UT_hash_handle hh;
 } route_entry_t;
 
 struct neu_plugin {
-    neu_plugin_common_t common;
-    mqtt_config_t       config;
-    neu_mqtt_client_t * client;
-    int64_t             cache_metric_update_ts;
-    char *              read_req_topic;
-    char *              read_resp_topic;
-    route_entry_t *     route_tbl;
+    neu_plugin_common_t           common;
+    mqtt_config_t                 config;
+    neu_mqtt_client_t *           client;
+    int64_t                       cache_metric_update_ts;
+    neu_mqtt_client_cache_stats_t cache_stats; // at the last metric update
+    char *                        read_req_topic;
+    char *                        read_resp_topic;
+    route_entry_t *               route_tbl;
+    neu_json_writer_t             json_writer;
+    neu_msgpack_writer_t          msgpack_writer;
+    mqtt_batcher_t                batcher;
+    neu_events_t *                events;
+    neu_event_timer_t *           batch_timer;
+    neu_deflate_t *               deflate; // NULL if compression is disabled
+    pthread_mutex_t               deflate_mtx; // batch timer compresses too
+    mqtt_conn_t                   conns[MQTT_CONNECTIONS_MAX];
+    size_t                        n_conns;
 };
 
 static inline void route_entry_free(route_entry_t *e)
 {
     free(e->topic);
+    mqtt_tag_topics_fini(&e->tag_topics);
     free(e);
 }
 
@@ -118,6 +215,26 @@ static inline void route_tbl_del(route_entry_t **tbl, const char *driver,
     }
 }
 
+static inline void route_tbl_del_driver(route_entry_t **tbl,
+                                        const char *    driver)
+{
+    route_entry_t *e = NULL, *tmp = NULL;
+    HASH_ITER(hh, *tbl, e, tmp)
+    {
+        if (0 == strcmp(e->key.driver, driver)) {
+            HASH_DEL(*tbl, e);
+            route_entry_free(e);
+        }
+    }
+}
+
+// forget the tag topics expanded on use, of tags that may be gone
+static inline void route_tbl_clear_tag_topics(route_entry_t *tbl)
+{
+    route_entry_t *e = NULL, *tmp = NULL;
+    HASH_ITER(hh, tbl, e, tmp) { mqtt_tag_topics_clear(&e->tag_topics); }
+}
+
 #ifdef __cplusplus
 }
 #endif
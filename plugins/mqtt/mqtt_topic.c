@@ -0,0 +1,207 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "mqtt_topic.h"
+
+typedef struct {
+    const char *name;
+    size_t      len;
+    const char *value;
+} placeholder_t;
+
+char *mqtt_topic_expand(const char *tmpl, const char *app, const char *node,
+                        const char *group, const char *tag)
+{
+    placeholder_t ph[] = {
+        { "{app}", 5, app },
+        { "{node}", 6, node },
+        { "{group}", 7, group },
+        { "{tag}", 5, tag },
+    };
+    size_t n   = sizeof(ph) / sizeof(ph[0]);
+    size_t len = 0;
+
+    // compute the length first, to allocate once
+    for (const char *p = tmpl; *p;) {
+        size_t i = 0;
+        for (; i < n; ++i) {
+            if (ph[i].value && 0 == strncmp(p, ph[i].name, ph[i].len)) {
+                len += strlen(ph[i].value);
+                p += ph[i].len;
+                break;
+            }
+        }
+        if (i == n) {
+            ++len;
+            ++p;
+        }
+    }
+
+    char *topic = malloc(len + 1);
+    char *out   = topic;
+    if (NULL == topic) {
+        return NULL;
+    }
+
+    for (const char *p = tmpl; *p;) {
+        size_t i = 0;
+        for (; i < n; ++i) {
+            if (ph[i].value && 0 == strncmp(p, ph[i].name, ph[i].len)) {
+                size_t l = strlen(ph[i].value);
+                memcpy(out, ph[i].value, l);
+                out += l;
+                p += ph[i].len;
+                break;
+            }
+        }
+        if (i == n) {
+            *out++ = *p++;
+        }
+    }
+    *out = '\0';
+
+    return topic;
+}
+
+static mqtt_tag_topic_t *tag_topic_add(mqtt_tag_topics_t *topics,
+                                       const char *       tag)
+{
+    mqtt_tag_topic_t *t = calloc(1, sizeof(*t));
+    if (NULL == t) {
+        return NULL;
+    }
+
+    t->tag   = strdup(tag);
+    t->topic = mqtt_topic_expand(topics->tmpl, NULL, NULL, NULL, tag);
+    if (NULL == t->tag || NULL == t->topic) {
+        free(t->tag);
+        free(t->topic);
+        free(t);
+        return NULL;
+    }
+
+    HASH_ADD_STR(topics->tbl, tag, t);
+    return t;
+}
+
+int mqtt_tag_topics_init(mqtt_tag_topics_t *topics, char *tmpl,
+                         char *const *tags, size_t n_tag)
+{
+    topics->tmpl    = tmpl;
+    topics->any_tag = 0 == n_tag;
+    topics->epoch   = 0;
+    topics->limit   = MQTT_TAG_TOPICS_MIN;
+    topics->tbl     = NULL;
+
+    for (size_t i = 0; i < n_tag; ++i) {
+        mqtt_tag_topic_t *t = NULL;
+        HASH_FIND_STR(topics->tbl, tags[i], t);
+        if (NULL == t && NULL == tag_topic_add(topics, tags[i])) {
+            mqtt_tag_topics_fini(topics);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static void tag_topic_free(mqtt_tag_topic_t *t)
+{
+    free(t->tag);
+    free(t->topic);
+    free(t);
+}
+
+static void tag_topics_free(mqtt_tag_topics_t *topics)
+{
+    mqtt_tag_topic_t *t = NULL, *tmp = NULL;
+
+    HASH_ITER(hh, topics->tbl, t, tmp)
+    {
+        HASH_DEL(topics->tbl, t);
+        tag_topic_free(t);
+    }
+}
+
+void mqtt_tag_topics_fini(mqtt_tag_topics_t *topics)
+{
+    tag_topics_free(topics);
+    free(topics->tmpl);
+    topics->tmpl = NULL;
+}
+
+void mqtt_tag_topics_clear(mqtt_tag_topics_t *topics)
+{
+    // listed tags keep their topics for as long as the subscription
+    if (topics->any_tag) {
+        tag_topics_free(topics);
+        topics->limit = MQTT_TAG_TOPICS_MIN;
+    }
+}
+
+void mqtt_tag_topics_next(mqtt_tag_topics_t *topics)
+{
+    topics->epoch += 1;
+}
+
+// drop the topics used neither in this report nor in the previous one
+static void tag_topics_drop_unused(mqtt_tag_topics_t *topics)
+{
+    mqtt_tag_topic_t *t = NULL, *tmp = NULL;
+
+    HASH_ITER(hh, topics->tbl, t, tmp)
+    {
+        if (topics->epoch - t->epoch > 1) {
+            HASH_DEL(topics->tbl, t);
+            tag_topic_free(t);
+        }
+    }
+
+    // room for as many new tags as are in use, amortizing the drops
+    size_t n      = HASH_COUNT(topics->tbl);
+    topics->limit = n < MQTT_TAG_TOPICS_MIN / 2 ? MQTT_TAG_TOPICS_MIN : 2 * n;
+}
+
+const char *mqtt_tag_topics_get(mqtt_tag_topics_t *topics, const char *tag)
+{
+    mqtt_tag_topic_t *t = NULL;
+
+    if (NULL == topics->tmpl) {
+        return NULL;
+    }
+
+    HASH_FIND_STR(topics->tbl, tag, t);
+    if (NULL == t && topics->any_tag) {
+        // expanded once, the tags of a group hardly change
+        if (HASH_COUNT(topics->tbl) >= topics->limit) {
+            tag_topics_drop_unused(topics);
+        }
+        t = tag_topic_add(topics, tag);
+    }
+
+    if (NULL == t) {
+        return NULL;
+    }
+
+    t->epoch = topics->epoch;
+    return t->topic;
+}
@@ -0,0 +1,104 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#ifndef NEURON_PLUGIN_MQTT_TOPIC_H
+#define NEURON_PLUGIN_MQTT_TOPIC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils/uthash.h"
+
+/**
+ * Upload topic templates.
+ *
+ * The placeholders `{app}`, `{node}`, `{group}` and `{tag}` are replaced by
+ * the app node name, the driver node name, the group name and the tag name.
+ * Templates are expanded once when a group is subscribed, per tag topics
+ * once for each tag, never per message.
+ */
+
+/**
+ * @brief Expand the placeholders of which the value is not NULL, the others
+ *        are kept as they are.
+ *
+ * @return the expanded topic, or NULL on allocation failure.
+ */
+char *mqtt_topic_expand(const char *tmpl, const char *app, const char *node,
+                        const char *group, const char *tag);
+
+static inline bool mqtt_topic_has_tag(const char *tmpl)
+{
+    return NULL != tmpl && NULL != strstr(tmpl, "{tag}");
+}
+
+// any tag topics kept at least, before the unused ones are dropped
+#define MQTT_TAG_TOPICS_MIN 64
+
+typedef struct {
+    char *         tag;
+    char *         topic;
+    uint32_t       epoch; // report last used in, for any tag topics
+    UT_hash_handle hh;
+} mqtt_tag_topic_t;
+
+typedef struct {
+    char *            tmpl;    // only `{tag}` left to expand
+    bool              any_tag; // topics for any tag, or only for the listed
+    uint32_t          epoch;   // bumped for each report
+    size_t            limit;   // any tag topics kept before dropping
+    mqtt_tag_topic_t *tbl;
+} mqtt_tag_topics_t;
+
+/**
+ * @brief Set up per tag topics, pre-expanded for the `n_tag` listed tags,
+ *        or expanded for any tag on first use if none is listed.
+ *
+ * @note Takes ownership of `tmpl`.
+ */
+int  mqtt_tag_topics_init(mqtt_tag_topics_t *topics, char *tmpl,
+                          char *const *tags, size_t n_tag);
+void mqtt_tag_topics_fini(mqtt_tag_topics_t *topics);
+
+// start a new report, before getting the topics of its tags
+void mqtt_tag_topics_next(mqtt_tag_topics_t *topics);
+
+// drop the topics expanded on first use, they are expanded again when used
+void mqtt_tag_topics_clear(mqtt_tag_topics_t *topics);
+
+/**
+ * @brief Get the topic of `tag`, NULL if it has none.
+ *
+ * @note Topics for any tag are expanded on first use. Once `limit` of them
+ *       are kept, those used neither in this report nor in the previous one
+ *       are dropped, so that the topics of deleted tags do not pile up.
+ */
+const char *mqtt_tag_topics_get(mqtt_tag_topics_t *topics, const char *tag);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
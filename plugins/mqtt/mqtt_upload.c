@@ -0,0 +1,47 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#include "mqtt_upload.h"
+
+int mqtt_encode_upload_json(neu_json_writer_t *       w,
+                            neu_reqresp_trans_data_t *data,
+                            mqtt_upload_format_e      format)
+{
+    if (MQTT_UPLOAD_FORMAT_VALUES != format &&
+        MQTT_UPLOAD_FORMAT_TAGS != format) {
+        return -1;
+    }
+
+    neu_json_writer_reset(w);
+    neu_json_writer_object_begin(w);
+    neu_json_writer_key(w, "node");
+    neu_json_writer_str_value(w, data->driver);
+    neu_json_writer_key(w, "group");
+    neu_json_writer_str_value(w, data->group);
+    neu_json_writer_key(w, "timestamp");
+    neu_json_writer_int(w, global_timestamp);
+    if (MQTT_UPLOAD_FORMAT_VALUES == format) { // values
+        neu_json_writer_tags_values(w, data->tags, data->n_tag);
+    } else { // tags
+        neu_json_writer_tags_array(w, data->tags, data->n_tag);
+    }
+    neu_json_writer_object_end(w);
+
+    return NULL == neu_json_writer_str(w) ? -1 : 0;
+}
@@ -0,0 +1,48 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#ifndef NEURON_PLUGIN_MQTT_UPLOAD_H
+#define NEURON_PLUGIN_MQTT_UPLOAD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "neuron.h"
+#include "json/json_writer.h"
+
+#include "mqtt_config.h"
+
+// {
+//    "node": "node0",
+//    "group": "grp0",
+//    "timestamp": 1649776722631,
+//    "values": { "tag0": 0 },
+//    "errors": { "tag1": 3000 }
+// }
+// or the tags format, the buffer is kept by the writer
+int mqtt_encode_upload_json(neu_json_writer_t *       w,
+                            neu_reqresp_trans_data_t *data,
+                            mqtt_upload_format_e      format);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,426 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#include <time.h>
+
+#include "errcodes.h"
+#include "utils/time.h"
+#include "json/json_writer.h"
+#include "json/neu_json_param.h"
+
+#include "json_rw.h"
+#include "mqtt_upload.h"
+#include "probe_plugin.h"
+
+#define PROBE_DEFAULT_GAP_THRESHOLD 3000
+#define PROBE_WINDOW_MS 1000
+
+#define REGISTER_METRIC(plugin, name, init)                  \
+    (plugin)->common.adapter_callbacks->register_metric(     \
+        (plugin)->common.adapter, name, name##_HELP, name##_TYPE, init)
+
+#define UPDATE_METRIC(plugin, name, n)                 \
+    (plugin)->common.adapter_callbacks->update_metric( \
+        (plugin)->common.adapter, name, n, NULL)
+
+const neu_plugin_module_t neu_plugin_module;
+
+static inline int64_t monotonic_us()
+{
+    struct timespec ts = { 0 };
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static neu_plugin_t *probe_plugin_open(void)
+{
+    neu_plugin_t *plugin = calloc(1, sizeof(neu_plugin_t));
+
+    neu_plugin_common_init(&plugin->common);
+    neu_json_writer_init(&plugin->json_writer, 0);
+    plugin->gap_threshold = PROBE_DEFAULT_GAP_THRESHOLD;
+
+    return plugin;
+}
+
+static int probe_plugin_close(neu_plugin_t *plugin)
+{
+    neu_json_writer_fini(&plugin->json_writer);
+    free(plugin);
+    zlog_notice(neuron, "success to free plugin: %s",
+                neu_plugin_module.module_name);
+    return NEU_ERR_SUCCESS;
+}
+
+static int probe_plugin_init(neu_plugin_t *plugin)
+{
+    REGISTER_METRIC(plugin, NEU_METRIC_PROBE_LATENCY_LAST_MS, 0);
+    REGISTER_METRIC(plugin, NEU_METRIC_PROBE_LATENCY_AVG_MS, 0);
+    REGISTER_METRIC(plugin, NEU_METRIC_PROBE_LATENCY_MAX_MS, 0);
+    REGISTER_METRIC(plugin, NEU_METRIC_PROBE_MSGS_PER_SEC, 0);
+    REGISTER_METRIC(plugin, NEU_METRIC_PROBE_TAGS_PER_SEC, 0);
+    REGISTER_METRIC(plugin, NEU_METRIC_PROBE_TAGS_TOTAL, 0);
+    REGISTER_METRIC(plugin, NEU_METRIC_PROBE_TAG_ERRORS_TOTAL, 0);
+    REGISTER_METRIC(plugin, NEU_METRIC_PROBE_GAPS_TOTAL, 0);
+    REGISTER_METRIC(plugin, NEU_METRIC_PROBE_MAX_GAP_MS, 0);
+    REGISTER_METRIC(plugin, NEU_METRIC_PROBE_ENCODE_AVG_US, 0);
+    REGISTER_METRIC(plugin, NEU_METRIC_PROBE_ENCODE_BYTES_TOTAL, 0);
+
+    plog_notice(plugin, "plugin initialized");
+    return NEU_ERR_SUCCESS;
+}
+
+static int probe_plugin_uninit(neu_plugin_t *plugin)
+{
+    probe_group_t *g = NULL, *tmp = NULL;
+    HASH_ITER(hh, plugin->groups, g, tmp)
+    {
+        HASH_DEL(plugin->groups, g);
+        free(g);
+    }
+
+    plog_notice(plugin, "plugin uninitialized");
+    return NEU_ERR_SUCCESS;
+}
+
+static int probe_plugin_start(neu_plugin_t *plugin)
+{
+    memset(&plugin->window, 0, sizeof(plugin->window));
+    plugin->window.start      = neu_time_ms();
+    plugin->started           = true;
+    plugin->common.link_state = NEU_NODE_LINK_STATE_CONNECTED;
+    plog_notice(plugin, "start successfully");
+    return NEU_ERR_SUCCESS;
+}
+
+static int probe_plugin_stop(neu_plugin_t *plugin)
+{
+    plugin->started           = false;
+    plugin->common.link_state = NEU_NODE_LINK_STATE_DISCONNECTED;
+    plog_notice(plugin, "stop successfully");
+    return NEU_ERR_SUCCESS;
+}
+
+static int probe_plugin_config(neu_plugin_t *plugin, const char *setting)
+{
+    char *          err_param = NULL;
+    neu_json_elem_t mode      = {
+        .name      = "mode",
+        .t         = NEU_JSON_INT,
+        .v.val_int = PROBE_MODE_DECODE,
+        .attribute = NEU_JSON_ATTRIBUTE_OPTIONAL,
+    };
+    neu_json_elem_t gap_threshold = {
+        .name      = "gap-threshold",
+        .t         = NEU_JSON_INT,
+        .v.val_int = PROBE_DEFAULT_GAP_THRESHOLD,
+        .attribute = NEU_JSON_ATTRIBUTE_OPTIONAL,
+    };
+
+    if (0 != neu_parse_param(setting, &err_param, 2, &mode, &gap_threshold)) {
+        plog_error(plugin, "parsing setting fail, key: `%s`", err_param);
+        free(err_param);
+        return NEU_ERR_NODE_SETTING_INVALID;
+    }
+
+    if (mode.v.val_int < PROBE_MODE_DECODE ||
+        PROBE_MODE_EKUIPER_JSON < mode.v.val_int) {
+        plog_error(plugin, "setting invalid mode: %" PRIi64, mode.v.val_int);
+        return NEU_ERR_NODE_SETTING_INVALID;
+    }
+
+    if (gap_threshold.v.val_int < 0) {
+        plog_error(plugin, "setting invalid gap-threshold: %" PRIi64,
+                   gap_threshold.v.val_int);
+        return NEU_ERR_NODE_SETTING_INVALID;
+    }
+
+    plugin->mode          = mode.v.val_int;
+    plugin->gap_threshold = gap_threshold.v.val_int;
+
+    plog_notice(plugin, "config mode:%d gap-threshold:%" PRIi64, plugin->mode,
+                plugin->gap_threshold);
+    return NEU_ERR_SUCCESS;
+}
+
+static probe_group_t *find_group(neu_plugin_t *plugin, const char *driver,
+                                 const char *group)
+{
+    probe_group_t *find = NULL;
+    probe_key_t    key  = { 0 };
+
+    strncpy(key.driver, driver, sizeof(key.driver));
+    strncpy(key.group, group, sizeof(key.group));
+
+    HASH_FIND(hh, plugin->groups, &key, sizeof(key), find);
+    return find;
+}
+
+static int handle_subscribe(neu_plugin_t *plugin, neu_req_subscribe_t *sub)
+{
+    probe_group_t *g = find_group(plugin, sub->driver, sub->group);
+
+    free(sub->params);
+
+    if (NULL != g) {
+        return NEU_ERR_GROUP_ALREADY_SUBSCRIBED;
+    }
+
+    g = calloc(1, sizeof(*g));
+    if (NULL == g) {
+        return NEU_ERR_EINTERNAL;
+    }
+
+    strncpy(g->key.driver, sub->driver, sizeof(g->key.driver));
+    strncpy(g->key.group, sub->group, sizeof(g->key.group));
+    HASH_ADD(hh, plugin->groups, key, sizeof(g->key), g);
+
+    plog_notice(plugin, "probe driver:%s group:%s", sub->driver, sub->group);
+    return NEU_ERR_SUCCESS;
+}
+
+// the groups of a deleted driver are unsubscribed without a request
+static int handle_del_driver(neu_plugin_t *                    plugin,
+                             const neu_reqresp_node_deleted_t *req)
+{
+    probe_group_t *g = NULL, *tmp = NULL;
+
+    HASH_ITER(hh, plugin->groups, g, tmp)
+    {
+        if (0 == strcmp(g->key.driver, req->node)) {
+            HASH_DEL(plugin->groups, g);
+            free(g);
+        }
+    }
+
+    plog_notice(plugin, "unprobe driver:%s", req->node);
+    return NEU_ERR_SUCCESS;
+}
+
+static int handle_unsubscribe(neu_plugin_t *plugin, neu_req_unsubscribe_t *sub)
+{
+    probe_group_t *g = find_group(plugin, sub->driver, sub->group);
+
+    if (NULL != g) {
+        HASH_DEL(plugin->groups, g);
+        free(g);
+    }
+
+    plog_notice(plugin, "unprobe driver:%s group:%s", sub->driver,
+                sub->group);
+    return NEU_ERR_SUCCESS;
+}
+
+// the MQTT plugin encoder, the buffer kept for the next message
+static void encode_mqtt(neu_plugin_t *plugin, neu_reqresp_trans_data_t *data,
+                        size_t *len)
+{
+    neu_json_writer_t *  w      = &plugin->json_writer;
+    mqtt_upload_format_e format = PROBE_MODE_MQTT_VALUES == plugin->mode
+        ? MQTT_UPLOAD_FORMAT_VALUES
+        : MQTT_UPLOAD_FORMAT_TAGS;
+
+    if (0 == mqtt_encode_upload_json(w, data, format)) {
+        *len = neu_json_writer_len(w);
+    }
+}
+
+// same layout and buffer handling as the eKuiper plugin
+static void encode_ekuiper(neu_plugin_t *            plugin,
+                           neu_reqresp_trans_data_t *data, size_t *len)
+{
+    json_encode_read_resp(&plugin->json_writer, data);
+    *len = neu_json_writer_len(&plugin->json_writer);
+}
+
+// run the northbound encoder selected by `mode`, but never send the result
+static void encode(neu_plugin_t *plugin, neu_reqresp_trans_data_t *trans_data)
+{
+    size_t  len   = 0;
+    int64_t spend = monotonic_us();
+
+    switch (plugin->mode) {
+    case PROBE_MODE_MQTT_VALUES:
+    case PROBE_MODE_MQTT_TAGS:
+        encode_mqtt(plugin, trans_data, &len);
+        break;
+    case PROBE_MODE_EKUIPER_JSON:
+        encode_ekuiper(plugin, trans_data, &len);
+        break;
+    case PROBE_MODE_DECODE:
+    default:
+        return;
+    }
+
+    spend = monotonic_us() - spend;
+    plugin->window.encode_us_sum += spend;
+
+    if (plugin->json_writer.error) {
+        plog_error(plugin, "encode driver:%s group:%s fail",
+                   trans_data->driver, trans_data->group);
+        UPDATE_METRIC(plugin, NEU_METRIC_SEND_MSG_ERRORS_TOTAL, 1);
+        return;
+    }
+
+    UPDATE_METRIC(plugin, NEU_METRIC_PROBE_ENCODE_BYTES_TOTAL, len);
+    UPDATE_METRIC(plugin, NEU_METRIC_SEND_MSGS_TOTAL, 1);
+}
+
+static void flush_window(neu_plugin_t *plugin, int64_t now)
+{
+    probe_window_t *w       = &plugin->window;
+    int64_t         elapsed = now - w->start;
+
+    if (elapsed < PROBE_WINDOW_MS) {
+        return;
+    }
+
+    UPDATE_METRIC(plugin, NEU_METRIC_PROBE_MSGS_PER_SEC,
+                  w->msgs * 1000 / elapsed);
+    UPDATE_METRIC(plugin, NEU_METRIC_PROBE_TAGS_PER_SEC,
+                  w->tags * 1000 / elapsed);
+    UPDATE_METRIC(plugin, NEU_METRIC_PROBE_LATENCY_AVG_MS,
+                  w->latency_msgs ? w->latency_sum / w->latency_msgs : 0);
+    UPDATE_METRIC(plugin, NEU_METRIC_PROBE_LATENCY_MAX_MS, w->latency_max);
+    UPDATE_METRIC(plugin, NEU_METRIC_PROBE_MAX_GAP_MS, w->max_gap);
+    UPDATE_METRIC(plugin, NEU_METRIC_PROBE_ENCODE_AVG_US,
+                  w->msgs ? w->encode_us_sum / w->msgs : 0);
+
+    memset(w, 0, sizeof(*w));
+    w->start = now;
+}
+
+static int handle_trans_data(neu_plugin_t *            plugin,
+                             neu_reqresp_trans_data_t *trans_data)
+{
+    int64_t         now    = neu_time_ms();
+    probe_window_t *w      = &plugin->window;
+    uint64_t        errors = 0;
+
+    if (!plugin->started) {
+        return NEU_ERR_SUCCESS;
+    }
+
+    // a trans data with no fresh value carries no timestamp
+    if (trans_data->timestamp > 0) {
+        uint64_t latency = 0;
+        if (now > trans_data->timestamp) {
+            latency = now - trans_data->timestamp;
+        }
+        UPDATE_METRIC(plugin, NEU_METRIC_PROBE_LATENCY_LAST_MS, latency);
+        w->latency_sum += latency;
+        w->latency_msgs += 1;
+        if (latency > w->latency_max) {
+            w->latency_max = latency;
+        }
+    }
+
+    probe_group_t *g =
+        find_group(plugin, trans_data->driver, trans_data->group);
+    if (NULL != g) {
+        if (g->last_arrival > 0) {
+            uint64_t gap = now - g->last_arrival;
+            if (gap > w->max_gap) {
+                w->max_gap = gap;
+            }
+            if (plugin->gap_threshold > 0 &&
+                gap > (uint64_t) plugin->gap_threshold) {
+                UPDATE_METRIC(plugin, NEU_METRIC_PROBE_GAPS_TOTAL, 1);
+                plog_info(plugin, "driver:%s group:%s gap %" PRIu64 "ms",
+                          trans_data->driver, trans_data->group, gap);
+            }
+        }
+        g->last_arrival = now;
+    }
+
+    for (uint32_t i = 0; i < trans_data->n_tag; i++) {
+        if (NEU_TYPE_ERROR == trans_data->tags[i].value.type) {
+            errors += 1;
+        }
+    }
+
+    w->msgs += 1;
+    w->tags += trans_data->n_tag;
+    UPDATE_METRIC(plugin, NEU_METRIC_RECV_MSGS_TOTAL, 1);
+    UPDATE_METRIC(plugin, NEU_METRIC_PROBE_TAGS_TOTAL, trans_data->n_tag);
+    UPDATE_METRIC(plugin, NEU_METRIC_PROBE_TAG_ERRORS_TOTAL, errors);
+
+    encode(plugin, trans_data);
+    flush_window(plugin, now);
+
+    return NEU_ERR_SUCCESS;
+}
+
+static int probe_plugin_request(neu_plugin_t *plugin, neu_reqresp_head_t *head,
+                                void *data)
+{
+    int error = NEU_ERR_SUCCESS;
+
+    switch (head->type) {
+    case NEU_RESP_ERROR:
+        break;
+    case NEU_REQRESP_TRANS_DATA:
+        error = handle_trans_data(plugin, data);
+        break;
+    case NEU_REQ_SUBSCRIBE_GROUP:
+        error = handle_subscribe(plugin, data);
+        break;
+    case NEU_REQ_UNSUBSCRIBE_GROUP:
+        error = handle_unsubscribe(plugin, data);
+        break;
+    case NEU_REQRESP_NODE_DELETED:
+        error = handle_del_driver(plugin, data);
+        break;
+    case NEU_REQ_UPDATE_LICENSE:
+        break;
+    default:
+        plog_warn(plugin, "unsupported request type: %d", head->type);
+        break;
+    }
+
+    return error;
+}
+
+static const neu_plugin_intf_funs_t plugin_intf_funs = {
+    .open    = probe_plugin_open,
+    .close   = probe_plugin_close,
+    .init    = probe_plugin_init,
+    .uninit  = probe_plugin_uninit,
+    .start   = probe_plugin_start,
+    .stop    = probe_plugin_stop,
+    .setting = probe_plugin_config,
+    .request = probe_plugin_request,
+};
+
+#define DESCRIPTION \
+    "Northbound sink measuring latency, throughput and encoding cost."
+#define DESCRIPTION_ZH "测量北向时延、吞吐量和编码开销的数据接收插件"
+
+const neu_plugin_module_t neu_plugin_module = {
+    .version         = NEURON_PLUGIN_VER_1_0,
+    .schema          = "probe",
+    .module_name     = "Probe",
+    .module_descr    = DESCRIPTION,
+    .module_descr_zh = DESCRIPTION_ZH,
+    .intf_funs       = &plugin_intf_funs,
+    .kind            = NEU_PLUGIN_KIND_SYSTEM,
+    .type            = NEU_NA_TYPE_APP,
+    .display         = true,
+    .single          = false,
+};
@@ -0,0 +1,131 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#ifndef NEURON_PLUGIN_PROBE_H
+#define NEURON_PLUGIN_PROBE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "neuron.h"
+#include "json/json_writer.h"
+
+// latency between the latest cache update and arrival at the probe
+#define NEU_METRIC_PROBE_LATENCY_LAST_MS "probe_latency_last_ms"
+#define NEU_METRIC_PROBE_LATENCY_LAST_MS_TYPE NEU_METRIC_TYPE_GAUAGE
+#define NEU_METRIC_PROBE_LATENCY_LAST_MS_HELP \
+    "Latency in milliseconds of the last message received"
+
+#define NEU_METRIC_PROBE_LATENCY_AVG_MS "probe_latency_avg_ms"
+#define NEU_METRIC_PROBE_LATENCY_AVG_MS_TYPE NEU_METRIC_TYPE_GAUAGE
+#define NEU_METRIC_PROBE_LATENCY_AVG_MS_HELP \
+    "Average message latency in milliseconds over the last second"
+
+#define NEU_METRIC_PROBE_LATENCY_MAX_MS "probe_latency_max_ms"
+#define NEU_METRIC_PROBE_LATENCY_MAX_MS_TYPE NEU_METRIC_TYPE_GAUAGE
+#define NEU_METRIC_PROBE_LATENCY_MAX_MS_HELP \
+    "Maximum message latency in milliseconds over the last second"
+
+#define NEU_METRIC_PROBE_MSGS_PER_SEC "probe_msgs_per_sec"
+#define NEU_METRIC_PROBE_MSGS_PER_SEC_TYPE NEU_METRIC_TYPE_GAUAGE
+#define NEU_METRIC_PROBE_MSGS_PER_SEC_HELP \
+    "Number of messages received over the last second"
+
+#define NEU_METRIC_PROBE_TAGS_PER_SEC "probe_tags_per_sec"
+#define NEU_METRIC_PROBE_TAGS_PER_SEC_TYPE NEU_METRIC_TYPE_GAUAGE
+#define NEU_METRIC_PROBE_TAGS_PER_SEC_HELP \
+    "Number of tag values received over the last second"
+
+#define NEU_METRIC_PROBE_TAGS_TOTAL "probe_tags_total"
+#define NEU_METRIC_PROBE_TAGS_TOTAL_TYPE NEU_METRIC_TYPE_COUNTER
+#define NEU_METRIC_PROBE_TAGS_TOTAL_HELP "Total number of tag values received"
+
+#define NEU_METRIC_PROBE_TAG_ERRORS_TOTAL "probe_tag_errors_total"
+#define NEU_METRIC_PROBE_TAG_ERRORS_TOTAL_TYPE NEU_METRIC_TYPE_COUNTER
+#define NEU_METRIC_PROBE_TAG_ERRORS_TOTAL_HELP \
+    "Total number of tag values received carrying an error code"
+
+// a gap is an arrival interval of a group exceeding `gap-threshold`
+#define NEU_METRIC_PROBE_GAPS_TOTAL "probe_gaps_total"
+#define NEU_METRIC_PROBE_GAPS_TOTAL_TYPE NEU_METRIC_TYPE_COUNTER
+#define NEU_METRIC_PROBE_GAPS_TOTAL_HELP \
+    "Total number of gaps between consecutive messages of a group"
+
+#define NEU_METRIC_PROBE_MAX_GAP_MS "probe_max_gap_ms"
+#define NEU_METRIC_PROBE_MAX_GAP_MS_TYPE NEU_METRIC_TYPE_GAUAGE
+#define NEU_METRIC_PROBE_MAX_GAP_MS_HELP \
+    "Maximum message interval of a group over the last second"
+
+#define NEU_METRIC_PROBE_ENCODE_AVG_US "probe_encode_avg_us"
+#define NEU_METRIC_PROBE_ENCODE_AVG_US_TYPE NEU_METRIC_TYPE_GAUAGE
+#define NEU_METRIC_PROBE_ENCODE_AVG_US_HELP \
+    "Average encoding time per message in microseconds over the last second"
+
+#define NEU_METRIC_PROBE_ENCODE_BYTES_TOTAL "probe_encode_bytes_total"
+#define NEU_METRIC_PROBE_ENCODE_BYTES_TOTAL_TYPE NEU_METRIC_TYPE_COUNTER
+#define NEU_METRIC_PROBE_ENCODE_BYTES_TOTAL_HELP \
+    "Total number of bytes produced by the encoder"
+
+typedef enum {
+    PROBE_MODE_DECODE       = 0, // only walk the tag values
+    PROBE_MODE_MQTT_VALUES  = 1, // MQTT plugin values-format
+    PROBE_MODE_MQTT_TAGS    = 2, // MQTT plugin tags-format
+    PROBE_MODE_EKUIPER_JSON = 3, // eKuiper plugin JSON
+} probe_mode_e;
+
+typedef struct {
+    char driver[NEU_NODE_NAME_LEN];
+    char group[NEU_GROUP_NAME_LEN];
+} probe_key_t;
+
+// per subscribed group arrival state
+typedef struct {
+    probe_key_t    key;
+    int64_t        last_arrival;
+    UT_hash_handle hh;
+} probe_group_t;
+
+// statistics accumulated over one metric window
+typedef struct {
+    int64_t  start;
+    uint64_t msgs;
+    uint64_t tags;
+    uint64_t latency_msgs; // messages with a timestamp
+    uint64_t latency_sum;
+    uint64_t latency_max;
+    uint64_t max_gap;
+    uint64_t encode_us_sum;
+} probe_window_t;
+
+struct neu_plugin {
+    neu_plugin_common_t common;
+    probe_mode_e        mode;
+    int64_t             gap_threshold;
+    bool                started;
+    probe_group_t *     groups;
+    probe_window_t      window;
+    neu_json_writer_t   json_writer;
+};
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
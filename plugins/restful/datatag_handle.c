@@ -21,6 +21,7 @@
 #include "parser/neu_json_tag.h"
 #include "plugin.h"
 #include "utils/log.h"
+#include "json/json_writer.h"
 #include "json/neu_json_error.h"
 #include "json/neu_json_fn.h"
 
@@ -53,19 +54,25 @@ void handle_add_tags(nng_aio *aio)
                 cmd.n_tag = req->n_tag;
                 cmd.tags  = calloc(req->n_tag, sizeof(neu_datatag_t));
 
+                // take over the decoded strings instead of copying them,
+                // requests may carry a whole tag table
                 for (int i = 0; i < req->n_tag; i++) {
                     cmd.tags[i].attribute = req->tags[i].attribute;
                     cmd.tags[i].type      = req->tags[i].type;
                     cmd.tags[i].precision = req->tags[i].precision;
                     cmd.tags[i].decimal   = req->tags[i].decimal;
-                    cmd.tags[i].address   = strdup(req->tags[i].address);
-                    cmd.tags[i].name      = strdup(req->tags[i].name);
+                    cmd.tags[i].address   = req->tags[i].address;
+                    cmd.tags[i].name      = req->tags[i].name;
+                    req->tags[i].address  = NULL;
+                    req->tags[i].name     = NULL;
                     if (req->tags[i].description != NULL) {
-                        cmd.tags[i].description =
-                            strdup(req->tags[i].description);
+                        cmd.tags[i].description  = req->tags[i].description;
+                        req->tags[i].description = NULL;
                     } else {
                         cmd.tags[i].description = strdup("");
                     }
+                    neu_json_tag_get_report(&req->tags[i],
+                                            &cmd.tags[i].report);
                     if (NEU_ATTRIBUTE_STATIC & req->tags[i].attribute) {
                         neu_tag_set_static_value_json(
                             &cmd.tags[i], req->tags[i].t, &req->tags[i].value);
@@ -155,6 +162,7 @@ void handle_update_tags(nng_aio *aio)
                 } else {
                     cmd.tags[i].description = strdup("");
                 }
+                neu_json_tag_get_report(&req->tags[i], &cmd.tags[i].report);
                 if (NEU_ATTRIBUTE_STATIC & req->tags[i].attribute) {
                     neu_tag_set_static_value_json(&cmd.tags[i], req->tags[i].t,
                                                   &req->tags[i].value);
@@ -175,12 +183,55 @@ void handle_update_tags_resp(nng_aio *aio, neu_resp_update_tag_t *resp)
     handle_add_tags_resp(aio, resp);
 }
 
+static const struct {
+    const char *name;
+    uint32_t    field;
+} tag_fields[] = {
+    { "name", NEU_TAG_FIELD_NAME },
+    { "type", NEU_TAG_FIELD_TYPE },
+    { "address", NEU_TAG_FIELD_ADDRESS },
+    { "attribute", NEU_TAG_FIELD_ATTRIBUTE },
+    { "precision", NEU_TAG_FIELD_PRECISION },
+    { "decimal", NEU_TAG_FIELD_DECIMAL },
+    { "description", NEU_TAG_FIELD_DESCRIPTION },
+    { "deadband", NEU_TAG_FIELD_REPORT },
+    { "deadband_type", NEU_TAG_FIELD_REPORT },
+    { "heartbeat", NEU_TAG_FIELD_REPORT },
+    { "min_interval", NEU_TAG_FIELD_REPORT },
+    { "value", NEU_TAG_FIELD_VALUE },
+};
+
+// comma separated field names, as in `fields=name,address`
+static int parse_tag_fields(char *list, uint32_t *fields)
+{
+    char *save = NULL;
+
+    *fields = 0;
+    for (char *f = strtok_r(list, ",", &save); f != NULL;
+         f       = strtok_r(NULL, ",", &save)) {
+        size_t i = 0;
+
+        for (; i < sizeof(tag_fields) / sizeof(tag_fields[0]); i++) {
+            if (strcmp(f, tag_fields[i].name) == 0) {
+                *fields |= tag_fields[i].field;
+                break;
+            }
+        }
+        if (i == sizeof(tag_fields) / sizeof(tag_fields[0])) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
 void handle_get_tags(nng_aio *aio)
 {
     neu_plugin_t *     plugin                     = neu_rest_get_plugin();
     char               node[NEU_NODE_NAME_LEN]    = { 0 };
     char               group[NEU_GROUP_NAME_LEN]  = { 0 };
     char               tag_name[NEU_TAG_NAME_LEN] = { 0 };
+    char               fields[256]                = { 0 };
     int                ret                        = 0;
     neu_req_get_tag_t  cmd                        = { 0 };
     neu_reqresp_head_t header                     = {
@@ -207,6 +258,30 @@ void handle_get_tags(nng_aio *aio)
         strcpy(cmd.name, tag_name);
     }
 
+    ret = neu_http_get_param_str(aio, "prefix", cmd.prefix, sizeof(cmd.prefix));
+    if (ret == -1 || ret == (int) sizeof(cmd.prefix)) {
+        goto param_error;
+    }
+    ret = neu_http_get_param_str(aio, "cursor", cmd.cursor, sizeof(cmd.cursor));
+    if (ret == -1 || ret == (int) sizeof(cmd.cursor)) {
+        goto param_error;
+    }
+    if (neu_http_get_param(aio, "limit", NULL) != NULL &&
+        neu_http_get_param_uint32(aio, "limit", &cmd.limit) != 0) {
+        goto param_error;
+    }
+    if (neu_http_get_param(aio, "attribute", NULL) != NULL &&
+        neu_http_get_param_uint32(aio, "attribute", &cmd.attribute) != 0) {
+        goto param_error;
+    }
+    ret = neu_http_get_param_str(aio, "fields", fields, sizeof(fields));
+    if (ret == -1 || ret == (int) sizeof(fields)) {
+        goto param_error;
+    }
+    if (ret > 0 && parse_tag_fields(fields, &cmd.fields) != 0) {
+        goto param_error;
+    }
+
     strcpy(cmd.driver, node);
     strcpy(cmd.group, group);
 
@@ -216,40 +291,131 @@ void handle_get_tags(nng_aio *aio)
             neu_http_response(aio, NEU_ERR_IS_BUSY, result_error);
         });
     }
+    return;
+
+param_error:
+    NEU_JSON_RESPONSE_ERROR(NEU_ERR_PARAM_IS_WRONG, {
+        neu_http_response(aio, NEU_ERR_PARAM_IS_WRONG, result_error);
+    })
 }
 
-void handle_get_tags_resp(nng_aio *aio, neu_resp_get_tag_t *tags)
+static void write_static_value(neu_json_writer_t *w, neu_datatag_t *tag)
 {
-    neu_json_get_tags_resp_t tags_res = { 0 };
-    char *                   result   = NULL;
+    neu_json_type_e  t = NEU_JSON_UNDEFINE;
+    neu_json_value_u v = { 0 };
 
-    tags_res.n_tag = utarray_len(tags->tags);
-    tags_res.tags  = calloc(tags_res.n_tag, sizeof(neu_json_tag_t));
+    if (!neu_tag_attribute_test(tag, NEU_ATTRIBUTE_STATIC) ||
+        neu_tag_get_static_value_json(tag, &t, &v) != 0) {
+        return;
+    }
 
-    utarray_foreach(tags->tags, neu_datatag_t *, tag)
-    {
-        int index = utarray_eltidx(tags->tags, tag);
-
-        tags_res.tags[index].name        = tag->name;
-        tags_res.tags[index].address     = tag->address;
-        tags_res.tags[index].description = tag->description;
-        tags_res.tags[index].type        = tag->type;
-        tags_res.tags[index].attribute   = tag->attribute;
-        tags_res.tags[index].precision   = tag->precision;
-        tags_res.tags[index].decimal     = tag->decimal;
-        if (neu_tag_attribute_test(tag, NEU_ATTRIBUTE_STATIC)) {
-            neu_tag_get_static_value_json(tag, &tags_res.tags[index].t,
-                                          &tags_res.tags[index].value);
-        } else {
-            tags_res.tags[index].t = NEU_JSON_UNDEFINE;
-        }
+    switch (t) {
+    case NEU_JSON_INT:
+        neu_json_writer_key(w, "value");
+        neu_json_writer_int(w, v.val_int);
+        break;
+    case NEU_JSON_BOOL:
+        neu_json_writer_key(w, "value");
+        neu_json_writer_bool(w, v.val_bool);
+        break;
+    case NEU_JSON_FLOAT:
+        neu_json_writer_key(w, "value");
+        neu_json_writer_double(w, v.val_float, 0);
+        break;
+    case NEU_JSON_DOUBLE:
+        neu_json_writer_key(w, "value");
+        neu_json_writer_double(w, v.val_double, 0);
+        break;
+    case NEU_JSON_STR:
+        neu_json_writer_key(w, "value");
+        neu_json_writer_str_value(w, v.val_str);
+        break;
+    default:
+        break;
     }
+}
 
-    neu_json_encode_by_fn(&tags_res, neu_json_encode_get_tags_resp, &result);
+static void write_tag(neu_json_writer_t *w, neu_datatag_t *tag, uint32_t fields)
+{
+    neu_json_writer_object_begin(w);
 
-    neu_http_ok(aio, result);
+    if (fields & NEU_TAG_FIELD_TYPE) {
+        neu_json_writer_key(w, "type");
+        neu_json_writer_int(w, tag->type);
+    }
+    neu_json_writer_key(w, "name");
+    neu_json_writer_str_value(w, tag->name);
+    if (fields & NEU_TAG_FIELD_ATTRIBUTE) {
+        neu_json_writer_key(w, "attribute");
+        neu_json_writer_int(w, tag->attribute);
+    }
+    if (fields & NEU_TAG_FIELD_PRECISION) {
+        neu_json_writer_key(w, "precision");
+        neu_json_writer_int(w, tag->precision);
+    }
+    if (fields & NEU_TAG_FIELD_DECIMAL) {
+        neu_json_writer_key(w, "decimal");
+        neu_json_writer_double(w, tag->decimal, 0);
+    }
+    if (fields & NEU_TAG_FIELD_REPORT) {
+        neu_json_writer_key(w, "deadband");
+        neu_json_writer_double(w, tag->report.deadband, 0);
+        neu_json_writer_key(w, "deadband_type");
+        neu_json_writer_int(w, tag->report.deadband_type);
+        neu_json_writer_key(w, "heartbeat");
+        neu_json_writer_int(w, tag->report.heartbeat);
+        neu_json_writer_key(w, "min_interval");
+        neu_json_writer_int(w, tag->report.min_interval);
+    }
+    if (fields & NEU_TAG_FIELD_ADDRESS) {
+        neu_json_writer_key(w, "address");
+        neu_json_writer_str_value(w, tag->address);
+    }
+    if (fields & NEU_TAG_FIELD_DESCRIPTION) {
+        neu_json_writer_key(w, "description");
+        neu_json_writer_str_value(w, tag->description);
+    }
+    if (fields & NEU_TAG_FIELD_VALUE) {
+        write_static_value(w, tag);
+    }
+
+    neu_json_writer_object_end(w);
+}
+
+void handle_get_tags_resp(nng_aio *aio, neu_resp_get_tag_t *tags)
+{
+    neu_json_writer_t w;
+    uint32_t fields = tags->fields != 0 ? tags->fields : NEU_TAG_FIELD_ALL;
+
+    // encoded straight from the tag array, a page of thousands of tags is
+    // never held twice as jansson objects
+    neu_json_writer_init(&w, 64 + utarray_len(tags->tags) * 160);
+    neu_json_writer_object_begin(&w);
+    neu_json_writer_key(&w, "tags");
+    neu_json_writer_array_begin(&w);
+    utarray_foreach(tags->tags, neu_datatag_t *, tag)
+    {
+        write_tag(&w, tag, fields);
+    }
+    neu_json_writer_array_end(&w);
+    if (tags->next[0] != '\0') {
+        neu_json_writer_key(&w, "next");
+        neu_json_writer_str_value(&w, tags->next);
+    }
+    neu_json_writer_key(&w, "total");
+    neu_json_writer_uint(&w, tags->total);
+    neu_json_writer_object_end(&w);
+
+    char *result = neu_json_writer_detach(&w);
+    if (NULL != result) {
+        neu_http_ok(aio, result);
+    } else {
+        NEU_JSON_RESPONSE_ERROR(NEU_ERR_EINTERNAL, {
+            neu_http_response(aio, NEU_ERR_EINTERNAL, result_error);
+        });
+    }
 
     free(result);
-    free(tags_res.tags);
+    neu_json_writer_fini(&w);
     utarray_free(tags->tags);
 }
@@ -627,6 +627,7 @@ static int get_tags_resp(context_t *ctx, neu_resp_get_tag_t *tags)
         tags_res.tags[index].attribute   = tag->attribute;
         tags_res.tags[index].precision   = tag->precision;
         tags_res.tags[index].decimal     = tag->decimal;
+        neu_json_tag_set_report(&tags_res.tags[index], &tag->report);
         if (neu_tag_attribute_test(tag, NEU_ATTRIBUTE_STATIC)) {
             neu_tag_get_static_value_json(tag, &tags_res.tags[index].t,
                                           &tags_res.tags[index].value);
@@ -901,6 +902,7 @@ static int add_tag(context_t *ctx, neu_json_add_tags_req_t *data)
         cmd.tags[i].name      = strdup(data->tags[i].name);
         cmd.tags[i].description =
             strdup(data->tags[i].description ? data->tags[i].description : "");
+        neu_json_tag_get_report(&data->tags[i], &cmd.tags[i].report);
 
         if (NULL == cmd.tags[i].address || NULL == cmd.tags[i].name ||
             NULL == cmd.tags[i].description) {
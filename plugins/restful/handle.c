@@ -34,6 +34,7 @@
 #include "normal_handle.h"
 #include "plugin_handle.h"
 #include "rw_handle.h"
+#include "stream_handle.h"
 #include "template_handle.h"
 #include "utils/http.h"
 #include "version_handle.h"
@@ -53,6 +54,9 @@ static struct neu_http_handler cors_handler[] = {
     {
         .url = "/api/v2/login",
     },
+    {
+        .url = "/api/v2/logout",
+    },
     {
         .url = "/api/v2/tags",
     },
@@ -74,6 +78,9 @@ static struct neu_http_handler cors_handler[] = {
     {
         .url = "/api/v2/write",
     },
+    {
+        .url = "/api/v2/stream",
+    },
     {
         .url = "/api/v2/write/tags",
     },
@@ -170,6 +177,12 @@ static struct neu_http_handler rest_handlers[] = {
         .url           = "/api/v2/login",
         .value.handler = handle_login,
     },
+    {
+        .method        = NEU_HTTP_METHOD_POST,
+        .type          = NEU_HTTP_HANDLER_FUNCTION,
+        .url           = "/api/v2/logout",
+        .value.handler = handle_logout,
+    },
     {
         .method        = NEU_HTTP_METHOD_POST,
         .type          = NEU_HTTP_HANDLER_FUNCTION,
@@ -280,6 +293,12 @@ static struct neu_http_handler rest_handlers[] = {
         .url           = "/api/v2/write",
         .value.handler = handle_write,
     },
+    {
+        .method        = NEU_HTTP_METHOD_GET,
+        .type          = NEU_HTTP_HANDLER_FUNCTION,
+        .url           = "/api/v2/stream",
+        .value.handler = handle_stream,
+    },
     {
         .method        = NEU_HTTP_METHOD_POST,
         .type          = NEU_HTTP_HANDLER_FUNCTION,
@@ -99,6 +99,18 @@ void handle_login(nng_aio *aio)
         })
 }
 
+void handle_logout(nng_aio *aio)
+{
+    NEU_VALIDATE_JWT(aio);
+
+    char *jwt = (char *) neu_http_get_header(aio, (char *) "Authorization");
+    int   rv  = disable_jwt ? NEU_ERR_SUCCESS : neu_jwt_revoke(jwt);
+
+    NEU_JSON_RESPONSE_ERROR(rv, {
+        neu_http_response(aio, error_code.error, result_error);
+    });
+}
+
 void handle_password(nng_aio *aio)
 {
     NEU_PROCESS_HTTP_REQUEST_VALIDATE_JWT(
@@ -123,6 +135,9 @@ void handle_password(nng_aio *aio)
                 nlog_error("user `%s` update password fail", req->name);
             } else if (0 != (rv = neu_save_user(user))) {
                 nlog_error("user `%s` persist fail", req->name);
+            } else {
+                // sessions opened with the old password end here
+                neu_jwt_revoke_all();
             }
 
             NEU_JSON_RESPONSE_ERROR(rv, {
@@ -24,6 +24,7 @@
 
 void handle_ping(nng_aio *aio);
 void handle_login(nng_aio *aio);
+void handle_logout(nng_aio *aio);
 void handle_password(nng_aio *aio);
 void handle_get_plugin_schema(nng_aio *aio);
 
@@ -35,6 +35,7 @@
 #include "plugin_handle.h"
 #include "rest.h"
 #include "rw_handle.h"
+#include "stream_handle.h"
 #include "template_handle.h"
 #include "utils/http.h"
 #include "utils/log.h"
@@ -85,6 +86,7 @@ static neu_plugin_t *dashb_plugin_open(void)
     neu_plugin_common_init(&plugin->common);
 
     plugin->handle_ctx = neu_rest_init_ctx(plugin);
+    handle_stream_init();
 
     plugin->server = server_init();
 
@@ -113,6 +115,7 @@ server_init_fail:
     if (plugin->server != NULL) {
         nng_http_server_release(plugin->server);
     }
+    handle_stream_uninit();
     neu_rest_free_ctx(plugin->handle_ctx);
     free(plugin);
     return NULL;
@@ -124,6 +127,7 @@ static int dashb_plugin_close(neu_plugin_t *plugin)
 
     nng_http_server_stop(plugin->server);
     nng_http_server_release(plugin->server);
+    handle_stream_uninit(); // streams are off the server, hijacked
 
     free(plugin);
     nlog_notice("Success to free plugin: %s", neu_plugin_module.module_name);
@@ -168,6 +172,11 @@ static int dashb_plugin_request(neu_plugin_t *      plugin,
 {
     (void) plugin;
 
+    if (handle_stream_ctx(header->ctx)) {
+        handle_stream_resp(header->ctx, header->type, data);
+        return 0;
+    }
+
     if (header->ctx && nng_aio_get_input(header->ctx, 3)) {
         // catch all response messages for global config request
         handle_global_config_resp(header->ctx, header->type, data);
@@ -241,6 +250,15 @@ static int dashb_plugin_request(neu_plugin_t *      plugin,
         handle_get_ndriver_tags_resp(header->ctx,
                                      (neu_resp_get_ndriver_tags_t *) data);
         break;
+    case NEU_REQRESP_TRANS_DATA:
+        handle_stream_trans_data((neu_reqresp_trans_data_t *) data);
+        break;
+    case NEU_REQ_SUBSCRIBE_GROUP:
+        free(((neu_req_subscribe_t *) data)->params);
+        break;
+    case NEU_REQ_UNSUBSCRIBE_GROUP:
+        handle_stream_unsubscribe((neu_req_unsubscribe_t *) data);
+        break;
     case NEU_REQ_UPDATE_LICENSE:
         break;
     default:
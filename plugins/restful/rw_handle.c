@@ -20,6 +20,7 @@
 
 #include "plugin.h"
 #include "utils/log.h"
+#include "json/json_writer.h"
 #include "json/neu_json_fn.h"
 #include "json/neu_json_rw.h"
 
@@ -175,87 +176,24 @@ void handle_write_tags(nng_aio *aio)
 
 void handle_read_resp(nng_aio *aio, neu_resp_read_group_t *resp)
 {
-    neu_json_read_resp_t api_res = { 0 };
-    char *               result  = NULL;
-
-    api_res.n_tag = resp->n_tag;
-    api_res.tags  = calloc(api_res.n_tag, sizeof(neu_json_read_resp_tag_t));
-
-    for (int i = 0; i < resp->n_tag; i++) {
-        api_res.tags[i].name  = resp->tags[i].tag;
-        api_res.tags[i].error = NEU_ERR_SUCCESS;
-
-        switch (resp->tags[i].value.type) {
-        case NEU_TYPE_INT8:
-            api_res.tags[i].t             = NEU_JSON_INT;
-            api_res.tags[i].value.val_int = resp->tags[i].value.value.i8;
-            break;
-        case NEU_TYPE_UINT8:
-            api_res.tags[i].t             = NEU_JSON_INT;
-            api_res.tags[i].value.val_int = resp->tags[i].value.value.u8;
-            break;
-        case NEU_TYPE_INT16:
-            api_res.tags[i].t             = NEU_JSON_INT;
-            api_res.tags[i].value.val_int = resp->tags[i].value.value.i16;
-            break;
-        case NEU_TYPE_WORD:
-        case NEU_TYPE_UINT16:
-            api_res.tags[i].t             = NEU_JSON_INT;
-            api_res.tags[i].value.val_int = resp->tags[i].value.value.u16;
-            break;
-        case NEU_TYPE_INT32:
-            api_res.tags[i].t             = NEU_JSON_INT;
-            api_res.tags[i].value.val_int = resp->tags[i].value.value.i32;
-            break;
-        case NEU_TYPE_DWORD:
-        case NEU_TYPE_UINT32:
-            api_res.tags[i].t             = NEU_JSON_INT;
-            api_res.tags[i].value.val_int = resp->tags[i].value.value.u32;
-            break;
-        case NEU_TYPE_INT64:
-            api_res.tags[i].t             = NEU_JSON_INT;
-            api_res.tags[i].value.val_int = resp->tags[i].value.value.i64;
-            break;
-        case NEU_TYPE_LWORD:
-        case NEU_TYPE_UINT64:
-            api_res.tags[i].t             = NEU_JSON_INT;
-            api_res.tags[i].value.val_int = resp->tags[i].value.value.u64;
-            break;
-        case NEU_TYPE_FLOAT:
-            api_res.tags[i].t               = NEU_JSON_FLOAT;
-            api_res.tags[i].value.val_float = resp->tags[i].value.value.f32;
-            api_res.tags[i].precision       = resp->tags[i].value.precision;
-            break;
-        case NEU_TYPE_DOUBLE:
-            api_res.tags[i].t                = NEU_JSON_DOUBLE;
-            api_res.tags[i].value.val_double = resp->tags[i].value.value.d64;
-            api_res.tags[i].precision        = resp->tags[i].value.precision;
-            break;
-        case NEU_TYPE_BIT:
-            api_res.tags[i].t             = NEU_JSON_BIT;
-            api_res.tags[i].value.val_bit = resp->tags[i].value.value.u8;
-            break;
-        case NEU_TYPE_BOOL:
-            api_res.tags[i].t              = NEU_JSON_BOOL;
-            api_res.tags[i].value.val_bool = resp->tags[i].value.value.boolean;
-            break;
-        case NEU_TYPE_STRING:
-            api_res.tags[i].t             = NEU_JSON_STR;
-            api_res.tags[i].value.val_str = resp->tags[i].value.value.str;
-            break;
-        case NEU_TYPE_ERROR:
-            api_res.tags[i].t             = NEU_JSON_INT;
-            api_res.tags[i].value.val_int = resp->tags[i].value.value.i32;
-            api_res.tags[i].error         = resp->tags[i].value.value.i32;
-            break;
-        default:
-            break;
-        }
+    neu_json_writer_t w;
+
+    // roughly enough for typical tag names and values
+    neu_json_writer_init(&w, 32 + resp->n_tag * 48);
+    neu_json_writer_object_begin(&w);
+    neu_json_writer_tags_array(&w, resp->tags, resp->n_tag);
+    neu_json_writer_object_end(&w);
+
+    char *result = neu_json_writer_detach(&w);
+    if (NULL != result) {
+        neu_http_ok(aio, result);
+    } else {
+        NEU_JSON_RESPONSE_ERROR(NEU_ERR_EINTERNAL, {
+            neu_http_response(aio, NEU_ERR_EINTERNAL, result_error);
+        });
     }
 
-    neu_json_encode_by_fn(&api_res, neu_json_encode_read_resp, &result);
-    neu_http_ok(aio, result);
-    free(api_res.tags);
     free(result);
+    neu_json_writer_fini(&w);
     free(resp->tags);
 }
@@ -0,0 +1,755 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2023 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <nng/nng.h>
+#include <nng/supplemental/http/http.h>
+#include <nng/supplemental/util/platform.h>
+
+#include "define.h"
+#include "errcodes.h"
+#include "plugin.h"
+#include "utils/http.h"
+#include "utils/log.h"
+#include "utils/neu_jwt.h"
+#include "utils/time.h"
+#include "utils/uthash.h"
+#include "utils/utlist.h"
+#include "json/json_writer.h"
+#include "json/neu_json_fn.h"
+
+#include "handle.h"
+#include "stream_handle.h"
+
+#define STREAM_INTERVAL_MAX 3600000
+#define STREAM_TOKEN_LEN 2048
+
+static const char stream_header[] = "HTTP/1.1 200 OK\r\n"
+                                    "Content-Type: text/event-stream\r\n"
+                                    "Cache-Control: no-cache\r\n"
+                                    "Connection: keep-alive\r\n"
+                                    "Access-Control-Allow-Origin: *\r\n"
+                                    "\r\n";
+
+// an encoded event, shared by the clients writing it
+typedef struct {
+    int    ref;
+    size_t len;
+    char   data[];
+} payload_t;
+
+typedef struct {
+    char driver[NEU_NODE_NAME_LEN];
+    char group[NEU_GROUP_NAME_LEN];
+} stream_key_t;
+
+typedef struct {
+    neu_resp_tag_value_t tag;
+    UT_hash_handle       hh;
+} stream_value_t;
+
+typedef struct stream_client stream_client_t;
+
+typedef struct {
+    stream_key_t     key;
+    uint64_t         gen;       // tells apart successive groups of a key
+    bool             owned;     // subscribed by the streams, so unsubscribed
+    uint64_t         version;   // bumped on each change of the values
+    int64_t          timestamp; // of the last change
+    stream_value_t * values;    // latest values by tag name
+    payload_t *      diff;      // changed values of `version`
+    payload_t *      snapshot;  // all values of `version`, encoded on demand
+    stream_client_t *clients;
+    UT_hash_handle   hh;
+} stream_group_t;
+
+struct stream_client {
+    stream_group_t * group; // NULL once detached
+    nng_http_conn *  conn;  // hijacked from the http server
+    nng_aio *        aio;   // write
+    nng_aio *        timer; // rate limit
+    bool             busy;  // aio or timer in progress
+    bool             closed;
+    payload_t *      writing; // in aio
+    payload_t *      final;   // written after detaching, before closing
+    uint64_t         version; // of the last event sent
+    uint32_t         interval;
+    int64_t          last_ts; // time of the last event
+    stream_client_t *prev;
+    stream_client_t *next;
+};
+
+// a request sent for the streams, its address is the request ctx
+typedef struct stream_req {
+    neu_reqresp_type_e type;
+    stream_key_t       key;
+    uint64_t           gen;
+    struct stream_req *prev;
+    struct stream_req *next;
+} stream_req_t;
+
+// all guarded by stream_mtx
+static nng_mtx *         stream_mtx = NULL;
+static stream_group_t *  groups     = NULL;
+static stream_req_t *    reqs       = NULL;
+static stream_client_t * zombies    = NULL; // closed, freed out of callbacks
+static uint64_t          next_gen   = 0;
+static neu_json_writer_t writer;
+
+static payload_t *payload_new(const char *event, const char *data, size_t len)
+{
+    // event: <event>\ndata: <data>\n\n
+    size_t     size = strlen("event: \ndata: \n\n") + strlen(event) + len;
+    payload_t *p    = malloc(sizeof(*p) + size + 1);
+    if (NULL == p) {
+        return NULL;
+    }
+
+    p->ref = 1;
+    p->len = snprintf(p->data, size + 1, "event: %s\ndata: %.*s\n\n", event,
+                      (int) len, data);
+    return p;
+}
+
+static void payload_unref(payload_t *p)
+{
+    if (NULL != p && 0 == --p->ref) {
+        free(p);
+    }
+}
+
+static payload_t *encode_event(stream_group_t *group, const char *event,
+                               const neu_resp_tag_value_t *tags, uint32_t n)
+{
+    neu_json_writer_reset(&writer);
+    neu_json_writer_object_begin(&writer);
+    neu_json_writer_key(&writer, "node");
+    neu_json_writer_str_value(&writer, group->key.driver);
+    neu_json_writer_key(&writer, "group");
+    neu_json_writer_str_value(&writer, group->key.group);
+    neu_json_writer_key(&writer, "timestamp");
+    neu_json_writer_int(&writer, group->timestamp);
+    neu_json_writer_tags_array(&writer, tags, n);
+    neu_json_writer_object_end(&writer);
+
+    const char *json = neu_json_writer_str(&writer);
+    if (NULL == json) {
+        return NULL;
+    }
+
+    return payload_new(event, json, neu_json_writer_len(&writer));
+}
+
+static payload_t *group_snapshot(stream_group_t *group)
+{
+    if (NULL != group->snapshot) {
+        return group->snapshot;
+    }
+
+    int                   n    = HASH_COUNT(group->values);
+    int                   i    = 0;
+    neu_resp_tag_value_t *tags = calloc(n > 0 ? n : 1, sizeof(*tags));
+    stream_value_t *      v    = NULL, *tmp;
+    if (NULL == tags) {
+        return NULL;
+    }
+
+    HASH_ITER(hh, group->values, v, tmp) { tags[i++] = v->tag; }
+    group->snapshot = encode_event(group, "snapshot", tags, n);
+    free(tags);
+    return group->snapshot;
+}
+
+static bool value_equal(const neu_dvalue_t *a, const neu_dvalue_t *b)
+{
+    if (a->type != b->type) {
+        return false;
+    }
+
+    switch (a->type) {
+    case NEU_TYPE_INT8:
+    case NEU_TYPE_UINT8:
+    case NEU_TYPE_BIT:
+        return a->value.u8 == b->value.u8;
+    case NEU_TYPE_BOOL:
+        return a->value.boolean == b->value.boolean;
+    case NEU_TYPE_INT16:
+    case NEU_TYPE_UINT16:
+    case NEU_TYPE_WORD:
+        return a->value.u16 == b->value.u16;
+    case NEU_TYPE_INT32:
+    case NEU_TYPE_UINT32:
+    case NEU_TYPE_DWORD:
+    case NEU_TYPE_FLOAT:
+    case NEU_TYPE_ERROR:
+        return a->value.u32 == b->value.u32;
+    case NEU_TYPE_INT64:
+    case NEU_TYPE_UINT64:
+    case NEU_TYPE_LWORD:
+    case NEU_TYPE_DOUBLE:
+        return a->value.u64 == b->value.u64;
+    case NEU_TYPE_STRING:
+        return 0 == strncmp(a->value.str, b->value.str, NEU_VALUE_SIZE);
+    default:
+        return 0 == memcmp(&a->value, &b->value, sizeof(a->value));
+    }
+}
+
+// remember the value, return whether it changed
+static bool group_update(stream_group_t *group, const neu_resp_tag_value_t *tag)
+{
+    stream_value_t *v = NULL;
+
+    HASH_FIND_STR(group->values, tag->tag, v);
+    if (NULL == v) {
+        v = calloc(1, sizeof(*v));
+        if (NULL == v) {
+            return true;
+        }
+        strcpy(v->tag.tag, tag->tag);
+        HASH_ADD_STR(group->values, tag.tag, v);
+    } else if (value_equal(&v->tag.value, &tag->value)) {
+        return false;
+    }
+
+    v->tag.value = tag->value;
+    return true;
+}
+
+static void group_free(stream_group_t *group)
+{
+    stream_value_t *v = NULL, *tmp = NULL;
+
+    HASH_DEL(groups, group);
+    HASH_ITER(hh, group->values, v, tmp)
+    {
+        HASH_DEL(group->values, v);
+        free(v);
+    }
+    payload_unref(group->diff);
+    payload_unref(group->snapshot);
+    free(group);
+}
+
+static void client_write(stream_client_t *client, payload_t *payload,
+                         const void *buf, size_t len)
+{
+    nng_iov iov = { .iov_buf = (void *) buf, .iov_len = len };
+
+    client->writing = payload;
+    client->busy    = true;
+    nng_aio_set_iov(client->aio, 1, &iov);
+    nng_http_conn_write_all(client->conn, client->aio);
+}
+
+static void client_close(stream_client_t *client)
+{
+    if (client->closed) {
+        return;
+    }
+
+    client->closed = true;
+    nng_aio_cancel(client->timer);
+    nng_http_conn_close(client->conn); // aborts a pending write
+    DL_APPEND(zombies, client);
+}
+
+// remove the client from its group, return whether to unsubscribe the group
+static bool client_detach(stream_client_t *client, stream_key_t *key)
+{
+    stream_group_t *group = client->group;
+    bool            owned = false;
+    if (NULL == group) {
+        return false;
+    }
+
+    DL_DELETE(group->clients, client);
+    client->group = NULL;
+    if (NULL == group->clients) {
+        *key  = group->key;
+        owned = group->owned;
+        group_free(group);
+    }
+    return owned;
+}
+
+// write what the client misses, if it is ready for it
+static void client_pump(stream_client_t *client)
+{
+    stream_group_t *group   = client->group;
+    payload_t *     payload = NULL;
+
+    if (client->closed || client->busy) {
+        return;
+    }
+
+    if (NULL == group) {
+        if (NULL != client->final) {
+            payload       = client->final;
+            client->final = NULL;
+            client_write(client, payload, payload->data, payload->len);
+        } else {
+            client_close(client);
+        }
+        return;
+    }
+
+    if (client->version == group->version) {
+        return;
+    }
+
+    int64_t wait = client->last_ts + client->interval - neu_time_ms();
+    if (wait > 0) {
+        client->busy = true;
+        nng_sleep_aio((nng_duration) wait, client->timer);
+        return;
+    }
+
+    // a client that skipped events needs all the values
+    if (client->version + 1 == group->version && NULL != group->diff) {
+        payload = group->diff;
+    } else {
+        payload = group_snapshot(group);
+    }
+    if (NULL == payload) {
+        return; // retried on the next change
+    }
+
+    payload->ref += 1;
+    client->version = group->version;
+    client->last_ts = neu_time_ms();
+    client_write(client, payload, payload->data, payload->len);
+}
+
+// detach all the clients, which are sent `error` if not 0 and closed
+static void group_fail(stream_group_t *group, int error)
+{
+    stream_client_t *client = NULL, *tmp = NULL;
+    payload_t *      p      = NULL;
+
+    if (0 != error) {
+        char json[32] = { 0 };
+        int  len      = snprintf(json, sizeof(json), "{\"error\":%d}", error);
+        p             = payload_new("error", json, len);
+    }
+
+    DL_FOREACH_SAFE(group->clients, client, tmp)
+    {
+        DL_DELETE(group->clients, client);
+        client->group = NULL;
+        if (NULL != p) {
+            p->ref += 1;
+            client->final = p;
+        }
+        nng_aio_cancel(client->timer); // pumped from timer_cb
+        client_pump(client);
+    }
+
+    payload_unref(p);
+    group_free(group);
+}
+
+static void reap()
+{
+    stream_client_t *list = NULL, *client = NULL, *tmp = NULL;
+
+    nng_mtx_lock(stream_mtx);
+    list    = zombies;
+    zombies = NULL;
+    nng_mtx_unlock(stream_mtx);
+
+    DL_FOREACH_SAFE(list, client, tmp)
+    {
+        DL_DELETE(list, client);
+        // wait for the callbacks, without stream_mtx they might take
+        nng_aio_free(client->aio);
+        nng_aio_free(client->timer);
+        nng_mtx_lock(stream_mtx);
+        payload_unref(client->writing);
+        payload_unref(client->final);
+        nng_mtx_unlock(stream_mtx);
+        free(client);
+    }
+}
+
+static int send_request(neu_reqresp_type_e type, const stream_key_t *key,
+                        uint64_t gen)
+{
+    int                rv     = 0;
+    neu_plugin_t *     plugin = neu_rest_get_plugin();
+    const char *       app    = neu_plugin_to_plugin_common(plugin)->name;
+    neu_reqresp_head_t header = { 0 };
+    stream_req_t *     req    = calloc(1, sizeof(*req));
+    if (NULL == req) {
+        return NEU_ERR_EINTERNAL;
+    }
+
+    req->type   = type;
+    req->key    = *key;
+    req->gen    = gen;
+    header.ctx  = req;
+    header.type = type;
+    nng_mtx_lock(stream_mtx);
+    DL_APPEND(reqs, req);
+    nng_mtx_unlock(stream_mtx);
+
+    if (NEU_REQ_SUBSCRIBE_GROUP == type) {
+        neu_req_subscribe_t cmd = { 0 };
+        strcpy(cmd.app, app);
+        strcpy(cmd.driver, key->driver);
+        strcpy(cmd.group, key->group);
+        rv = neu_plugin_op(plugin, header, &cmd);
+    } else {
+        neu_req_unsubscribe_t cmd = { 0 };
+        strcpy(cmd.app, app);
+        strcpy(cmd.driver, key->driver);
+        strcpy(cmd.group, key->group);
+        rv = neu_plugin_op(plugin, header, &cmd);
+    }
+
+    if (0 != rv) {
+        nlog_error("stream %s of %s:%s fail: %d",
+                   neu_reqresp_type_string(type), key->driver, key->group, rv);
+        nng_mtx_lock(stream_mtx);
+        DL_DELETE(reqs, req);
+        nng_mtx_unlock(stream_mtx);
+        free(req);
+    }
+
+    return rv;
+}
+
+static void client_write_cb(void *arg)
+{
+    stream_client_t *client = arg;
+    int              rv     = nng_aio_result(client->aio);
+    bool             unsub  = false;
+    stream_key_t     key    = { 0 };
+
+    nng_mtx_lock(stream_mtx);
+    payload_unref(client->writing);
+    client->writing = NULL;
+    client->busy    = false;
+    if (0 != rv) {
+        nlog_debug("stream client gone: %s", nng_strerror(rv));
+        unsub = client_detach(client, &key);
+        client_close(client);
+    } else {
+        client_pump(client);
+    }
+    nng_mtx_unlock(stream_mtx);
+
+    if (unsub) {
+        send_request(NEU_REQ_UNSUBSCRIBE_GROUP, &key, 0);
+    }
+}
+
+static void client_timer_cb(void *arg)
+{
+    stream_client_t *client = arg;
+
+    nng_mtx_lock(stream_mtx);
+    client->busy = false;
+    client_pump(client);
+    nng_mtx_unlock(stream_mtx);
+}
+
+static int validate_jwt(nng_aio *aio)
+{
+    char   token[STREAM_TOKEN_LEN] = "Bearer ";
+    size_t prefix                  = strlen(token);
+    char * jwt = (char *) neu_http_get_header(aio, (char *) "Authorization");
+
+    if (disable_jwt) {
+        return NEU_ERR_SUCCESS;
+    }
+
+    // EventSource cannot set headers, so the token may come in the query
+    if (NULL == jwt) {
+        ssize_t n = neu_http_get_param_str(aio, "token", token + prefix,
+                                           sizeof(token) - prefix);
+        if (n > 0 && (size_t) n < sizeof(token) - prefix) {
+            jwt = token;
+        }
+    }
+
+    return neu_jwt_validate(jwt);
+}
+
+static int parse_params(nng_aio *aio, stream_key_t *key, uint32_t *interval)
+{
+    ssize_t n = neu_http_get_param_str(aio, "node", key->driver,
+                                       sizeof(key->driver));
+    if (n <= 0 || (size_t) n == sizeof(key->driver)) {
+        return NEU_ERR_PARAM_IS_WRONG;
+    }
+
+    n = neu_http_get_param_str(aio, "group", key->group, sizeof(key->group));
+    if (n <= 0 || (size_t) n == sizeof(key->group)) {
+        return NEU_ERR_PARAM_IS_WRONG;
+    }
+
+    // optional
+    if (NULL != neu_http_get_param(aio, "interval", NULL) &&
+        (0 != neu_http_get_param_uint32(aio, "interval", interval) ||
+         *interval > STREAM_INTERVAL_MAX)) {
+        return NEU_ERR_PARAM_IS_WRONG;
+    }
+
+    return NEU_ERR_SUCCESS;
+}
+
+void handle_stream_init()
+{
+    nng_mtx_alloc(&stream_mtx);
+    neu_json_writer_init(&writer, 0);
+}
+
+void handle_stream_uninit()
+{
+    stream_group_t *group = NULL, *gtmp = NULL;
+    stream_req_t *  req = NULL, *rtmp = NULL;
+
+    nng_mtx_lock(stream_mtx);
+    HASH_ITER(hh, groups, group, gtmp)
+    {
+        stream_client_t *client = NULL, *ctmp = NULL;
+        DL_FOREACH_SAFE(group->clients, client, ctmp)
+        {
+            DL_DELETE(group->clients, client);
+            client->group = NULL;
+            client_close(client);
+        }
+        group_free(group);
+    }
+    DL_FOREACH_SAFE(reqs, req, rtmp)
+    {
+        DL_DELETE(reqs, req);
+        free(req);
+    }
+    nng_mtx_unlock(stream_mtx);
+
+    reap();
+    neu_json_writer_fini(&writer);
+    nng_mtx_free(stream_mtx);
+    stream_mtx = NULL;
+}
+
+void handle_stream(nng_aio *aio)
+{
+    int              rv       = 0;
+    uint32_t         interval = 0;
+    stream_key_t     key      = { 0 };
+    stream_client_t *client   = NULL;
+    stream_group_t * group    = NULL;
+    uint64_t         gen      = 0;
+    nng_http_conn *  conn     = nng_aio_get_input(aio, 2);
+
+    rv = validate_jwt(aio);
+    if (NEU_ERR_SUCCESS == rv) {
+        rv = parse_params(aio, &key, &interval);
+    }
+    if (NEU_ERR_SUCCESS != rv) {
+        NEU_JSON_RESPONSE_ERROR(
+            rv, { neu_http_response(aio, error_code.error, result_error); });
+        return;
+    }
+
+    reap();
+
+    client = calloc(1, sizeof(*client));
+    if (NULL == client ||
+        0 != nng_aio_alloc(&client->aio, client_write_cb, client) ||
+        0 != nng_aio_alloc(&client->timer, client_timer_cb, client) ||
+        0 != nng_http_hijack(conn)) {
+        if (NULL != client) {
+            nng_aio_free(client->aio);
+            nng_aio_free(client->timer);
+            free(client);
+        }
+        NEU_JSON_RESPONSE_ERROR(NEU_ERR_EINTERNAL, {
+            neu_http_response(aio, error_code.error, result_error);
+        });
+        return;
+    }
+
+    client->conn     = conn;
+    client->interval = interval;
+
+    nng_mtx_lock(stream_mtx);
+    HASH_FIND(hh, groups, &key, sizeof(key), group);
+    if (NULL == group && NULL != (group = calloc(1, sizeof(*group)))) {
+        group->key = key;
+        group->gen = gen = ++next_gen;
+        HASH_ADD(hh, groups, key, sizeof(key), group);
+    }
+    if (NULL != group) {
+        DL_APPEND(group->clients, client);
+        client->group = group;
+        // the events follow the header, the conn is ours now
+        client_write(client, NULL, stream_header, strlen(stream_header));
+    } else {
+        client_close(client);
+    }
+    nng_mtx_unlock(stream_mtx);
+
+    nng_aio_finish(aio, 0);
+    nlog_notice("stream %s:%s, interval: %" PRIu32 " ms", key.driver,
+                key.group, interval);
+
+    // the first client of the group subscribes to it
+    if (gen > 0 &&
+        0 != (rv = send_request(NEU_REQ_SUBSCRIBE_GROUP, &key, gen))) {
+        nng_mtx_lock(stream_mtx);
+        HASH_FIND(hh, groups, &key, sizeof(key), group);
+        if (NULL != group && group->gen == gen) {
+            group_fail(group, NEU_ERR_IS_BUSY);
+        }
+        nng_mtx_unlock(stream_mtx);
+    }
+}
+
+bool handle_stream_ctx(void *ctx)
+{
+    stream_req_t *req = NULL;
+
+    if (NULL == ctx || NULL == stream_mtx) {
+        return false;
+    }
+
+    nng_mtx_lock(stream_mtx);
+    DL_FOREACH(reqs, req)
+    {
+        if (req == ctx) {
+            break;
+        }
+    }
+    nng_mtx_unlock(stream_mtx);
+    return NULL != req;
+}
+
+void handle_stream_resp(void *ctx, neu_reqresp_type_e type, void *data)
+{
+    stream_req_t *  req   = ctx;
+    stream_group_t *group = NULL;
+    int             error = 0;
+    bool            unsub = false;
+
+    switch (type) {
+    case NEU_REQ_SUBSCRIBE_GROUP:
+        // forwarded back to this node, the response follows
+        free(((neu_req_subscribe_t *) data)->params);
+        return;
+    case NEU_REQ_UNSUBSCRIBE_GROUP:
+        return;
+    case NEU_RESP_ERROR:
+        error = ((neu_resp_error_t *) data)->error;
+        break;
+    default:
+        nlog_warn("stream unexpected response: %s",
+                  neu_reqresp_type_string(type));
+        return;
+    }
+
+    nng_mtx_lock(stream_mtx);
+    DL_DELETE(reqs, req);
+    if (NEU_REQ_SUBSCRIBE_GROUP == req->type) {
+        HASH_FIND(hh, groups, &req->key, sizeof(req->key), group);
+    }
+    if (NEU_REQ_SUBSCRIBE_GROUP == req->type && NEU_ERR_SUCCESS == error) {
+        // a later group of the key may have found it already subscribed
+        if (NULL != group) {
+            group->owned = true;
+        } else {
+            unsub = true;
+        }
+    } else if (NEU_REQ_SUBSCRIBE_GROUP == req->type &&
+               NEU_ERR_GROUP_ALREADY_SUBSCRIBED != error) {
+        nlog_warn("stream subscribe %s:%s fail: %d", req->key.driver,
+                  req->key.group, error);
+        if (NULL != group && group->gen == req->gen) {
+            group_fail(group, error);
+        }
+    }
+    nng_mtx_unlock(stream_mtx);
+
+    // all the clients left before the subscription
+    if (unsub) {
+        send_request(NEU_REQ_UNSUBSCRIBE_GROUP, &req->key, 0);
+    }
+    free(req);
+}
+
+void handle_stream_trans_data(neu_reqresp_trans_data_t *trans_data)
+{
+    stream_key_t     key    = { 0 };
+    stream_group_t * group  = NULL;
+    stream_client_t *client = NULL;
+    uint32_t         n      = 0;
+
+    strcpy(key.driver, trans_data->driver);
+    strcpy(key.group, trans_data->group);
+
+    nng_mtx_lock(stream_mtx);
+    HASH_FIND(hh, groups, &key, sizeof(key), group);
+    if (NULL != group) {
+        // keep the changed tags only, trans_data is this node's own copy
+        for (uint32_t i = 0; i < trans_data->n_tag; ++i) {
+            if (group_update(group, &trans_data->tags[i])) {
+                if (n != i) {
+                    trans_data->tags[n] = trans_data->tags[i];
+                }
+                ++n;
+            }
+        }
+    }
+
+    if (n > 0) {
+        group->version += 1;
+        group->timestamp = global_timestamp;
+        payload_unref(group->diff);
+        payload_unref(group->snapshot);
+        group->snapshot = NULL;
+        group->diff     = encode_event(group, "values", trans_data->tags, n);
+        DL_FOREACH(group->clients, client) { client_pump(client); }
+    }
+    nng_mtx_unlock(stream_mtx);
+
+    reap();
+}
+
+void handle_stream_unsubscribe(neu_req_unsubscribe_t *unsubscribe)
+{
+    stream_key_t    key   = { 0 };
+    stream_group_t *group = NULL;
+
+    strcpy(key.driver, unsubscribe->driver);
+    strcpy(key.group, unsubscribe->group);
+
+    // the group or its node is gone
+    nng_mtx_lock(stream_mtx);
+    HASH_FIND(hh, groups, &key, sizeof(key), group);
+    if (NULL != group) {
+        group_fail(group, 0);
+    }
+    nng_mtx_unlock(stream_mtx);
+}
@@ -0,0 +1,52 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2023 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#ifndef _NEU_STREAM_HANDLE_H_
+#define _NEU_STREAM_HANDLE_H_
+
+#include <stdbool.h>
+
+#include <nng/nng.h>
+
+#include "adapter.h"
+
+/**
+ * Live values of driver groups pushed as server-sent events.
+ *
+ * GET /api/v2/stream?node=<driver>&group=<group>[&interval=<ms>][&token=<jwt>]
+ *
+ * The dashboard node subscribes to a group while at least one client watches
+ * it. A group it had already subscribed to is left subscribed. Each report is
+ * compared with the last values of the group and only the changed tags are
+ * encoded, once, into a `values` event shared by all clients of the group. A
+ * client that is still busy or within its `interval` skips events and is sent
+ * a `snapshot` event with all current values instead.
+ */
+void handle_stream_init();
+void handle_stream_uninit();
+void handle_stream(nng_aio *aio);
+
+// whether `ctx` is the context of a request sent for the streams
+bool handle_stream_ctx(void *ctx);
+void handle_stream_resp(void *ctx, neu_reqresp_type_e type, void *data);
+void handle_stream_trans_data(neu_reqresp_trans_data_t *trans_data);
+// the group is no longer subscribed, its clients are closed
+void handle_stream_unsubscribe(neu_req_unsubscribe_t *unsubscribe);
+
+#endif
@@ -52,6 +52,7 @@ static int set_tag_by_json(neu_datatag_t *tag, neu_json_tag_t *json_tag)
     tag->precision   = json_tag->precision;
     tag->decimal     = json_tag->decimal;
     tag->description = json_tag->description;
+    neu_json_tag_get_report(json_tag, &tag->report);
     // ownership moved
     json_tag->name        = NULL;
     json_tag->address     = NULL;
@@ -254,6 +255,7 @@ void handle_get_template_resp(nng_aio *aio, neu_resp_get_template_t *resp)
             tags.tags[j].attribute   = tag->attribute;
             tags.tags[j].precision   = tag->precision;
             tags.tags[j].decimal     = tag->decimal;
+            neu_json_tag_set_report(&tags.tags[j], &tag->report);
             if (neu_tag_attribute_test(tag, NEU_ATTRIBUTE_STATIC)) {
                 neu_tag_get_static_value_json(tag, &tags.tags[j].t,
                                               &tags.tags[j].value);
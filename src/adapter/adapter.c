@@ -49,9 +49,11 @@ static int adapter_response(neu_adapter_t *adapter, neu_reqresp_head_t *header,
 static int adapter_register_metric(neu_adapter_t *adapter, const char *name,
                                    const char *help, neu_metric_type_e type,
                                    uint64_t init);
-static int adapter_update_metric(neu_adapter_t *adapter,
-                                 const char *metric_name, uint64_t n,
-                                 const char *group);
+static void adapter_unregister_metric(neu_adapter_t *adapter,
+                                      const char *   name);
+static int  adapter_update_metric(neu_adapter_t *adapter,
+                                  const char *metric_name, uint64_t n,
+                                  const char *group);
 inline static void reply(neu_adapter_t *adapter, neu_reqresp_head_t *header,
                          void *data);
 inline static void notify_monitor(neu_adapter_t *    adapter,
@@ -59,26 +61,28 @@ inline static void notify_monitor(neu_adapter_t *    adapter,
 static int         level_check(void *usr_data);
 
 static const adapter_callbacks_t callback_funs = {
-    .command         = adapter_command,
-    .response        = adapter_response,
-    .register_metric = adapter_register_metric,
-    .update_metric   = adapter_update_metric,
+    .command           = adapter_command,
+    .response          = adapter_response,
+    .register_metric   = adapter_register_metric,
+    .unregister_metric = adapter_unregister_metric,
+    .update_metric     = adapter_update_metric,
 };
 
 #define REGISTER_METRIC(adapter, name, init) \
     adapter_register_metric(adapter, name, name##_HELP, name##_TYPE, init);
 
-#define REGISTER_DRIVER_METRICS(adapter)                     \
-    REGISTER_METRIC(adapter, NEU_METRIC_LINK_STATE,          \
-                    NEU_NODE_LINK_STATE_DISCONNECTED);       \
-    REGISTER_METRIC(adapter, NEU_METRIC_RUNNING_STATE,       \
-                    NEU_NODE_RUNNING_STATE_INIT);            \
-    REGISTER_METRIC(adapter, NEU_METRIC_LAST_RTT_MS,         \
-                    NEU_METRIC_LAST_RTT_MS_MAX);             \
-    REGISTER_METRIC(adapter, NEU_METRIC_SEND_BYTES, 0);      \
-    REGISTER_METRIC(adapter, NEU_METRIC_RECV_BYTES, 0);      \
-    REGISTER_METRIC(adapter, NEU_METRIC_TAG_READS_TOTAL, 0); \
-    REGISTER_METRIC(adapter, NEU_METRIC_TAG_READ_ERRORS_TOTAL, 0);
+#define REGISTER_DRIVER_METRICS(adapter)                           \
+    REGISTER_METRIC(adapter, NEU_METRIC_LINK_STATE,                \
+                    NEU_NODE_LINK_STATE_DISCONNECTED);             \
+    REGISTER_METRIC(adapter, NEU_METRIC_RUNNING_STATE,             \
+                    NEU_NODE_RUNNING_STATE_INIT);                  \
+    REGISTER_METRIC(adapter, NEU_METRIC_LAST_RTT_MS,               \
+                    NEU_METRIC_LAST_RTT_MS_MAX);                   \
+    REGISTER_METRIC(adapter, NEU_METRIC_SEND_BYTES, 0);            \
+    REGISTER_METRIC(adapter, NEU_METRIC_RECV_BYTES, 0);            \
+    REGISTER_METRIC(adapter, NEU_METRIC_TAG_READS_TOTAL, 0);       \
+    REGISTER_METRIC(adapter, NEU_METRIC_TAG_READ_ERRORS_TOTAL, 0); \
+    REGISTER_METRIC(adapter, NEU_METRIC_MEMORY_BYTES, 0);
 
 #define REGISTER_APP_METRICS(adapter)                              \
     REGISTER_METRIC(adapter, NEU_METRIC_LINK_STATE,                \
@@ -124,15 +128,16 @@ neu_adapter_t *neu_adapter_create(neu_adapter_info_t *info)
         break;
     }
 
-    adapter->name                    = strdup(info->name);
-    adapter->events                  = neu_event_new();
-    adapter->state                   = NEU_NODE_RUNNING_STATE_INIT;
-    adapter->handle                  = info->handle;
-    adapter->cb_funs.command         = callback_funs.command;
-    adapter->cb_funs.response        = callback_funs.response;
-    adapter->cb_funs.register_metric = callback_funs.register_metric;
-    adapter->cb_funs.update_metric   = callback_funs.update_metric;
-    adapter->module                  = info->module;
+    adapter->name                      = strdup(info->name);
+    adapter->events                    = neu_event_new();
+    adapter->state                     = NEU_NODE_RUNNING_STATE_INIT;
+    adapter->handle                    = info->handle;
+    adapter->cb_funs.command           = callback_funs.command;
+    adapter->cb_funs.response          = callback_funs.response;
+    adapter->cb_funs.register_metric   = callback_funs.register_metric;
+    adapter->cb_funs.unregister_metric = callback_funs.unregister_metric;
+    adapter->cb_funs.update_metric     = callback_funs.update_metric;
+    adapter->module                    = info->module;
 
     adapter->timestamp_lev = 0;
 
@@ -280,13 +285,33 @@ static int adapter_register_metric(neu_adapter_t *adapter, const char *name,
         neu_metrics_add_node(adapter);
     }
 
-    if (0 > neu_metric_entries_add(&adapter->metrics->entries, name, help, type,
-                                   init)) {
+    switch (neu_metric_entries_add(&adapter->metrics->entries, name, help,
+                                   type, init)) {
+    case 0:
+        neu_metrics_register_entry(name, help, type);
+        return 0;
+    case 1: // registered already, counted once
+        return 0;
+    default:
         return -1;
     }
+}
+
+static void adapter_unregister_metric(neu_adapter_t *adapter,
+                                      const char *   name)
+{
+    neu_metric_entry_t *entry = NULL;
+
+    if (NULL == adapter->metrics) {
+        return;
+    }
 
-    neu_metrics_register_entry(name, help, type);
-    return 0;
+    HASH_FIND_STR(adapter->metrics->entries, name, entry);
+    if (NULL != entry) {
+        HASH_DEL(adapter->metrics->entries, entry);
+        neu_metric_entry_free(entry);
+        neu_metrics_unregister_entry(name);
+    }
 }
 
 static int adapter_update_metric(neu_adapter_t *adapter,
@@ -599,11 +624,11 @@ static int adapter_loop(enum neu_event_io_type type, int fd, void *usr_data)
     case NEU_REQ_GET_TAG: {
         neu_req_get_tag_t *cmd   = (neu_req_get_tag_t *) &header[1];
         neu_resp_error_t   error = { .error = 0 };
-        UT_array *         tags  = NULL;
+        neu_resp_get_tag_t resp  = { 0 };
 
         if (adapter->module->type == NEU_NA_TYPE_DRIVER) {
             error.error = neu_adapter_driver_query_tag(
-                (neu_adapter_driver_t *) adapter, cmd->group, cmd->name, &tags);
+                (neu_adapter_driver_t *) adapter, cmd, &resp);
         } else {
             error.error = NEU_ERR_GROUP_NOT_ALLOW;
         }
@@ -613,8 +638,6 @@ static int adapter_loop(enum neu_event_io_type type, int fd, void *usr_data)
             header->type = NEU_RESP_ERROR;
             reply(adapter, header, &error);
         } else {
-            neu_resp_get_tag_t resp = { .tags = tags };
-
             header->type = NEU_RESP_GET_TAG;
             reply(adapter, header, &resp);
         }
@@ -765,22 +788,14 @@ static int adapter_loop(enum neu_event_io_type type, int fd, void *usr_data)
         neu_resp_add_tag_t resp = { 0 };
 
         if (adapter->module->type == NEU_NA_TYPE_DRIVER) {
-            for (int i = 0; i < cmd->n_tag; i++) {
-                int ret =
-                    neu_adapter_driver_add_tag((neu_adapter_driver_t *) adapter,
-                                               cmd->group, &cmd->tags[i]);
-                if (ret == 0) {
-                    resp.index += 1;
-                } else {
-                    resp.error = ret;
-                    break;
-                }
-            }
+            resp.error = neu_adapter_driver_add_tags(
+                (neu_adapter_driver_t *) adapter, cmd->group, cmd->tags,
+                cmd->n_tag, &resp.index);
         } else {
             resp.error = NEU_ERR_GROUP_NOT_ALLOW;
         }
 
-        for (uint16_t i = resp.index; i < cmd->n_tag; i++) {
+        for (uint32_t i = resp.index; i < cmd->n_tag; i++) {
             neu_tag_fini(&cmd->tags[i]);
         }
 
@@ -804,7 +819,7 @@ static int adapter_loop(enum neu_event_io_type type, int fd, void *usr_data)
         neu_resp_update_tag_t resp = { 0 };
 
         if (adapter->module->type == NEU_NA_TYPE_DRIVER) {
-            for (int i = 0; i < cmd->n_tag; i++) {
+            for (uint32_t i = 0; i < cmd->n_tag; i++) {
                 int ret = neu_adapter_driver_update_tag(
                     (neu_adapter_driver_t *) adapter, cmd->group,
                     &cmd->tags[i]);
@@ -822,7 +837,7 @@ static int adapter_loop(enum neu_event_io_type type, int fd, void *usr_data)
             resp.error = NEU_ERR_GROUP_NOT_ALLOW;
         }
 
-        for (uint16_t i = resp.index; i < cmd->n_tag; i++) {
+        for (uint32_t i = resp.index; i < cmd->n_tag; i++) {
             neu_tag_fini(&cmd->tags[i]);
         }
         if (resp.index > 0) {
@@ -1112,11 +1127,28 @@ int neu_adapter_validate_tag(neu_adapter_t *adapter, neu_datatag_t *tag)
     const neu_plugin_intf_funs_t *intf_funs = adapter->module->intf_funs;
     neu_err_code_e                error     = NEU_ERR_SUCCESS;
 
+    neu_tag_clear_meta(tag);
     error = intf_funs->driver.validate_tag(adapter->plugin, tag);
 
     return error;
 }
 
+int neu_adapter_send_trans_data(neu_adapter_t *adapter, nng_msg *msg)
+{
+    neu_reqresp_head_t *header = nng_msg_body(msg);
+    int                 ret    = 0;
+
+    strcpy(header->sender, adapter->name);
+    neu_trans_data_msg_trim(msg);
+
+    ret = nng_sendmsg(adapter->sock, msg, 0);
+    if (ret != 0) {
+        nng_msg_free(msg);
+    }
+
+    return ret;
+}
+
 neu_event_timer_t *neu_adapter_add_timer(neu_adapter_t *         adapter,
                                          neu_event_timer_param_t param)
 {
@@ -1268,251 +1300,3 @@ static int level_check(void *usr_data)
 
     return 0;
 }
-
-void *neu_msg_gen(neu_reqresp_head_t *header, void *data)
-{
-    nng_msg *msg       = NULL;
-    void *   body      = NULL;
-    size_t   data_size = 0;
-
-    switch (header->type) {
-    case NEU_REQ_NODE_INIT:
-    case NEU_REQ_NODE_UNINIT:
-    case NEU_RESP_NODE_UNINIT:
-        data_size = sizeof(neu_req_node_init_t);
-        break;
-    case NEU_RESP_ERROR:
-        data_size = sizeof(neu_resp_error_t);
-        break;
-    case NEU_REQ_ADD_PLUGIN:
-        data_size = sizeof(neu_req_add_plugin_t);
-        break;
-    case NEU_REQ_DEL_PLUGIN:
-        data_size = sizeof(neu_req_del_plugin_t);
-        break;
-    case NEU_REQ_GET_PLUGIN:
-        data_size = sizeof(neu_req_get_plugin_t);
-        break;
-    case NEU_RESP_GET_PLUGIN:
-        data_size = sizeof(neu_resp_get_plugin_t);
-        break;
-    case NEU_REQ_ADD_TEMPLATE:
-        data_size = sizeof(neu_req_add_template_t);
-        break;
-    case NEU_REQ_DEL_TEMPLATE:
-        data_size = sizeof(neu_req_del_template_t);
-        break;
-    case NEU_REQ_GET_TEMPLATE:
-        data_size = sizeof(neu_req_get_template_t);
-        break;
-    case NEU_RESP_GET_TEMPLATE:
-        data_size = sizeof(neu_resp_get_template_t);
-        break;
-    case NEU_REQ_GET_TEMPLATES:
-        data_size = sizeof(neu_req_get_templates_t);
-        break;
-    case NEU_RESP_GET_TEMPLATES:
-        data_size = sizeof(neu_resp_get_templates_t);
-        break;
-    case NEU_REQ_ADD_TEMPLATE_GROUP:
-        data_size = sizeof(neu_req_add_template_group_t);
-        break;
-    case NEU_REQ_DEL_TEMPLATE_GROUP:
-        data_size = sizeof(neu_req_del_template_group_t);
-        break;
-    case NEU_REQ_UPDATE_TEMPLATE_GROUP:
-        data_size = sizeof(neu_req_update_template_group_t);
-        break;
-    case NEU_REQ_GET_TEMPLATE_GROUP:
-        data_size = sizeof(neu_req_get_template_group_t);
-        break;
-    case NEU_REQ_ADD_TEMPLATE_TAG:
-        data_size = sizeof(neu_req_add_template_tag_t);
-        break;
-    case NEU_REQ_DEL_TEMPLATE_TAG:
-        data_size = sizeof(neu_req_del_template_tag_t);
-        break;
-    case NEU_REQ_UPDATE_TEMPLATE_TAG:
-        data_size = sizeof(neu_req_update_template_tag_t);
-        break;
-    case NEU_REQ_GET_TEMPLATE_TAG:
-        data_size = sizeof(neu_req_get_template_tag_t);
-        break;
-    case NEU_REQ_INST_TEMPLATE:
-        data_size = sizeof(neu_req_inst_template_t);
-        break;
-    case NEU_REQ_ADD_NODE:
-    case NEU_REQ_ADD_NODE_EVENT:
-        data_size = sizeof(neu_req_add_node_t);
-        break;
-    case NEU_REQ_UPDATE_NODE:
-        data_size = sizeof(neu_req_update_node_t);
-        break;
-    case NEU_REQ_DEL_NODE:
-    case NEU_REQ_DEL_NODE_EVENT:
-        data_size = sizeof(neu_req_del_node_t);
-        break;
-    case NEU_REQ_GET_NODE:
-        data_size = sizeof(neu_req_get_node_t);
-        break;
-    case NEU_RESP_GET_NODE:
-        data_size = sizeof(neu_resp_get_node_t);
-        break;
-    case NEU_REQ_ADD_GROUP:
-    case NEU_REQ_ADD_GROUP_EVENT:
-        data_size = sizeof(neu_req_add_group_t);
-        break;
-    case NEU_REQ_UPDATE_GROUP:
-    case NEU_REQ_UPDATE_GROUP_EVENT:
-        data_size = sizeof(neu_req_update_group_t);
-        break;
-    case NEU_REQ_DEL_GROUP:
-    case NEU_REQ_DEL_GROUP_EVENT:
-        data_size = sizeof(neu_req_del_group_t);
-        break;
-    case NEU_REQ_GET_DRIVER_GROUP:
-    case NEU_REQ_GET_GROUP:
-        data_size = sizeof(neu_req_get_group_t);
-        break;
-    case NEU_RESP_GET_GROUP:
-        data_size = sizeof(neu_resp_get_group_t);
-        break;
-    case NEU_REQ_ADD_TAG:
-    case NEU_REQ_ADD_TAG_EVENT:
-        data_size = sizeof(neu_req_add_tag_t);
-        break;
-    case NEU_RESP_ADD_TAG:
-    case NEU_RESP_ADD_TEMPLATE_TAG:
-        data_size = sizeof(neu_resp_add_tag_t);
-        break;
-    case NEU_RESP_UPDATE_TAG:
-    case NEU_RESP_UPDATE_TEMPLATE_TAG:
-        data_size = sizeof(neu_resp_update_tag_t);
-        break;
-    case NEU_REQ_UPDATE_TAG:
-    case NEU_REQ_UPDATE_TAG_EVENT:
-        data_size = sizeof(neu_req_update_tag_t);
-        break;
-    case NEU_REQ_DEL_TAG:
-    case NEU_REQ_DEL_TAG_EVENT:
-        data_size = sizeof(neu_req_del_tag_t);
-        break;
-    case NEU_REQ_GET_TAG:
-        data_size = sizeof(neu_req_get_tag_t);
-        break;
-    case NEU_RESP_GET_TAG:
-    case NEU_RESP_GET_TEMPLATE_TAG:
-        data_size = sizeof(neu_resp_get_tag_t);
-        break;
-    case NEU_REQ_SUBSCRIBE_GROUP:
-        data_size = sizeof(neu_req_subscribe_t);
-        break;
-    case NEU_REQ_UNSUBSCRIBE_GROUP:
-        data_size = sizeof(neu_req_unsubscribe_t);
-        break;
-    case NEU_REQ_GET_SUBSCRIBE_GROUP:
-    case NEU_REQ_GET_SUB_DRIVER_TAGS:
-        data_size = sizeof(neu_req_get_subscribe_group_t);
-        break;
-    case NEU_RESP_GET_SUB_DRIVER_TAGS:
-        data_size = sizeof(neu_resp_get_sub_driver_tags_t);
-        break;
-    case NEU_RESP_GET_SUBSCRIBE_GROUP:
-        data_size = sizeof(neu_resp_get_subscribe_group_t);
-        break;
-    case NEU_REQ_NODE_SETTING:
-    case NEU_REQ_NODE_SETTING_EVENT:
-        data_size = sizeof(neu_req_node_setting_t);
-        break;
-    case NEU_REQ_GET_NODE_SETTING:
-        data_size = sizeof(neu_req_get_node_setting_t);
-        break;
-    case NEU_RESP_GET_NODE_SETTING:
-        data_size = sizeof(neu_resp_get_node_setting_t);
-        break;
-    case NEU_REQ_NODE_CTL:
-    case NEU_REQ_NODE_CTL_EVENT:
-        data_size = sizeof(neu_req_node_ctl_t);
-        break;
-    case NEU_REQ_NODE_RENAME:
-        data_size = sizeof(neu_req_node_rename_t);
-        break;
-    case NEU_RESP_NODE_RENAME:
-        data_size = sizeof(neu_resp_node_rename_t);
-        break;
-    case NEU_REQ_GET_NODE_STATE:
-        data_size = sizeof(neu_req_get_node_state_t);
-        break;
-    case NEU_RESP_GET_NODE_STATE:
-        data_size = sizeof(neu_resp_get_node_state_t);
-        break;
-    case NEU_REQ_GET_NODES_STATE:
-        data_size = sizeof(neu_req_get_nodes_state_t);
-        break;
-    case NEU_REQRESP_NODES_STATE:
-    case NEU_RESP_GET_NODES_STATE:
-        data_size = sizeof(neu_resp_get_nodes_state_t);
-        break;
-    case NEU_REQ_READ_GROUP:
-        data_size = sizeof(neu_req_read_group_t);
-        break;
-    case NEU_REQ_WRITE_TAG:
-        data_size = sizeof(neu_req_write_tag_t);
-        break;
-    case NEU_REQ_WRITE_TAGS:
-        data_size = sizeof(neu_req_write_tags_t);
-        break;
-    case NEU_RESP_READ_GROUP:
-        data_size = sizeof(neu_resp_read_group_t);
-        break;
-    case NEU_REQRESP_TRANS_DATA: {
-        neu_reqresp_trans_data_t *trans = (neu_reqresp_trans_data_t *) data;
-        data_size                       = sizeof(neu_reqresp_trans_data_t) +
-            trans->n_tag * sizeof(neu_resp_tag_value_t);
-        break;
-    }
-    case NEU_REQ_UPDATE_LICENSE:
-        data_size = sizeof(neu_req_update_license_t);
-        break;
-    case NEU_REQRESP_NODE_DELETED:
-        data_size = sizeof(neu_reqresp_node_deleted_t);
-        break;
-    case NEU_RESP_GET_DRIVER_GROUP:
-        data_size = sizeof(neu_resp_get_driver_group_t);
-        break;
-    case NEU_REQ_ADD_NDRIVER_MAP:
-    case NEU_REQ_DEL_NDRIVER_MAP:
-        data_size = sizeof(neu_req_ndriver_map_t);
-        break;
-    case NEU_REQ_GET_NDRIVER_MAPS:
-        data_size = sizeof(neu_req_get_ndriver_maps_t);
-        break;
-    case NEU_RESP_GET_NDRIVER_MAPS:
-        data_size = sizeof(neu_resp_get_ndriver_maps_t);
-        break;
-    case NEU_REQ_UPDATE_NDRIVER_TAG_PARAM:
-        data_size = sizeof(neu_req_update_ndriver_tag_param_t);
-        break;
-    case NEU_REQ_UPDATE_NDRIVER_TAG_INFO:
-        data_size = sizeof(neu_req_update_ndriver_tag_info_t);
-        break;
-    case NEU_REQ_GET_NDRIVER_TAGS:
-        data_size = sizeof(neu_req_get_ndriver_tags_t);
-        break;
-    case NEU_RESP_GET_NDRIVER_TAGS:
-        data_size = sizeof(neu_resp_get_ndriver_tags_t);
-        break;
-    case NEU_REQ_UPDATE_LOG_LEVEL:
-        data_size = sizeof(neu_req_update_log_level_t);
-        break;
-    default:
-        assert(false);
-        break;
-    }
-
-    nng_msg_alloc(&msg, sizeof(neu_reqresp_head_t) + data_size);
-    body = nng_msg_body(msg);
-    memcpy(body, header, sizeof(neu_reqresp_head_t));
-    memcpy((uint8_t *) body + sizeof(neu_reqresp_head_t), data, data_size);
-    return msg;
-}
\ No newline at end of file
@@ -87,6 +87,12 @@ neu_node_state_t neu_adapter_get_state(neu_adapter_t *adapter);
 
 int neu_adapter_validate_tag(neu_adapter_t *adapter, neu_datatag_t *tag);
 
+/**
+ * Send a trans data message from neu_trans_data_msg_alloc, trimmed to the
+ * tags filled. It is freed on failure.
+ */
+int neu_adapter_send_trans_data(neu_adapter_t *adapter, nng_msg *msg);
+
 int  neu_adapter_register_group_metric(neu_adapter_t *adapter,
                                        const char *group_name, const char *name,
                                        const char *help, neu_metric_type_e type,
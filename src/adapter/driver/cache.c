@@ -38,10 +38,16 @@ typedef struct {
 
 struct elem {
     int64_t timestamp;
-    bool    changed;
 
     neu_dvalue_t value;
 
+    // the last reported value, strings and bytes are compared by hash
+    bool       reported;
+    int64_t    report_ts;
+    neu_type_e report_type;
+    uint64_t   report_bits;
+    double     report_num;
+
     tkey_t         key;
     UT_hash_handle hh;
 };
@@ -92,6 +98,23 @@ void neu_driver_cache_destroy(neu_driver_cache_t *cache)
     free(cache);
 }
 
+size_t neu_driver_cache_memory(neu_driver_cache_t *cache)
+{
+    size_t size = sizeof(neu_driver_cache_t);
+
+    nng_mtx_lock(cache->mtx);
+    size += HASH_COUNT(cache->table) * sizeof(struct elem);
+    size += HASH_OVERHEAD(hh, cache->table);
+    nng_mtx_unlock(cache->mtx);
+
+    return size;
+}
+
+size_t neu_driver_cache_entry_size()
+{
+    return sizeof(struct elem);
+}
+
 // void neu_driver_cache_error(neu_driver_cache_t *cache, const char *group,
 // const char *tag, int64_t timestamp, int32_t error)
 //{
@@ -117,7 +140,7 @@ void neu_driver_cache_add(neu_driver_cache_t *cache, const char *group,
     }
 
     elem->timestamp = 0;
-    elem->changed   = false;
+    elem->reported  = false;
     elem->value     = value;
 
     nng_mtx_unlock(cache->mtx);
@@ -134,57 +157,6 @@ void neu_driver_cache_update(neu_driver_cache_t *cache, const char *group,
     HASH_FIND(hh, cache->table, &key, sizeof(tkey_t), elem);
     if (elem != NULL) {
         elem->timestamp = timestamp;
-        if (elem->value.type != value.type) {
-            elem->changed = true;
-        } else {
-            switch (value.type) {
-            case NEU_TYPE_INT8:
-            case NEU_TYPE_UINT8:
-            case NEU_TYPE_INT16:
-            case NEU_TYPE_UINT16:
-            case NEU_TYPE_INT32:
-            case NEU_TYPE_UINT32:
-            case NEU_TYPE_INT64:
-            case NEU_TYPE_UINT64:
-            case NEU_TYPE_BIT:
-            case NEU_TYPE_BOOL:
-            case NEU_TYPE_STRING:
-            case NEU_TYPE_BYTES:
-            case NEU_TYPE_WORD:
-            case NEU_TYPE_DWORD:
-            case NEU_TYPE_LWORD:
-                if (memcmp(&elem->value.value, &value.value,
-                           sizeof(value.value)) != 0) {
-                    elem->changed = true;
-                }
-                break;
-            case NEU_TYPE_FLOAT:
-                if (elem->value.precision == 0) {
-                    elem->changed = elem->value.value.f32 != value.value.f32;
-                } else {
-                    if (fabs(elem->value.value.f32 - value.value.f32) >
-                        pow(0.1, elem->value.precision)) {
-                        elem->changed = true;
-                    }
-                }
-                break;
-            case NEU_TYPE_DOUBLE:
-                if (elem->value.precision == 0) {
-                    elem->changed = elem->value.value.d64 != value.value.d64;
-                } else {
-                    if (fabs(elem->value.value.d64 - value.value.d64) >
-                        pow(0.1, elem->value.precision)) {
-                        elem->changed = true;
-                    }
-                }
-
-                break;
-            case NEU_TYPE_ERROR:
-                elem->changed = true;
-                break;
-            }
-        }
-
         elem->value.type  = value.type;
         elem->value.value = value.value;
     }
@@ -249,60 +221,153 @@ int neu_driver_cache_get(neu_driver_cache_t *cache, const char *group,
     return ret;
 }
 
-int neu_driver_cache_get_changed(neu_driver_cache_t *cache, const char *group,
-                                 const char *              tag,
-                                 neu_driver_cache_value_t *value)
+static uint64_t hash_bytes(const void *data, size_t len)
+{
+    const uint8_t *p    = data;
+    uint64_t       hash = 14695981039346656037ULL; // FNV-1a
+
+    for (size_t i = 0; i < len; ++i) {
+        hash = (hash ^ p[i]) * 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+static uint64_t value_bits(const neu_dvalue_t *value)
+{
+    switch (value->type) {
+    case NEU_TYPE_INT8:
+    case NEU_TYPE_UINT8:
+    case NEU_TYPE_BIT:
+        return value->value.u8;
+    case NEU_TYPE_BOOL:
+        return value->value.boolean;
+    case NEU_TYPE_INT16:
+    case NEU_TYPE_UINT16:
+    case NEU_TYPE_WORD:
+        return value->value.u16;
+    case NEU_TYPE_INT32:
+    case NEU_TYPE_UINT32:
+    case NEU_TYPE_DWORD:
+    case NEU_TYPE_FLOAT:
+    case NEU_TYPE_ERROR:
+        return value->value.u32;
+    case NEU_TYPE_INT64:
+    case NEU_TYPE_UINT64:
+    case NEU_TYPE_LWORD:
+    case NEU_TYPE_DOUBLE:
+        return value->value.u64;
+    case NEU_TYPE_STRING:
+        return hash_bytes(value->value.str,
+                          strnlen(value->value.str, sizeof(value->value.str)));
+    case NEU_TYPE_BYTES:
+    default:
+        return hash_bytes(value->value.bytes, sizeof(value->value.bytes));
+    }
+}
+
+static bool value_num(const neu_dvalue_t *value, double *num)
+{
+    switch (value->type) {
+    case NEU_TYPE_INT8:
+        *num = value->value.i8;
+        break;
+    case NEU_TYPE_UINT8:
+    case NEU_TYPE_BIT:
+        *num = value->value.u8;
+        break;
+    case NEU_TYPE_INT16:
+        *num = value->value.i16;
+        break;
+    case NEU_TYPE_UINT16:
+    case NEU_TYPE_WORD:
+        *num = value->value.u16;
+        break;
+    case NEU_TYPE_INT32:
+        *num = value->value.i32;
+        break;
+    case NEU_TYPE_UINT32:
+    case NEU_TYPE_DWORD:
+        *num = value->value.u32;
+        break;
+    case NEU_TYPE_INT64:
+        *num = value->value.i64;
+        break;
+    case NEU_TYPE_UINT64:
+    case NEU_TYPE_LWORD:
+        *num = value->value.u64;
+        break;
+    case NEU_TYPE_FLOAT:
+        *num = value->value.f32;
+        break;
+    case NEU_TYPE_DOUBLE:
+        *num = value->value.d64;
+        break;
+    default:
+        return false;
+    }
+
+    return true;
+}
+
+static bool value_changed(const struct elem *elem, const neu_dvalue_t *value,
+                          const neu_tag_report_t *report, uint64_t bits)
+{
+    double num = 0;
+
+    if (elem->report_type != value->type) {
+        return true;
+    }
+
+    if (report->deadband > 0 && value_num(value, &num)) {
+        double delta = fabs(num - elem->report_num);
+        if (NEU_DEADBAND_PERCENT == report->deadband_type) {
+            return delta > fabs(elem->report_num) * report->deadband / 100.0;
+        }
+        return delta > report->deadband;
+    }
+
+    if ((NEU_TYPE_FLOAT == value->type || NEU_TYPE_DOUBLE == value->type) &&
+        value->precision > 0 && value_num(value, &num)) {
+        return fabs(num - elem->report_num) > pow(0.1, value->precision);
+    }
+
+    return bits != elem->report_bits;
+}
+
+bool neu_driver_cache_report_test(neu_driver_cache_t *cache, const char *group,
+                                  const char *            tag,
+                                  const neu_tag_report_t *report,
+                                  const neu_dvalue_t *value, int64_t now)
 {
     struct elem *elem = NULL;
-    int          ret  = -1;
+    bool         ret  = true;
     tkey_t       key  = to_key(group, tag);
+    uint64_t     bits = value_bits(value);
 
     nng_mtx_lock(cache->mtx);
     HASH_FIND(hh, cache->table, &key, sizeof(tkey_t), elem);
 
-    if (elem != NULL && elem->changed) {
-        value->timestamp       = elem->timestamp;
-        value->value.type      = elem->value.type;
-        value->value.precision = elem->value.precision;
-
-        switch (elem->value.type) {
-        case NEU_TYPE_INT8:
-        case NEU_TYPE_UINT8:
-        case NEU_TYPE_BIT:
-            value->value.value.u8 = elem->value.value.u8;
-            break;
-        case NEU_TYPE_INT16:
-        case NEU_TYPE_UINT16:
-        case NEU_TYPE_WORD:
-            value->value.value.u16 = elem->value.value.u16;
-            break;
-        case NEU_TYPE_INT32:
-        case NEU_TYPE_UINT32:
-        case NEU_TYPE_FLOAT:
-        case NEU_TYPE_ERROR:
-        case NEU_TYPE_DWORD:
-            value->value.value.u32 = elem->value.value.u32;
-            break;
-        case NEU_TYPE_INT64:
-        case NEU_TYPE_UINT64:
-        case NEU_TYPE_DOUBLE:
-        case NEU_TYPE_LWORD:
-            value->value.value.u64 = elem->value.value.u64;
-            break;
-        case NEU_TYPE_BOOL:
-            value->value.value.boolean = elem->value.value.boolean;
-            break;
-        case NEU_TYPE_STRING:
-        case NEU_TYPE_BYTES:
-            memcpy(value->value.value.str, elem->value.value.str,
-                   sizeof(elem->value.value.str));
-            break;
+    if (elem != NULL) {
+        if (!elem->reported) {
+            ret = true;
+        } else if (now - elem->report_ts < (int64_t) report->min_interval) {
+            ret = false;
+        } else if (value_changed(elem, value, report, bits)) {
+            ret = true;
+        } else {
+            ret = report->heartbeat > 0 &&
+                now - elem->report_ts >= (int64_t) report->heartbeat;
         }
 
-        if (elem->value.type != NEU_TYPE_ERROR) {
-            elem->changed = false;
+        if (ret) {
+            elem->reported    = true;
+            elem->report_ts   = now;
+            elem->report_type = value->type;
+            elem->report_bits = bits;
+            elem->report_num  = 0;
+            value_num(value, &elem->report_num);
         }
-        ret = 0;
     }
 
     nng_mtx_unlock(cache->mtx);
@@ -20,14 +20,19 @@
 #ifndef _NEU_DRIVER_CACHE_H_
 #define _NEU_DRIVER_CACHE_H_
 
+#include <stdbool.h>
 #include <stdint.h>
 
+#include "tag.h"
 #include "type.h"
 
 typedef struct neu_driver_cache neu_driver_cache_t;
 
 neu_driver_cache_t *neu_driver_cache_new();
 void                neu_driver_cache_destroy(neu_driver_cache_t *cache);
+// bytes held by the cache, and by each of its tags
+size_t neu_driver_cache_memory(neu_driver_cache_t *cache);
+size_t neu_driver_cache_entry_size();
 
 void neu_driver_cache_add(neu_driver_cache_t *cache, const char *group,
                           const char *tag, neu_dvalue_t value);
@@ -45,8 +50,18 @@ typedef struct {
 
 int neu_driver_cache_get(neu_driver_cache_t *cache, const char *group,
                          const char *tag, neu_driver_cache_value_t *value);
-int neu_driver_cache_get_changed(neu_driver_cache_t *cache, const char *group,
-                                 const char *              tag,
-                                 neu_driver_cache_value_t *value);
+
+/**
+ * @brief Report by exception, test whether `value` of a tag, as it is
+ *        uploaded, should be reported at `now` given its report settings,
+ *        and record it as the last reported value if so.
+ *
+ * Compares against the last reported value rather than the last read one,
+ * so that slow drifts are still reported once beyond the deadband.
+ */
+bool neu_driver_cache_report_test(neu_driver_cache_t *cache, const char *group,
+                                  const char *            tag,
+                                  const neu_tag_report_t *report,
+                                  const neu_dvalue_t *value, int64_t now);
 
 #endif
@@ -32,6 +32,7 @@
 #include "adapter.h"
 #include "adapter/adapter_internal.h"
 #include "adapter/storage.h"
+#include "argparse.h"
 #include "base/group.h"
 #include "cache.h"
 #include "driver_internal.h"
@@ -57,8 +58,10 @@ typedef struct group {
 
     neu_event_timer_t *report;
     neu_event_timer_t *read;
+    uint32_t           n_report;
 
     neu_plugin_group_t    grp;
+    size_t                tags_memory; // of grp.tags, under wt_mtx
     neu_adapter_driver_t *driver;
 
     UT_hash_handle hh;
@@ -71,6 +74,11 @@ struct neu_adapter_driver {
     neu_events_t *      driver_events;
 
     struct group *groups;
+
+    size_t  memory; // bytes, counted by update_memory, charged per request
+    int64_t memory_ts;
+    bool    memory_soft;
+    bool    memory_hard;
 };
 
 static int  report_callback(void *usr_data);
@@ -78,9 +86,11 @@ static int  read_callback(void *usr_data);
 static void read_group(int64_t timestamp, int64_t timeout,
                        neu_driver_cache_t *cache, const char *group,
                        UT_array *tags, neu_resp_tag_value_t *datas);
-static int  read_report_group(int64_t timestamp, int64_t timeout,
-                              neu_driver_cache_t *cache, const char *group,
-                              UT_array *tags, neu_resp_tag_value_t *datas);
+static uint32_t read_report_group(int64_t timestamp, int64_t timeout,
+                                  neu_driver_cache_t *cache,
+                                  const char *group, UT_array *tags,
+                                  neu_resp_tag_value_t *datas,
+                                  int64_t *latest);
 static void update(neu_adapter_t *adapter, const char *group, const char *tag,
                    neu_dvalue_t value);
 static void write_response(neu_adapter_t *adapter, void *r, neu_error error);
@@ -149,6 +159,126 @@ static void update(neu_adapter_t *adapter, const char *group, const char *tag,
         global_timestamp);
 }
 
+static size_t tag_memory(const neu_datatag_t *tag)
+{
+    return sizeof(neu_datatag_t) + strlen(tag->name) + 1 +
+        strlen(tag->address) + 1 + strlen(tag->description) + 1;
+}
+
+static size_t tags_memory(UT_array *tags)
+{
+    size_t size = 0;
+
+    if (tags == NULL) {
+        return 0;
+    }
+
+    utarray_foreach(tags, neu_datatag_t *, tag) { size += tag_memory(tag); }
+
+    return size;
+}
+
+// a tag is held by its group, by the copy the plugin reads and by the cache
+static size_t tag_cost(const neu_datatag_t *tag)
+{
+    return 2 * tag_memory(tag) + neu_driver_cache_entry_size();
+}
+
+// the copies of the tags handed to the plugin and the writes not yet done
+static size_t group_pending_memory(group_t *group)
+{
+    size_t size = 0;
+
+    pthread_mutex_lock(&group->wt_mtx);
+    size += group->tags_memory;
+    size += utarray_len(group->wt_tags) * sizeof(to_be_write_tag_t);
+    utarray_foreach(group->wt_tags, to_be_write_tag_t *, wtag)
+    {
+        if (wtag->single) {
+            size += tag_memory(wtag->tag);
+        } else {
+            size += utarray_len(wtag->tvs) * sizeof(neu_plugin_tag_value_t);
+            utarray_foreach(wtag->tvs, neu_plugin_tag_value_t *, tv)
+            {
+                size += tag_memory(tv->tag);
+            }
+        }
+    }
+    pthread_mutex_unlock(&group->wt_mtx);
+
+    return size;
+}
+
+// publish the bytes held by the node and check them against the limits
+static void account_memory(neu_adapter_driver_t *driver, size_t memory)
+{
+    bool soft =
+        g_node_memory_soft_limit > 0 && memory >= g_node_memory_soft_limit;
+    bool hard =
+        g_node_memory_hard_limit > 0 && memory >= g_node_memory_hard_limit;
+
+    if (soft != driver->memory_soft) {
+        nlog_warn("%s memory %zu bytes, %s soft limit %zu, report rate %s",
+                  driver->adapter.name, memory, soft ? "over" : "back under",
+                  g_node_memory_soft_limit, soft ? "halved" : "restored");
+    }
+    if (hard != driver->memory_hard) {
+        nlog_warn("%s memory %zu bytes, %s hard limit %zu, %s",
+                  driver->adapter.name, memory, hard ? "over" : "back under",
+                  g_node_memory_hard_limit,
+                  hard ? "refusing tags, groups and writes"
+                       : "accepting tags, groups and writes");
+    }
+
+    driver->memory      = memory;
+    driver->memory_soft = soft;
+    driver->memory_hard = hard;
+    driver->adapter.cb_funs.update_metric(
+        &driver->adapter, NEU_METRIC_MEMORY_BYTES, memory, NULL);
+}
+
+/*
+ * Recount the bytes held by the node. Counting walks every group, so the
+ * report timers do it at most once a second and group changes right away,
+ * tag changes only charge what they add or remove.
+ */
+static void update_memory(neu_adapter_driver_t *driver)
+{
+    group_t *el = NULL, *tmp = NULL;
+    size_t   memory = neu_driver_cache_memory(driver->cache);
+
+    HASH_ITER(hh, driver->groups, el, tmp)
+    {
+        memory += sizeof(group_t) + neu_group_memory(el->group);
+        memory += group_pending_memory(el);
+    }
+
+    driver->memory_ts = global_timestamp;
+    account_memory(driver, memory);
+}
+
+// charge bytes taken (delta > 0) or given back (delta < 0) by a request
+static void charge_memory(neu_adapter_driver_t *driver, int64_t delta)
+{
+    if (delta < 0 && (size_t)(-delta) > driver->memory) {
+        account_memory(driver, 0);
+    } else {
+        account_memory(driver, driver->memory + delta);
+    }
+}
+
+// bytes the node may still take under the hard limit, SIZE_MAX without one
+static size_t memory_left(neu_adapter_driver_t *driver)
+{
+    if (g_node_memory_hard_limit == 0) {
+        return SIZE_MAX;
+    }
+
+    return driver->memory < g_node_memory_hard_limit
+        ? g_node_memory_hard_limit - driver->memory
+        : 0;
+}
+
 neu_adapter_driver_t *neu_adapter_driver_create()
 {
     neu_adapter_driver_t *driver = calloc(1, sizeof(neu_adapter_driver_t));
@@ -268,7 +398,7 @@ void neu_adapter_driver_read_group(neu_adapter_driver_t *driver,
 
     neu_resp_read_group_t resp  = { 0 };
     neu_group_t *         group = g->group;
-    UT_array *            tags  = neu_group_get_read_tag(group);
+    UT_array *            tags  = neu_group_read_tags(group);
 
     resp.n_tag = utarray_len(tags);
     resp.tags  = calloc(1, utarray_len(tags) * sizeof(neu_resp_tag_value_t));
@@ -292,13 +422,11 @@ void neu_adapter_driver_read_group(neu_adapter_driver_t *driver,
     strcpy(resp.driver, cmd->driver);
     strcpy(resp.group, cmd->group);
 
-    utarray_free(tags);
-
     req->type = NEU_RESP_READ_GROUP;
     driver->adapter.cb_funs.response(&driver->adapter, req, &resp);
 }
 
-static void fix_value(neu_datatag_t *tag, neu_type_e value_type,
+static void fix_value(const neu_datatag_t *tag, neu_type_e value_type,
                       neu_dvalue_t *value)
 {
     switch (tag->type) {
@@ -450,6 +578,13 @@ void neu_adapter_driver_write_tags(neu_adapter_driver_t *driver,
         return;
     }
 
+    if (driver->memory_hard) {
+        free_tags(cmd);
+        driver->adapter.cb_funs.driver.write_response(
+            &driver->adapter, req, NEU_ERR_NODE_MEMORY_LIMIT);
+        return;
+    }
+
     group_t *g = find_group(driver, cmd->group);
 
     if (g == NULL) {
@@ -467,9 +602,11 @@ void neu_adapter_driver_write_tags(neu_adapter_driver_t *driver,
     for (int i = 0; i < cmd->n_tag; i++) {
         neu_plugin_tag_value_t tv = { 0 };
 
-        neu_datatag_t *tag = neu_group_find_tag(g->group, cmd->tags[i].tag);
+        const neu_datatag_t *tag =
+            neu_group_find_tag(g->group, cmd->tags[i].tag);
         if (tag != NULL && neu_tag_attribute_test(tag, NEU_ATTRIBUTE_WRITE) &&
             neu_tag_attribute_test(tag, NEU_ATTRIBUTE_STATIC) == false) {
+            // written later by the driver thread, keep a copy
             tv.tag = neu_tag_dup(tag);
 
             if (tag->type == NEU_TYPE_FLOAT || tag->type == NEU_TYPE_DOUBLE) {
@@ -485,10 +622,6 @@ void neu_adapter_driver_write_tags(neu_adapter_driver_t *driver,
 
             tv.value = cmd->tags[i].value.value;
             utarray_push_back(tags, &tv);
-        } else {
-            if (tag != NULL) {
-                neu_tag_free(tag);
-            }
         }
     }
 
@@ -534,7 +667,7 @@ void neu_adapter_driver_write_tag(neu_adapter_driver_t *driver,
         free(req);
         return;
     }
-    neu_datatag_t *tag = neu_group_find_tag(g->group, cmd->tag);
+    const neu_datatag_t *tag = neu_group_find_tag(g->group, cmd->tag);
 
     if (tag == NULL) {
         neu_resp_error_t error = { .error = NEU_ERR_TAG_NOT_EXIST };
@@ -546,7 +679,6 @@ void neu_adapter_driver_write_tag(neu_adapter_driver_t *driver,
         if ((tag->attribute & NEU_ATTRIBUTE_WRITE) != NEU_ATTRIBUTE_WRITE) {
             driver->adapter.cb_funs.driver.write_response(
                 &driver->adapter, req, NEU_ERR_PLUGIN_TAG_NOT_ALLOW_WRITE);
-            neu_tag_free(tag);
             return;
         }
         if (tag->type == NEU_TYPE_FLOAT || tag->type == NEU_TYPE_DOUBLE) {
@@ -563,15 +695,22 @@ void neu_adapter_driver_write_tag(neu_adapter_driver_t *driver,
         fix_value(tag, cmd->value.type, &cmd->value);
 
         if (neu_tag_attribute_test(tag, NEU_ATTRIBUTE_STATIC)) {
+            neu_datatag_t *value_tag = neu_tag_dup(tag);
+
             neu_driver_cache_update(g->driver->cache, g->name, tag->name,
                                     global_timestamp, cmd->value);
-            neu_tag_set_static_value(tag, &cmd->value.value);
-            neu_group_update_tag(g->group, tag);
-            adapter_storage_update_tag_value(cmd->driver, cmd->group, tag);
+            neu_tag_set_static_value(value_tag, &cmd->value.value);
+            neu_group_update_tag(g->group, value_tag);
+            adapter_storage_update_tag_value(cmd->driver, cmd->group,
+                                             value_tag);
+            neu_tag_free(value_tag);
             neu_resp_error_t error = { .error = NEU_ERR_SUCCESS };
             req->type              = NEU_RESP_ERROR;
             driver->adapter.cb_funs.response(&driver->adapter, req, &error);
             free(req);
+        } else if (driver->memory_hard) {
+            driver->adapter.cb_funs.driver.write_response(
+                &driver->adapter, req, NEU_ERR_NODE_MEMORY_LIMIT);
         } else {
             to_be_write_tag_t wtag = { 0 };
             wtag.single            = true;
@@ -581,8 +720,6 @@ void neu_adapter_driver_write_tag(neu_adapter_driver_t *driver,
 
             store_write_tag(g, &wtag);
         }
-
-        neu_tag_free(tag);
     }
 }
 
@@ -598,7 +735,9 @@ int neu_adapter_driver_add_group(neu_adapter_driver_t *driver, const char *name,
     int      ret  = NEU_ERR_GROUP_EXIST;
 
     HASH_FIND_STR(driver->groups, name, find);
-    if (find == NULL) {
+    if (find == NULL && memory_left(driver) < sizeof(group_t)) {
+        ret = NEU_ERR_NODE_MEMORY_LIMIT;
+    } else if (find == NULL) {
         find = calloc(1, sizeof(group_t));
 
         neu_event_timer_param_t param = {
@@ -634,6 +773,7 @@ int neu_adapter_driver_add_group(neu_adapter_driver_t *driver, const char *name,
                               NEU_METRIC_GROUP_LAST_TIMER_MS, 0);
 
         HASH_ADD_STR(driver->groups, name, find);
+        update_memory(driver);
         ret = NEU_ERR_SUCCESS;
     }
 
@@ -720,6 +860,7 @@ int neu_adapter_driver_del_group(neu_adapter_driver_t *driver, const char *name)
 
         pthread_mutex_destroy(&find->wt_mtx);
         neu_adapter_del_group_metrics(&driver->adapter, name);
+        update_memory(driver);
         ret = NEU_ERR_SUCCESS;
     }
 
@@ -770,12 +911,33 @@ UT_array *neu_adapter_driver_get_group(neu_adapter_driver_t *driver)
     return groups;
 }
 
-int neu_adapter_driver_add_tag(neu_adapter_driver_t *driver, const char *group,
-                               neu_datatag_t *tag)
+// validate the address of a tag and cache what was parsed from it
+static int parse_tag(neu_adapter_driver_t *driver, neu_datatag_t *tag)
 {
-    int      ret  = NEU_ERR_SUCCESS;
-    group_t *find = NULL;
+    const neu_plugin_intf_funs_t *funs = driver->adapter.module->intf_funs;
+    int                           ret  = NEU_ERR_SUCCESS;
+
+    if (!neu_tag_attribute_test(tag, NEU_ATTRIBUTE_STATIC)) {
+        // whatever the tag carries was parsed from another address
+        neu_tag_clear_meta(tag);
+        ret = funs->driver.validate_tag(driver->adapter.plugin, tag);
+        if (ret != NEU_ERR_SUCCESS) {
+            return ret;
+        }
+    }
+
+    neu_datatag_parse_addr_option(tag, &tag->option);
+
+    if (!neu_tag_attribute_test(tag, NEU_ATTRIBUTE_STATIC) &&
+        funs->driver.parse_tag != NULL) {
+        ret = funs->driver.parse_tag(driver->adapter.plugin, tag);
+    }
+
+    return ret;
+}
 
+static int check_new_tag(neu_adapter_driver_t *driver, neu_datatag_t *tag)
+{
     if (strlen(tag->name) >= NEU_TAG_NAME_LEN) {
         return NEU_ERR_TAG_NAME_TOO_LONG;
     }
@@ -797,29 +959,110 @@ int neu_adapter_driver_add_tag(neu_adapter_driver_t *driver, const char *group,
         return NEU_ERR_TAG_ATTRIBUTE_NOT_SUPPORT;
     }
 
-    if (!neu_tag_attribute_test(tag, NEU_ATTRIBUTE_STATIC)) {
-        ret = driver->adapter.module->intf_funs->driver.validate_tag(
-            driver->adapter.plugin, tag);
-        if (ret != NEU_ERR_SUCCESS) {
-            return ret;
-        }
-    }
+    return parse_tag(driver, tag);
+}
 
-    neu_datatag_parse_addr_option(tag, &tag->option);
+static group_t *find_or_add_group(neu_adapter_driver_t *driver,
+                                  const char *          group)
+{
+    group_t *find = NULL;
 
     HASH_FIND_STR(driver->groups, group, find);
-    if (find == NULL) {
-        neu_adapter_driver_add_group(driver, group, 3000);
+    if (find == NULL &&
+        neu_adapter_driver_add_group(driver, group, 3000) == NEU_ERR_SUCCESS) {
         adapter_storage_add_group(driver->adapter.name, group, 3000);
+        HASH_FIND_STR(driver->groups, group, find);
     }
-    HASH_FIND_STR(driver->groups, group, find);
-    assert(find != NULL);
-    ret = neu_group_add_tag(find->group, tag);
+    // NULL only when over the memory limit
+    return find;
+}
 
+int neu_adapter_driver_add_tag(neu_adapter_driver_t *driver, const char *group,
+                               neu_datatag_t *tag)
+{
+    int      ret  = NEU_ERR_SUCCESS;
+    group_t *find = NULL;
+
+    ret = check_new_tag(driver, tag);
+    if (ret != NEU_ERR_SUCCESS) {
+        return ret;
+    }
+
+    if (tag_cost(tag) > memory_left(driver)) {
+        return NEU_ERR_NODE_MEMORY_LIMIT;
+    }
+
+    find = find_or_add_group(driver, group);
+    if (find == NULL) {
+        return NEU_ERR_NODE_MEMORY_LIMIT;
+    }
+
+    ret = neu_group_add_tag(find->group, tag);
     if (ret == NEU_ERR_SUCCESS) {
         neu_adapter_update_group_metric(&driver->adapter, group,
                                         NEU_METRIC_GROUP_TAGS_TOTAL,
                                         neu_group_tag_size(find->group));
+        charge_memory(driver, tag_cost(tag));
+    }
+
+    return ret;
+}
+
+int neu_adapter_driver_add_tags(neu_adapter_driver_t *driver, const char *group,
+                                neu_datatag_t *tags, uint32_t n,
+                                uint32_t *index_p)
+{
+    int      ret     = NEU_ERR_SUCCESS;
+    uint32_t n_valid = 0;
+    uint32_t n_added = 0;
+    group_t *find    = NULL;
+    size_t   left    = memory_left(driver);
+
+    // check every tag first, then change the group once
+    for (; n_valid < n; ++n_valid) {
+        size_t cost = 0;
+
+        ret = check_new_tag(driver, &tags[n_valid]);
+        if (ret != NEU_ERR_SUCCESS) {
+            break;
+        }
+
+        cost = tag_cost(&tags[n_valid]);
+        if (cost > left) {
+            ret = NEU_ERR_NODE_MEMORY_LIMIT;
+            break;
+        }
+        left -= cost;
+    }
+
+    if (n_valid > 0) {
+        int rv = NEU_ERR_SUCCESS;
+
+        find = find_or_add_group(driver, group);
+        if (find == NULL) {
+            rv = NEU_ERR_NODE_MEMORY_LIMIT;
+        } else {
+            rv = neu_group_add_tags(find->group, tags, n_valid, &n_added);
+        }
+        if (rv != NEU_ERR_SUCCESS) {
+            ret = rv;
+        }
+
+        if (n_added > 0) {
+            int64_t cost = 0;
+
+            for (uint32_t i = 0; i < n_added; ++i) {
+                cost += tag_cost(&tags[i]);
+            }
+            neu_adapter_update_group_metric(&driver->adapter, group,
+                                            NEU_METRIC_GROUP_TAGS_TOTAL,
+                                            neu_group_tag_size(find->group));
+            charge_memory(driver, cost);
+        }
+    }
+
+    if (index_p) {
+        *index_p = n_added;
     }
 
     return ret;
@@ -828,11 +1071,17 @@ int neu_adapter_driver_add_tag(neu_adapter_driver_t *driver, const char *group,
 int neu_adapter_driver_del_tag(neu_adapter_driver_t *driver, const char *group,
                                const char *tag)
 {
-    int      ret  = NEU_ERR_SUCCESS;
-    group_t *find = NULL;
+    int                  ret  = NEU_ERR_SUCCESS;
+    group_t *            find = NULL;
+    const neu_datatag_t *old  = NULL;
+    int64_t              cost = 0;
 
     HASH_FIND_STR(driver->groups, group, find);
     if (find != NULL) {
+        old = neu_group_find_tag(find->group, tag);
+        if (old != NULL) {
+            cost = tag_cost(old);
+        }
         ret = neu_group_del_tag(find->group, tag);
     } else {
         ret = NEU_ERR_GROUP_NOT_EXIST;
@@ -842,6 +1091,7 @@ int neu_adapter_driver_del_tag(neu_adapter_driver_t *driver, const char *group,
         neu_adapter_update_group_metric(&driver->adapter, group,
                                         NEU_METRIC_GROUP_TAGS_TOTAL,
                                         neu_group_tag_size(find->group));
+        charge_memory(driver, -cost);
     }
 
     return ret;
@@ -850,8 +1100,10 @@ int neu_adapter_driver_del_tag(neu_adapter_driver_t *driver, const char *group,
 int neu_adapter_driver_update_tag(neu_adapter_driver_t *driver,
                                   const char *group, neu_datatag_t *tag)
 {
-    int      ret  = NEU_ERR_SUCCESS;
-    group_t *find = NULL;
+    int                  ret   = NEU_ERR_SUCCESS;
+    group_t *            find  = NULL;
+    const neu_datatag_t *old   = NULL;
+    int64_t              delta = 0;
 
     if (strlen(tag->name) >= NEU_TAG_NAME_LEN) {
         return NEU_ERR_TAG_NAME_TOO_LONG;
@@ -869,20 +1121,28 @@ int neu_adapter_driver_update_tag(neu_adapter_driver_t *driver,
         return NEU_ERR_TAG_PRECISION_INVALID;
     }
 
-    if (!neu_tag_attribute_test(tag, NEU_ATTRIBUTE_STATIC)) {
-        ret = driver->adapter.module->intf_funs->driver.validate_tag(
-            driver->adapter.plugin, tag);
-        if (ret != NEU_ERR_SUCCESS) {
-            return ret;
-        }
+    ret = parse_tag(driver, tag);
+    if (ret != NEU_ERR_SUCCESS) {
+        return ret;
     }
 
-    neu_datatag_parse_addr_option(tag, &tag->option);
     HASH_FIND_STR(driver->groups, group, find);
-    if (find != NULL) {
-        ret = neu_group_update_tag(find->group, tag);
-    } else {
-        ret = NEU_ERR_GROUP_NOT_EXIST;
+    if (find == NULL) {
+        return NEU_ERR_GROUP_NOT_EXIST;
+    }
+
+    // only a tag growing may go over the limit
+    old = neu_group_find_tag(find->group, tag->name);
+    if (old != NULL) {
+        delta = 2 * ((int64_t) tag_memory(tag) - (int64_t) tag_memory(old));
+    }
+    if (delta > 0 && (size_t) delta > memory_left(driver)) {
+        return NEU_ERR_NODE_MEMORY_LIMIT;
+    }
+
+    ret = neu_group_update_tag(find->group, tag);
+    if (ret == NEU_ERR_SUCCESS) {
+        charge_memory(driver, delta);
     }
 
     return ret;
@@ -904,20 +1164,27 @@ int neu_adapter_driver_get_tag(neu_adapter_driver_t *driver, const char *group,
     return ret;
 }
 
-int neu_adapter_driver_query_tag(neu_adapter_driver_t *driver,
-                                 const char *group, const char *name,
-                                 UT_array **tags)
+int neu_adapter_driver_query_tag(neu_adapter_driver_t *   driver,
+                                 const neu_req_get_tag_t *req,
+                                 neu_resp_get_tag_t *     resp)
 {
     int      ret  = NEU_ERR_SUCCESS;
     group_t *find = NULL;
 
-    HASH_FIND_STR(driver->groups, group, find);
+    HASH_FIND_STR(driver->groups, req->group, find);
     if (find != NULL) {
-        if (strlen(name) > 0) {
-            *tags = neu_group_query_tag(find->group, name);
-        } else {
-            *tags = neu_group_get_tag(find->group);
-        }
+        neu_group_tag_query_t query = {
+            .name      = req->name,
+            .prefix    = req->prefix,
+            .cursor    = req->cursor,
+            .limit     = req->limit,
+            .attribute = req->attribute,
+            .fields    = req->fields,
+        };
+
+        resp->fields = req->fields;
+        resp->tags   = neu_group_query_tag_page(find->group, &query,
+                                              &resp->total, resp->next);
     } else {
         ret = NEU_ERR_GROUP_NOT_EXIST;
     }
@@ -966,107 +1233,247 @@ UT_array *neu_adapter_driver_get_read_tag(neu_adapter_driver_t *driver,
 
 static int report_callback(void *usr_data)
 {
-    group_t *                group  = (group_t *) usr_data;
-    neu_reqresp_head_t       header = { 0 };
-    neu_node_running_state_e state  = group->driver->adapter.state;
-    if (state != NEU_NODE_RUNNING_STATE_RUNNING) {
+    group_t *                 group   = (group_t *) usr_data;
+    neu_adapter_t *           adapter = &group->driver->adapter;
+    neu_reqresp_trans_data_t *data    = NULL;
+    nng_msg *                 msg     = NULL;
+    UT_array *                tags    = NULL;
+
+    if (adapter->state != NEU_NODE_RUNNING_STATE_RUNNING) {
         return 0;
     }
 
-    header.type = NEU_REQRESP_TRANS_DATA;
+    if (global_timestamp - group->driver->memory_ts >= 1000) {
+        update_memory(group->driver);
+    }
 
-    UT_array *tags =
-        neu_adapter_driver_get_read_tag(group->driver, group->name);
+    // over the soft limit, consumers get every other report
+    if (group->driver->memory_soft && (++group->n_report & 1) == 0) {
+        return 0;
+    }
 
-    neu_reqresp_trans_data_t *data =
-        calloc(1,
-               sizeof(neu_reqresp_trans_data_t) +
-                   utarray_len(tags) * sizeof(neu_resp_tag_value_t));
+    // report timers run on the adapter thread, where groups are modified
+    tags = neu_group_read_tags(group->group);
+    if (utarray_len(tags) == 0) {
+        return 0;
+    }
 
-    strcpy(data->driver, group->driver->adapter.name);
+    // values are written straight into the message sent
+    msg = neu_trans_data_msg_alloc(utarray_len(tags), &data);
+    if (msg == NULL) {
+        nlog_warn("%s:%s report msg alloc fail", adapter->name, group->name);
+        return 0;
+    }
+
+    strcpy(data->driver, adapter->name);
     strcpy(data->group, group->name);
-    data->n_tag = read_report_group(global_timestamp,
-                                    neu_group_get_interval(group->group) *
-                                        NEU_DRIVER_TAG_CACHE_EXPIRE_TIME,
-                                    group->driver->cache, group->name, tags,
-                                    (neu_resp_tag_value_t *) &data[1]);
+    data->n_tag = read_report_group(
+        global_timestamp,
+        neu_group_get_interval(group->group) * NEU_DRIVER_TAG_CACHE_EXPIRE_TIME,
+        group->driver->cache, group->name, tags, data->tags, &data->timestamp);
 
     if (data->n_tag > 0) {
-        group->driver->adapter.cb_funs.response(&group->driver->adapter,
-                                                &header, data);
+        neu_adapter_send_trans_data(adapter, msg);
+    } else {
+        nng_msg_free(msg);
     }
-    utarray_free(tags);
-    free(data);
     return 0;
 }
 
-static void group_change(void *arg, int64_t timestamp, UT_array *static_tags,
-                         UT_array *other_tags, uint32_t interval)
+// whether the value or the way to read a tag differ, the description aside
+static bool tag_changed(const neu_datatag_t *old, const neu_datatag_t *tag)
 {
-    group_t *group   = (group_t *) arg;
-    group->timestamp = timestamp;
-    (void) interval;
-
-    if (group->grp.group_free != NULL)
-        group->grp.group_free(&group->grp);
-
-    utarray_foreach(group->static_tags, neu_datatag_t *, tag)
-    {
-        neu_driver_cache_del(group->driver->cache, group->name, tag->name);
+    neu_value_u old_value = { 0 }, value = { 0 };
+
+    if (old->type != tag->type || old->attribute != tag->attribute ||
+        old->precision != tag->precision || old->decimal != tag->decimal ||
+        strcmp(old->address, tag->address) != 0 ||
+        old->report.deadband != tag->report.deadband ||
+        old->report.deadband_type != tag->report.deadband_type ||
+        old->report.heartbeat != tag->report.heartbeat ||
+        old->report.min_interval != tag->report.min_interval) {
+        return true;
     }
 
-    utarray_foreach(group->grp.tags, neu_datatag_t *, tag)
-    {
-        neu_driver_cache_del(group->driver->cache, group->name, tag->name);
+    if (neu_tag_attribute_test(tag, NEU_ATTRIBUTE_STATIC)) {
+        neu_tag_get_static_value(old, &old_value);
+        neu_tag_get_static_value(tag, &value);
+        return memcmp(&old_value, &value, sizeof(value)) != 0;
     }
 
-    utarray_foreach(static_tags, neu_datatag_t *, tag)
-    {
-        neu_dvalue_t value = { 0 };
+    return false;
+}
+
+static void cache_add_tag(group_t *group, const neu_datatag_t *tag)
+{
+    neu_dvalue_t value = { 0 };
 
-        value.precision = tag->precision;
-        value.type      = tag->type;
+    value.precision = tag->precision;
+    if (neu_tag_attribute_test(tag, NEU_ATTRIBUTE_STATIC)) {
+        value.type = tag->type;
         if (0 != neu_tag_get_static_value(tag, &value.value)) {
             value.type      = NEU_TYPE_ERROR;
             value.value.i32 = NEU_ERR_EINTERNAL;
         }
+    } else {
+        value.type      = NEU_TYPE_ERROR;
+        value.value.i32 = NEU_ERR_PLUGIN_TAG_NOT_READY;
+    }
+
+    neu_driver_cache_add(group->driver->cache, group->name, tag->name, value);
+}
+
+typedef struct {
+    neu_datatag_t *tag;
+    bool           kept;
+    UT_hash_handle hh;
+} tag_index_t;
 
-        neu_driver_cache_add(group->driver->cache, group->name, tag->name,
-                             value);
+static void index_tags(tag_index_t **index, tag_index_t *entries, size_t *n,
+                       UT_array *tags)
+{
+    if (tags == NULL) {
+        return;
     }
 
-    utarray_foreach(other_tags, neu_datatag_t *, tag)
+    utarray_foreach(tags, neu_datatag_t *, tag)
     {
-        neu_dvalue_t value = { 0 };
-
-        value.precision = tag->precision;
-        value.type      = NEU_TYPE_ERROR;
-        value.value.i32 = NEU_ERR_PLUGIN_TAG_NOT_READY;
+        tag_index_t *entry = &entries[(*n)++];
 
-        neu_driver_cache_add(group->driver->cache, group->name, tag->name,
-                             value);
+        entry->tag = tag;
+        HASH_ADD_KEYPTR(hh, *index, tag->name, strlen(tag->name), entry);
     }
+}
 
-    neu_plugin_group_t grp = {
-        .group_name = strdup(group->name),
-        .tags       = NULL,
-        .group_free = NULL,
-        .user_data  = NULL,
-    };
+/*
+ * Apply the difference between the tags in use and the new ones to the
+ * cache, leaving the values of unchanged tags alone, and collect the
+ * changes of the tags read by the plugin.
+ */
+static void group_diff(group_t *group, UT_array *static_tags,
+                       UT_array *other_tags, neu_plugin_group_diff_t *diff)
+{
+    tag_index_t *index   = NULL;
+    tag_index_t *entries = NULL;
+    size_t       n       = 1;
+    UT_array *   news[]  = { static_tags, other_tags };
 
-    grp.tags = other_tags;
-    free(group->grp.group_name);
     if (group->static_tags != NULL) {
-        utarray_free(group->static_tags);
+        n += utarray_len(group->static_tags);
     }
     if (group->grp.tags != NULL) {
-        utarray_free(group->grp.tags);
+        n += utarray_len(group->grp.tags);
+    }
+
+    entries = calloc(n, sizeof(tag_index_t));
+    n       = 0;
+    index_tags(&index, entries, &n, group->static_tags);
+    index_tags(&index, entries, &n, group->grp.tags);
+
+    for (size_t i = 0; i < sizeof(news) / sizeof(news[0]); ++i) {
+        utarray_foreach(news[i], neu_datatag_t *, tag)
+        {
+            tag_index_t *find = NULL;
+            bool         is_static =
+                neu_tag_attribute_test(tag, NEU_ATTRIBUTE_STATIC);
+
+            HASH_FIND_STR(index, tag->name, find);
+            if (find == NULL) {
+                cache_add_tag(group, tag);
+                if (!is_static) {
+                    utarray_push_back(diff->added, &tag);
+                }
+                continue;
+            }
+
+            find->kept = true;
+            if (!tag_changed(find->tag, tag)) {
+                continue;
+            }
+
+            cache_add_tag(group, tag);
+            if (neu_tag_attribute_test(find->tag, NEU_ATTRIBUTE_STATIC)) {
+                if (!is_static) {
+                    utarray_push_back(diff->added, &tag);
+                }
+            } else if (is_static) {
+                utarray_push_back(diff->removed, &find->tag);
+            } else {
+                utarray_push_back(diff->modified, &tag);
+            }
+        }
     }
 
-    group->static_tags = static_tags;
-    group->grp         = grp;
-    nlog_notice("group: %s changed, timestamp: %" PRIi64, group->name,
-                timestamp);
+    for (size_t i = 0; i < n; ++i) {
+        neu_datatag_t *tag = entries[i].tag;
+
+        if (!entries[i].kept) {
+            neu_driver_cache_del(group->driver->cache, group->name, tag->name);
+            if (!neu_tag_attribute_test(tag, NEU_ATTRIBUTE_STATIC)) {
+                utarray_push_back(diff->removed, &tag);
+            }
+        }
+    }
+
+    HASH_CLEAR(hh, index);
+    free(entries);
+}
+
+static void group_change(void *arg, int64_t timestamp, UT_array *static_tags,
+                         UT_array *other_tags, uint32_t interval)
+{
+    group_t *               group = (group_t *) arg;
+    neu_plugin_group_diff_t diff  = { 0 };
+    group->timestamp              = timestamp;
+    (void) interval;
+
+    utarray_new(diff.added, &ut_ptr_icd);
+    utarray_new(diff.removed, &ut_ptr_icd);
+    utarray_new(diff.modified, &ut_ptr_icd);
+    group_diff(group, static_tags, other_tags, &diff);
+
+    UT_array *old_static = group->static_tags;
+    UT_array *old_tags   = group->grp.tags;
+
+    free(group->grp.group_name);
+    group->grp.group_name = strdup(group->name);
+    group->grp.tags       = other_tags;
+    group->static_tags    = static_tags;
+
+    pthread_mutex_lock(&group->wt_mtx);
+    group->tags_memory = tags_memory(other_tags);
+    pthread_mutex_unlock(&group->wt_mtx);
+
+    if (group->grp.user_data != NULL && group->grp.group_update != NULL) {
+        if (0 != group->grp.group_update(&group->grp, &diff)) {
+            nlog_warn("group: %s update failed, rebuild", group->name);
+            group->grp.group_free(&group->grp);
+            group->grp.user_data = NULL;
+        }
+    } else if (group->grp.group_free != NULL) {
+        group->grp.group_free(&group->grp);
+        group->grp.user_data = NULL;
+    }
+    if (group->grp.user_data == NULL) {
+        group->grp.group_free   = NULL;
+        group->grp.group_update = NULL;
+    }
+
+    if (old_static != NULL) {
+        utarray_free(old_static);
+    }
+    if (old_tags != NULL) {
+        utarray_free(old_tags);
+    }
+
+    nlog_notice("group: %s changed, timestamp: %" PRIi64
+                ", tags added: %u, removed: %u, modified: %u",
+                group->name, timestamp, utarray_len(diff.added),
+                utarray_len(diff.removed), utarray_len(diff.modified));
+
+    utarray_free(diff.added);
+    utarray_free(diff.removed);
+    utarray_free(diff.modified);
 }
 
 static int read_callback(void *usr_data)
@@ -1120,36 +1527,47 @@ static int read_callback(void *usr_data)
     return 0;
 }
 
-static int read_report_group(int64_t timestamp, int64_t timeout,
-                             neu_driver_cache_t *cache, const char *group,
-                             UT_array *tags, neu_resp_tag_value_t *datas)
+static uint32_t read_report_group(int64_t timestamp, int64_t timeout,
+                                  neu_driver_cache_t *cache,
+                                  const char *group, UT_array *tags,
+                                  neu_resp_tag_value_t *datas,
+                                  int64_t *latest)
 {
-    int index = 0;
+    uint32_t index = 0;
+
+    *latest = 0;
 
     utarray_foreach(tags, neu_datatag_t *, tag)
     {
         neu_driver_cache_value_t value = { 0 };
+        bool                     rbe =
+            neu_tag_attribute_test(tag, NEU_ATTRIBUTE_SUBSCRIBE);
 
-        if (neu_tag_attribute_test(tag, NEU_ATTRIBUTE_SUBSCRIBE)) {
-            if (neu_driver_cache_get_changed(cache, group, tag->name, &value) !=
-                0) {
-                nlog_info("tag: %s not changed", tag->name);
-                continue;
-            }
-        } else {
-            if (neu_driver_cache_get(cache, group, tag->name, &value) != 0) {
-                strcpy(datas[index].tag, tag->name);
-                datas[index].value.type      = NEU_TYPE_ERROR;
-                datas[index].value.value.i32 = NEU_ERR_PLUGIN_TAG_NOT_READY;
-                index += 1;
+        // datas is not zeroed
+        memset(&datas[index], 0, sizeof(datas[index]));
+        if (neu_driver_cache_get(cache, group, tag->name, &value) != 0) {
+            if (rbe) {
                 continue;
             }
+            strcpy(datas[index].tag, tag->name);
+            datas[index].value.type      = NEU_TYPE_ERROR;
+            datas[index].value.value.i32 = NEU_ERR_PLUGIN_TAG_NOT_READY;
+            index += 1;
+            continue;
         }
         strcpy(datas[index].tag, tag->name);
 
         if (value.value.type == NEU_TYPE_ERROR) {
             datas[index].value = value.value;
-            index += 1;
+            if (!rbe ||
+                neu_driver_cache_report_test(cache, group, tag->name,
+                                             &tag->report, &datas[index].value,
+                                             timestamp)) {
+                if (value.timestamp > *latest) {
+                    *latest = value.timestamp;
+                }
+                index += 1;
+            }
             continue;
         }
 
@@ -1264,6 +1682,19 @@ static int read_report_group(int64_t timestamp, int64_t timeout,
                 }
             }
         }
+
+        // report by exception on the value as it is uploaded, unchanged
+        // tags never get into the message
+        if (rbe &&
+            !neu_driver_cache_report_test(cache, group, tag->name,
+                                          &tag->report, &datas[index].value,
+                                          timestamp)) {
+            continue;
+        }
+
+        if (value.timestamp > *latest) {
+            *latest = value.timestamp;
+        }
         index += 1;
     }
 
@@ -53,15 +53,19 @@ UT_array *neu_adapter_driver_get_group(neu_adapter_driver_t *driver);
 
 int  neu_adapter_driver_add_tag(neu_adapter_driver_t *driver, const char *group,
                                 neu_datatag_t *tag);
+// add tags in order until the first invalid or conflicting one
+int  neu_adapter_driver_add_tags(neu_adapter_driver_t *driver,
+                                 const char *group, neu_datatag_t *tags,
+                                 uint32_t n, uint32_t *index_p);
 int  neu_adapter_driver_del_tag(neu_adapter_driver_t *driver, const char *group,
                                 const char *tag);
 int  neu_adapter_driver_update_tag(neu_adapter_driver_t *driver,
                                    const char *group, neu_datatag_t *tag);
 int  neu_adapter_driver_get_tag(neu_adapter_driver_t *driver, const char *group,
                                 UT_array **tags);
-int  neu_adapter_driver_query_tag(neu_adapter_driver_t *driver,
-                                  const char *group, const char *name,
-                                  UT_array **tags);
+int  neu_adapter_driver_query_tag(neu_adapter_driver_t *   driver,
+                                  const neu_req_get_tag_t *req,
+                                  neu_resp_get_tag_t *     resp);
 void neu_adapter_driver_get_value_tag(neu_adapter_driver_t *driver,
                                       const char *group, UT_array **tags);
 UT_array *neu_adapter_driver_get_read_tag(neu_adapter_driver_t *driver,
@@ -50,8 +50,10 @@
         }                                                                      \
     } while (0)
 
-const char *g_config_dir = NULL;
-const char *g_plugin_dir = NULL;
+const char *g_config_dir             = NULL;
+const char *g_plugin_dir             = NULL;
+size_t      g_node_memory_soft_limit = 0;
+size_t      g_node_memory_hard_limit = 0;
 
 // clang-format off
 const char *usage_text =
@@ -72,6 +74,12 @@ const char *usage_text =
 "    --disable_auth       disable http api auth\n"
 "    --config_dir <DIR>   directory from which neuron reads configuration\n"
 "    --plugin_dir <DIR>   directory from which neuron loads plugin lib files\n"
+"    --node_memory_soft_limit <MIB>\n"
+"                         memory of a driver node beyond which it halves its\n"
+"                         report rate, 0 for no limit (default)\n"
+"    --node_memory_hard_limit <MIB>\n"
+"                         memory of a driver node beyond which it refuses new\n"
+"                         tags, groups and writes, 0 for no limit (default)\n"
 "\n";
 // clang-format on
 
@@ -126,6 +134,20 @@ static inline size_t parse_restart_policy(const char *s, size_t *out)
     return 0;
 }
 
+// MiB to bytes
+static inline int parse_memory_limit(const char *s, size_t *out)
+{
+    errno         = 0;
+    char *    end = NULL;
+    uintmax_t n   = strtoumax(s, &end, 0);
+    if (0 != errno || '\0' == *s || '\0' != *end || n > (SIZE_MAX >> 20)) {
+        return -1;
+    }
+    *out = n << 20;
+
+    return 0;
+}
+
 static inline bool file_exists(const char *const path)
 {
     struct stat buf = { 0 };
@@ -151,6 +173,8 @@ void neu_cli_args_init(neu_cli_args_t *args, int argc, char *argv[])
         { "disable_auth", no_argument, NULL, 'a' },
         { "config_dir", required_argument, NULL, 'c' },
         { "plugin_dir", required_argument, NULL, 'p' },
+        { "node_memory_soft_limit", required_argument, NULL, 's' },
+        { "node_memory_hard_limit", required_argument, NULL, 'm' },
         { NULL, 0, NULL, 0 },
     };
 
@@ -200,6 +224,18 @@ void neu_cli_args_init(neu_cli_args_t *args, int argc, char *argv[])
         case 'p':
             plugin_dir = strdup(optarg);
             break;
+        case 's':
+        case 'm': {
+            size_t *limit = 's' == c ? &args->node_memory_soft_limit
+                                     : &args->node_memory_hard_limit;
+            if (0 != parse_memory_limit(optarg, limit)) {
+                fprintf(stderr, "%s: option '--%s' invalid size: `%s`\n",
+                        argv[0], long_options[option_index].name, optarg);
+                ret = 1;
+                goto quit;
+            }
+            break;
+        }
         case '?':
         default:
             usage();
@@ -208,6 +244,15 @@ void neu_cli_args_init(neu_cli_args_t *args, int argc, char *argv[])
         }
     }
 
+    if (0 != args->node_memory_hard_limit &&
+        args->node_memory_soft_limit > args->node_memory_hard_limit) {
+        fprintf(stderr,
+                "%s: option '--node_memory_soft_limit' above the hard one\n",
+                argv[0]);
+        ret = 1;
+        goto quit;
+    }
+
     if (!args->daemonized && args->restart != NEU_RESTART_NEVER) {
         fprintf(stderr,
                 "%s: option '--restart' has no effects without '--daemon'\n",
@@ -242,8 +287,10 @@ void neu_cli_args_init(neu_cli_args_t *args, int argc, char *argv[])
     }
 
     // passing information by global variable is not a good style
-    g_config_dir = args->config_dir;
-    g_plugin_dir = args->plugin_dir;
+    g_config_dir             = args->config_dir;
+    g_plugin_dir             = args->plugin_dir;
+    g_node_memory_soft_limit = args->node_memory_soft_limit;
+    g_node_memory_hard_limit = args->node_memory_hard_limit;
 
     if (reset_password_flag) {
         ret = reset_password();
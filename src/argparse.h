@@ -35,6 +35,9 @@ extern "C" {
 
 extern const char *g_config_dir;
 extern const char *g_plugin_dir;
+// bytes a driver node may hold, 0 for no limit
+extern size_t g_node_memory_soft_limit;
+extern size_t g_node_memory_hard_limit;
 
 /** Neuron command line arguments.
  */
@@ -46,6 +49,8 @@ typedef struct {
     char * log_init_file;
     char * config_dir;
     char * plugin_dir;
+    size_t node_memory_soft_limit; // bytes, 0 for no limit
+    size_t node_memory_hard_limit; // bytes, 0 for no limit
 } neu_cli_args_t;
 
 /** Parse command line arguments.
@@ -16,29 +16,55 @@
  * along with this program; if not, write to the Free Software Foundation,
  * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
  **/
+#include <pthread.h>
 #include <string.h>
 #include <sys/time.h>
 
 #include "define.h"
 #include "errcodes.h"
+#include "utils/arena.h"
 
 #include "group.h"
 
-typedef struct tag_elem {
-    char *name;
+// arena block of a group, a few dozen tags
+#define GROUP_ARENA_BLOCK 4096
 
-    neu_datatag_t *tag;
+typedef struct tag_elem {
+    neu_datatag_t tag; // keyed by name, strings live in the group arena
 
     UT_hash_handle hh;
 } tag_elem_t;
 
+typedef struct {
+    const char *   str;
+    UT_hash_handle hh;
+} intern_str_t;
+
+/*
+ * Tags of a group are stored in its arena: the element, name and address
+ * of a tag are bump allocated next to each other and descriptions, which
+ * repeat a lot, are interned. Deleted elements are reused, the bytes of
+ * replaced strings are only counted and reclaimed by compacting the arena
+ * once they outweigh the live ones.
+ *
+ * The driver thread copies the tags while the adapter thread modifies them,
+ * compacting frees the arena, so both hold mtx. Pointers into the group are
+ * only handed out to the adapter thread.
+ */
 struct neu_group {
     char *name;
 
-    tag_elem_t *tags;
-    uint32_t    interval;
+    tag_elem_t *  tags;
+    neu_arena_t * arena;
+    intern_str_t *strings;    // interned descriptions
+    tag_elem_t *  free_elems; // deleted elements, chained by hh.next
+    size_t        garbage;    // arena bytes no longer referenced
+    UT_array *    read_tags;  // shallow copies, dropped once tags change
+    uint32_t      interval;
 
     int64_t timestamp;
+
+    pthread_mutex_t mtx;
 };
 
 static UT_array *to_array(tag_elem_t *tags);
@@ -46,13 +72,34 @@ static UT_array *to_read_array(tag_elem_t *tags);
 static void      split_static_array(tag_elem_t *tags, UT_array **static_tags,
                                     UT_array **other_tags);
 static void      update_timestamp(neu_group_t *group);
+static int       store_tag(neu_group_t *group, const neu_datatag_t *tag);
+static int       restore_tag(neu_group_t *group, tag_elem_t *el,
+                             const neu_datatag_t *tag);
+static void      drop_tag(neu_group_t *group, tag_elem_t *el);
+static void      compact(neu_group_t *group);
+static bool      tag_match(const neu_datatag_t *        tag,
+                           const neu_group_tag_query_t *query);
+static void      push_projected(UT_array *array, const neu_datatag_t *tag,
+                                uint32_t fields);
 
 neu_group_t *neu_group_new(const char *name, uint32_t interval)
 {
     neu_group_t *group = calloc(1, sizeof(neu_group_t));
 
+    if (group == NULL) {
+        return NULL;
+    }
+
     group->name     = strdup(name);
     group->interval = interval;
+    group->arena    = neu_arena_new(GROUP_ARENA_BLOCK);
+    if (group->name == NULL || group->arena == NULL) {
+        neu_arena_free(group->arena);
+        free(group->name);
+        free(group);
+        return NULL;
+    }
+    pthread_mutex_init(&group->mtx, NULL);
 
     return group;
 }
@@ -64,11 +111,15 @@ void neu_group_destroy(neu_group_t *group)
     HASH_ITER(hh, group->tags, el, tmp)
     {
         HASH_DEL(group->tags, el);
-        free(el->name);
-        neu_tag_free(el->tag);
-        free(el);
+        drop_tag(group, el);
     }
+    HASH_CLEAR(hh, group->strings);
 
+    if (group->read_tags != NULL) {
+        utarray_free(group->read_tags);
+    }
+    neu_arena_free(group->arena);
+    pthread_mutex_destroy(&group->mtx);
     free(group->name);
     free(group);
 }
@@ -82,43 +133,83 @@ uint32_t neu_group_get_interval(const neu_group_t *group)
 {
     uint32_t interval = 0;
 
+    pthread_mutex_lock(&((neu_group_t *) group)->mtx);
     interval = group->interval;
+    pthread_mutex_unlock(&((neu_group_t *) group)->mtx);
 
     return interval;
 }
 
 void neu_group_set_interval(neu_group_t *group, uint32_t interval)
 {
+    pthread_mutex_lock(&group->mtx);
     group->interval = interval;
+    pthread_mutex_unlock(&group->mtx);
 }
 
 int neu_group_update(neu_group_t *group, uint32_t interval)
 {
+    pthread_mutex_lock(&group->mtx);
     if (group->interval != interval) {
         group->interval = interval;
         update_timestamp(group);
     }
+    pthread_mutex_unlock(&group->mtx);
 
     return 0;
 }
 
 int neu_group_add_tag(neu_group_t *group, const neu_datatag_t *tag)
 {
-    tag_elem_t *el = NULL;
+    tag_elem_t *el  = NULL;
+    int         ret = NEU_ERR_SUCCESS;
 
+    pthread_mutex_lock(&group->mtx);
     HASH_FIND_STR(group->tags, tag->name, el);
     if (el != NULL) {
-        return NEU_ERR_TAG_NAME_CONFLICT;
+        ret = NEU_ERR_TAG_NAME_CONFLICT;
+    } else if (0 != store_tag(group, tag)) {
+        ret = NEU_ERR_EINTERNAL;
+    } else {
+        update_timestamp(group);
     }
+    pthread_mutex_unlock(&group->mtx);
 
-    el       = calloc(1, sizeof(tag_elem_t));
-    el->name = strdup(tag->name);
-    el->tag  = neu_tag_dup(tag);
+    return ret;
+}
+
+int neu_group_add_tags(neu_group_t *group, const neu_datatag_t *tags,
+                       uint32_t n, uint32_t *n_added)
+{
+    int      ret = 0;
+    uint32_t i   = 0;
 
-    HASH_ADD_STR(group->tags, name, el);
-    update_timestamp(group);
+    pthread_mutex_lock(&group->mtx);
+    for (; i < n; ++i) {
+        tag_elem_t *el = NULL;
 
-    return 0;
+        HASH_FIND_STR(group->tags, tags[i].name, el);
+        if (el != NULL) {
+            ret = NEU_ERR_TAG_NAME_CONFLICT;
+            break;
+        }
+
+        if (0 != store_tag(group, &tags[i])) {
+            ret = NEU_ERR_EINTERNAL;
+            break;
+        }
+    }
+
+    if (i > 0) {
+        update_timestamp(group);
+    }
+    pthread_mutex_unlock(&group->mtx);
+
+    if (n_added) {
+        *n_added = i;
+    }
+
+    return ret;
 }
 
 int neu_group_update_tag(neu_group_t *group, const neu_datatag_t *tag)
@@ -126,13 +217,18 @@ int neu_group_update_tag(neu_group_t *group, const neu_datatag_t *tag)
     tag_elem_t *el  = NULL;
     int         ret = NEU_ERR_TAG_NOT_EXIST;
 
+    pthread_mutex_lock(&group->mtx);
     HASH_FIND_STR(group->tags, tag->name, el);
     if (el != NULL) {
-        neu_tag_copy(el->tag, tag);
-
-        update_timestamp(group);
-        ret = NEU_ERR_SUCCESS;
+        if (0 != restore_tag(group, el, tag)) {
+            ret = NEU_ERR_EINTERNAL;
+        } else {
+            update_timestamp(group);
+            compact(group);
+            ret = NEU_ERR_SUCCESS;
+        }
     }
+    pthread_mutex_unlock(&group->mtx);
 
     return ret;
 }
@@ -142,16 +238,19 @@ int neu_group_del_tag(neu_group_t *group, const char *tag_name)
     tag_elem_t *el  = NULL;
     int         ret = NEU_ERR_TAG_NOT_EXIST;
 
+    pthread_mutex_lock(&group->mtx);
     HASH_FIND_STR(group->tags, tag_name, el);
     if (el != NULL) {
         HASH_DEL(group->tags, el);
-        free(el->name);
-        neu_tag_free(el->tag);
-        free(el);
+        drop_tag(group, el);
+        el->hh.next       = group->free_elems;
+        group->free_elems = el;
 
         update_timestamp(group);
+        compact(group);
         ret = NEU_ERR_SUCCESS;
     }
+    pthread_mutex_unlock(&group->mtx);
 
     return ret;
 }
@@ -160,7 +259,9 @@ UT_array *neu_group_get_tag(const neu_group_t *group)
 {
     UT_array *array = NULL;
 
+    pthread_mutex_lock(&((neu_group_t *) group)->mtx);
     array = to_array(group->tags);
+    pthread_mutex_unlock(&((neu_group_t *) group)->mtx);
 
     return array;
 }
@@ -171,12 +272,154 @@ UT_array *neu_group_query_tag(neu_group_t *group, const char *name)
     UT_array *  array = NULL;
 
     utarray_new(array, neu_tag_get_icd());
+    pthread_mutex_lock(&group->mtx);
     HASH_ITER(hh, group->tags, el, tmp)
     {
-        if (strstr(el->tag->name, name) != NULL) {
-            utarray_push_back(array, el->tag);
+        if (strstr(el->tag.name, name) != NULL) {
+            utarray_push_back(array, &el->tag);
         }
     }
+    pthread_mutex_unlock(&group->mtx);
+
+    return array;
+}
+
+static inline bool name_before(const neu_datatag_t *a,
+                               const neu_datatag_t *b)
+{
+    return strcmp(a->name, b->name) < 0;
+}
+
+// max heap on the name, the root is the last tag of the page so far
+static void heap_down(neu_datatag_t **heap, uint32_t n, uint32_t i)
+{
+    for (;;) {
+        uint32_t l = 2 * i + 1, r = l + 1, top = i;
+
+        if (l < n && name_before(heap[top], heap[l])) {
+            top = l;
+        }
+        if (r < n && name_before(heap[top], heap[r])) {
+            top = r;
+        }
+        if (top == i) {
+            break;
+        }
+
+        neu_datatag_t *t = heap[i];
+        heap[i]          = heap[top];
+        heap[top]        = t;
+        i                = top;
+    }
+}
+
+static void heap_up(neu_datatag_t **heap, uint32_t i)
+{
+    while (i > 0) {
+        uint32_t parent = (i - 1) / 2;
+
+        if (!name_before(heap[parent], heap[i])) {
+            break;
+        }
+
+        neu_datatag_t *t = heap[i];
+        heap[i]          = heap[parent];
+        heap[parent]     = t;
+        i                = parent;
+    }
+}
+
+static UT_array *query_tag_page(neu_group_t *                group,
+                                const neu_group_tag_query_t *query,
+                                uint32_t *total, char *next)
+{
+    tag_elem_t *el = NULL, *tmp = NULL;
+    UT_array *  array  = NULL;
+    const char *cursor = query->cursor;
+    uint32_t    limit  = query->limit;
+    uint32_t    fields = query->fields != 0 ? query->fields : NEU_TAG_FIELD_ALL;
+
+    *total  = 0;
+    next[0] = '\0';
+    utarray_new(array, neu_tag_get_icd());
+
+    if (limit == 0 && (cursor == NULL || cursor[0] == '\0')) {
+        HASH_ITER(hh, group->tags, el, tmp)
+        {
+            if (tag_match(&el->tag, query)) {
+                push_projected(array, &el->tag, fields);
+                *total += 1;
+            }
+        }
+        return array;
+    }
+
+    // keep the `limit` smallest names after the cursor, without sorting the
+    // whole group for every page
+    uint32_t count = HASH_COUNT(group->tags);
+    uint32_t cap   = limit == 0 || limit > count ? count : limit;
+    uint32_t n     = 0;
+    bool     more  = false;
+
+    neu_datatag_t **heap = calloc(cap > 0 ? cap : 1, sizeof(neu_datatag_t *));
+    if (heap == NULL) {
+        return array;
+    }
+
+    HASH_ITER(hh, group->tags, el, tmp)
+    {
+        if (!tag_match(&el->tag, query)) {
+            continue;
+        }
+
+        *total += 1;
+        if (cursor != NULL && strcmp(el->tag.name, cursor) <= 0) {
+            continue;
+        }
+
+        if (n < cap) {
+            heap[n] = &el->tag;
+            heap_up(heap, n++);
+        } else {
+            more = true;
+            if (name_before(&el->tag, heap[0])) {
+                heap[0] = &el->tag;
+                heap_down(heap, n, 0);
+            }
+        }
+    }
+
+    if (more) {
+        strncpy(next, heap[0]->name, NEU_TAG_NAME_LEN - 1);
+        next[NEU_TAG_NAME_LEN - 1] = '\0';
+    }
+
+    // heap sort in place, ascending by name
+    for (uint32_t i = n; i > 1; i--) {
+        neu_datatag_t *t = heap[0];
+        heap[0]          = heap[i - 1];
+        heap[i - 1]      = t;
+        heap_down(heap, i - 1, 0);
+    }
+
+    utarray_reserve(array, n);
+    for (uint32_t i = 0; i < n; i++) {
+        push_projected(array, heap[i], fields);
+    }
+
+    free(heap);
+    return array;
+}
+
+UT_array *neu_group_query_tag_page(neu_group_t *                group,
+                                   const neu_group_tag_query_t *query,
+                                   uint32_t *total, char *next)
+{
+    UT_array *array = NULL;
+
+    pthread_mutex_lock(&group->mtx);
+    array = query_tag_page(group, query, total, next);
+    pthread_mutex_unlock(&group->mtx);
 
     return array;
 }
@@ -185,46 +428,103 @@ UT_array *neu_group_get_read_tag(neu_group_t *group)
 {
     UT_array *array = NULL;
 
+    pthread_mutex_lock(&group->mtx);
     array = to_read_array(group->tags);
+    pthread_mutex_unlock(&group->mtx);
 
     return array;
 }
 
-uint16_t neu_group_tag_size(const neu_group_t *group)
+UT_array *neu_group_read_tags(neu_group_t *group)
+{
+    static UT_icd icd = { sizeof(neu_datatag_t), NULL, NULL, NULL };
+    tag_elem_t *  el = NULL, *tmp = NULL;
+
+    pthread_mutex_lock(&group->mtx);
+    if (group->read_tags != NULL) {
+        pthread_mutex_unlock(&group->mtx);
+        return group->read_tags;
+    }
+
+    utarray_new(group->read_tags, &icd);
+    utarray_reserve(group->read_tags, HASH_COUNT(group->tags));
+    HASH_ITER(hh, group->tags, el, tmp)
+    {
+        if (neu_tag_attribute_test(&el->tag, NEU_ATTRIBUTE_READ) ||
+            neu_tag_attribute_test(&el->tag, NEU_ATTRIBUTE_SUBSCRIBE) ||
+            neu_tag_attribute_test(&el->tag, NEU_ATTRIBUTE_STATIC)) {
+            utarray_push_back(group->read_tags, &el->tag);
+        }
+    }
+    pthread_mutex_unlock(&group->mtx);
+
+    return group->read_tags;
+}
+
+size_t neu_group_memory(const neu_group_t *group)
+{
+    size_t size = sizeof(neu_group_t) + strlen(group->name) + 1;
+
+    pthread_mutex_lock(&((neu_group_t *) group)->mtx);
+    size += neu_arena_size(group->arena);
+    size += HASH_OVERHEAD(hh, group->tags);
+    size += HASH_OVERHEAD(hh, group->strings);
+    if (group->read_tags != NULL) {
+        size += utarray_len(group->read_tags) * sizeof(neu_datatag_t);
+    }
+    pthread_mutex_unlock(&((neu_group_t *) group)->mtx);
+
+    return size;
+}
+
+uint32_t neu_group_tag_size(const neu_group_t *group)
 {
-    uint16_t size = 0;
+    uint32_t size = 0;
 
+    pthread_mutex_lock(&((neu_group_t *) group)->mtx);
     size = HASH_COUNT(group->tags);
+    pthread_mutex_unlock(&((neu_group_t *) group)->mtx);
 
     return size;
 }
 
-neu_datatag_t *neu_group_find_tag(neu_group_t *group, const char *tag)
+const neu_datatag_t *neu_group_find_tag(neu_group_t *group, const char *tag)
 {
-    tag_elem_t *   find   = NULL;
-    neu_datatag_t *result = NULL;
+    tag_elem_t *find = NULL;
 
+    pthread_mutex_lock(&group->mtx);
     HASH_FIND_STR(group->tags, tag, find);
-    if (find != NULL) {
-        result = neu_tag_dup(find->tag);
-    }
+    pthread_mutex_unlock(&group->mtx);
 
-    return result;
+    return find != NULL ? &find->tag : NULL;
 }
 
 void neu_group_split_static_tags(neu_group_t *group, UT_array **static_tags,
                                  UT_array **other_tags)
 {
-    return split_static_array(group->tags, static_tags, other_tags);
+    pthread_mutex_lock(&group->mtx);
+    split_static_array(group->tags, static_tags, other_tags);
+    pthread_mutex_unlock(&group->mtx);
 }
 
 void neu_group_change_test(neu_group_t *group, int64_t timestamp, void *arg,
                            neu_group_change_fn fn)
 {
+    UT_array *static_tags = NULL, *other_tags = NULL;
+    int64_t   changed     = 0;
+    uint32_t  interval    = 0;
+
+    // copy under the lock, the callback runs without it
+    pthread_mutex_lock(&group->mtx);
     if (group->timestamp != timestamp) {
-        UT_array *static_tags = NULL, *other_tags = NULL;
         split_static_array(group->tags, &static_tags, &other_tags);
-        fn(arg, group->timestamp, static_tags, other_tags, group->interval);
+        changed  = group->timestamp;
+        interval = group->interval;
+    }
+    pthread_mutex_unlock(&group->mtx);
+
+    if (static_tags != NULL) {
+        fn(arg, changed, static_tags, other_tags, interval);
     }
 }
 
@@ -232,7 +532,9 @@ bool neu_group_is_change(neu_group_t *group, int64_t timestamp)
 {
     bool change = false;
 
+    pthread_mutex_lock(&group->mtx);
     change = group->timestamp != timestamp;
+    pthread_mutex_unlock(&group->mtx);
 
     return change;
 }
@@ -244,6 +546,182 @@ static void update_timestamp(neu_group_t *group)
     gettimeofday(&tv, NULL);
 
     group->timestamp = (int64_t) tv.tv_sec * 1000 * 1000 + (int64_t) tv.tv_usec;
+
+    // every change of the tags goes through here
+    if (group->read_tags != NULL) {
+        utarray_free(group->read_tags);
+        group->read_tags = NULL;
+    }
+}
+
+static const char *intern_in(neu_arena_t *arena, intern_str_t **strings,
+                             const char *str)
+{
+    intern_str_t *find = NULL;
+    size_t        len  = strlen(str);
+
+    HASH_FIND(hh, *strings, str, len, find);
+    if (find == NULL) {
+        find = neu_arena_alloc(arena, sizeof(intern_str_t));
+        if (find == NULL ||
+            (find->str = neu_arena_strdup(arena, str)) == NULL) {
+            return NULL;
+        }
+        HASH_ADD_KEYPTR(hh, *strings, find->str, len, find);
+    }
+
+    return find->str;
+}
+
+static const char *intern(neu_group_t *group, const char *str)
+{
+    return intern_in(group->arena, &group->strings, str);
+}
+
+static size_t arena_strlen(const char *str)
+{
+    return (strlen(str) + 8) & ~(size_t) 7;
+}
+
+// fill the fields of `el` but the name from `tag`
+static int fill_tag(neu_group_t *group, tag_elem_t *el,
+                    const neu_datatag_t *tag)
+{
+    neu_datatag_t *dst = &el->tag;
+
+    dst->type        = tag->type;
+    dst->attribute   = tag->attribute;
+    dst->precision   = tag->precision;
+    dst->decimal     = tag->decimal;
+    dst->option      = tag->option;
+    dst->report      = tag->report;
+    dst->address     = neu_arena_strdup(group->arena, tag->address);
+    dst->description = (char *) intern(group, tag->description);
+    if (dst->address == NULL || dst->description == NULL) {
+        return -1;
+    }
+
+    memset(dst->meta, 0, sizeof(dst->meta));
+    if (neu_tag_attribute_test(tag, NEU_ATTRIBUTE_STATIC)) {
+        neu_value_u value = { 0 };
+        if (0 == neu_tag_get_static_value(tag, &value)) {
+            neu_tag_set_static_value(dst, &value);
+        }
+    } else {
+        memcpy(dst->meta, tag->meta, sizeof(tag->meta));
+    }
+
+    return 0;
+}
+
+static int store_tag(neu_group_t *group, const neu_datatag_t *tag)
+{
+    tag_elem_t *el = group->free_elems;
+
+    if (el != NULL) {
+        group->free_elems = el->hh.next;
+        group->garbage -= sizeof(tag_elem_t);
+    } else {
+        el = neu_arena_alloc(group->arena, sizeof(tag_elem_t));
+        if (el == NULL) {
+            return -1;
+        }
+    }
+
+    memset(el, 0, sizeof(*el));
+    el->tag.name = neu_arena_strdup(group->arena, tag->name);
+    if (el->tag.name == NULL || 0 != fill_tag(group, el, tag)) {
+        // the element was not linked, leave it for the next tag
+        group->garbage += sizeof(tag_elem_t);
+        el->hh.next       = group->free_elems;
+        group->free_elems = el;
+        return -1;
+    }
+
+    HASH_ADD_KEYPTR(hh, group->tags, el->tag.name, strlen(el->tag.name), el);
+    return 0;
+}
+
+static int restore_tag(neu_group_t *group, tag_elem_t *el,
+                       const neu_datatag_t *tag)
+{
+    neu_datatag_t old = el->tag;
+
+    if (0 != fill_tag(group, el, tag)) {
+        el->tag = old;
+        return -1;
+    }
+
+    group->garbage += arena_strlen(old.address);
+    neu_tag_clear_static_value(&old);
+
+    return 0;
+}
+
+// release what `el` holds outside of the arena, the element is unlinked
+static void drop_tag(neu_group_t *group, tag_elem_t *el)
+{
+    neu_tag_clear_static_value(&el->tag);
+    group->garbage += sizeof(tag_elem_t) + arena_strlen(el->tag.name) +
+        arena_strlen(el->tag.address);
+}
+
+// move the live tags to a new arena once most of the current one is garbage
+static void compact(neu_group_t *group)
+{
+    if (group->garbage < GROUP_ARENA_BLOCK ||
+        group->garbage * 2 < neu_arena_used(group->arena)) {
+        return;
+    }
+
+    neu_arena_t * arena   = neu_arena_new(GROUP_ARENA_BLOCK);
+    tag_elem_t *  tags    = NULL;
+    intern_str_t *strings = NULL;
+    tag_elem_t *  el = NULL, *tmp = NULL;
+
+    if (arena == NULL) {
+        return;
+    }
+
+    // in iteration order, which is the insertion order
+    HASH_ITER(hh, group->tags, el, tmp)
+    {
+        tag_elem_t *moved = neu_arena_alloc(arena, sizeof(tag_elem_t));
+        if (moved == NULL) {
+            goto error;
+        }
+
+        // the static value pointer is moved along with the meta bytes
+        moved->tag         = el->tag;
+        moved->tag.name    = neu_arena_strdup(arena, el->tag.name);
+        moved->tag.address = neu_arena_strdup(arena, el->tag.address);
+        moved->tag.description =
+            (char *) intern_in(arena, &strings, el->tag.description);
+        if (moved->tag.name == NULL || moved->tag.address == NULL ||
+            moved->tag.description == NULL) {
+            goto error;
+        }
+
+        HASH_ADD_KEYPTR(hh, tags, moved->tag.name, strlen(moved->tag.name),
+                        moved);
+    }
+
+    HASH_CLEAR(hh, group->tags);
+    HASH_CLEAR(hh, group->strings);
+    neu_arena_free(group->arena);
+
+    group->arena      = arena;
+    group->tags       = tags;
+    group->strings    = strings;
+    group->free_elems = NULL;
+    group->garbage    = 0;
+    return;
+
+error:
+    // keep the current arena, compacting is tried again on the next change
+    HASH_CLEAR(hh, tags);
+    HASH_CLEAR(hh, strings);
+    neu_arena_free(arena);
 }
 
 static UT_array *to_array(tag_elem_t *tags)
@@ -252,7 +730,7 @@ static UT_array *to_array(tag_elem_t *tags)
     UT_array *  array = NULL;
 
     utarray_new(array, neu_tag_get_icd());
-    HASH_ITER(hh, tags, el, tmp) { utarray_push_back(array, el->tag); }
+    HASH_ITER(hh, tags, el, tmp) { utarray_push_back(array, &el->tag); }
 
     return array;
 }
@@ -265,10 +743,10 @@ static UT_array *to_read_array(tag_elem_t *tags)
     utarray_new(array, neu_tag_get_icd());
     HASH_ITER(hh, tags, el, tmp)
     {
-        if (neu_tag_attribute_test(el->tag, NEU_ATTRIBUTE_READ) ||
-            neu_tag_attribute_test(el->tag, NEU_ATTRIBUTE_SUBSCRIBE) ||
-            neu_tag_attribute_test(el->tag, NEU_ATTRIBUTE_STATIC)) {
-            utarray_push_back(array, el->tag);
+        if (neu_tag_attribute_test(&el->tag, NEU_ATTRIBUTE_READ) ||
+            neu_tag_attribute_test(&el->tag, NEU_ATTRIBUTE_SUBSCRIBE) ||
+            neu_tag_attribute_test(&el->tag, NEU_ATTRIBUTE_STATIC)) {
+            utarray_push_back(array, &el->tag);
         }
     }
 
@@ -284,10 +762,47 @@ static void split_static_array(tag_elem_t *tags, UT_array **static_tags,
     utarray_new(*other_tags, neu_tag_get_icd());
     HASH_ITER(hh, tags, el, tmp)
     {
-        if (neu_tag_attribute_test(el->tag, NEU_ATTRIBUTE_STATIC)) {
-            utarray_push_back(*static_tags, el->tag);
+        if (neu_tag_attribute_test(&el->tag, NEU_ATTRIBUTE_STATIC)) {
+            utarray_push_back(*static_tags, &el->tag);
         } else {
-            utarray_push_back(*other_tags, el->tag);
+            utarray_push_back(*other_tags, &el->tag);
         }
     }
 }
+
+static bool tag_match(const neu_datatag_t *        tag,
+                      const neu_group_tag_query_t *query)
+{
+    if (query->name != NULL && query->name[0] != '\0' &&
+        strstr(tag->name, query->name) == NULL) {
+        return false;
+    }
+
+    if (query->prefix != NULL && query->prefix[0] != '\0' &&
+        strncmp(tag->name, query->prefix, strlen(query->prefix)) != 0) {
+        return false;
+    }
+
+    return (tag->attribute & query->attribute) == query->attribute;
+}
+
+static void push_projected(UT_array *array, const neu_datatag_t *tag,
+                           uint32_t fields)
+{
+    neu_datatag_t copy = *tag;
+
+    // the array copy duplicates the strings and the static value, leave out
+    // the ones nobody will look at
+    if (!(fields & NEU_TAG_FIELD_ADDRESS)) {
+        copy.address = "";
+    }
+    if (!(fields & NEU_TAG_FIELD_DESCRIPTION)) {
+        copy.description = "";
+    }
+    if (!(fields & NEU_TAG_FIELD_VALUE) &&
+        neu_tag_attribute_test(tag, NEU_ATTRIBUTE_STATIC)) {
+        memset(copy.meta, 0, sizeof(copy.meta));
+    }
+
+    utarray_push_back(array, &copy);
+}
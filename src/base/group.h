@@ -20,6 +20,10 @@
 #ifndef _NEU_GROUP_H_
 #define _NEU_GROUP_H_
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 #include <stdint.h>
 
 #include "utils/utextend.h"
@@ -35,13 +39,66 @@ void         neu_group_set_interval(neu_group_t *group, uint32_t interval);
 void         neu_group_destroy(neu_group_t *group);
 int          neu_group_update(neu_group_t *group, uint32_t interval);
 int          neu_group_add_tag(neu_group_t *group, const neu_datatag_t *tag);
+/**
+ * @brief Add tags in order, stopping at the first name conflict.
+ *
+ * Unlike calling neu_group_add_tag for each tag the group changes once, so
+ * a bulk import is seen as a single change by the next group cycle.
+ *
+ * @param[out] n_added Number of tags added, may be NULL.
+ */
+int neu_group_add_tags(neu_group_t *group, const neu_datatag_t *tags,
+                       uint32_t n, uint32_t *n_added);
 int          neu_group_update_tag(neu_group_t *group, const neu_datatag_t *tag);
 int          neu_group_del_tag(neu_group_t *group, const char *tag_name);
 UT_array *   neu_group_get_tag(const neu_group_t *group);
 UT_array *   neu_group_query_tag(neu_group_t *group, const char *name);
 UT_array *   neu_group_get_read_tag(neu_group_t *group);
-uint16_t     neu_group_tag_size(const neu_group_t *group);
-neu_datatag_t *neu_group_find_tag(neu_group_t *group, const char *tag);
+/**
+ * @brief Get the tags to read without copying them, for periodic reports.
+ *
+ * @return Array of neu_datatag_t owned by the group, sharing its strings,
+ *         valid until the group is modified. Do not free it, nor use it
+ *         outside of the thread modifying the group.
+ */
+UT_array *neu_group_read_tags(neu_group_t *group);
+
+typedef struct {
+    const char *name;      // substring of the tag name, NULL or "" for any
+    const char *prefix;    // prefix of the tag name, NULL or "" for any
+    const char *cursor;    // only tags named after it, NULL or "" for any
+    uint32_t    limit;     // max tags returned, 0 for no limit
+    uint32_t    attribute; // attribute bits a tag must all have
+    uint32_t    fields;    // neu_tag_field_e bits to copy, 0 for all
+} neu_group_tag_query_t;
+
+/**
+ * @brief Get one page of the tags matching a query.
+ *
+ * Without limit and cursor tags are returned in insertion order, as with
+ * neu_group_query_tag. Otherwise they are ordered by name so that the name
+ * of the last tag of a page is a stable cursor for the next one, even when
+ * tags are added or deleted in between. Fields not asked for are left empty
+ * in the copies, which saves duplicating long addresses and descriptions.
+ *
+ * @param[out] total Number of tags matching the query, cursor aside.
+ * @param[out] next  Cursor of the next page, "" if this is the last one,
+ *                   NEU_TAG_NAME_LEN bytes.
+ */
+UT_array *neu_group_query_tag_page(neu_group_t *                group,
+                                   const neu_group_tag_query_t *query,
+                                   uint32_t *total, char *next);
+uint32_t     neu_group_tag_size(const neu_group_t *group);
+// bytes held by the group, static tag values aside
+size_t neu_group_memory(const neu_group_t *group);
+/**
+ * @brief Find a tag of the group, without copying it.
+ *
+ * @return The tag stored in the group, valid until the group is modified,
+ *         NULL if not found. Copy it with neu_tag_dup to keep it longer or
+ *         to hand it to another thread.
+ */
+const neu_datatag_t *neu_group_find_tag(neu_group_t *group, const char *tag);
 void neu_group_split_static_tags(neu_group_t *group, UT_array **static_tags,
                                  UT_array **other_tags);
 
@@ -51,4 +108,9 @@ typedef void (*neu_group_change_fn)(void *arg, int64_t timestamp,
 void neu_group_change_test(neu_group_t *group, int64_t timestamp, void *arg,
                            neu_group_change_fn fn);
 bool neu_group_is_change(neu_group_t *group, int64_t timestamp);
-#endif
\ No newline at end of file
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -26,6 +26,7 @@
 #include "adapter.h"
 #include "adapter/adapter_internal.h"
 #include "metrics.h"
+#include "persist/persist.h"
 #include "utils/log.h"
 #include "utils/time.h"
 
@@ -281,6 +282,10 @@ void neu_metrics_visist(neu_metrics_cb_t cb, void *data)
     disk_usage(&disk_size, &disk_used, &disk_avail);
     bool     core_dumped    = has_core_dumps();
     uint64_t uptime_seconds = (neu_time_ms() - g_start_ts_) / 1000;
+
+    neu_persist_stats_t persist_stats = { 0 };
+    neu_persister_stats(&persist_stats);
+
     pthread_rwlock_rdlock(&g_metrics_mtx_);
     g_metrics_.cpu_percent          = cpu;
     g_metrics_.cpu_cores            = get_nprocs();
@@ -292,6 +297,12 @@ void neu_metrics_visist(neu_metrics_cb_t cb, void *data)
     g_metrics_.core_dumped          = core_dumped;
     g_metrics_.uptime_seconds       = uptime_seconds;
 
+    g_metrics_.persist_queued_ops      = persist_stats.queued_ops;
+    g_metrics_.persist_batches_total   = persist_stats.batches_total;
+    g_metrics_.persist_errors_total    = persist_stats.errors_total;
+    g_metrics_.persist_last_batch_ops  = persist_stats.last_batch_ops;
+    g_metrics_.persist_last_latency_ms = persist_stats.last_latency_ms;
+
     g_metrics_.north_nodes              = 0;
     g_metrics_.north_running_nodes      = 0;
     g_metrics_.north_disconnected_nodes = 0;
@@ -0,0 +1,308 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <nng/nng.h>
+
+#include "adapter.h"
+
+void *neu_msg_gen(neu_reqresp_head_t *header, void *data)
+{
+    nng_msg *msg       = NULL;
+    void *   body      = NULL;
+    size_t   data_size = 0;
+
+    switch (header->type) {
+    case NEU_REQ_NODE_INIT:
+    case NEU_REQ_NODE_UNINIT:
+    case NEU_RESP_NODE_UNINIT:
+        data_size = sizeof(neu_req_node_init_t);
+        break;
+    case NEU_RESP_ERROR:
+        data_size = sizeof(neu_resp_error_t);
+        break;
+    case NEU_REQ_ADD_PLUGIN:
+        data_size = sizeof(neu_req_add_plugin_t);
+        break;
+    case NEU_REQ_DEL_PLUGIN:
+        data_size = sizeof(neu_req_del_plugin_t);
+        break;
+    case NEU_REQ_GET_PLUGIN:
+        data_size = sizeof(neu_req_get_plugin_t);
+        break;
+    case NEU_RESP_GET_PLUGIN:
+        data_size = sizeof(neu_resp_get_plugin_t);
+        break;
+    case NEU_REQ_ADD_TEMPLATE:
+        data_size = sizeof(neu_req_add_template_t);
+        break;
+    case NEU_REQ_DEL_TEMPLATE:
+        data_size = sizeof(neu_req_del_template_t);
+        break;
+    case NEU_REQ_GET_TEMPLATE:
+        data_size = sizeof(neu_req_get_template_t);
+        break;
+    case NEU_RESP_GET_TEMPLATE:
+        data_size = sizeof(neu_resp_get_template_t);
+        break;
+    case NEU_REQ_GET_TEMPLATES:
+        data_size = sizeof(neu_req_get_templates_t);
+        break;
+    case NEU_RESP_GET_TEMPLATES:
+        data_size = sizeof(neu_resp_get_templates_t);
+        break;
+    case NEU_REQ_ADD_TEMPLATE_GROUP:
+        data_size = sizeof(neu_req_add_template_group_t);
+        break;
+    case NEU_REQ_DEL_TEMPLATE_GROUP:
+        data_size = sizeof(neu_req_del_template_group_t);
+        break;
+    case NEU_REQ_UPDATE_TEMPLATE_GROUP:
+        data_size = sizeof(neu_req_update_template_group_t);
+        break;
+    case NEU_REQ_GET_TEMPLATE_GROUP:
+        data_size = sizeof(neu_req_get_template_group_t);
+        break;
+    case NEU_REQ_ADD_TEMPLATE_TAG:
+        data_size = sizeof(neu_req_add_template_tag_t);
+        break;
+    case NEU_REQ_DEL_TEMPLATE_TAG:
+        data_size = sizeof(neu_req_del_template_tag_t);
+        break;
+    case NEU_REQ_UPDATE_TEMPLATE_TAG:
+        data_size = sizeof(neu_req_update_template_tag_t);
+        break;
+    case NEU_REQ_GET_TEMPLATE_TAG:
+        data_size = sizeof(neu_req_get_template_tag_t);
+        break;
+    case NEU_REQ_INST_TEMPLATE:
+        data_size = sizeof(neu_req_inst_template_t);
+        break;
+    case NEU_REQ_ADD_NODE:
+    case NEU_REQ_ADD_NODE_EVENT:
+        data_size = sizeof(neu_req_add_node_t);
+        break;
+    case NEU_REQ_UPDATE_NODE:
+        data_size = sizeof(neu_req_update_node_t);
+        break;
+    case NEU_REQ_DEL_NODE:
+    case NEU_REQ_DEL_NODE_EVENT:
+        data_size = sizeof(neu_req_del_node_t);
+        break;
+    case NEU_REQ_GET_NODE:
+        data_size = sizeof(neu_req_get_node_t);
+        break;
+    case NEU_RESP_GET_NODE:
+        data_size = sizeof(neu_resp_get_node_t);
+        break;
+    case NEU_REQ_ADD_GROUP:
+    case NEU_REQ_ADD_GROUP_EVENT:
+        data_size = sizeof(neu_req_add_group_t);
+        break;
+    case NEU_REQ_UPDATE_GROUP:
+    case NEU_REQ_UPDATE_GROUP_EVENT:
+        data_size = sizeof(neu_req_update_group_t);
+        break;
+    case NEU_REQ_DEL_GROUP:
+    case NEU_REQ_DEL_GROUP_EVENT:
+        data_size = sizeof(neu_req_del_group_t);
+        break;
+    case NEU_REQ_GET_DRIVER_GROUP:
+    case NEU_REQ_GET_GROUP:
+        data_size = sizeof(neu_req_get_group_t);
+        break;
+    case NEU_RESP_GET_GROUP:
+        data_size = sizeof(neu_resp_get_group_t);
+        break;
+    case NEU_REQ_ADD_TAG:
+    case NEU_REQ_ADD_TAG_EVENT:
+        data_size = sizeof(neu_req_add_tag_t);
+        break;
+    case NEU_RESP_ADD_TAG:
+    case NEU_RESP_ADD_TEMPLATE_TAG:
+        data_size = sizeof(neu_resp_add_tag_t);
+        break;
+    case NEU_RESP_UPDATE_TAG:
+    case NEU_RESP_UPDATE_TEMPLATE_TAG:
+        data_size = sizeof(neu_resp_update_tag_t);
+        break;
+    case NEU_REQ_UPDATE_TAG:
+    case NEU_REQ_UPDATE_TAG_EVENT:
+        data_size = sizeof(neu_req_update_tag_t);
+        break;
+    case NEU_REQ_DEL_TAG:
+    case NEU_REQ_DEL_TAG_EVENT:
+        data_size = sizeof(neu_req_del_tag_t);
+        break;
+    case NEU_REQ_GET_TAG:
+        data_size = sizeof(neu_req_get_tag_t);
+        break;
+    case NEU_RESP_GET_TAG:
+    case NEU_RESP_GET_TEMPLATE_TAG:
+        data_size = sizeof(neu_resp_get_tag_t);
+        break;
+    case NEU_REQ_SUBSCRIBE_GROUP:
+        data_size = sizeof(neu_req_subscribe_t);
+        break;
+    case NEU_REQ_UNSUBSCRIBE_GROUP:
+        data_size = sizeof(neu_req_unsubscribe_t);
+        break;
+    case NEU_REQ_GET_SUBSCRIBE_GROUP:
+    case NEU_REQ_GET_SUB_DRIVER_TAGS:
+        data_size = sizeof(neu_req_get_subscribe_group_t);
+        break;
+    case NEU_RESP_GET_SUB_DRIVER_TAGS:
+        data_size = sizeof(neu_resp_get_sub_driver_tags_t);
+        break;
+    case NEU_RESP_GET_SUBSCRIBE_GROUP:
+        data_size = sizeof(neu_resp_get_subscribe_group_t);
+        break;
+    case NEU_REQ_NODE_SETTING:
+    case NEU_REQ_NODE_SETTING_EVENT:
+        data_size = sizeof(neu_req_node_setting_t);
+        break;
+    case NEU_REQ_GET_NODE_SETTING:
+        data_size = sizeof(neu_req_get_node_setting_t);
+        break;
+    case NEU_RESP_GET_NODE_SETTING:
+        data_size = sizeof(neu_resp_get_node_setting_t);
+        break;
+    case NEU_REQ_NODE_CTL:
+    case NEU_REQ_NODE_CTL_EVENT:
+        data_size = sizeof(neu_req_node_ctl_t);
+        break;
+    case NEU_REQ_NODE_RENAME:
+        data_size = sizeof(neu_req_node_rename_t);
+        break;
+    case NEU_RESP_NODE_RENAME:
+        data_size = sizeof(neu_resp_node_rename_t);
+        break;
+    case NEU_REQ_GET_NODE_STATE:
+        data_size = sizeof(neu_req_get_node_state_t);
+        break;
+    case NEU_RESP_GET_NODE_STATE:
+        data_size = sizeof(neu_resp_get_node_state_t);
+        break;
+    case NEU_REQ_GET_NODES_STATE:
+        data_size = sizeof(neu_req_get_nodes_state_t);
+        break;
+    case NEU_REQRESP_NODES_STATE:
+    case NEU_RESP_GET_NODES_STATE:
+        data_size = sizeof(neu_resp_get_nodes_state_t);
+        break;
+    case NEU_REQ_READ_GROUP:
+        data_size = sizeof(neu_req_read_group_t);
+        break;
+    case NEU_REQ_WRITE_TAG:
+        data_size = sizeof(neu_req_write_tag_t);
+        break;
+    case NEU_REQ_WRITE_TAGS:
+        data_size = sizeof(neu_req_write_tags_t);
+        break;
+    case NEU_RESP_READ_GROUP:
+        data_size = sizeof(neu_resp_read_group_t);
+        break;
+    case NEU_REQRESP_TRANS_DATA: {
+        neu_reqresp_trans_data_t *trans = (neu_reqresp_trans_data_t *) data;
+        data_size                       = sizeof(neu_reqresp_trans_data_t) +
+            trans->n_tag * sizeof(neu_resp_tag_value_t);
+        break;
+    }
+    case NEU_REQ_UPDATE_LICENSE:
+        data_size = sizeof(neu_req_update_license_t);
+        break;
+    case NEU_REQRESP_NODE_DELETED:
+        data_size = sizeof(neu_reqresp_node_deleted_t);
+        break;
+    case NEU_RESP_GET_DRIVER_GROUP:
+        data_size = sizeof(neu_resp_get_driver_group_t);
+        break;
+    case NEU_REQ_ADD_NDRIVER_MAP:
+    case NEU_REQ_DEL_NDRIVER_MAP:
+        data_size = sizeof(neu_req_ndriver_map_t);
+        break;
+    case NEU_REQ_GET_NDRIVER_MAPS:
+        data_size = sizeof(neu_req_get_ndriver_maps_t);
+        break;
+    case NEU_RESP_GET_NDRIVER_MAPS:
+        data_size = sizeof(neu_resp_get_ndriver_maps_t);
+        break;
+    case NEU_REQ_UPDATE_NDRIVER_TAG_PARAM:
+        data_size = sizeof(neu_req_update_ndriver_tag_param_t);
+        break;
+    case NEU_REQ_UPDATE_NDRIVER_TAG_INFO:
+        data_size = sizeof(neu_req_update_ndriver_tag_info_t);
+        break;
+    case NEU_REQ_GET_NDRIVER_TAGS:
+        data_size = sizeof(neu_req_get_ndriver_tags_t);
+        break;
+    case NEU_RESP_GET_NDRIVER_TAGS:
+        data_size = sizeof(neu_resp_get_ndriver_tags_t);
+        break;
+    case NEU_REQ_UPDATE_LOG_LEVEL:
+        data_size = sizeof(neu_req_update_log_level_t);
+        break;
+    default:
+        assert(false);
+        break;
+    }
+
+    nng_msg_alloc(&msg, sizeof(neu_reqresp_head_t) + data_size);
+    body = nng_msg_body(msg);
+    memcpy(body, header, sizeof(neu_reqresp_head_t));
+    memcpy((uint8_t *) body + sizeof(neu_reqresp_head_t), data, data_size);
+    return msg;
+}
+
+void *neu_trans_data_msg_alloc(uint32_t                   n_tag,
+                               neu_reqresp_trans_data_t **data)
+{
+    nng_msg *           msg    = NULL;
+    neu_reqresp_head_t *header = NULL;
+
+    if (nng_msg_alloc(&msg,
+                      sizeof(neu_reqresp_head_t) +
+                          sizeof(neu_reqresp_trans_data_t) +
+                          n_tag * sizeof(neu_resp_tag_value_t)) != 0) {
+        return NULL;
+    }
+
+    header = (neu_reqresp_head_t *) nng_msg_body(msg);
+    memset(header, 0, sizeof(neu_reqresp_head_t));
+    header->type = NEU_REQRESP_TRANS_DATA;
+
+    *data = (neu_reqresp_trans_data_t *) &header[1];
+    memset(*data, 0, sizeof(neu_reqresp_trans_data_t));
+
+    return msg;
+}
+
+void neu_trans_data_msg_trim(void *msg)
+{
+    neu_reqresp_head_t *      header = nng_msg_body(msg);
+    neu_reqresp_trans_data_t *data   = (neu_reqresp_trans_data_t *) &header[1];
+    size_t                    len    = sizeof(neu_reqresp_head_t) +
+        sizeof(neu_reqresp_trans_data_t) +
+        data->n_tag * sizeof(neu_resp_tag_value_t);
+
+    nng_msg_chop(msg, nng_msg_len(msg) - len);
+}
@@ -46,6 +46,7 @@ static void tag_array_copy(void *_dst, const void *_src)
     dst->precision   = src->precision;
     dst->decimal     = src->decimal;
     dst->option      = src->option;
+    dst->report      = src->report;
     dst->address     = strdup(src->address);
     dst->name        = strdup(src->name);
     dst->description = strdup(src->description);
@@ -447,6 +448,50 @@ int neu_tag_set_static_value(neu_datatag_t *tag, const neu_value_u *value)
     return 0;
 }
 
+void neu_tag_clear_static_value(neu_datatag_t *tag)
+{
+    neu_value_u *cur = NULL;
+
+    if (!neu_tag_attribute_test(tag, NEU_ATTRIBUTE_STATIC)) {
+        return;
+    }
+
+    GET_STATIC_VALUE_PTR(tag, cur);
+    free(cur);
+    memset(tag->meta, 0, sizeof(tag->meta));
+}
+
+// meta[0] tells whether the remaining bytes were set
+int neu_tag_set_meta(neu_datatag_t *tag, const void *data, size_t size)
+{
+    if (neu_tag_attribute_test(tag, NEU_ATTRIBUTE_STATIC) ||
+        size > NEU_TAG_META_SIZE - 1) {
+        return -1;
+    }
+
+    tag->meta[0] = 1;
+    memcpy(&tag->meta[1], data, size);
+    return 0;
+}
+
+int neu_tag_get_meta(const neu_datatag_t *tag, void *data, size_t size)
+{
+    if (neu_tag_attribute_test(tag, NEU_ATTRIBUTE_STATIC) ||
+        size > NEU_TAG_META_SIZE - 1 || tag->meta[0] == 0) {
+        return -1;
+    }
+
+    memcpy(data, &tag->meta[1], size);
+    return 0;
+}
+
+void neu_tag_clear_meta(neu_datatag_t *tag)
+{
+    if (!neu_tag_attribute_test(tag, NEU_ATTRIBUTE_STATIC)) {
+        memset(tag->meta, 0, sizeof(tag->meta));
+    }
+}
+
 int neu_tag_get_static_value_json(neu_datatag_t *tag, neu_json_type_e *t,
                                   neu_json_value_u *v)
 {
@@ -24,7 +24,6 @@
 #include <string.h>
 
 #define NNG_SUPP_TLS 1
-#define NNG_SUPP_SQLITE 1
 #include <nng/mqtt/mqtt_client.h>
 #include <nng/nng.h>
 #include <nng/supplemental/tls/tls.h>
@@ -33,6 +32,7 @@
 #include "connection/mqtt_client.h"
 #include "event/event.h"
 #include "utils/asprintf.h"
+#include "utils/seg_log.h"
 #include "utils/time.h"
 #include "utils/utextend.h"
 #include "utils/uthash.h"
@@ -56,6 +56,17 @@
         }                                                                  \
     } while (0)
 
+// offline cache segment size bounds, at most two segments are mapped
+#define CACHE_SEG_MIN (64 * 1024)
+#define CACHE_SEG_MAX (64 * 1024 * 1024)
+
+// cache record header, [qos:1][topic length:2][timestamp:8][topic][payload]
+#define CACHE_REC_HDR 11
+
+#define REPLAY_INFLIGHT_MAX 64
+// replay pacing timer period in milliseconds
+#define REPLAY_TICK 100
+
 typedef struct {
     size_t                         ref;
     bool                           ack;
@@ -101,6 +112,15 @@ typedef struct task_s {
     struct task_s *next;
 } task_t;
 
+typedef struct {
+    neu_mqtt_client_t *client;
+    nng_aio *          aio;
+    bool               busy;
+    bool               done;
+    uint64_t           seq;
+    uint8_t *          buf;
+} replay_slot_t;
+
 struct neu_mqtt_client_s {
     nng_socket                      sock;
     nng_mtx *                       mtx;
@@ -118,7 +138,18 @@ struct neu_mqtt_client_s {
     void *                          connect_cb_data;
     neu_mqtt_client_connection_cb_t disconnect_cb;
     void *                          disconnect_cb_data;
-    nng_mqtt_sqlite_option *        sqlite_cfg;
+    neu_seg_log_t *                 cache;
+    neu_event_timer_t *             replay_timer;
+    replay_slot_t *                 replay_slots;
+    size_t                          replay_inflight;
+    size_t                          replay_busy;
+    bool                            replay_error;
+    size_t                          replay_rate;
+    int64_t                         replay_tokens;
+    int64_t                         replay_ts;
+    char *                          replay_topic;
+    uint64_t                        replayed_msgs;
+    uint64_t                        replayed_bytes;
     bool                            receiving;
     nng_aio *                       recv_aio;
     subscription_t *                subscriptions;
@@ -147,6 +178,8 @@ static inline subscription_t *subscription_ref(subscription_t *subscription);
 static inline void            subscriptions_free(subscription_t *subscriptions);
 
 static void recv_cb(void *arg);
+static void replay_cb(void *arg);
+static int  replay_timer_cb(void *data);
 static int  resub_cb(void *data);
 static void disconnect_cb(nng_pipe p, nng_pipe_ev ev, void *arg);
 static void connect_cb(nng_pipe p, nng_pipe_ev ev, void *arg);
@@ -161,6 +194,8 @@ static int            client_send_sub_msg(neu_mqtt_client_t *client,
 static inline void    client_start_recv(neu_mqtt_client_t *client);
 static inline int     client_start_timer(neu_mqtt_client_t *client);
 static inline int     client_make_url(neu_mqtt_client_t *client);
+static void           client_replay(neu_mqtt_client_t *client);
+static void           client_replay_settle(neu_mqtt_client_t *client);
 
 static inline uint8_t neu_mqtt_version_to_nng_mqtt_version(neu_mqtt_version_e v)
 {
@@ -441,6 +476,9 @@ static void connect_cb(nng_pipe p, nng_pipe_ev ev, void *arg)
     client->connected = true;
     cb                = client->connect_cb;
     data              = client->connect_cb_data;
+
+    // flush messages cached while offline
+    client_replay(client);
     nng_mtx_unlock(client->mtx);
 
     if (cb) {
@@ -539,6 +577,252 @@ end:
     nng_recv_aio(client->sock, aio);
 }
 
+static void replay_cb(void *arg)
+{
+    replay_slot_t *    slot   = arg;
+    neu_mqtt_client_t *client = slot->client;
+    int                rv     = nng_aio_result(slot->aio);
+
+    nng_mtx_lock(client->mtx);
+    free(slot->buf);
+    slot->buf = NULL;
+
+    if (0 != rv) {
+        nng_msg_free(nng_aio_get_msg(slot->aio));
+        nng_aio_set_msg(slot->aio, NULL);
+        // keep the message, it is sent again after the others settle
+        log(warn, "replay cached message fail: %s", nng_strerror(rv));
+        client->replay_error = true;
+        slot->busy           = false;
+        client->replay_busy -= 1;
+    } else {
+        slot->done = true;
+    }
+
+    client_replay_settle(client);
+    client_replay(client);
+    nng_mtx_unlock(client->mtx);
+}
+
+static int replay_timer_cb(void *data)
+{
+    neu_mqtt_client_t *client = data;
+
+    nng_mtx_lock(client->mtx);
+    client_replay(client);
+    nng_mtx_unlock(client->mtx);
+
+    return 0;
+}
+
+// pop sent messages in order, should be called with client->mtx held
+static void client_replay_settle(neu_mqtt_client_t *client)
+{
+    for (;;) {
+        replay_slot_t *oldest = NULL;
+        for (size_t i = 0; i < client->replay_inflight; ++i) {
+            replay_slot_t *slot = &client->replay_slots[i];
+            if (slot->busy && (NULL == oldest || slot->seq < oldest->seq)) {
+                oldest = slot;
+            }
+        }
+
+        if (NULL == oldest || !oldest->done) {
+            break;
+        }
+
+        // no effect if a failed message precedes it, or it was evicted
+        neu_seg_log_pop(client->cache, oldest->seq);
+        oldest->busy = false;
+        oldest->done = false;
+        client->replay_busy -= 1;
+    }
+
+    if (client->replay_error && 0 == client->replay_busy) {
+        client->replay_error = false;
+        neu_seg_log_rewind(client->cache);
+    }
+}
+
+static inline bool client_replay_take_tokens(neu_mqtt_client_t *client)
+{
+    if (0 == client->replay_rate) {
+        return true;
+    }
+
+    int64_t now = neu_time_ms();
+    int64_t max = client->replay_rate / 4 + 1;
+    client->replay_tokens +=
+        (now - client->replay_ts) * (int64_t) client->replay_rate / 1000;
+    client->replay_ts = now;
+    if (client->replay_tokens > max) {
+        client->replay_tokens = max;
+    }
+
+    // allow a message as long as there is any credit, and owe the rest
+    return client->replay_tokens > 0;
+}
+
+static int client_replay_send(neu_mqtt_client_t *client, replay_slot_t *slot,
+                              const uint8_t *rec, size_t len)
+{
+    int      rv        = 0;
+    nng_msg *msg       = NULL;
+    uint16_t topic_len = (uint16_t)(rec[1] | rec[2] << 8);
+    char *   topic     = NULL;
+
+    if (len <= CACHE_REC_HDR + (size_t) topic_len) {
+        // should not happen as records are CRC checked
+        log(error, "drop malformed cached message");
+        return -1;
+    }
+
+    // the record is only valid until the next append
+    slot->buf = malloc(len + 1);
+    if (NULL == slot->buf) {
+        log(error, "malloc cached message fail");
+        return -1;
+    }
+    memcpy(slot->buf, rec, len);
+    topic = (char *) slot->buf + CACHE_REC_HDR;
+    // make room for the topic terminator
+    memmove(topic + topic_len + 1, topic + topic_len,
+            len - CACHE_REC_HDR - topic_len);
+    topic[topic_len] = '\0';
+
+    if (0 != (rv = nng_mqtt_msg_alloc(&msg, 0)) ||
+        0 !=
+            (rv = nng_mqtt_msg_set_publish_topic(
+                 msg, client->replay_topic ? client->replay_topic : topic))) {
+        log(error, "alloc cached message fail: %s", nng_strerror(rv));
+        nng_msg_free(msg);
+        free(slot->buf);
+        slot->buf = NULL;
+        return -1;
+    }
+
+    nng_mqtt_msg_set_packet_type(msg, NNG_MQTT_PUBLISH);
+    nng_mqtt_msg_set_publish_payload(msg, (uint8_t *) topic + topic_len + 1,
+                                     len - CACHE_REC_HDR - topic_len);
+    nng_mqtt_msg_set_publish_qos(msg, slot->buf[0]);
+
+    if (NEU_MQTT_VERSION_V5 == client->version) {
+        // tag with the original timestamp
+        uint64_t ts = 0;
+        char     ts_str[24];
+        for (int i = 7; i >= 0; --i) {
+            ts = ts << 8 | slot->buf[3 + i];
+        }
+        int       n    = snprintf(ts_str, sizeof(ts_str), "%" PRIu64, ts);
+        property *prop = mqtt_property_alloc();
+        mqtt_property_append(prop,
+                             mqtt_property_set_value_strpair(
+                                 USER_PROPERTY, "timestamp", 9, ts_str, n,
+                                 true));
+        nng_mqtt_msg_set_publish_property(msg, prop);
+    }
+
+    client->replayed_msgs += 1;
+    client->replayed_bytes += len - CACHE_REC_HDR - topic_len;
+    client->replay_tokens -= len - CACHE_REC_HDR - topic_len;
+
+    nng_aio_set_msg(slot->aio, msg);
+    nng_send_aio(client->sock, slot->aio);
+    return 0;
+}
+
+// replay cached messages in order, paced by the replay rate and with at
+// most replay_inflight messages in flight
+// should be called with client->mtx held
+static void client_replay(neu_mqtt_client_t *client)
+{
+    int            rv  = 0;
+    uint64_t       seq = 0;
+    const uint8_t *rec = NULL;
+    size_t         len = 0;
+
+    if (NULL == client->cache || !client->connected || !client->open ||
+        client->replay_error) {
+        return;
+    }
+
+    if (NULL == client->replay_slots) {
+        client->replay_slots =
+            calloc(client->replay_inflight, sizeof(replay_slot_t));
+        if (NULL == client->replay_slots) {
+            log(error, "calloc replay slots fail");
+            return;
+        }
+        for (size_t i = 0; i < client->replay_inflight; ++i) {
+            replay_slot_t *slot = &client->replay_slots[i];
+            slot->client        = client;
+            if (0 != (rv = nng_aio_alloc(&slot->aio, replay_cb, slot))) {
+                log(error, "nng_aio_alloc fail: %s", nng_strerror(rv));
+                client->replay_inflight = i;
+                break;
+            }
+        }
+        client->replay_ts = neu_time_ms();
+    }
+
+    while (client->replay_busy < client->replay_inflight &&
+           client_replay_take_tokens(client) &&
+           0 ==
+               neu_seg_log_next(client->cache, &seq, (const void **) &rec,
+                                &len)) {
+        replay_slot_t *slot = NULL;
+        for (size_t i = 0; i < client->replay_inflight; ++i) {
+            if (!client->replay_slots[i].busy) {
+                slot = &client->replay_slots[i];
+                break;
+            }
+        }
+
+        slot->busy = true;
+        slot->seq  = seq;
+        client->replay_busy += 1;
+        if (0 != client_replay_send(client, slot, rec, len)) {
+            // skip the message
+            slot->done = true;
+            client_replay_settle(client);
+        }
+    }
+}
+
+// should be called with client->mtx held
+static int client_cache_msg(neu_mqtt_client_t *client, neu_mqtt_qos_e qos,
+                            const char *topic, const uint8_t *payload,
+                            uint32_t len)
+{
+    size_t   topic_len = strlen(topic);
+    size_t   rec_len   = CACHE_REC_HDR + topic_len + len;
+    uint8_t *rec       = NULL;
+
+    if (topic_len > UINT16_MAX || NULL == (rec = malloc(rec_len))) {
+        return -1;
+    }
+
+    uint64_t ts = (uint64_t) neu_time_ms();
+    rec[0]      = qos;
+    rec[1]      = topic_len & 0xFF;
+    rec[2]      = topic_len >> 8;
+    for (int i = 0; i < 8; ++i) {
+        rec[3 + i] = (ts >> (8 * i)) & 0xFF;
+    }
+    memcpy(rec + CACHE_REC_HDR, topic, topic_len);
+    memcpy(rec + CACHE_REC_HDR + topic_len, payload, len);
+
+    int rv = neu_seg_log_append(client->cache, rec, rec_len);
+    free(rec);
+    if (0 != rv) {
+        log(error, "cache [%s, QoS%d] %" PRIu32 " bytes fail", topic, qos, len);
+        return -1;
+    }
+
+    log(debug, "cache [%s, QoS%d] %" PRIu32 " bytes", topic, qos, len);
+    return 0;
+}
+
 static inline task_t *client_alloc_task(neu_mqtt_client_t *client)
 {
     task_t *task = client->task_free_list;
@@ -724,6 +1008,22 @@ static inline int client_start_timer(neu_mqtt_client_t *client)
         return -1;
     }
 
+    if (client->cache) {
+        neu_event_timer_param_t replay_param = {
+            .second      = 0,
+            .millisecond = REPLAY_TICK,
+            .cb          = replay_timer_cb,
+            .usr_data    = client,
+        };
+
+        client->replay_timer = neu_event_add_timer(events, replay_param);
+        if (NULL == client->replay_timer) {
+            neu_event_del_timer(events, timer);
+            neu_event_close(events);
+            return -1;
+        }
+    }
+
     client->events = events;
     client->timer  = timer;
     return 0;
@@ -787,43 +1087,6 @@ static inline nng_tls_config *alloc_tls_config(neu_mqtt_client_t *client)
     return cfg;
 }
 
-static inline nng_mqtt_sqlite_option *
-alloc_sqlite_config(neu_mqtt_client_t *client)
-{
-    int                     rv;
-    char *                  db  = NULL;
-    nng_mqtt_sqlite_option *cfg = NULL;
-    const mqtt_buf          client_id =
-        nng_mqtt_msg_get_connect_client_id(client->conn_msg);
-
-    if (NULL == client_id.buf || 0 == client_id.length) {
-        log(error, "nng_mqtt_msg_get_connect_client_id fail");
-        return NULL;
-    }
-
-    neu_asprintf(&db, "neuron-mqtt-client-%.*s.db", (unsigned) client_id.length,
-                 (char *) client_id.buf);
-    if (NULL == db) {
-        log(error, "neu_asprintf nano-mqtt cilent db fail");
-        return NULL;
-    }
-
-    if ((rv = nng_mqtt_alloc_sqlite_opt(&cfg)) != 0) {
-        log(error, "nng_mqtt_alloc_sqlite_opt fail: %s", nng_strerror(rv));
-        free(db);
-        return NULL;
-    }
-
-    nng_mqtt_set_sqlite_enable(cfg, true);
-    nng_mqtt_set_sqlite_flush_threshold(cfg, 256);
-    nng_mqtt_set_sqlite_max_rows(cfg, 256);
-    nng_mqtt_set_sqlite_db_dir(cfg, "persistence/");
-    nng_mqtt_sqlite_db_init(cfg, db, client->version);
-
-    free(db);
-    return cfg;
-}
-
 neu_mqtt_client_t *neu_mqtt_client_new(neu_mqtt_version_e version)
 {
     neu_mqtt_client_t *client = calloc(1, sizeof(*client));
@@ -843,8 +1106,9 @@ neu_mqtt_client_t *neu_mqtt_client_new(neu_mqtt_version_e version)
         return NULL;
     }
 
-    client->version    = version;
-    client->task_limit = 1024;
+    client->version         = version;
+    client->task_limit      = 1024;
+    client->replay_inflight = 1;
 
     return client;
 }
@@ -871,10 +1135,15 @@ void neu_mqtt_client_free(neu_mqtt_client_t *client)
         if (client->tls_cfg) {
             nng_tls_config_free(client->tls_cfg);
         }
-        if (client->sqlite_cfg) {
-            nng_mqtt_free_sqlite_opt(client->sqlite_cfg);
-        }
         nng_aio_free(client->recv_aio);
+        for (size_t i = 0; client->replay_slots && i < client->replay_inflight;
+             ++i) {
+            nng_aio_free(client->replay_slots[i].aio);
+            free(client->replay_slots[i].buf);
+        }
+        free(client->replay_slots);
+        free(client->replay_topic);
+        neu_seg_log_close(client->cache);
         subscriptions_free(client->subscriptions);
         tasks_free(client->task_free_list);
         nng_msg_free(client->conn_msg);
@@ -912,14 +1181,30 @@ size_t neu_mqtt_client_get_cached_msgs_num(neu_mqtt_client_t *client)
     size_t num = 0;
 
     nng_mtx_lock(client->mtx);
-    if (NULL != client->sqlite_cfg) {
-        num = nng_mqtt_sqlite_db_get_cached_size(client->sqlite_cfg);
+    if (NULL != client->cache) {
+        num = neu_seg_log_count(client->cache);
     }
     nng_mtx_unlock(client->mtx);
 
     return num;
 }
 
+void neu_mqtt_client_get_cache_stats(neu_mqtt_client_t *            client,
+                                     neu_mqtt_client_cache_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+
+    nng_mtx_lock(client->mtx);
+    if (NULL != client->cache) {
+        stats->msgs    = neu_seg_log_count(client->cache);
+        stats->bytes   = neu_seg_log_bytes(client->cache);
+        stats->evicted = neu_seg_log_evicted(client->cache);
+    }
+    stats->replayed_msgs  = client->replayed_msgs;
+    stats->replayed_bytes = client->replayed_bytes;
+    nng_mtx_unlock(client->mtx);
+}
+
 int neu_mqtt_client_set_addr(neu_mqtt_client_t *client, const char *host,
                              uint16_t port)
 {
@@ -949,6 +1234,25 @@ end:
     return rv;
 }
 
+int neu_mqtt_client_set_version(neu_mqtt_client_t *client,
+                                neu_mqtt_version_e version)
+{
+    if (NEU_MQTT_VERSION_V31 != version && NEU_MQTT_VERSION_V311 != version &&
+        NEU_MQTT_VERSION_V5 != version) {
+        return -1;
+    }
+
+    nng_mtx_lock(client->mtx);
+    return_failure_if_open();
+
+    nng_mqtt_msg_set_connect_proto_version(
+        client->conn_msg, neu_mqtt_version_to_nng_mqtt_version(version));
+    client->version = version;
+    nng_mtx_unlock(client->mtx);
+
+    return 0;
+}
+
 int neu_mqtt_client_set_id(neu_mqtt_client_t *client, const char *id)
 {
     if (NULL == id || 0 == strlen(id)) {
@@ -1075,44 +1379,120 @@ int neu_mqtt_client_set_cache_size(neu_mqtt_client_t *client,
     nng_mtx_lock(client->mtx);
     return_failure_if_open();
 
+    neu_seg_log_close(client->cache);
+    client->cache = NULL;
+
     if (0 == mem_size_bytes && 0 == db_size_bytes) {
         // disable cache
         log(debug, "cache disabled");
-        if (client->sqlite_cfg) {
-            nng_mqtt_free_sqlite_opt(client->sqlite_cfg);
-            client->sqlite_cfg = NULL;
-        }
         goto end;
     }
 
-    if (NULL == client->sqlite_cfg) {
-        client->sqlite_cfg = alloc_sqlite_config(client);
-        if (NULL == client->sqlite_cfg) {
-            log(error, "alloc_sqlite_config fail");
-            rv = -1;
-            goto end;
-        }
+    const mqtt_buf client_id =
+        nng_mqtt_msg_get_connect_client_id(client->conn_msg);
+    if (NULL == client_id.buf || 0 == client_id.length) {
+        log(error, "nng_mqtt_msg_get_connect_client_id fail");
+        rv = -1;
+        goto end;
     }
 
-    // FIXME: until NanoSDK cache size limit feature out
-    // Assume that,
-    // 1. every upload message follows the below template
-    //    '{"node":"","group":"","timestamp":1669708991767,"values":{"":0},"errors":{}}'
-    // 2. every upload message has 50 tags in average
-    // 3. every tag has 4 bytes data
-    // then, estimated average message size is
-    //    len(tmpl) + 128/2 + 128/2 + 50*(64/2+4) ~= 2000
-    size_t avg_msg_size = 2000;
-    nng_mqtt_set_sqlite_flush_threshold(client->sqlite_cfg,
-                                        mem_size_bytes / avg_msg_size);
-    nng_mqtt_set_sqlite_max_rows(client->sqlite_cfg,
-                                 db_size_bytes / avg_msg_size);
+    // the memory limit bounds the two mapped segments,
+    // and the disk limit bounds all segment files exactly
+    size_t seg_size = mem_size_bytes / 2;
+    if (seg_size > db_size_bytes / 2) {
+        seg_size = db_size_bytes / 2;
+    }
+    if (seg_size < CACHE_SEG_MIN) {
+        seg_size = CACHE_SEG_MIN;
+    } else if (seg_size > CACHE_SEG_MAX) {
+        seg_size = CACHE_SEG_MAX;
+    }
+
+    char *dir = NULL;
+    neu_asprintf(&dir, "persistence/mqtt-%.*s", (unsigned) client_id.length,
+                 (char *) client_id.buf);
+    if (NULL == dir) {
+        log(error, "neu_asprintf mqtt cache dir fail");
+        rv = -1;
+        goto end;
+    }
+
+    client->cache = neu_seg_log_open(dir, seg_size, db_size_bytes);
+    if (NULL == client->cache) {
+        log(error, "open cache `%s` fail", dir);
+        rv = -1;
+    } else {
+        log(notice, "cache `%s` %zu messages, segment size %zu", dir,
+            neu_seg_log_count(client->cache), seg_size);
+    }
+    free(dir);
 
 end:
     nng_mtx_unlock(client->mtx);
     return rv;
 }
 
+int neu_mqtt_client_set_replay(neu_mqtt_client_t *client, size_t rate,
+                               size_t inflight, const char *topic)
+{
+    char *replay_topic = NULL;
+
+    if (NULL != topic && 0 != strlen(topic) &&
+        NULL == (replay_topic = strdup(topic))) {
+        return -1;
+    }
+
+    nng_mtx_lock(client->mtx);
+    if (client->open) {
+        free(replay_topic);
+    }
+    return_failure_if_open();
+
+    if (0 == inflight) {
+        inflight = 1;
+    } else if (inflight > REPLAY_INFLIGHT_MAX) {
+        inflight = REPLAY_INFLIGHT_MAX;
+    }
+
+    for (size_t i = 0; client->replay_slots && i < client->replay_inflight;
+         ++i) {
+        nng_aio_free(client->replay_slots[i].aio);
+    }
+    free(client->replay_slots);
+    free(client->replay_topic);
+    client->replay_slots    = NULL;
+    client->replay_inflight = inflight;
+    client->replay_rate     = rate;
+    client->replay_tokens   = 0;
+    client->replay_topic    = replay_topic;
+    nng_mtx_unlock(client->mtx);
+
+    return 0;
+}
+
+int neu_mqtt_client_set_max_inflight(neu_mqtt_client_t *client, size_t n)
+{
+    nng_mtx_lock(client->mtx);
+    return_failure_if_open();
+
+    if (0 == n) {
+        n = 1;
+    }
+    client->task_limit = n;
+
+    // all tasks are on the free list when the client is not open
+    while (client->task_count > client->task_limit &&
+           NULL != client->task_free_list) {
+        task_t *task = client->task_free_list;
+        DL_DELETE(client->task_free_list, task);
+        task_free(task);
+        --client->task_count;
+    }
+    nng_mtx_unlock(client->mtx);
+
+    return 0;
+}
+
 int neu_mqtt_client_set_zlog_category(neu_mqtt_client_t *client,
                                       zlog_category_t *  cat)
 {
@@ -1135,11 +1515,12 @@ int neu_mqtt_client_open(neu_mqtt_client_t *client)
         return 0;
     }
 
-    if (NEU_MQTT_VERSION_V5 == client->version &&
-        (rv = nng_mqttv5_client_open(&client->sock)) != 0) {
-        log(error, "nng_mqttv5_client_open fail: %s", nng_strerror(rv));
-        nng_mtx_unlock(client->mtx);
-        return -1;
+    if (NEU_MQTT_VERSION_V5 == client->version) {
+        if ((rv = nng_mqttv5_client_open(&client->sock)) != 0) {
+            log(error, "nng_mqttv5_client_open fail: %s", nng_strerror(rv));
+            nng_mtx_unlock(client->mtx);
+            return -1;
+        }
     } else if ((rv = nng_mqtt_client_open(&client->sock)) != 0) {
         log(error, "nng_mqtt_client_open fail: %s", nng_strerror(rv));
         nng_mtx_unlock(client->mtx);
@@ -1156,14 +1537,6 @@ int neu_mqtt_client_open(neu_mqtt_client_t *client)
         goto error;
     }
 
-    if (client->sqlite_cfg &&
-        (rv = nng_socket_set_ptr(client->sock, NNG_OPT_MQTT_SQLITE,
-                                 client->sqlite_cfg))) {
-        log(error, "nng_socket_set_ptr(NNG_OPT_MQTT_SQLITE) fail: %s",
-            nng_strerror(rv));
-        goto error;
-    }
-
     nng_dialer dialer;
     if ((rv = nng_dialer_create(&dialer, client->sock, client->url)) != 0) {
         log(error, "nng_dialer_create fail: %s", nng_strerror(rv));
@@ -1202,9 +1575,13 @@ error:
     nng_mtx_unlock(client->mtx);
     if (client->events) {
         neu_event_del_timer(client->events, client->timer);
+        if (client->replay_timer) {
+            neu_event_del_timer(client->events, client->replay_timer);
+        }
         neu_event_close(client->events);
-        client->events = NULL;
-        client->timer  = NULL;
+        client->events       = NULL;
+        client->timer        = NULL;
+        client->replay_timer = NULL;
     }
     nng_close(client->sock);
     return -1;
@@ -1212,23 +1589,29 @@ error:
 
 int neu_mqtt_client_close(neu_mqtt_client_t *client)
 {
-    int                rv     = 0;
-    neu_events_t *     events = NULL;
-    neu_event_timer_t *timer  = NULL;
+    int                rv           = 0;
+    neu_events_t *     events       = NULL;
+    neu_event_timer_t *timer        = NULL;
+    neu_event_timer_t *replay_timer = NULL;
 
     nng_mtx_lock(client->mtx);
     if (!client->open) {
         nng_mtx_unlock(client->mtx);
         return 0;
     }
-    events         = client->events;
-    timer          = client->timer;
-    client->events = NULL;
-    client->timer  = NULL;
+    events               = client->events;
+    timer                = client->timer;
+    replay_timer         = client->replay_timer;
+    client->events       = NULL;
+    client->timer        = NULL;
+    client->replay_timer = NULL;
     nng_mtx_unlock(client->mtx);
 
     if (events) {
         neu_event_del_timer(events, timer);
+        if (replay_timer) {
+            neu_event_del_timer(events, replay_timer);
+        }
         neu_event_close(events);
     }
 
@@ -1242,8 +1625,9 @@ int neu_mqtt_client_close(neu_mqtt_client_t *client)
     }
 
     nng_mtx_lock(client->mtx);
-    // wait for all tasks
-    while (client_task_free_list_len(client) != client->task_count) {
+    // wait for all tasks and the cache replay
+    while (client_task_free_list_len(client) != client->task_count ||
+           client->replay_busy > 0) {
         nng_mtx_unlock(client->mtx);
         neu_msleep(100);
         nng_mtx_lock(client->mtx);
@@ -1262,6 +1646,23 @@ int neu_mqtt_client_publish(neu_mqtt_client_t *client, neu_mqtt_qos_e qos,
     nng_msg *pub_msg = NULL;
     task_t * task    = NULL;
 
+    nng_mtx_lock(client->mtx);
+    if (NULL != client->cache && !client->connected) {
+        // cache while offline, live messages go first once reconnected
+        // while the cached ones are replayed at the configured pace
+        rv = client_cache_msg(client, qos, topic, payload, len);
+        nng_mtx_unlock(client->mtx);
+
+        if (0 != rv) {
+            return -1;
+        }
+        if (cb) {
+            cb(0, qos, topic, payload, len, data);
+        }
+        return 0;
+    }
+    nng_mtx_unlock(client->mtx);
+
     if (0 != (rv = nng_mqtt_msg_alloc(&pub_msg, 0))) {
         log(error, "nng_mqtt_msg_alloc fail: %s", nng_strerror(rv));
         return -1;
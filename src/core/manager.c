@@ -535,6 +535,7 @@ static int manager_loop(enum neu_event_io_type type, int fd, void *usr_data)
 
         strcpy(header->receiver, header->sender);
         if (0 == e.error) {
+            resp.total   = utarray_len(resp.tags);
             header->type = NEU_RESP_GET_TEMPLATE_TAG;
             reply(manager, header, &resp);
         } else {
@@ -686,8 +687,11 @@ static int manager_loop(enum neu_event_io_type type, int fd, void *usr_data)
 
         if (error.error == NEU_ERR_SUCCESS) {
             forward_msg(manager, msg, cmd->app);
-            manager_storage_subscribe(manager, cmd->app, cmd->driver,
-                                      cmd->group, cmd->params);
+            // live streams of the dashboard do not outlive the process
+            if (0 != strcmp(cmd->app, DEFAULT_DASHBOARD_ADAPTER_NAME)) {
+                manager_storage_subscribe(manager, cmd->app, cmd->driver,
+                                          cmd->group, cmd->params);
+            }
         } else {
             free(cmd->params);
         }
@@ -706,8 +710,10 @@ static int manager_loop(enum neu_event_io_type type, int fd, void *usr_data)
 
         if (error.error == NEU_ERR_SUCCESS) {
             forward_msg(manager, msg, cmd->app);
-            manager_storage_unsubscribe(manager, cmd->app, cmd->driver,
-                                        cmd->group);
+            if (0 != strcmp(cmd->app, DEFAULT_DASHBOARD_ADAPTER_NAME)) {
+                manager_storage_unsubscribe(manager, cmd->app, cmd->driver,
+                                            cmd->group);
+            }
         }
 
         header->type = NEU_RESP_ERROR;
@@ -880,7 +886,7 @@ static int manager_loop(enum neu_event_io_type type, int fd, void *usr_data)
             header->type       = NEU_RESP_ERROR;
             neu_msg_exchange(header);
             reply(manager, header, &e);
-            for (int i = 0; i < cmd->n_tag; i++) {
+            for (uint32_t i = 0; i < cmd->n_tag; i++) {
                 neu_tag_fini(&cmd->tags[i]);
             }
             free(cmd->tags);
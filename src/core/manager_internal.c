@@ -47,43 +47,61 @@ UT_array *neu_manager_get_plugins(neu_manager_t *manager)
 int neu_manager_add_node(neu_manager_t *manager, const char *node_name,
                          const char *plugin_name, bool start)
 {
-    neu_adapter_t *       adapter      = NULL;
-    neu_plugin_instance_t instance     = { 0 };
-    neu_adapter_info_t    adapter_info = {
-        .name = node_name,
-    };
-    neu_resp_plugin_info_t info = { 0 };
+    neu_adapter_t *    adapter      = NULL;
+    neu_adapter_info_t adapter_info = { 0 };
+    int                ret          = neu_manager_prepare_node(
+        manager, node_name, plugin_name, &adapter_info);
+
+    if (ret != NEU_ERR_SUCCESS) {
+        return ret;
+    }
+
+    adapter = neu_adapter_create(&adapter_info);
+    neu_manager_register_node(manager, adapter, start);
+
+    return NEU_ERR_SUCCESS;
+}
+
+int neu_manager_prepare_node(neu_manager_t *manager, const char *node_name,
+                             const char *plugin_name, neu_adapter_info_t *info)
+{
+    neu_plugin_instance_t  instance = { 0 };
+    neu_resp_plugin_info_t plugin   = { 0 };
     int                    ret =
-        neu_plugin_manager_find(manager->plugin_manager, plugin_name, &info);
+        neu_plugin_manager_find(manager->plugin_manager, plugin_name, &plugin);
 
     if (ret != 0) {
         return NEU_ERR_LIBRARY_NOT_FOUND;
     }
 
-    if (info.single) {
+    if (plugin.single) {
         return NEU_ERR_LIBRARY_NOT_ALLOW_CREATE_INSTANCE;
     }
 
-    adapter = neu_node_manager_find(manager->node_manager, node_name);
-    if (adapter != NULL) {
+    if (neu_node_manager_find(manager->node_manager, node_name) != NULL) {
         return NEU_ERR_NODE_EXIST;
     }
 
-    ret = neu_plugin_manager_create_instance(manager->plugin_manager, info.name,
-                                             &instance);
+    ret = neu_plugin_manager_create_instance(manager->plugin_manager,
+                                             plugin.name, &instance);
     if (ret != 0) {
         return NEU_ERR_LIBRARY_FAILED_TO_OPEN;
     }
-    adapter_info.handle = instance.handle;
-    adapter_info.module = instance.module;
 
-    adapter = neu_adapter_create(&adapter_info);
-    neu_node_manager_add(manager->node_manager, adapter);
-    neu_adapter_init(adapter, start);
+    info->name   = node_name;
+    info->handle = instance.handle;
+    info->module = instance.module;
 
     return NEU_ERR_SUCCESS;
 }
 
+void neu_manager_register_node(neu_manager_t *manager, neu_adapter_t *adapter,
+                               bool start)
+{
+    neu_node_manager_add(manager->node_manager, adapter);
+    neu_adapter_init(adapter, start);
+}
+
 int neu_manager_del_node(neu_manager_t *manager, const char *node_name)
 {
     neu_adapter_t *adapter =
@@ -374,7 +392,7 @@ int neu_manager_get_template_group(neu_manager_t *               manager,
 
 int neu_manager_add_template_tags(neu_manager_t *manager, const char *tmpl_name,
                                   const char *group, uint16_t n_tag,
-                                  neu_datatag_t *tags, uint16_t *index_p)
+                                  neu_datatag_t *tags, uint32_t *index_p)
 {
     int ret = 0;
 
@@ -400,7 +418,7 @@ int neu_manager_add_template_tags(neu_manager_t *manager, const char *tmpl_name,
 
 int neu_manager_update_template_tags(neu_manager_t *                manager,
                                      neu_req_update_template_tag_t *req,
-                                     uint16_t *                     index_p)
+                                     uint32_t *                     index_p)
 {
     int ret = 0;
 
@@ -23,6 +23,7 @@
 #include <nng/nng.h>
 #include <nng/supplemental/util/platform.h>
 
+#include "adapter_info.h"
 #include "event/event.h"
 #include "persist/persist.h"
 
@@ -54,6 +55,17 @@ UT_array *neu_manager_get_plugins(neu_manager_t *manager);
 int       neu_manager_add_node(neu_manager_t *manager, const char *node_name,
                                const char *plugin_name, bool start);
 int       neu_manager_del_node(neu_manager_t *manager, const char *node_name);
+
+/*
+ * The steps of neu_manager_add_node, for callers constructing adapters off
+ * the manager thread: prepare and register must run on it, in between
+ * neu_adapter_create may run anywhere.
+ */
+int  neu_manager_prepare_node(neu_manager_t *manager, const char *node_name,
+                              const char *        plugin_name,
+                              neu_adapter_info_t *info);
+void neu_manager_register_node(neu_manager_t *manager, neu_adapter_t *adapter,
+                               bool start);
 UT_array *neu_manager_get_nodes(neu_manager_t *manager, int type,
                                 const char *plugin, const char *node);
 int       neu_manager_update_node_name(neu_manager_t *manager, const char *node,
@@ -80,10 +92,10 @@ int  neu_manager_get_template_group(neu_manager_t *               manager,
                                     UT_array **                   group_info_p);
 int neu_manager_add_template_tags(neu_manager_t *manager, const char *tmpl_name,
                                   const char *group, uint16_t n_tag,
-                                  neu_datatag_t *tags, uint16_t *index_p);
+                                  neu_datatag_t *tags, uint32_t *index_p);
 int neu_manager_update_template_tags(neu_manager_t *             manager,
                                      neu_req_add_template_tag_t *req,
-                                     uint16_t *                  index_p);
+                                     uint32_t *                  index_p);
 int neu_manager_del_template_tags(neu_manager_t *             manager,
                                   neu_req_del_template_tag_t *req);
 int neu_manager_get_template_tags(neu_manager_t *             manager,
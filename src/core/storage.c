@@ -16,9 +16,15 @@
  * along with this program; if not, write to the Free Software Foundation,
  * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
  **/
+#include <inttypes.h>
+#include <pthread.h>
+#include <sys/sysinfo.h>
+
 #include "errcodes.h"
 #include "utils/log.h"
+#include "utils/time.h"
 
+#include "adapter/adapter_internal.h"
 #include "adapter/storage.h"
 #include "storage.h"
 
@@ -349,28 +355,158 @@ int manager_load_plugin(neu_manager_t *manager)
     return rv;
 }
 
-int manager_load_node(neu_manager_t *manager)
+// upper bound of the threads constructing adapters at startup
+#define MANAGER_LOAD_WORKERS_MAX 8
+
+typedef struct {
+    neu_persist_node_info_t *node_info;
+    neu_adapter_info_t       adapter_info;
+    neu_adapter_t *          adapter;
+    int                      rv;
+    int64_t                  create_ms;
+} load_node_job_t;
+
+typedef struct {
+    load_node_job_t *jobs;
+    size_t           n_jobs;
+    size_t           next;
+    pthread_mutex_t  mtx;
+} load_node_pool_t;
+
+static void *load_node_worker(void *arg)
 {
-    UT_array *node_infos = NULL;
-    int       rv         = 0;
+    load_node_pool_t *pool = arg;
+
+    for (;;) {
+        pthread_mutex_lock(&pool->mtx);
+        size_t i = pool->next++;
+        pthread_mutex_unlock(&pool->mtx);
+
+        if (i >= pool->n_jobs) {
+            break;
+        }
+
+        load_node_job_t *job   = &pool->jobs[i];
+        int64_t          start = neu_time_ms();
+        job->adapter           = neu_adapter_create(&job->adapter_info);
+        job->create_ms         = neu_time_ms() - start;
+    }
+
+    return NULL;
+}
+
+// run neu_adapter_create of every prepared job on at most `n_workers` threads
+static void load_node_create(load_node_job_t *jobs, size_t n_jobs,
+                             size_t n_workers)
+{
+    load_node_pool_t pool    = { .jobs = jobs, .n_jobs = n_jobs };
+    pthread_t        tids[MANAGER_LOAD_WORKERS_MAX];
+    size_t           started = 0;
+
+    pthread_mutex_init(&pool.mtx, NULL);
+    for (; started < n_workers; ++started) {
+        if (0 !=
+            pthread_create(&tids[started], NULL, load_node_worker, &pool)) {
+            nlog_warn("failed to start adapter loader %zu", started);
+            break;
+        }
+    }
+
+    if (0 == started) {
+        // not a single thread, construct on the calling one
+        load_node_worker(&pool);
+    }
+
+    for (size_t i = 0; i < started; ++i) {
+        pthread_join(tids[i], NULL);
+    }
+    pthread_mutex_destroy(&pool.mtx);
+}
 
-    rv = neu_persister_load_nodes(&node_infos);
+/*
+ * Nodes are loaded in three phases. Plugin instances are resolved and
+ * adapters registered on the manager thread, in the persisted order, as
+ * neu_manager_add_node does. Constructing the adapters in between, which
+ * runs the plugin open/init callbacks and reads settings, groups and tags
+ * back from the persister, is independent per node and fanned out to a
+ * bounded pool of threads.
+ */
+int manager_load_node(neu_manager_t *manager)
+{
+    UT_array *       node_infos = NULL;
+    load_node_job_t *jobs       = NULL;
+    size_t           n_jobs     = 0;
+    size_t           n_workers  = 0;
+    int64_t          ts[4]      = { 0 };
+    int              rv         = 0;
+
+    ts[0] = neu_time_ms();
+    rv    = neu_persister_load_nodes(&node_infos);
     if (0 != rv) {
         nlog_error("failed to load adapter infos");
         return -1;
     }
 
+    jobs = calloc(utarray_len(node_infos) + 1, sizeof(load_node_job_t));
+    if (NULL == jobs) {
+        nlog_error("failed to allocate adapter loaders");
+        utarray_free(node_infos);
+        return -1;
+    }
+
+    ts[1] = neu_time_ms();
     utarray_foreach(node_infos, neu_persist_node_info_t *, node_info)
     {
-        rv = neu_manager_add_node(
-            manager, node_info->name, node_info->plugin_name,
+        load_node_job_t *job = &jobs[n_jobs];
+
+        job->node_info = node_info;
+        job->rv = neu_manager_prepare_node(manager, node_info->name,
+                                           node_info->plugin_name,
+                                           &job->adapter_info);
+        if (0 != job->rv) {
+            nlog_notice("load adapter fail type:%d, name:%s plugin:%s "
+                        "state:%d, error:%d",
+                        node_info->type, node_info->name,
+                        node_info->plugin_name, node_info->state, job->rv);
+            rv = job->rv;
+            continue;
+        }
+
+        ++n_jobs;
+    }
+
+    n_workers = get_nprocs();
+    if (n_workers > MANAGER_LOAD_WORKERS_MAX) {
+        n_workers = MANAGER_LOAD_WORKERS_MAX;
+    }
+    if (n_workers > n_jobs) {
+        n_workers = n_jobs;
+    }
+
+    ts[2] = neu_time_ms();
+    load_node_create(jobs, n_jobs, n_workers);
+
+    ts[3] = neu_time_ms();
+    for (size_t i = 0; i < n_jobs; ++i) {
+        load_node_job_t *        job       = &jobs[i];
+        neu_persist_node_info_t *node_info = job->node_info;
+
+        neu_manager_register_node(
+            manager, job->adapter,
             node_info->state == NEU_NODE_RUNNING_STATE_RUNNING);
-        const char *ok_or_err = (0 == rv) ? "success" : "fail";
-        nlog_notice("load adapter %s type:%d, name:%s plugin:%s state:%d",
-                    ok_or_err, node_info->type, node_info->name,
-                    node_info->plugin_name, node_info->state);
+        nlog_notice("load adapter success type:%d, name:%s plugin:%s state:%d, "
+                    "created in %" PRId64 " ms",
+                    node_info->type, node_info->name, node_info->plugin_name,
+                    node_info->state, job->create_ms);
     }
 
+    nlog_notice("loaded %zu/%u adapters with %zu threads, query %" PRId64
+                " ms, resolve %" PRId64 " ms, create %" PRId64
+                " ms, register %" PRId64 " ms",
+                n_jobs, utarray_len(node_infos), n_workers, ts[1] - ts[0],
+                ts[2] - ts[1], ts[3] - ts[2], neu_time_ms() - ts[3]);
+
+    free(jobs);
     utarray_free(node_infos);
     return rv;
 }
@@ -64,6 +64,26 @@ int neu_json_encode_tag(void *json_obj, void *param)
             .t            = NEU_JSON_DOUBLE,
             .v.val_double = tag->decimal,
         },
+        {
+            .name         = "deadband",
+            .t            = NEU_JSON_DOUBLE,
+            .v.val_double = tag->deadband,
+        },
+        {
+            .name      = "deadband_type",
+            .t         = NEU_JSON_INT,
+            .v.val_int = tag->deadband_type,
+        },
+        {
+            .name      = "heartbeat",
+            .t         = NEU_JSON_INT,
+            .v.val_int = tag->heartbeat,
+        },
+        {
+            .name      = "min_interval",
+            .t         = NEU_JSON_INT,
+            .v.val_int = tag->min_interval,
+        },
         {
             .name      = "address",
             .t         = NEU_JSON_STR,
@@ -130,6 +150,26 @@ int neu_json_decode_tag_json(void *json_obj, neu_json_tag_t *tag_p)
             .t         = NEU_JSON_VALUE,
             .attribute = NEU_JSON_ATTRIBUTE_OPTIONAL,
         },
+        {
+            .name      = "deadband",
+            .t         = NEU_JSON_DOUBLE,
+            .attribute = NEU_JSON_ATTRIBUTE_OPTIONAL,
+        },
+        {
+            .name      = "deadband_type",
+            .t         = NEU_JSON_INT,
+            .attribute = NEU_JSON_ATTRIBUTE_OPTIONAL,
+        },
+        {
+            .name      = "heartbeat",
+            .t         = NEU_JSON_INT,
+            .attribute = NEU_JSON_ATTRIBUTE_OPTIONAL,
+        },
+        {
+            .name      = "min_interval",
+            .t         = NEU_JSON_INT,
+            .attribute = NEU_JSON_ATTRIBUTE_OPTIONAL,
+        },
     };
 
     int ret = neu_json_decode_by_json(json_obj, NEU_JSON_ELEM_SIZE(tag_elems),
@@ -137,22 +177,26 @@ int neu_json_decode_tag_json(void *json_obj, neu_json_tag_t *tag_p)
 
     // set the fields before check for easy clean up on error
     neu_json_tag_t tag = {
-        .type        = tag_elems[0].v.val_int,
-        .name        = tag_elems[1].v.val_str,
-        .attribute   = tag_elems[2].v.val_int,
-        .address     = tag_elems[3].v.val_str,
-        .decimal     = tag_elems[4].v.val_double,
-        .precision   = tag_elems[5].v.val_int,
-        .description = tag_elems[6].v.val_str,
-        .t           = tag_elems[7].t,
-        .value       = tag_elems[7].v,
+        .type          = tag_elems[0].v.val_int,
+        .name          = tag_elems[1].v.val_str,
+        .attribute     = tag_elems[2].v.val_int,
+        .address       = tag_elems[3].v.val_str,
+        .decimal       = tag_elems[4].v.val_double,
+        .precision     = tag_elems[5].v.val_int,
+        .description   = tag_elems[6].v.val_str,
+        .t             = tag_elems[7].t,
+        .value         = tag_elems[7].v,
+        .deadband      = tag_elems[8].v.val_double,
+        .deadband_type = tag_elems[9].v.val_int,
+        .heartbeat     = tag_elems[10].v.val_int,
+        .min_interval  = tag_elems[11].v.val_int,
     };
 
     if (0 != ret) {
         goto decode_fail;
     }
 
-    if (!neu_json_tag_check_type(&tag)) {
+    if (!neu_json_tag_check_type(&tag) || !neu_json_tag_check_report(&tag)) {
         goto decode_fail;
     }
 
@@ -174,6 +218,33 @@ void neu_json_decode_tag_fini(neu_json_tag_t *tag)
     }
 }
 
+int neu_json_tag_check_report(neu_json_tag_t *tag)
+{
+    return tag->deadband >= 0 &&
+        (NEU_DEADBAND_ABSOLUTE == tag->deadband_type ||
+         NEU_DEADBAND_PERCENT == tag->deadband_type) &&
+        tag->heartbeat >= 0 && tag->heartbeat <= UINT32_MAX &&
+        tag->min_interval >= 0 && tag->min_interval <= UINT32_MAX;
+}
+
+void neu_json_tag_get_report(const neu_json_tag_t *tag,
+                             neu_tag_report_t *    report)
+{
+    report->deadband      = tag->deadband;
+    report->deadband_type = tag->deadband_type;
+    report->heartbeat     = tag->heartbeat;
+    report->min_interval  = tag->min_interval;
+}
+
+void neu_json_tag_set_report(neu_json_tag_t *        tag,
+                             const neu_tag_report_t *report)
+{
+    tag->deadband      = report->deadband;
+    tag->deadband_type = report->deadband_type;
+    tag->heartbeat     = report->heartbeat;
+    tag->min_interval  = report->min_interval;
+}
+
 int neu_json_tag_check_type(neu_json_tag_t *tag)
 {
     if (NEU_ATTRIBUTE_STATIC & tag->attribute) {
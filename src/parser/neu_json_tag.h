@@ -25,6 +25,7 @@
 #ifndef _NEU_JSON_API_NEU_JSON_TAG_H_
 #define _NEU_JSON_API_NEU_JSON_TAG_H_
 
+#include "tag.h"
 #include "json/json.h"
 
 #ifdef __cplusplus
@@ -39,6 +40,10 @@ typedef struct {
     int64_t          attribute;
     int64_t          precision;
     double           decimal;
+    double           deadband;
+    int64_t          deadband_type;
+    int64_t          heartbeat;
+    int64_t          min_interval;
     neu_json_type_e  t;
     neu_json_value_u value;
 } neu_json_tag_t;
@@ -47,6 +52,11 @@ int  neu_json_encode_tag(void *json_obj, void *param);
 int  neu_json_decode_tag_json(void *json_obj, neu_json_tag_t *tag_p);
 void neu_json_decode_tag_fini(neu_json_tag_t *tag);
 int  neu_json_tag_check_type(neu_json_tag_t *tag);
+int  neu_json_tag_check_report(neu_json_tag_t *tag);
+void neu_json_tag_get_report(const neu_json_tag_t *tag,
+                             neu_tag_report_t *    report);
+void neu_json_tag_set_report(neu_json_tag_t *        tag,
+                             const neu_tag_report_t *report);
 
 typedef struct {
     int             len;
@@ -69,7 +79,7 @@ int  neu_json_decode_add_tags_req(char *buf, neu_json_add_tags_req_t **result);
 void neu_json_decode_add_tags_req_free(neu_json_add_tags_req_t *req);
 
 typedef struct {
-    uint16_t index;
+    uint32_t index;
     int      error;
 } neu_json_add_tag_res_t, neu_json_update_tag_res_t;
 
@@ -25,6 +25,8 @@
 #include <dirent.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <inttypes.h>
+#include <pthread.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -34,6 +36,8 @@
 #include "errcodes.h"
 #include "utils/asprintf.h"
 #include "utils/log.h"
+#include "utils/time.h"
+#include "utils/uthash.h"
 
 #include "argparse.h"
 #include "persist/json/persist_json_plugin.h"
@@ -41,6 +45,8 @@
 
 #include "json/neu_json_fn.h"
 
+#include "snapshot.h"
+
 #if defined _WIN32 || defined __CYGWIN__
 #define PATH_SEP_CHAR '\\'
 #else
@@ -49,10 +55,107 @@
 
 #define PATH_MAX_SIZE 128
 
+// a transaction commits at most this many operations
+#define PERSIST_BATCH_MAX_OPS 256
+// an operation waits at most this long for others to share its commit
+#define PERSIST_BATCH_DELAY_MS 20
+// parameters bound to one statement at most
+#define PERSIST_PARAM_MAX 16
+// the snapshot is written once changes stop for this long
+#define PERSIST_SNAPSHOT_DELAY_MS 1000
+
 static const char *plugin_file = "persistence/plugins.json";
 static const char *db_file     = "persistence/sqlite.db";
+static const char *snapshot_file = "persistence/snapshot.bin";
 static sqlite3 *   global_db   = NULL;
 
+// prepared statement, cached by connection and SQL text
+typedef struct {
+    char *         sql;
+    sqlite3_stmt * stmt;
+    UT_hash_handle hh;
+} persist_stmt_t;
+
+typedef struct {
+    sqlite3 *       db;
+    persist_stmt_t *stmts;
+} persist_conn_t;
+
+typedef enum {
+    PERSIST_OP_STMT,  // one statement with bound parameters
+    PERSIST_OP_FN,    // statements issued by a function, e.g. bulk tag inserts
+    PERSIST_OP_FLUSH, // barrier, earlier operations are committed when done
+} persist_op_type_e;
+
+typedef struct {
+    char type; // see persist_stmt
+    union {
+        int64_t i;
+        double  d;
+        char *  t;
+    } v;
+} persist_param_t;
+
+typedef struct {
+    bool done;
+    int  rv;
+} persist_flush_t;
+
+typedef struct persist_op {
+    persist_op_type_e type;
+    int64_t           ts; // enqueue time in ms
+    const char *      sql;
+    int               n_param;
+    persist_param_t   params[PERSIST_PARAM_MAX];
+    int (*fn)(persist_conn_t *conn, void *arg);
+    void (*free_arg)(void *arg);
+    void *             arg;
+    persist_flush_t *  flush;
+    struct persist_op *next;
+} persist_op_t;
+
+// committed without invalidating the startup snapshot but for node states
+static const char node_state_sql[] = "UPDATE nodes SET state=? WHERE name=?";
+
+// loads share global_db and its statements, one at a time
+static pthread_mutex_t reader_mtx = PTHREAD_MUTEX_INITIALIZER;
+static persist_conn_t  reader     = { 0 };
+// snapshot mapped at startup, dropped once the database changes
+static neu_snapshot_t *reader_snapshot = NULL;
+
+/*
+ * Write behind queue.
+ *
+ * Callers only render their statements and queue them. The writer thread
+ * commits queued operations in batches on its own connection, one
+ * transaction and so one fsync per batch, each operation in a savepoint so
+ * that a failing one does not take the others down. Reads go through
+ * global_db and flush the queue first to see every earlier write.
+ */
+static struct {
+    pthread_mutex_t     mtx;
+    pthread_cond_t      cond;      // operation queued or stop asked
+    pthread_cond_t      done_cond; // a barrier was reached
+    pthread_t           thread;
+    bool                running;
+    bool                stop;
+    bool                busy;   // a batch is being committed
+    int                 flush;  // barriers queued
+    int                 errors; // failed operations since the last barrier
+    persist_op_t *      head;
+    persist_op_t *      tail;
+    persist_conn_t      conn;
+    uint32_t            generation;  // user_version, bumped by each commit
+    uint32_t            state_bumps; // of those, commits of node states only
+    bool                snapshot_dirty;
+    int64_t             commit_ts;
+    neu_persist_stats_t stats;
+} writer = {
+    .mtx       = PTHREAD_MUTEX_INITIALIZER,
+    .cond      = PTHREAD_COND_INITIALIZER,
+    .done_cond = PTHREAD_COND_INITIALIZER,
+};
+
 static inline bool ends_with(const char *str, const char *suffix)
 {
     size_t m = strlen(str);
@@ -212,6 +315,506 @@ static inline int execute_sql(sqlite3 *db, const char *sql, ...)
     return rv;
 }
 
+static sqlite3_stmt *persist_prepare(persist_conn_t *conn, const char *sql)
+{
+    persist_stmt_t *entry = NULL;
+
+    HASH_FIND_STR(conn->stmts, sql, entry);
+    if (NULL != entry) {
+        return entry->stmt;
+    }
+
+    entry = calloc(1, sizeof(*entry));
+    if (NULL == entry || NULL == (entry->sql = strdup(sql))) {
+        nlog_error("allocate statement `%s` fail", sql);
+        free(entry);
+        return NULL;
+    }
+
+    if (SQLITE_OK !=
+        sqlite3_prepare_v3(conn->db, sql, -1, SQLITE_PREPARE_PERSISTENT,
+                           &entry->stmt, NULL)) {
+        nlog_error("prepare `%s` fail: %s", sql, sqlite3_errmsg(conn->db));
+        free(entry->sql);
+        free(entry);
+        return NULL;
+    }
+
+    HASH_ADD_KEYPTR(hh, conn->stmts, entry->sql, strlen(entry->sql), entry);
+    return entry->stmt;
+}
+
+// make a cached statement ready for its next use
+static inline void persist_release(sqlite3_stmt *stmt)
+{
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+}
+
+// finalize the cached statements, e.g. as schemas change
+static void persist_conn_clear(persist_conn_t *conn)
+{
+    persist_stmt_t *entry = NULL, *tmp = NULL;
+
+    HASH_ITER(hh, conn->stmts, entry, tmp)
+    {
+        HASH_DEL(conn->stmts, entry);
+        sqlite3_finalize(entry->stmt);
+        free(entry->sql);
+        free(entry);
+    }
+}
+
+// get a cached statement of global_db, to be released by reader_done
+static sqlite3_stmt *reader_stmt(const char *sql)
+{
+    // see every change persisted before
+    neu_persister_flush();
+
+    pthread_mutex_lock(&reader_mtx);
+    sqlite3_stmt *stmt = persist_prepare(&reader, sql);
+    if (NULL == stmt) {
+        pthread_mutex_unlock(&reader_mtx);
+    }
+
+    return stmt;
+}
+
+static void reader_done(sqlite3_stmt *stmt)
+{
+    if (NULL != stmt) {
+        persist_release(stmt);
+        pthread_mutex_unlock(&reader_mtx);
+    }
+}
+
+/*
+ * Get the startup snapshot if still current, to be released by snapshot_done.
+ *
+ * Adapters store their running state as they are created, so commits of node
+ * states alone only keep the snapshot from being used for `node_state`.
+ */
+static neu_snapshot_t *snapshot_get(bool node_state)
+{
+    neu_snapshot_t *snapshot = NULL;
+
+    neu_persister_flush();
+
+    pthread_mutex_lock(&reader_mtx);
+    if (NULL != reader_snapshot) {
+        pthread_mutex_lock(&writer.mtx);
+        uint32_t generation  = writer.generation;
+        uint32_t state_bumps = writer.state_bumps;
+        if (generation - state_bumps ==
+            neu_snapshot_generation(reader_snapshot)) {
+            if (!node_state || 0 == state_bumps) {
+                snapshot = reader_snapshot;
+                writer.stats.snapshot_loads += 1;
+            }
+        } else {
+            // changed since, read the database from now on
+            neu_snapshot_close(reader_snapshot);
+            reader_snapshot = NULL;
+        }
+        pthread_mutex_unlock(&writer.mtx);
+    }
+
+    if (NULL == snapshot) {
+        pthread_mutex_unlock(&reader_mtx);
+    }
+
+    return snapshot;
+}
+
+static inline void snapshot_done()
+{
+    pthread_mutex_unlock(&reader_mtx);
+}
+
+static int persist_bind(sqlite3_stmt *stmt, const persist_op_t *op)
+{
+    int rv = SQLITE_OK;
+
+    for (int i = 0; i < op->n_param && SQLITE_OK == rv; ++i) {
+        const persist_param_t *param = &op->params[i];
+
+        switch (param->type) {
+        case 'i':
+        case 'u':
+            rv = sqlite3_bind_int64(stmt, i + 1, param->v.i);
+            break;
+        case 'd':
+            rv = sqlite3_bind_double(stmt, i + 1, param->v.d);
+            break;
+        case 't':
+            rv = sqlite3_bind_text(stmt, i + 1, param->v.t, -1, SQLITE_STATIC);
+            break;
+        }
+    }
+
+    return rv;
+}
+
+static void persist_op_free(persist_op_t *op)
+{
+    for (int i = 0; i < op->n_param; ++i) {
+        if ('t' == op->params[i].type) {
+            free(op->params[i].v.t);
+        }
+    }
+    if (NULL != op->free_arg) {
+        op->free_arg(op->arg);
+    }
+    free(op);
+}
+
+static int persist_op_exec(persist_conn_t *conn, persist_op_t *op)
+{
+    int           rv   = 0;
+    sqlite3_stmt *stmt = persist_prepare(conn, op->sql);
+
+    if (NULL == stmt) {
+        return NEU_ERR_EINTERNAL;
+    }
+
+    if (SQLITE_OK != persist_bind(stmt, op)) {
+        nlog_error("bind `%s` fail: %s", op->sql, sqlite3_errmsg(conn->db));
+        rv = NEU_ERR_EINTERNAL;
+    } else if (SQLITE_DONE != sqlite3_step(stmt)) {
+        nlog_error("query `%s` fail: %s", op->sql, sqlite3_errmsg(conn->db));
+        rv = NEU_ERR_EINTERNAL;
+    } else {
+        nlog_debug("query %s success", op->sql);
+    }
+
+    persist_release(stmt);
+    return rv;
+}
+
+static int persist_op_run(persist_conn_t *conn, persist_op_t *op)
+{
+    int rv = 0;
+
+    if (SQLITE_OK !=
+        sqlite3_exec(conn->db, "SAVEPOINT op", NULL, NULL, NULL)) {
+        nlog_error("savepoint fail: %s", sqlite3_errmsg(conn->db));
+        return NEU_ERR_EINTERNAL;
+    }
+
+    if (PERSIST_OP_STMT == op->type) {
+        rv = persist_op_exec(conn, op);
+    } else {
+        rv = op->fn(conn, op->arg);
+    }
+
+    if (0 != rv) {
+        sqlite3_exec(conn->db, "ROLLBACK TO op", NULL, NULL, NULL);
+    }
+    sqlite3_exec(conn->db, "RELEASE op", NULL, NULL, NULL);
+
+    return rv;
+}
+
+static void persist_commit(persist_op_t *batch)
+{
+    sqlite3 *db         = writer.conn.db;
+    int      n_op       = 0;
+    int      n_state_op = 0;
+    int      errors     = 0;
+    bool     begun  = SQLITE_OK == sqlite3_exec(db, "BEGIN", NULL, NULL, NULL);
+
+    if (!begun) {
+        // every operation then commits on its own
+        nlog_error("begin transaction fail: %s", sqlite3_errmsg(db));
+    }
+
+    for (persist_op_t *op = batch; NULL != op; op = op->next) {
+        if (PERSIST_OP_FLUSH != op->type) {
+            n_op += 1;
+            n_state_op += node_state_sql == op->sql;
+            errors += 0 != persist_op_run(&writer.conn, op);
+        }
+    }
+
+    // tells snapshots written before this commit apart
+    bool bumped = n_op > 0 &&
+        0 == execute_sql(db, "PRAGMA user_version=%d",
+                         (int) (writer.generation + 1));
+
+    if (begun && SQLITE_OK != sqlite3_exec(db, "COMMIT", NULL, NULL, NULL)) {
+        nlog_error("commit %d operations fail: %s", n_op, sqlite3_errmsg(db));
+        sqlite3_exec(db, "ROLLBACK", NULL, NULL, NULL);
+        errors = n_op;
+        bumped = false;
+    }
+
+    int64_t now = neu_time_ms();
+
+    pthread_mutex_lock(&writer.mtx);
+    writer.busy = false;
+    writer.errors += errors;
+    if (bumped) {
+        writer.generation += 1;
+        writer.state_bumps += n_op == n_state_op;
+        writer.snapshot_dirty = true;
+        writer.commit_ts      = now;
+    }
+    if (n_op > 0) {
+        writer.stats.batches_total += 1;
+        writer.stats.ops_total += n_op;
+        writer.stats.errors_total += errors;
+        writer.stats.last_batch_ops = n_op;
+        writer.stats.last_latency_ms =
+            now > batch->ts ? (uint64_t)(now - batch->ts) : 0;
+    }
+    for (persist_op_t *op = batch; NULL != op; op = op->next) {
+        if (PERSIST_OP_FLUSH == op->type) {
+            op->flush->rv   = writer.errors > 0 ? NEU_ERR_EINTERNAL : 0;
+            op->flush->done = true;
+            writer.errors   = 0;
+        }
+    }
+    pthread_cond_broadcast(&writer.done_cond);
+    pthread_mutex_unlock(&writer.mtx);
+
+    while (NULL != batch) {
+        persist_op_t *next = batch->next;
+        persist_op_free(batch);
+        batch = next;
+    }
+}
+
+static void persist_snapshot(uint32_t generation)
+{
+    int64_t start = neu_time_ms();
+
+    if (0 == neu_snapshot_dump(writer.conn.db, snapshot_file, generation)) {
+        nlog_info("snapshot generation:%" PRIu32 " took %" PRId64 "ms",
+                  generation, neu_time_ms() - start);
+    } else {
+        // must not pass for a later generation
+        unlink(snapshot_file);
+    }
+}
+
+static void *persist_routine(void *arg)
+{
+    (void) arg;
+
+    for (;;) {
+        persist_op_t *batch = NULL, *last = NULL;
+
+        pthread_mutex_lock(&writer.mtx);
+        while (NULL == writer.head && !writer.stop) {
+            if (!writer.snapshot_dirty) {
+                pthread_cond_wait(&writer.cond, &writer.mtx);
+                continue;
+            }
+
+            // write the snapshot once changes settle
+            int64_t deadline = writer.commit_ts + PERSIST_SNAPSHOT_DELAY_MS;
+            if (neu_time_ms() >= deadline) {
+                break;
+            }
+            struct timespec ts = {
+                .tv_sec  = deadline / 1000,
+                .tv_nsec = (deadline % 1000) * 1000000,
+            };
+            pthread_cond_timedwait(&writer.cond, &writer.mtx, &ts);
+        }
+
+        if (NULL == writer.head) {
+            bool     stop       = writer.stop;
+            bool     dirty      = writer.snapshot_dirty;
+            uint32_t generation = writer.generation;
+
+            writer.snapshot_dirty = false;
+            pthread_mutex_unlock(&writer.mtx);
+
+            if (dirty) {
+                persist_snapshot(generation);
+            }
+            if (stop) {
+                break;
+            }
+            continue;
+        }
+
+        // give other operations a chance to share the commit
+        int64_t deadline = writer.head->ts + PERSIST_BATCH_DELAY_MS;
+        while (!writer.stop && 0 == writer.flush &&
+               writer.stats.queued_ops < PERSIST_BATCH_MAX_OPS &&
+               neu_time_ms() < deadline) {
+            struct timespec ts = {
+                .tv_sec  = deadline / 1000,
+                .tv_nsec = (deadline % 1000) * 1000000,
+            };
+            pthread_cond_timedwait(&writer.cond, &writer.mtx, &ts);
+        }
+
+        // take operations up to the size limit or the first barrier
+        batch = last = writer.head;
+        for (int n = 1;; ++n) {
+            if (PERSIST_OP_FLUSH == last->type) {
+                writer.flush -= 1;
+            } else {
+                writer.stats.queued_ops -= 1;
+            }
+            if (PERSIST_OP_FLUSH == last->type || NULL == last->next ||
+                n >= PERSIST_BATCH_MAX_OPS) {
+                break;
+            }
+            last = last->next;
+        }
+        writer.head = last->next;
+        if (NULL == writer.head) {
+            writer.tail = NULL;
+        }
+        last->next  = NULL;
+        writer.busy = true;
+        pthread_mutex_unlock(&writer.mtx);
+
+        persist_commit(batch);
+    }
+
+    return NULL;
+}
+
+static int persist_enqueue(persist_op_t *op)
+{
+    op->ts = neu_time_ms();
+
+    pthread_mutex_lock(&writer.mtx);
+    if (!writer.running) {
+        pthread_mutex_unlock(&writer.mtx);
+        // no writer thread, e.g. while creating, write through
+        pthread_mutex_lock(&reader_mtx);
+        int rv = persist_op_run(&reader, op);
+        pthread_mutex_unlock(&reader_mtx);
+        persist_op_free(op);
+        return rv;
+    }
+
+    if (NULL == writer.tail) {
+        writer.head = writer.tail = op;
+    } else {
+        writer.tail->next = op;
+        writer.tail       = op;
+    }
+    if (PERSIST_OP_FLUSH == op->type) {
+        writer.flush += 1;
+    } else {
+        writer.stats.queued_ops += 1;
+    }
+    pthread_cond_signal(&writer.cond);
+    pthread_mutex_unlock(&writer.mtx);
+
+    return 0;
+}
+
+/*
+ * Queue statement `sql`, which is prepared once and then cached.
+ *
+ * Each character of `types` describes the next parameter bound to it:
+ *   'i' int, 'u' unsigned int, 'd' double, 't' string copied, may be NULL.
+ */
+static int persist_stmt(const char *sql, const char *types, ...)
+{
+    persist_op_t *op = calloc(1, sizeof(persist_op_t));
+    if (NULL == op) {
+        return NEU_ERR_EINTERNAL;
+    }
+
+    op->type = PERSIST_OP_STMT;
+    op->sql  = sql;
+
+    va_list args;
+    va_start(args, types);
+    for (; '\0' != types[op->n_param]; ++op->n_param) {
+        persist_param_t *param = &op->params[op->n_param];
+        const char *     t     = NULL;
+
+        param->type = types[op->n_param];
+        switch (param->type) {
+        case 'i':
+            param->v.i = va_arg(args, int);
+            break;
+        case 'u':
+            param->v.i = va_arg(args, unsigned);
+            break;
+        case 'd':
+            param->v.d = va_arg(args, double);
+            break;
+        case 't':
+            t = va_arg(args, const char *);
+            if (NULL != t && NULL == (param->v.t = strdup(t))) {
+                va_end(args);
+                persist_op_free(op);
+                return NEU_ERR_EINTERNAL;
+            }
+            break;
+        }
+    }
+    va_end(args);
+
+    return persist_enqueue(op);
+}
+
+static int persist_fn(int (*fn)(persist_conn_t *conn, void *arg), void *arg,
+                      void (*free_arg)(void *arg))
+{
+    persist_op_t *op = calloc(1, sizeof(persist_op_t));
+    if (NULL == op) {
+        free_arg(arg);
+        return NEU_ERR_EINTERNAL;
+    }
+
+    op->type     = PERSIST_OP_FN;
+    op->fn       = fn;
+    op->arg      = arg;
+    op->free_arg = free_arg;
+    return persist_enqueue(op);
+}
+
+int neu_persister_flush()
+{
+    persist_flush_t flush = { 0 };
+    int             rv    = 0;
+
+    pthread_mutex_lock(&writer.mtx);
+    if (!writer.running || (NULL == writer.head && !writer.busy)) {
+        rv            = writer.errors > 0 ? NEU_ERR_EINTERNAL : 0;
+        writer.errors = 0;
+        pthread_mutex_unlock(&writer.mtx);
+        return rv;
+    }
+    pthread_mutex_unlock(&writer.mtx);
+
+    persist_op_t *op = calloc(1, sizeof(persist_op_t));
+    if (NULL == op) {
+        return NEU_ERR_EINTERNAL;
+    }
+
+    op->type  = PERSIST_OP_FLUSH;
+    op->flush = &flush;
+    persist_enqueue(op);
+
+    pthread_mutex_lock(&writer.mtx);
+    while (!flush.done) {
+        pthread_cond_wait(&writer.done_cond, &writer.mtx);
+    }
+    pthread_mutex_unlock(&writer.mtx);
+
+    return flush.rv;
+}
+
+void neu_persister_stats(neu_persist_stats_t *stats)
+{
+    pthread_mutex_lock(&writer.mtx);
+    *stats = writer.stats;
+    pthread_mutex_unlock(&writer.mtx);
+}
+
 static int get_schema_version(sqlite3 *db, char **version_p, bool *dirty_p)
 {
     sqlite3_stmt *stmt  = NULL;
@@ -381,6 +984,9 @@ static int apply_schema_file(sqlite3 *db, const char *dir, const char *file)
     rv = execute_sql(db, "UPDATE migrations SET dirty = 0 WHERE version=%Q",
                      version);
 
+    // the snapshot may not match the migrated tables
+    unlink(snapshot_file);
+
 end:
     if (0 == rv) {
         nlog_notice("success apply schema `%s`, version=`%s` description=`%s`",
@@ -471,9 +1077,31 @@ static int apply_schemas(sqlite3 *db, const char *dir)
     free(version);
     utarray_free(files);
 
+    // cached statements were compiled against the schema before migration
+    persist_conn_clear(&reader);
+
     return rv;
 }
 
+static uint32_t get_generation(sqlite3 *db)
+{
+    sqlite3_stmt *stmt       = NULL;
+    uint32_t      generation = 0;
+
+    if (SQLITE_OK !=
+        sqlite3_prepare_v2(db, "PRAGMA user_version", -1, &stmt, NULL)) {
+        nlog_error("prepare user_version fail: %s", sqlite3_errmsg(db));
+        return 0;
+    }
+
+    if (SQLITE_ROW == sqlite3_step(stmt)) {
+        generation = sqlite3_column_int(stmt, 0);
+    }
+
+    sqlite3_finalize(stmt);
+    return generation;
+}
+
 int neu_persister_create(const char *schema_dir)
 {
     int rv = sqlite3_open(db_file, &global_db);
@@ -499,6 +1127,8 @@ int neu_persister_create(const char *schema_dir)
         return -1;
     }
 
+    reader.db = global_db;
+
     rv = apply_schemas(global_db, schema_dir);
     if (rv != 0) {
         nlog_fatal("db apply schemas fail");
@@ -506,6 +1136,48 @@ int neu_persister_create(const char *schema_dir)
         return -1;
     }
 
+    rv = sqlite3_open(db_file, &writer.conn.db);
+    if (SQLITE_OK != rv) {
+        nlog_fatal("db `%s` fail: %s", db_file, sqlite3_errstr(rv));
+        sqlite3_close(writer.conn.db);
+        sqlite3_close(global_db);
+        return -1;
+    }
+    sqlite3_busy_timeout(writer.conn.db, 100 * 1000);
+
+    rv = sqlite3_exec(writer.conn.db, "PRAGMA foreign_keys=ON", NULL, NULL,
+                      NULL);
+    if (rv != SQLITE_OK) {
+        nlog_fatal("db foreign key support fail: %s",
+                   sqlite3_errmsg(writer.conn.db));
+        sqlite3_close(writer.conn.db);
+        sqlite3_close(global_db);
+        return -1;
+    }
+
+    writer.stop       = false;
+    writer.errors     = 0;
+    writer.generation  = get_generation(global_db);
+    writer.state_bumps = 0;
+    memset(&writer.stats, 0, sizeof(writer.stats));
+
+    reader_snapshot = neu_snapshot_open(snapshot_file, writer.generation);
+    if (NULL == reader_snapshot) {
+        // have one for the next start
+        writer.snapshot_dirty = true;
+        writer.commit_ts      = neu_time_ms();
+    }
+
+    if (0 != pthread_create(&writer.thread, NULL, persist_routine, NULL)) {
+        nlog_fatal("db writer thread fail: %s", strerror(errno));
+        neu_snapshot_close(reader_snapshot);
+        reader_snapshot = NULL;
+        sqlite3_close(writer.conn.db);
+        sqlite3_close(global_db);
+        return -1;
+    }
+    writer.running = true;
+
     return 0;
 }
 
@@ -516,15 +1188,33 @@ sqlite3 *neu_persister_get_db()
 
 void neu_persister_destroy()
 {
+    pthread_mutex_lock(&writer.mtx);
+    bool running = writer.running;
+    writer.stop  = true;
+    pthread_cond_signal(&writer.cond);
+    pthread_mutex_unlock(&writer.mtx);
+
+    if (running) {
+        // the writer commits what is queued before exiting
+        pthread_join(writer.thread, NULL);
+        writer.running = false;
+        persist_conn_clear(&writer.conn);
+        sqlite3_close(writer.conn.db);
+        writer.conn.db = NULL;
+    }
+
+    neu_snapshot_close(reader_snapshot);
+    reader_snapshot = NULL;
+    persist_conn_clear(&reader);
     sqlite3_close(global_db);
 }
 
 int neu_persister_store_node(neu_persist_node_info_t *info)
 {
-    return execute_sql(global_db,
-                       "INSERT INTO nodes (name, type, state, plugin_name) "
-                       "VALUES (%Q, %i, %i, %Q)",
-                       info->name, info->type, info->state, info->plugin_name);
+    return persist_stmt("INSERT INTO nodes (name, type, state, plugin_name) "
+                        "VALUES (?, ?, ?, ?)",
+                        "tiit", info->name, info->type, info->state,
+                        info->plugin_name);
 }
 
 static UT_icd node_info_icd = {
@@ -542,8 +1232,14 @@ int neu_persister_load_nodes(UT_array **node_infos)
 
     utarray_new(*node_infos, &node_info_icd);
 
-    if (SQLITE_OK != sqlite3_prepare_v2(global_db, query, -1, &stmt, NULL)) {
-        nlog_error("prepare `%s` fail: %s", query, sqlite3_errmsg(global_db));
+    neu_snapshot_t *snapshot = snapshot_get(true);
+    if (NULL != snapshot) {
+        rv = neu_snapshot_load_nodes(snapshot, *node_infos);
+        snapshot_done();
+        return rv;
+    }
+
+    if (NULL == (stmt = reader_stmt(query))) {
         utarray_free(*node_infos);
         *node_infos = NULL;
         return NEU_ERR_EINTERNAL;
@@ -577,7 +1273,7 @@ int neu_persister_load_nodes(UT_array **node_infos)
         // do not set return code, return partial or empty result
     }
 
-    sqlite3_finalize(stmt);
+    reader_done(stmt);
     return rv;
 }
 
@@ -585,20 +1281,18 @@ int neu_persister_delete_node(const char *node_name)
 {
     // rely on foreign key constraints to remove settings, groups, tags and
     // subscriptions
-    return execute_sql(global_db, "DELETE FROM nodes WHERE name=%Q;",
-                       node_name);
+    return persist_stmt("DELETE FROM nodes WHERE name=?", "t", node_name);
 }
 
 int neu_persister_update_node(const char *node_name, const char *new_name)
 {
-    return execute_sql(global_db, "UPDATE nodes SET name=%Q WHERE name=%Q;",
-                       new_name, node_name);
+    return persist_stmt("UPDATE nodes SET name=? WHERE name=?", "tt",
+                        new_name, node_name);
 }
 
 int neu_persister_update_node_state(const char *node_name, int state)
 {
-    return execute_sql(global_db, "UPDATE nodes SET state=%i WHERE name=%Q;",
-                       state, node_name);
+    return persist_stmt(node_state_sql, "it", state, node_name);
 }
 
 int neu_persister_store_plugins(UT_array *plugin_infos)
@@ -707,22 +1401,60 @@ int neu_persister_store_tag(const char *driver_name, const char *group_name,
                             const neu_datatag_t *tag)
 {
     char *val_str = neu_tag_dump_static_value(tag);
-    int   rv      = execute_sql(global_db,
+    int   rv      = persist_stmt(
                          "INSERT INTO tags ("
                          " driver_name, group_name, name, address, attribute,"
-                         " precision, type, decimal, description, value"
-                         ") VALUES (%Q, %Q, %Q, %Q, %i, %i, %i, %lf, %Q, %Q)",
-                         driver_name, group_name, tag->name, tag->address,
+                         " precision, type, decimal, description, value,"
+                         " deadband, deadband_type, heartbeat, min_interval"
+                         ") VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)",
+                         "ttttiiidttdiuu", driver_name, group_name, tag->name,
+                         tag->address,
                          tag->attribute, tag->precision, tag->type,
-                         tag->decimal, tag->description, val_str);
+                         tag->decimal, tag->description, val_str,
+                         tag->report.deadband, tag->report.deadband_type,
+                         tag->report.heartbeat, tag->report.min_interval);
 
     free(val_str);
     return rv;
 }
 
+static int put_tag_report(const char *query, sqlite3_stmt *stmt,
+                          const neu_tag_report_t *report)
+{
+    sqlite3 *db = sqlite3_db_handle(stmt);
+
+    if (SQLITE_OK != sqlite3_bind_double(stmt, 11, report->deadband)) {
+        nlog_error("bind `%s` with deadband=`%f` fail: %s", query,
+                   report->deadband, sqlite3_errmsg(db));
+        return -1;
+    }
+
+    if (SQLITE_OK != sqlite3_bind_int(stmt, 12, report->deadband_type)) {
+        nlog_error("bind `%s` with deadband_type=`%i` fail: %s", query,
+                   report->deadband_type, sqlite3_errmsg(db));
+        return -1;
+    }
+
+    if (SQLITE_OK != sqlite3_bind_int64(stmt, 13, report->heartbeat)) {
+        nlog_error("bind `%s` with heartbeat=`%u` fail: %s", query,
+                   report->heartbeat, sqlite3_errmsg(db));
+        return -1;
+    }
+
+    if (SQLITE_OK != sqlite3_bind_int64(stmt, 14, report->min_interval)) {
+        nlog_error("bind `%s` with min_interval=`%u` fail: %s", query,
+                   report->min_interval, sqlite3_errmsg(db));
+        return -1;
+    }
+
+    return 0;
+}
+
 static int put_tags(const char *query, sqlite3_stmt *stmt,
                     const neu_datatag_t *tags, size_t n)
 {
+    sqlite3 *db = sqlite3_db_handle(stmt);
+
     for (size_t i = 0; i < n; ++i) {
         const neu_datatag_t *tag = &tags[i];
 
@@ -730,57 +1462,61 @@ static int put_tags(const char *query, sqlite3_stmt *stmt,
 
         if (SQLITE_OK != sqlite3_bind_text(stmt, 3, tag->name, -1, NULL)) {
             nlog_error("bind `%s` with name=`%s` fail: %s", query, tag->name,
-                       sqlite3_errmsg(global_db));
+                       sqlite3_errmsg(db));
             return -1;
         }
 
         if (SQLITE_OK != sqlite3_bind_text(stmt, 4, tag->address, -1, NULL)) {
             nlog_error("bind `%s` with address=`%s` fail: %s", query,
-                       tag->address, sqlite3_errmsg(global_db));
+                       tag->address, sqlite3_errmsg(db));
             return -1;
         }
 
         if (SQLITE_OK != sqlite3_bind_int(stmt, 5, tag->attribute)) {
             nlog_error("bind `%s` with attribute=`%i` fail: %s", query,
-                       tag->attribute, sqlite3_errmsg(global_db));
+                       tag->attribute, sqlite3_errmsg(db));
             return -1;
         }
 
         if (SQLITE_OK != sqlite3_bind_int(stmt, 6, tag->precision)) {
             nlog_error("bind `%s` with precision=`%i` fail: %s", query,
-                       tag->precision, sqlite3_errmsg(global_db));
+                       tag->precision, sqlite3_errmsg(db));
             return -1;
         }
 
         if (SQLITE_OK != sqlite3_bind_int(stmt, 7, tag->type)) {
             nlog_error("bind `%s` with type=`%i` fail: %s", query, tag->type,
-                       sqlite3_errmsg(global_db));
+                       sqlite3_errmsg(db));
             return -1;
         }
 
         if (SQLITE_OK != sqlite3_bind_double(stmt, 8, tag->decimal)) {
             nlog_error("bind `%s` with decimal=`%f` fail: %s", query,
-                       tag->decimal, sqlite3_errmsg(global_db));
+                       tag->decimal, sqlite3_errmsg(db));
             return -1;
         }
 
         if (SQLITE_OK !=
             sqlite3_bind_text(stmt, 9, tag->description, -1, NULL)) {
             nlog_error("bind `%s` with description=`%s` fail: %s", query,
-                       tag->description, sqlite3_errmsg(global_db));
+                       tag->description, sqlite3_errmsg(db));
+            return -1;
+        }
+
+        if (0 != put_tag_report(query, stmt, &tag->report)) {
             return -1;
         }
 
         char *val_str = neu_tag_dump_static_value(tag);
         if (SQLITE_OK != sqlite3_bind_text(stmt, 10, val_str, -1, NULL)) {
             nlog_error("bind `%s` with value=`%s` fail: %s", query, val_str,
-                       sqlite3_errmsg(global_db));
+                       sqlite3_errmsg(db));
             free(val_str);
             return -1;
         }
 
         if (SQLITE_DONE != sqlite3_step(stmt)) {
-            nlog_error("sqlite3_step fail: %s", sqlite3_errmsg(global_db));
+            nlog_error("sqlite3_step fail: %s", sqlite3_errmsg(db));
             free(val_str);
             return -1;
         }
@@ -791,54 +1527,135 @@ static int put_tags(const char *query, sqlite3_stmt *stmt,
     return 0;
 }
 
-int neu_persister_store_tags(const char *driver_name, const char *group_name,
-                             const neu_datatag_t *tags, size_t n)
+typedef struct {
+    const char *   query; // string literal
+    char *         owner;
+    char *         group;
+    neu_datatag_t *tags;  // rows to insert or update
+    char **        names; // names of rows to delete
+    size_t         n;
+} persist_tags_t;
+
+static void persist_tags_free(void *arg)
 {
-    sqlite3_stmt *stmt  = NULL;
-    const char *  query = "INSERT INTO tags ("
-                        " driver_name, group_name, name, address, attribute,"
-                        " precision, type, decimal, description, value"
-                        ") VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8, ?9, ?10)";
+    persist_tags_t *ctx = arg;
+
+    for (size_t i = 0; i < ctx->n; ++i) {
+        if (ctx->tags) {
+            neu_tag_fini(&ctx->tags[i]);
+        }
+        if (ctx->names) {
+            free(ctx->names[i]);
+        }
+    }
+    free(ctx->tags);
+    free(ctx->names);
+    free(ctx->owner);
+    free(ctx->group);
+    free(ctx);
+}
 
-    if (SQLITE_OK != sqlite3_exec(global_db, "BEGIN", NULL, NULL, NULL)) {
-        nlog_error("begin transaction fail: %s", sqlite3_errmsg(global_db));
+static int persist_tags_run(persist_conn_t *conn, void *arg)
+{
+    persist_tags_t *ctx  = arg;
+    sqlite3 *       db   = conn->db;
+    sqlite3_stmt *  stmt = persist_prepare(conn, ctx->query);
+    int             rv   = 0;
+
+    if (NULL == stmt) {
         return NEU_ERR_EINTERNAL;
     }
 
-    if (SQLITE_OK != sqlite3_prepare_v2(global_db, query, -1, &stmt, NULL)) {
-        nlog_error("prepare `%s` fail: %s", query, sqlite3_errmsg(global_db));
-        goto error;
+    if (SQLITE_OK != sqlite3_bind_text(stmt, 1, ctx->owner, -1, NULL)) {
+        nlog_error("bind `%s` with `%s` fail: %s", ctx->query, ctx->owner,
+                   sqlite3_errmsg(db));
+        rv = NEU_ERR_EINTERNAL;
+        goto end;
     }
 
-    if (SQLITE_OK != sqlite3_bind_text(stmt, 1, driver_name, -1, NULL)) {
-        nlog_error("bind `%s` with driver_name=`%s` fail: %s", query,
-                   driver_name, sqlite3_errmsg(global_db));
-        goto error;
+    if (SQLITE_OK != sqlite3_bind_text(stmt, 2, ctx->group, -1, NULL)) {
+        nlog_error("bind `%s` with `%s` fail: %s", ctx->query, ctx->group,
+                   sqlite3_errmsg(db));
+        rv = NEU_ERR_EINTERNAL;
+        goto end;
     }
 
-    if (SQLITE_OK != sqlite3_bind_text(stmt, 2, group_name, -1, NULL)) {
-        nlog_error("bind `%s` with group_name=`%s` fail: %s", query, group_name,
-                   sqlite3_errmsg(global_db));
-        goto error;
+    if (ctx->tags) {
+        rv = 0 == put_tags(ctx->query, stmt, ctx->tags, ctx->n)
+            ? 0
+            : NEU_ERR_EINTERNAL;
+        goto end;
     }
 
-    if (0 != put_tags(query, stmt, tags, n)) {
-        goto error;
+    for (size_t i = 0; i < ctx->n; ++i) {
+        sqlite3_reset(stmt);
+
+        if (SQLITE_OK != sqlite3_bind_text(stmt, 3, ctx->names[i], -1, NULL)) {
+            nlog_error("bind `%s` with `%s` fail: %s", ctx->query,
+                       ctx->names[i], sqlite3_errmsg(db));
+            rv = NEU_ERR_EINTERNAL;
+            break;
+        }
+
+        if (SQLITE_DONE != sqlite3_step(stmt)) {
+            nlog_error("sqlite3_step fail: %s", sqlite3_errmsg(db));
+            rv = NEU_ERR_EINTERNAL;
+            break;
+        }
     }
 
-    if (SQLITE_OK != sqlite3_exec(global_db, "COMMIT", NULL, NULL, NULL)) {
-        nlog_error("commit transaction fail: %s", sqlite3_errmsg(global_db));
-        goto error;
+end:
+    persist_release(stmt);
+    return rv;
+}
+
+// queue statement `query` run once per tag, or per name to delete
+static int persist_tags(const char *query, const char *owner,
+                        const char *group, const neu_datatag_t *tags,
+                        const char *const *names, size_t n)
+{
+    persist_tags_t *ctx = calloc(1, sizeof(*ctx));
+    if (NULL == ctx) {
+        return NEU_ERR_EINTERNAL;
     }
 
-    sqlite3_finalize(stmt);
-    return 0;
+    ctx->query = query;
+    ctx->owner = strdup(owner);
+    ctx->group = strdup(group);
+    if (tags) {
+        ctx->tags = calloc(n, sizeof(neu_datatag_t));
+    } else {
+        ctx->names = calloc(n, sizeof(char *));
+    }
+    if (NULL == ctx->owner || NULL == ctx->group ||
+        (NULL == ctx->tags && NULL == ctx->names)) {
+        persist_tags_free(ctx);
+        return NEU_ERR_EINTERNAL;
+    }
 
-error:
-    nlog_warn("rollback transaction");
-    sqlite3_exec(global_db, "ROLLBACK", NULL, NULL, NULL);
-    sqlite3_finalize(stmt);
-    return NEU_ERR_EINTERNAL;
+    for (; ctx->n < n; ++ctx->n) {
+        if (tags) {
+            neu_tag_copy(&ctx->tags[ctx->n], &tags[ctx->n]);
+        } else if (NULL == (ctx->names[ctx->n] = strdup(names[ctx->n]))) {
+            persist_tags_free(ctx);
+            return NEU_ERR_EINTERNAL;
+        }
+    }
+
+    return persist_fn(persist_tags_run, ctx, persist_tags_free);
+}
+
+int neu_persister_store_tags(const char *driver_name, const char *group_name,
+                             const neu_datatag_t *tags, size_t n)
+{
+    const char *query = "INSERT INTO tags ("
+                        " driver_name, group_name, name, address, attribute,"
+                        " precision, type, decimal, description, value,"
+                        " deadband, deadband_type, heartbeat, min_interval"
+                        ") VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8, ?9, ?10,"
+                        " ?11, ?12, ?13, ?14)";
+
+    return persist_tags(query, driver_name, group_name, tags, NULL, n);
 }
 
 static int collect_tag_info(sqlite3_stmt *stmt, UT_array **tags)
@@ -853,6 +1670,12 @@ static int collect_tag_info(sqlite3_stmt *stmt, UT_array **tags)
             .type        = sqlite3_column_int(stmt, 4),
             .decimal     = sqlite3_column_double(stmt, 5),
             .description = (char *) sqlite3_column_text(stmt, 6),
+            .report      = {
+                .deadband      = sqlite3_column_double(stmt, 8),
+                .deadband_type = sqlite3_column_int(stmt, 9),
+                .heartbeat     = sqlite3_column_int64(stmt, 10),
+                .min_interval  = sqlite3_column_int64(stmt, 11),
+            },
         };
         utarray_push_back(*tags, &tag);
         if (neu_tag_attribute_test(&tag, NEU_ATTRIBUTE_STATIC)) {
@@ -875,14 +1698,22 @@ int neu_persister_load_tags(const char *driver_name, const char *group_name,
 {
     sqlite3_stmt *stmt  = NULL;
     const char *  query = "SELECT name, address, attribute, precision, type, "
-                        "decimal, description, value "
+                        "decimal, description, value, deadband, "
+                        "deadband_type, heartbeat, min_interval "
                         "FROM tags WHERE driver_name=? AND group_name=? "
                         "ORDER BY rowid ASC";
 
     utarray_new(*tags, neu_tag_get_icd());
 
-    if (SQLITE_OK != sqlite3_prepare_v2(global_db, query, -1, &stmt, NULL)) {
-        nlog_error("prepare `%s` fail: %s", query, sqlite3_errmsg(global_db));
+    neu_snapshot_t *snapshot = snapshot_get(false);
+    if (NULL != snapshot) {
+        int rv =
+            neu_snapshot_load_tags(snapshot, driver_name, group_name, *tags);
+        snapshot_done();
+        return rv;
+    }
+
+    if (NULL == (stmt = reader_stmt(query))) {
         goto error;
     }
 
@@ -903,10 +1734,11 @@ int neu_persister_load_tags(const char *driver_name, const char *group_name,
         // do not set return code, return partial or empty result
     }
 
-    sqlite3_finalize(stmt);
+    reader_done(stmt);
     return 0;
 
 error:
+    reader_done(stmt);
     utarray_free(*tags);
     *tags = NULL;
     return NEU_ERR_EINTERNAL;
@@ -916,13 +1748,18 @@ int neu_persister_update_tag(const char *driver_name, const char *group_name,
                              const neu_datatag_t *tag)
 {
     char *val_str = neu_tag_dump_static_value(tag);
-    int   rv      = execute_sql(global_db,
+    int   rv      = persist_stmt(
                          "UPDATE tags SET"
-                         " address=%Q, attribute=%i, precision=%i, type=%i,"
-                         " decimal=%lf, description=%Q, value=%Q "
-                         "WHERE driver_name=%Q AND group_name=%Q AND name=%Q",
-                         tag->address, tag->attribute, tag->precision,
-                         tag->type, tag->decimal, tag->description, val_str,
+                         " address=?, attribute=?, precision=?, type=?,"
+                         " decimal=?, description=?, value=?,"
+                         " deadband=?, deadband_type=?, heartbeat=?,"
+                         " min_interval=? "
+                         "WHERE driver_name=? AND group_name=? AND name=?",
+                         "tiiidttdiuuttt", tag->address, tag->attribute,
+                         tag->precision, tag->type, tag->decimal,
+                         tag->description, val_str,
+                         tag->report.deadband, tag->report.deadband_type,
+                         tag->report.heartbeat, tag->report.min_interval,
                          driver_name, group_name, tag->name);
     free(val_str);
     return rv;
@@ -933,10 +1770,10 @@ int neu_persister_update_tag_value(const char *         driver_name,
                                    const neu_datatag_t *tag)
 {
     char *val_str = neu_tag_dump_static_value(tag);
-    int   rv      = execute_sql(global_db,
-                         "UPDATE tags SET value=%Q "
-                         "WHERE driver_name=%Q AND group_name=%Q AND name=%Q",
-                         val_str, driver_name, group_name, tag->name);
+    int   rv      = persist_stmt(
+                         "UPDATE tags SET value=? "
+                         "WHERE driver_name=? AND group_name=? AND name=?",
+                         "tttt", val_str, driver_name, group_name, tag->name);
     free(val_str);
     return rv;
 }
@@ -944,21 +1781,19 @@ int neu_persister_update_tag_value(const char *         driver_name,
 int neu_persister_delete_tag(const char *driver_name, const char *group_name,
                              const char *tag_name)
 {
-    return execute_sql(
-        global_db,
-        "DELETE FROM tags WHERE driver_name=%Q AND group_name=%Q AND name=%Q",
-        driver_name, group_name, tag_name);
+    return persist_stmt(
+        "DELETE FROM tags WHERE driver_name=? AND group_name=? AND name=?",
+        "ttt", driver_name, group_name, tag_name);
 }
 
 int neu_persister_store_subscription(const char *app_name,
                                      const char *driver_name,
                                      const char *group_name, const char *params)
 {
-    return execute_sql(
-        global_db,
+    return persist_stmt(
         "INSERT INTO subscriptions (app_name, driver_name, group_name, params) "
-        "VALUES (%Q, %Q, %Q, %Q)",
-        app_name, driver_name, group_name, params);
+        "VALUES (?, ?, ?, ?)",
+        "tttt", app_name, driver_name, group_name, params);
 }
 
 static UT_icd subscription_info_icd = {
@@ -977,8 +1812,15 @@ int neu_persister_load_subscriptions(const char *app_name,
 
     utarray_new(*subscription_infos, &subscription_info_icd);
 
-    if (SQLITE_OK != sqlite3_prepare_v2(global_db, query, -1, &stmt, NULL)) {
-        nlog_error("prepare `%s` fail: %s", query, sqlite3_errmsg(global_db));
+    neu_snapshot_t *snapshot = snapshot_get(false);
+    if (NULL != snapshot) {
+        int rv = neu_snapshot_load_subscriptions(snapshot, app_name,
+                                                 *subscription_infos);
+        snapshot_done();
+        return rv;
+    }
+
+    if (NULL == (stmt = reader_stmt(query))) {
         goto error;
     }
 
@@ -1024,10 +1866,11 @@ int neu_persister_load_subscriptions(const char *app_name,
         // do not set return code, return partial or empty result
     }
 
-    sqlite3_finalize(stmt);
+    reader_done(stmt);
     return 0;
 
 error:
+    reader_done(stmt);
     utarray_free(*subscription_infos);
     *subscription_infos = NULL;
     return NEU_ERR_EINTERNAL;
@@ -1037,29 +1880,27 @@ int neu_persister_delete_subscription(const char *app_name,
                                       const char *driver_name,
                                       const char *group_name)
 {
-    return execute_sql(global_db,
-                       "DELETE FROM subscriptions WHERE app_name=%Q AND "
-                       "driver_name=%Q AND group_name=%Q",
-                       app_name, driver_name, group_name);
+    return persist_stmt("DELETE FROM subscriptions WHERE app_name=? AND "
+                        "driver_name=? AND group_name=?",
+                        "ttt", app_name, driver_name, group_name);
 }
 
 int neu_persister_store_group(const char *              driver_name,
                               neu_persist_group_info_t *group_info)
 {
-    return execute_sql(
-        global_db,
-        "INSERT INTO groups (driver_name, name, interval) VALUES (%Q, %Q, %u)",
-        driver_name, group_info->name, (unsigned) group_info->interval);
+    return persist_stmt(
+        "INSERT INTO groups (driver_name, name, interval) VALUES (?, ?, ?)",
+        "ttu", driver_name, group_info->name, (unsigned) group_info->interval);
 }
 
 int neu_persister_update_group(const char *              driver_name,
                                neu_persist_group_info_t *group_info)
 {
-    return execute_sql(global_db,
-                       "UPDATE groups SET driver_name=%Q, name=%Q, "
-                       "interval=%i WHERE driver_name=%Q AND name=%Q",
-                       driver_name, group_info->name, group_info->interval,
-                       driver_name, group_info->name);
+    return persist_stmt("UPDATE groups SET driver_name=?, name=?, "
+                        "interval=? WHERE driver_name=? AND name=?",
+                        "ttutt", driver_name, group_info->name,
+                        (unsigned) group_info->interval, driver_name,
+                        group_info->name);
 }
 
 static UT_icd group_info_icd = {
@@ -1100,8 +1941,14 @@ int neu_persister_load_groups(const char *driver_name, UT_array **group_infos)
 
     utarray_new(*group_infos, &group_info_icd);
 
-    if (SQLITE_OK != sqlite3_prepare_v2(global_db, query, -1, &stmt, NULL)) {
-        nlog_error("prepare `%s` fail: %s", query, sqlite3_errmsg(global_db));
+    neu_snapshot_t *snapshot = snapshot_get(false);
+    if (NULL != snapshot) {
+        int rv = neu_snapshot_load_groups(snapshot, driver_name, *group_infos);
+        snapshot_done();
+        return rv;
+    }
+
+    if (NULL == (stmt = reader_stmt(query))) {
         goto error;
     }
 
@@ -1116,10 +1963,11 @@ int neu_persister_load_groups(const char *driver_name, UT_array **group_infos)
         // do not set return code, return partial or empty result
     }
 
-    sqlite3_finalize(stmt);
+    reader_done(stmt);
     return 0;
 
 error:
+    reader_done(stmt);
     utarray_free(*group_infos);
     *group_infos = NULL;
     return NEU_ERR_EINTERNAL;
@@ -1128,17 +1976,15 @@ error:
 int neu_persister_delete_group(const char *driver_name, const char *group_name)
 {
     // rely on foreign key constraints to delete tags and subscriptions
-    return execute_sql(global_db,
-                       "DELETE FROM groups WHERE driver_name=%Q AND name=%Q",
-                       driver_name, group_name);
+    return persist_stmt("DELETE FROM groups WHERE driver_name=? AND name=?",
+                        "tt", driver_name, group_name);
 }
 
 int neu_persister_store_node_setting(const char *node_name, const char *setting)
 {
-    return execute_sql(
-        global_db,
-        "INSERT OR REPLACE INTO settings (node_name, setting) VALUES (%Q, %Q)",
-        node_name, setting);
+    return persist_stmt(
+        "INSERT OR REPLACE INTO settings (node_name, setting) VALUES (?, ?)",
+        "tt", node_name, setting);
 }
 
 int neu_persister_load_node_setting(const char *       node_name,
@@ -1148,9 +1994,14 @@ int neu_persister_load_node_setting(const char *       node_name,
     sqlite3_stmt *stmt  = NULL;
     const char *  query = "SELECT setting FROM settings WHERE node_name=?";
 
-    if (SQLITE_OK != sqlite3_prepare_v2(global_db, query, -1, &stmt, NULL)) {
-        nlog_error("prepare `%s` with `%s` fail: %s", query, node_name,
-                   sqlite3_errmsg(global_db));
+    neu_snapshot_t *snapshot = snapshot_get(false);
+    if (NULL != snapshot) {
+        rv = neu_snapshot_load_node_setting(snapshot, node_name, setting);
+        snapshot_done();
+        return rv;
+    }
+
+    if (NULL == (stmt = reader_stmt(query))) {
         return NEU_ERR_EINTERNAL;
     }
 
@@ -1178,27 +2029,29 @@ int neu_persister_load_node_setting(const char *       node_name,
     *setting = s;
 
 end:
-    sqlite3_finalize(stmt);
+    reader_done(stmt);
     return rv;
 }
 
 int neu_persister_delete_node_setting(const char *node_name)
 {
-    return execute_sql(global_db, "DELETE FROM settings WHERE node_name=%Q",
-                       node_name);
+    return persist_stmt("DELETE FROM settings WHERE node_name=?", "t",
+                        node_name);
 }
 
+// user changes are written through, a password must not be lost on crash
 int neu_persister_store_user(const neu_persist_user_info_t *user)
 {
-    return execute_sql(global_db,
-                       "INSERT INTO users (name, password) VALUES (%Q, %Q)",
-                       user->name, user->hash);
+    int rv = persist_stmt("INSERT INTO users (name, password) VALUES (?, ?)",
+                          "tt", user->name, user->hash);
+    return 0 != rv ? rv : neu_persister_flush();
 }
 
 int neu_persister_update_user(const neu_persist_user_info_t *user)
 {
-    return execute_sql(global_db, "UPDATE users SET password=%Q WHERE name=%Q",
-                       user->hash, user->name);
+    int rv = persist_stmt("UPDATE users SET password=? WHERE name=?", "tt",
+                          user->hash, user->name);
+    return 0 != rv ? rv : neu_persister_flush();
 }
 
 int neu_persister_load_user(const char *              user_name,
@@ -1208,9 +2061,7 @@ int neu_persister_load_user(const char *              user_name,
     sqlite3_stmt *           stmt  = NULL;
     const char *             query = "SELECT password FROM users WHERE name=?";
 
-    if (SQLITE_OK != sqlite3_prepare_v2(global_db, query, -1, &stmt, NULL)) {
-        nlog_error("prepare `%s` with `%s` fail: %s", query, user_name,
-                   sqlite3_errmsg(global_db));
+    if (NULL == (stmt = reader_stmt(query))) {
         return NEU_ERR_EINTERNAL;
     }
 
@@ -1244,7 +2095,7 @@ int neu_persister_load_user(const char *              user_name,
     }
 
     *user_p = user;
-    sqlite3_finalize(stmt);
+    reader_done(stmt);
     return 0;
 
 error:
@@ -1252,21 +2103,21 @@ error:
         neu_persist_user_info_fini(user);
         free(user);
     }
-    sqlite3_finalize(stmt);
+    reader_done(stmt);
     return NEU_ERR_EINTERNAL;
 }
 
 int neu_persister_delete_user(const char *user_name)
 {
-    return execute_sql(global_db, "DELETE FROM users WHERE name=%Q", user_name);
+    int rv = persist_stmt("DELETE FROM users WHERE name=?", "t", user_name);
+    return 0 != rv ? rv : neu_persister_flush();
 }
 
 int neu_persister_store_template(const char *name, const char *plugin)
 {
-    return execute_sql(global_db,
-                       "INSERT INTO templates (name, plugin_name) "
-                       "VALUES (%Q, %Q)",
-                       name, plugin);
+    return persist_stmt("INSERT INTO templates (name, plugin_name) "
+                        "VALUES (?, ?)",
+                        "tt", name, plugin);
 }
 
 static inline void
@@ -1289,8 +2140,7 @@ int neu_persister_load_templates(UT_array **infos)
     sqlite3_stmt *stmt  = NULL;
     const char *  query = "SELECT name, plugin_name FROM templates;";
 
-    if (SQLITE_OK != sqlite3_prepare_v2(global_db, query, -1, &stmt, NULL)) {
-        nlog_error("prepare `%s` fail: %s", query, sqlite3_errmsg(global_db));
+    if (NULL == (stmt = reader_stmt(query))) {
         return NEU_ERR_EINTERNAL;
     }
 
@@ -1322,39 +2172,37 @@ int neu_persister_load_templates(UT_array **infos)
         // do not set return code, return partial or empty result
     }
 
-    sqlite3_finalize(stmt);
+    reader_done(stmt);
     return rv;
 }
 
 int neu_persister_delete_template(const char *name)
 {
     // rely on foreign key constraints to remove groups and tags
-    return execute_sql(global_db, "DELETE FROM templates WHERE name=%Q;", name);
+    return persist_stmt("DELETE FROM templates WHERE name=?", "t", name);
 }
 
 int neu_persister_clear_templates()
 {
     // rely on foreign key constraints to remove groups and tags
-    return execute_sql(global_db, "DELETE FROM templates");
+    return persist_stmt("DELETE FROM templates", "");
 }
 
 int neu_persister_store_template_group(const char *              tmpl_name,
                                        neu_persist_group_info_t *group_info)
 {
-    return execute_sql(global_db,
-                       "INSERT INTO template_groups ("
-                       " tmpl_name, name, interval) VALUES (%Q, %Q, %u)",
-                       tmpl_name, group_info->name,
-                       (unsigned) group_info->interval);
+    return persist_stmt("INSERT INTO template_groups ("
+                        " tmpl_name, name, interval) VALUES (?, ?, ?)",
+                        "ttu", tmpl_name, group_info->name,
+                        (unsigned) group_info->interval);
 }
 
 int neu_persister_update_template_group(const char *              tmpl_name,
                                         neu_persist_group_info_t *group_info)
 {
-    return execute_sql(
-        global_db,
-        "UPDATE template_groups SET interval=%i WHERE tmpl_name=%Q AND name=%Q",
-        group_info->interval, tmpl_name, group_info->name);
+    return persist_stmt(
+        "UPDATE template_groups SET interval=? WHERE tmpl_name=? AND name=?",
+        "utt", (unsigned) group_info->interval, tmpl_name, group_info->name);
 }
 
 int neu_persister_load_template_groups(const char *tmpl_name,
@@ -1366,8 +2214,7 @@ int neu_persister_load_template_groups(const char *tmpl_name,
 
     utarray_new(*group_infos, &group_info_icd);
 
-    if (SQLITE_OK != sqlite3_prepare_v2(global_db, query, -1, &stmt, NULL)) {
-        nlog_error("prepare `%s` fail: %s", query, sqlite3_errmsg(global_db));
+    if (NULL == (stmt = reader_stmt(query))) {
         goto error;
     }
 
@@ -1382,10 +2229,11 @@ int neu_persister_load_template_groups(const char *tmpl_name,
         // do not set return code, return partial or empty result
     }
 
-    sqlite3_finalize(stmt);
+    reader_done(stmt);
     return 0;
 
 error:
+    reader_done(stmt);
     utarray_free(*group_infos);
     *group_infos = NULL;
     return NEU_ERR_EINTERNAL;
@@ -1395,8 +2243,8 @@ int neu_persister_delete_template_group(const char *tmpl_name,
                                         const char *group_name)
 {
     // rely on foreign key constraints to delete tags
-    return execute_sql(
-        global_db, "DELETE FROM template_groups WHERE tmpl_name=%Q AND name=%Q",
+    return persist_stmt(
+        "DELETE FROM template_groups WHERE tmpl_name=? AND name=?", "tt",
         tmpl_name, group_name);
 }
 
@@ -1404,53 +2252,14 @@ int neu_persister_store_template_tags(const char *         tmpl_name,
                                       const char *         group_name,
                                       const neu_datatag_t *tags, size_t n)
 {
-    char *        val_str = NULL;
-    sqlite3_stmt *stmt    = NULL;
-    const char *  query   = "INSERT INTO template_tags ("
+    const char *query = "INSERT INTO template_tags ("
                         " tmpl_name, group_name, name, address, attribute,"
-                        " precision, type, decimal, description, value"
-                        ") VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8, ?9, ?10)";
-
-    if (SQLITE_OK != sqlite3_exec(global_db, "BEGIN", NULL, NULL, NULL)) {
-        nlog_error("begin transaction fail: %s", sqlite3_errmsg(global_db));
-        return NEU_ERR_EINTERNAL;
-    }
-
-    if (SQLITE_OK != sqlite3_prepare_v2(global_db, query, -1, &stmt, NULL)) {
-        nlog_error("prepare `%s` fail: %s", query, sqlite3_errmsg(global_db));
-        goto error;
-    }
-
-    if (SQLITE_OK != sqlite3_bind_text(stmt, 1, tmpl_name, -1, NULL)) {
-        nlog_error("bind `%s` with tmpl_name=`%s` fail: %s", query, tmpl_name,
-                   sqlite3_errmsg(global_db));
-        goto error;
-    }
-
-    if (SQLITE_OK != sqlite3_bind_text(stmt, 2, group_name, -1, NULL)) {
-        nlog_error("bind `%s` with group_name=`%s` fail: %s", query, group_name,
-                   sqlite3_errmsg(global_db));
-        goto error;
-    }
-
-    if (0 != put_tags(query, stmt, tags, n)) {
-        goto error;
-    }
-
-    if (SQLITE_OK != sqlite3_exec(global_db, "COMMIT", NULL, NULL, NULL)) {
-        nlog_error("commit transaction fail: %s", sqlite3_errmsg(global_db));
-        goto error;
-    }
+                        " precision, type, decimal, description, value,"
+                        " deadband, deadband_type, heartbeat, min_interval"
+                        ") VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8, ?9, ?10,"
+                        " ?11, ?12, ?13, ?14)";
 
-    sqlite3_finalize(stmt);
-    return 0;
-
-error:
-    nlog_info("rollback transaction");
-    sqlite3_exec(global_db, "ROLLBACK", NULL, NULL, NULL);
-    sqlite3_finalize(stmt);
-    free(val_str);
-    return NEU_ERR_EINTERNAL;
+    return persist_tags(query, tmpl_name, group_name, tags, NULL, n);
 }
 
 int neu_persister_load_template_tags(const char *tmpl_name,
@@ -1458,14 +2267,14 @@ int neu_persister_load_template_tags(const char *tmpl_name,
 {
     sqlite3_stmt *stmt  = NULL;
     const char *  query = "SELECT name, address, attribute, precision, type, "
-                        "decimal, description, value "
+                        "decimal, description, value, deadband, "
+                        "deadband_type, heartbeat, min_interval "
                         "FROM template_tags WHERE tmpl_name=? AND group_name=? "
                         "ORDER BY rowid ASC";
 
     utarray_new(*tags, neu_tag_get_icd());
 
-    if (SQLITE_OK != sqlite3_prepare_v2(global_db, query, -1, &stmt, NULL)) {
-        nlog_error("prepare `%s` fail: %s", query, sqlite3_errmsg(global_db));
+    if (NULL == (stmt = reader_stmt(query))) {
         goto error;
     }
 
@@ -1486,10 +2295,11 @@ int neu_persister_load_template_tags(const char *tmpl_name,
         // do not set return code, return partial or empty result
     }
 
-    sqlite3_finalize(stmt);
+    reader_done(stmt);
     return 0;
 
 error:
+    reader_done(stmt);
     utarray_free(*tags);
     *tags = NULL;
     return NEU_ERR_EINTERNAL;
@@ -1499,109 +2309,22 @@ int neu_persister_update_template_tags(const char *         tmpl_name,
                                        const char *         group_name,
                                        const neu_datatag_t *tags, size_t n)
 {
-    sqlite3_stmt *stmt  = NULL;
-    const char *  query = "UPDATE template_tags SET"
+    const char *query = "UPDATE template_tags SET"
                         "  address=?4, attribute=?5, precision=?6, type=?7,"
-                        "  decimal=?8, description=?9, value=?10 "
+                        "  decimal=?8, description=?9, value=?10,"
+                        "  deadband=?11, deadband_type=?12, heartbeat=?13,"
+                        "  min_interval=?14 "
                         "WHERE tmpl_name=?1 AND group_name=?2 AND name=?3";
 
-    if (SQLITE_OK != sqlite3_exec(global_db, "BEGIN", NULL, NULL, NULL)) {
-        nlog_error("begin transaction fail: %s", sqlite3_errmsg(global_db));
-        return NEU_ERR_EINTERNAL;
-    }
-
-    if (SQLITE_OK != sqlite3_prepare_v2(global_db, query, -1, &stmt, NULL)) {
-        nlog_error("prepare `%s` fail: %s", query, sqlite3_errmsg(global_db));
-        goto error;
-    }
-
-    if (SQLITE_OK != sqlite3_bind_text(stmt, 1, tmpl_name, -1, NULL)) {
-        nlog_error("bind `%s` with tmpl_name=`%s` fail: %s", query, tmpl_name,
-                   sqlite3_errmsg(global_db));
-        goto error;
-    }
-
-    if (SQLITE_OK != sqlite3_bind_text(stmt, 2, group_name, -1, NULL)) {
-        nlog_error("bind `%s` with group_name=`%s` fail: %s", query, group_name,
-                   sqlite3_errmsg(global_db));
-        goto error;
-    }
-
-    if (0 != put_tags(query, stmt, tags, n)) {
-        goto error;
-    }
-
-    if (SQLITE_OK != sqlite3_exec(global_db, "COMMIT", NULL, NULL, NULL)) {
-        nlog_error("commit transaction fail: %s", sqlite3_errmsg(global_db));
-        goto error;
-    }
-
-    sqlite3_finalize(stmt);
-    return 0;
-
-error:
-    nlog_info("rollback transaction");
-    sqlite3_exec(global_db, "ROLLBACK", NULL, NULL, NULL);
-    sqlite3_finalize(stmt);
-    return NEU_ERR_EINTERNAL;
+    return persist_tags(query, tmpl_name, group_name, tags, NULL, n);
 }
 
 int neu_persister_delete_template_tags(const char *       tmpl_name,
                                        const char *       group_name,
                                        const char *const *tags, size_t n_tag)
 {
-    sqlite3_stmt *stmt  = NULL;
-    const char *  query = "DELETE FROM template_tags WHERE tmpl_name=? AND "
+    const char *query = "DELETE FROM template_tags WHERE tmpl_name=? AND "
                         "group_name=? AND name=?";
 
-    if (SQLITE_OK != sqlite3_exec(global_db, "BEGIN", NULL, NULL, NULL)) {
-        nlog_error("begin transaction fail: %s", sqlite3_errmsg(global_db));
-        return NEU_ERR_EINTERNAL;
-    }
-
-    if (SQLITE_OK != sqlite3_prepare_v2(global_db, query, -1, &stmt, NULL)) {
-        nlog_error("prepare `%s` fail: %s", query, sqlite3_errmsg(global_db));
-        goto error;
-    }
-
-    if (SQLITE_OK != sqlite3_bind_text(stmt, 1, tmpl_name, -1, NULL)) {
-        nlog_error("bind `%s` with tmpl_name=`%s` fail: %s", query, tmpl_name,
-                   sqlite3_errmsg(global_db));
-        goto error;
-    }
-
-    if (SQLITE_OK != sqlite3_bind_text(stmt, 2, group_name, -1, NULL)) {
-        nlog_error("bind `%s` with group_name=`%s` fail: %s", query, group_name,
-                   sqlite3_errmsg(global_db));
-        goto error;
-    }
-
-    for (size_t i = 0; i < n_tag; ++i) {
-        sqlite3_reset(stmt);
-
-        if (SQLITE_OK != sqlite3_bind_text(stmt, 3, tags[i], -1, NULL)) {
-            nlog_error("bind `%s` with tmpl_name=`%s` fail: %s", query,
-                       tmpl_name, sqlite3_errmsg(global_db));
-            goto error;
-        }
-
-        if (SQLITE_DONE != sqlite3_step(stmt)) {
-            nlog_error("sqlite3_step fail: %s", sqlite3_errmsg(global_db));
-            goto error;
-        }
-    }
-
-    if (SQLITE_OK != sqlite3_exec(global_db, "COMMIT", NULL, NULL, NULL)) {
-        nlog_error("commit transaction fail: %s", sqlite3_errmsg(global_db));
-        goto error;
-    }
-
-    sqlite3_finalize(stmt);
-    return 0;
-
-error:
-    nlog_info("rollback transaction");
-    sqlite3_exec(global_db, "ROLLBACK", NULL, NULL, NULL);
-    sqlite3_finalize(stmt);
-    return NEU_ERR_EINTERNAL;
+    return persist_tags(query, tmpl_name, group_name, NULL, tags, n_tag);
 }
@@ -0,0 +1,746 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <zlib.h>
+
+#include "errcodes.h"
+#include "persist/persist.h"
+#include "tag.h"
+#include "utils/log.h"
+
+#include "snapshot.h"
+
+/*
+ * Layout, integers in host byte order:
+ *
+ *   header   magic[8] version:u32 crc:u32 generation:u64 size:u64
+ *   payload  n_node:u32 node*
+ *   node     name type:i32 state:i32 plugin setting n_group:u32 group*
+ *            n_sub:u32 sub*
+ *   group    name interval:u32 n_tag:u32 tag*
+ *   tag      name address description value attribute:i32 precision:i32
+ *            type:i32 decimal:f64 deadband:f64 deadband_type:i32
+ *            heartbeat:u32 min_interval:u32
+ *   sub      driver group params
+ *
+ * Strings are a u32 length, UINT32_MAX for NULL, then the bytes and a '\0'
+ * so that they are used in place.
+ */
+#define SNAPSHOT_MAGIC "NEUSNAP1"
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_NULL_STR UINT32_MAX
+
+typedef struct {
+    char     magic[8];
+    uint32_t version;
+    uint32_t crc; // of the payload
+    uint64_t generation;
+    uint64_t size; // of the payload
+} snapshot_header_t;
+
+typedef struct {
+    const char *   name;
+    uint32_t       interval;
+    uint32_t       n_tag;
+    const uint8_t *tags;
+} snapshot_group_t;
+
+typedef struct {
+    const char *      name;
+    int32_t           type;
+    int32_t           state;
+    const char *      plugin;
+    const char *      setting;
+    snapshot_group_t *groups;
+    uint32_t          n_group;
+    const uint8_t *   subs;
+    uint32_t          n_sub;
+    UT_hash_handle    hh;
+} snapshot_node_t;
+
+struct neu_snapshot {
+    uint8_t *        map;
+    size_t           size;
+    uint64_t         generation;
+    snapshot_node_t *nodes; // in database order
+    uint32_t         n_node;
+    snapshot_node_t *index; // by name
+};
+
+typedef struct {
+    const uint8_t *p;
+    const uint8_t *end;
+    bool           err;
+} cursor_t;
+
+static inline bool cursor_take(cursor_t *c, void *dst, size_t n)
+{
+    if (c->err || (size_t)(c->end - c->p) < n) {
+        c->err = true;
+        memset(dst, 0, n);
+        return false;
+    }
+
+    memcpy(dst, c->p, n);
+    c->p += n;
+    return true;
+}
+
+static inline uint32_t cursor_u32(cursor_t *c)
+{
+    uint32_t v = 0;
+    cursor_take(c, &v, sizeof(v));
+    return v;
+}
+
+static inline int32_t cursor_i32(cursor_t *c)
+{
+    int32_t v = 0;
+    cursor_take(c, &v, sizeof(v));
+    return v;
+}
+
+static inline double cursor_f64(cursor_t *c)
+{
+    double v = 0;
+    cursor_take(c, &v, sizeof(v));
+    return v;
+}
+
+static inline const char *cursor_str(cursor_t *c)
+{
+    uint32_t len = cursor_u32(c);
+
+    if (c->err || SNAPSHOT_NULL_STR == len) {
+        return NULL;
+    }
+
+    if ((size_t)(c->end - c->p) <= len || '\0' != c->p[len]) {
+        c->err = true;
+        return NULL;
+    }
+
+    const char *s = (const char *) c->p;
+    c->p += len + 1;
+    return s;
+}
+
+static void cursor_tag(cursor_t *c, neu_datatag_t *tag, const char **value)
+{
+    tag->name                 = (char *) cursor_str(c);
+    tag->address              = (char *) cursor_str(c);
+    tag->description          = (char *) cursor_str(c);
+    *value                    = cursor_str(c);
+    tag->attribute            = cursor_i32(c);
+    tag->precision            = cursor_i32(c);
+    tag->type                 = cursor_i32(c);
+    tag->decimal              = cursor_f64(c);
+    tag->report.deadband      = cursor_f64(c);
+    tag->report.deadband_type = cursor_i32(c);
+    tag->report.heartbeat     = cursor_u32(c);
+    tag->report.min_interval  = cursor_u32(c);
+}
+
+static void cursor_sub(cursor_t *c, const char **driver, const char **group,
+                       const char **params)
+{
+    *driver = cursor_str(c);
+    *group  = cursor_str(c);
+    *params = cursor_str(c);
+}
+
+typedef struct {
+    FILE *   fp;
+    uint32_t crc;
+    uint64_t size;
+    bool     err;
+} writer_t;
+
+static void put(writer_t *w, const void *data, size_t n)
+{
+    if (w->err || 0 == n) {
+        return;
+    }
+
+    if (1 != fwrite(data, n, 1, w->fp)) {
+        w->err = true;
+        return;
+    }
+
+    w->crc = crc32(w->crc, data, n);
+    w->size += n;
+}
+
+static inline void put_u32(writer_t *w, uint32_t v)
+{
+    put(w, &v, sizeof(v));
+}
+
+static inline void put_i32(writer_t *w, int32_t v)
+{
+    put(w, &v, sizeof(v));
+}
+
+static inline void put_f64(writer_t *w, double v)
+{
+    put(w, &v, sizeof(v));
+}
+
+static inline void put_str(writer_t *w, const char *s)
+{
+    if (NULL == s) {
+        put_u32(w, SNAPSHOT_NULL_STR);
+        return;
+    }
+
+    size_t len = strlen(s);
+    put_u32(w, len);
+    put(w, s, len + 1);
+}
+
+static inline const char *column_str(sqlite3_stmt *stmt, int col)
+{
+    return (const char *) sqlite3_column_text(stmt, col);
+}
+
+static sqlite3_stmt *prepare(sqlite3 *db, const char *sql)
+{
+    sqlite3_stmt *stmt = NULL;
+
+    if (SQLITE_OK != sqlite3_prepare_v2(db, sql, -1, &stmt, NULL)) {
+        nlog_error("prepare `%s` fail: %s", sql, sqlite3_errmsg(db));
+        return NULL;
+    }
+
+    return stmt;
+}
+
+// run `stmt` with `node` and optionally `group` bound, counting rows first
+static uint32_t count_rows(sqlite3_stmt *stmt, const char *node,
+                           const char *group)
+{
+    uint32_t n = 0;
+
+    sqlite3_reset(stmt);
+    sqlite3_bind_text(stmt, 1, node, -1, SQLITE_STATIC);
+    if (NULL != group) {
+        sqlite3_bind_text(stmt, 2, group, -1, SQLITE_STATIC);
+    }
+
+    while (SQLITE_ROW == sqlite3_step(stmt)) {
+        n += 1;
+    }
+
+    sqlite3_reset(stmt);
+    return n;
+}
+
+static int dump_tags(writer_t *w, sqlite3_stmt *stmt, const char *node,
+                     const char *group)
+{
+    put_u32(w, count_rows(stmt, node, group));
+
+    int step = sqlite3_step(stmt);
+    for (; SQLITE_ROW == step; step = sqlite3_step(stmt)) {
+        put_str(w, column_str(stmt, 0));
+        put_str(w, column_str(stmt, 1));
+        put_str(w, column_str(stmt, 6));
+        put_str(w, column_str(stmt, 7));
+        put_i32(w, sqlite3_column_int(stmt, 2));
+        put_i32(w, sqlite3_column_int(stmt, 3));
+        put_i32(w, sqlite3_column_int(stmt, 4));
+        put_f64(w, sqlite3_column_double(stmt, 5));
+        put_f64(w, sqlite3_column_double(stmt, 8));
+        put_i32(w, sqlite3_column_int(stmt, 9));
+        put_u32(w, sqlite3_column_int64(stmt, 10));
+        put_u32(w, sqlite3_column_int64(stmt, 11));
+    }
+
+    return SQLITE_DONE == step ? 0 : -1;
+}
+
+static int dump_node(writer_t *w, sqlite3_stmt *const *stmts,
+                     sqlite3_stmt *nodes)
+{
+    sqlite3_stmt *setting = stmts[0], *groups = stmts[1], *tags = stmts[2],
+                 *subs = stmts[3];
+    const char *name   = column_str(nodes, 0);
+    int         rv     = 0;
+
+    put_str(w, name);
+    put_i32(w, sqlite3_column_int(nodes, 1));
+    put_i32(w, sqlite3_column_int(nodes, 2));
+    put_str(w, column_str(nodes, 3));
+
+    sqlite3_reset(setting);
+    sqlite3_bind_text(setting, 1, name, -1, SQLITE_STATIC);
+    put_str(w,
+            SQLITE_ROW == sqlite3_step(setting) ? column_str(setting, 0)
+                                                : NULL);
+    sqlite3_reset(setting);
+
+    put_u32(w, count_rows(groups, name, NULL));
+    int step = sqlite3_step(groups);
+    for (; SQLITE_ROW == step && 0 == rv; step = sqlite3_step(groups)) {
+        const char *group = column_str(groups, 0);
+        put_str(w, group);
+        put_u32(w, sqlite3_column_int64(groups, 1));
+        rv = dump_tags(w, tags, name, group);
+    }
+    if (0 != rv || SQLITE_DONE != step) {
+        return -1;
+    }
+
+    put_u32(w, count_rows(subs, name, NULL));
+    step = sqlite3_step(subs);
+    for (; SQLITE_ROW == step; step = sqlite3_step(subs)) {
+        put_str(w, column_str(subs, 0));
+        put_str(w, column_str(subs, 1));
+        put_str(w, column_str(subs, 2));
+    }
+
+    return SQLITE_DONE == step ? 0 : -1;
+}
+
+static int dump(writer_t *w, sqlite3 *db)
+{
+    // same statements and so the same order as the persister loads
+    const char *sqls[] = {
+        "SELECT name, type, state, plugin_name FROM nodes;",
+        "SELECT setting FROM settings WHERE node_name=?",
+        "SELECT name, interval FROM groups WHERE driver_name=?",
+        "SELECT name, address, attribute, precision, type, "
+        "decimal, description, value, deadband, "
+        "deadband_type, heartbeat, min_interval "
+        "FROM tags WHERE driver_name=? AND group_name=? "
+        "ORDER BY rowid ASC",
+        "SELECT driver_name, group_name, params "
+        "FROM subscriptions WHERE app_name=?",
+    };
+    sqlite3_stmt *stmts[5] = { NULL };
+    int           rv       = 0;
+
+    for (size_t i = 0; i < 5; ++i) {
+        if (NULL == (stmts[i] = prepare(db, sqls[i]))) {
+            rv = -1;
+            goto end;
+        }
+    }
+
+    uint32_t n_node = 0;
+    while (SQLITE_ROW == sqlite3_step(stmts[0])) {
+        n_node += 1;
+    }
+    sqlite3_reset(stmts[0]);
+
+    put_u32(w, n_node);
+    int step = sqlite3_step(stmts[0]);
+    for (; SQLITE_ROW == step && 0 == rv; step = sqlite3_step(stmts[0])) {
+        rv = dump_node(w, &stmts[1], stmts[0]);
+    }
+    if (SQLITE_DONE != step && 0 == rv) {
+        rv = -1;
+    }
+
+    if (0 != rv) {
+        nlog_error("snapshot query fail: %s", sqlite3_errmsg(db));
+    }
+
+end:
+    for (size_t i = 0; i < 5; ++i) {
+        sqlite3_finalize(stmts[i]);
+    }
+    return rv;
+}
+
+int neu_snapshot_dump(sqlite3 *db, const char *path, uint64_t generation)
+{
+    char              tmp[256] = { 0 };
+    snapshot_header_t header   = { 0 };
+    writer_t          w        = { 0 };
+    int               rv       = 0;
+
+    if ((int) sizeof(tmp) <= snprintf(tmp, sizeof(tmp), "%s.tmp", path)) {
+        nlog_error("snapshot path too long: %s", path);
+        return -1;
+    }
+
+    w.fp = fopen(tmp, "wb");
+    if (NULL == w.fp) {
+        nlog_error("open %s fail: %s", tmp, strerror(errno));
+        return -1;
+    }
+
+    // header is written last, once the payload is known
+    w.crc = crc32(0, NULL, 0);
+    if (1 != fwrite(&header, sizeof(header), 1, w.fp)) {
+        w.err = true;
+    }
+
+    // one read transaction, for a consistent view of the tables
+    sqlite3_exec(db, "BEGIN", NULL, NULL, NULL);
+    rv = dump(&w, db);
+    sqlite3_exec(db, "COMMIT", NULL, NULL, NULL);
+
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version    = SNAPSHOT_VERSION;
+    header.crc        = w.crc;
+    header.generation = generation;
+    header.size       = w.size;
+
+    if (0 == rv && !w.err &&
+        (0 != fseek(w.fp, 0, SEEK_SET) ||
+         1 != fwrite(&header, sizeof(header), 1, w.fp) ||
+         0 != fflush(w.fp) || 0 != fsync(fileno(w.fp)))) {
+        w.err = true;
+    }
+
+    if (0 != fclose(w.fp)) {
+        w.err = true;
+    }
+
+    if (0 == rv && !w.err && 0 != rename(tmp, path)) {
+        w.err = true;
+    }
+
+    if (0 != rv || w.err) {
+        nlog_error("write snapshot %s fail: %s", path, strerror(errno));
+        unlink(tmp);
+        return -1;
+    }
+
+    nlog_notice("snapshot %s written, generation:%" PRIu64 " size:%" PRIu64,
+                path, generation, header.size);
+    return 0;
+}
+
+// walk the payload once, checking bounds and indexing nodes and groups
+static int snapshot_index(neu_snapshot_t *snapshot)
+{
+    cursor_t c = {
+        .p   = snapshot->map + sizeof(snapshot_header_t),
+        .end = snapshot->map + snapshot->size,
+    };
+
+    snapshot->n_node = cursor_u32(&c);
+    if (c.err || snapshot->n_node > snapshot->size) {
+        return -1;
+    }
+
+    snapshot->nodes = calloc(snapshot->n_node, sizeof(snapshot_node_t));
+    if (NULL == snapshot->nodes && snapshot->n_node > 0) {
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < snapshot->n_node && !c.err; ++i) {
+        snapshot_node_t *node = &snapshot->nodes[i];
+
+        node->name    = cursor_str(&c);
+        node->type    = cursor_i32(&c);
+        node->state   = cursor_i32(&c);
+        node->plugin  = cursor_str(&c);
+        node->setting = cursor_str(&c);
+        node->n_group = cursor_u32(&c);
+        if (c.err || NULL == node->name || node->n_group > snapshot->size) {
+            return -1;
+        }
+
+        node->groups = calloc(node->n_group, sizeof(snapshot_group_t));
+        if (NULL == node->groups && node->n_group > 0) {
+            return -1;
+        }
+
+        for (uint32_t j = 0; j < node->n_group && !c.err; ++j) {
+            snapshot_group_t *group = &node->groups[j];
+            neu_datatag_t     tag   = { 0 };
+            const char *      value = NULL;
+
+            group->name     = cursor_str(&c);
+            group->interval = cursor_u32(&c);
+            group->n_tag    = cursor_u32(&c);
+            group->tags     = c.p;
+            for (uint32_t k = 0; k < group->n_tag && !c.err; ++k) {
+                cursor_tag(&c, &tag, &value);
+            }
+        }
+
+        node->n_sub = cursor_u32(&c);
+        node->subs  = c.p;
+        for (uint32_t j = 0; j < node->n_sub && !c.err; ++j) {
+            const char *driver = NULL, *group = NULL, *params = NULL;
+            cursor_sub(&c, &driver, &group, &params);
+        }
+
+        HASH_ADD_KEYPTR(hh, snapshot->index, node->name, strlen(node->name),
+                        node);
+    }
+
+    return c.err || c.p != c.end ? -1 : 0;
+}
+
+neu_snapshot_t *neu_snapshot_open(const char *path, uint64_t generation)
+{
+    snapshot_header_t header   = { 0 };
+    neu_snapshot_t *  snapshot = NULL;
+    struct stat       st       = { 0 };
+    const char *      reason   = NULL;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        if (ENOENT != errno) {
+            nlog_warn("open snapshot %s fail: %s", path, strerror(errno));
+        }
+        return NULL;
+    }
+
+    if (0 != fstat(fd, &st) || (size_t) st.st_size < sizeof(header)) {
+        reason = "truncated";
+        goto error;
+    }
+
+    snapshot = calloc(1, sizeof(*snapshot));
+    if (NULL == snapshot) {
+        reason = "out of memory";
+        goto error;
+    }
+
+    snapshot->size = st.st_size;
+    snapshot->map  = mmap(NULL, snapshot->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (MAP_FAILED == snapshot->map) {
+        snapshot->map = NULL;
+        reason        = strerror(errno);
+        goto error;
+    }
+
+    // the whole file is read right away to check it
+    madvise(snapshot->map, snapshot->size, MADV_SEQUENTIAL | MADV_WILLNEED);
+    memcpy(&header, snapshot->map, sizeof(header));
+
+    if (0 != memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) ||
+        SNAPSHOT_VERSION != header.version) {
+        reason = "unknown format";
+        goto error;
+    }
+
+    if (header.generation != generation) {
+        reason = "stale";
+        goto error;
+    }
+
+    if (header.size != snapshot->size - sizeof(header) ||
+        header.crc !=
+            crc32(crc32(0, NULL, 0), snapshot->map + sizeof(header),
+                  header.size)) {
+        reason = "checksum mismatch";
+        goto error;
+    }
+
+    snapshot->generation = generation;
+    if (0 != snapshot_index(snapshot)) {
+        reason = "malformed";
+        goto error;
+    }
+
+    close(fd);
+    nlog_notice("snapshot %s mapped, generation:%" PRIu64 " nodes:%" PRIu32,
+                path, generation, snapshot->n_node);
+    return snapshot;
+
+error:
+    nlog_warn("ignore snapshot %s: %s", path, reason);
+    neu_snapshot_close(snapshot);
+    close(fd);
+    return NULL;
+}
+
+void neu_snapshot_close(neu_snapshot_t *snapshot)
+{
+    if (NULL == snapshot) {
+        return;
+    }
+
+    HASH_CLEAR(hh, snapshot->index);
+    for (uint32_t i = 0; NULL != snapshot->nodes && i < snapshot->n_node;
+         ++i) {
+        free(snapshot->nodes[i].groups);
+    }
+    free(snapshot->nodes);
+
+    if (NULL != snapshot->map) {
+        munmap(snapshot->map, snapshot->size);
+    }
+    free(snapshot);
+}
+
+uint64_t neu_snapshot_generation(const neu_snapshot_t *snapshot)
+{
+    return snapshot->generation;
+}
+
+static inline snapshot_node_t *find_node(neu_snapshot_t *snapshot,
+                                         const char *    name)
+{
+    snapshot_node_t *node = NULL;
+    HASH_FIND_STR(snapshot->index, name, node);
+    return node;
+}
+
+static inline char *dup_str(const char *s)
+{
+    return NULL == s ? NULL : strdup(s);
+}
+
+int neu_snapshot_load_nodes(neu_snapshot_t *snapshot, UT_array *node_infos)
+{
+    for (uint32_t i = 0; i < snapshot->n_node; ++i) {
+        const snapshot_node_t * node = &snapshot->nodes[i];
+        neu_persist_node_info_t info = {
+            .name        = strdup(node->name),
+            .type        = node->type,
+            .plugin_name = dup_str(node->plugin),
+            .state       = node->state,
+        };
+
+        if (NULL == info.name || NULL == info.plugin_name) {
+            // return partial result, as loading from the database does
+            neu_persist_node_info_fini(&info);
+            break;
+        }
+
+        utarray_push_back(node_infos, &info);
+    }
+
+    return 0;
+}
+
+int neu_snapshot_load_node_setting(neu_snapshot_t *snapshot, const char *node,
+                                   const char **const setting)
+{
+    snapshot_node_t *n = find_node(snapshot, node);
+
+    if (NULL == n || NULL == n->setting) {
+        return NEU_ERR_EINTERNAL;
+    }
+
+    char *s = strdup(n->setting);
+    if (NULL == s) {
+        nlog_error("strdup fail");
+        return NEU_ERR_EINTERNAL;
+    }
+
+    *setting = s;
+    return 0;
+}
+
+int neu_snapshot_load_groups(neu_snapshot_t *snapshot, const char *node,
+                             UT_array *group_infos)
+{
+    snapshot_node_t *n = find_node(snapshot, node);
+
+    for (uint32_t i = 0; NULL != n && i < n->n_group; ++i) {
+        neu_persist_group_info_t info = {
+            .interval = n->groups[i].interval,
+            .name     = strdup(n->groups[i].name),
+        };
+
+        if (NULL == info.name) {
+            break;
+        }
+
+        utarray_push_back(group_infos, &info);
+    }
+
+    return 0;
+}
+
+int neu_snapshot_load_tags(neu_snapshot_t *snapshot, const char *node,
+                           const char *group, UT_array *tags)
+{
+    snapshot_node_t * n = find_node(snapshot, node);
+    snapshot_group_t *g = NULL;
+
+    for (uint32_t i = 0; NULL != n && i < n->n_group; ++i) {
+        if (0 == strcmp(n->groups[i].name, group)) {
+            g = &n->groups[i];
+            break;
+        }
+    }
+
+    if (NULL == g) {
+        return 0;
+    }
+
+    cursor_t c = { .p = g->tags, .end = snapshot->map + snapshot->size };
+    for (uint32_t i = 0; i < g->n_tag; ++i) {
+        neu_datatag_t tag   = { 0 };
+        const char *  value = NULL;
+
+        cursor_tag(&c, &tag, &value);
+        utarray_push_back(tags, &tag);
+        if (neu_tag_attribute_test(&tag, NEU_ATTRIBUTE_STATIC)) {
+            neu_tag_load_static_value(utarray_back(tags), value);
+        }
+    }
+
+    return 0;
+}
+
+int neu_snapshot_load_subscriptions(neu_snapshot_t *snapshot, const char *app,
+                                    UT_array *subscription_infos)
+{
+    snapshot_node_t *n = find_node(snapshot, app);
+
+    if (NULL == n) {
+        return 0;
+    }
+
+    cursor_t c = { .p = n->subs, .end = snapshot->map + snapshot->size };
+    for (uint32_t i = 0; i < n->n_sub; ++i) {
+        const char *driver = NULL, *group = NULL, *params = NULL;
+
+        cursor_sub(&c, &driver, &group, &params);
+
+        neu_persist_subscription_info_t info = {
+            .driver_name = dup_str(driver),
+            .group_name  = dup_str(group),
+            .params      = dup_str(params),
+        };
+
+        if (NULL == info.driver_name || NULL == info.group_name ||
+            (NULL != params && NULL == info.params)) {
+            neu_persist_subscription_info_fini(&info);
+            break;
+        }
+
+        utarray_push_back(subscription_infos, &info);
+    }
+
+    return 0;
+}
@@ -0,0 +1,74 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#ifndef _NEU_PERSIST_SNAPSHOT_H_
+#define _NEU_PERSIST_SNAPSHOT_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#include <sqlite3.h>
+
+#include "utils/utextend.h"
+
+/*
+ * Binary snapshot of the node configuration: nodes, settings, groups, tags
+ * and subscriptions, in the order the database returns them.
+ *
+ * It is written from the database after changes are committed and mapped at
+ * startup, so that loading nodes reads records in place instead of running
+ * queries. The database stays the source of truth: a snapshot is only used
+ * when its checksum is intact and its generation matches the one stored in
+ * the database.
+ */
+typedef struct neu_snapshot neu_snapshot_t;
+
+/**
+ * Dump the configuration in `db` to `path`, atomically replacing it.
+ * @return 0 on success, -1 otherwise.
+ */
+int neu_snapshot_dump(sqlite3 *db, const char *path, uint64_t generation);
+
+/**
+ * Map snapshot `path` and check it.
+ * @return NULL if missing, corrupt or of another generation.
+ */
+neu_snapshot_t *neu_snapshot_open(const char *path, uint64_t generation);
+void            neu_snapshot_close(neu_snapshot_t *snapshot);
+uint64_t        neu_snapshot_generation(const neu_snapshot_t *snapshot);
+
+// push records to arrays of the matching neu_persist_*_info_t or tag icd
+int neu_snapshot_load_nodes(neu_snapshot_t *snapshot, UT_array *node_infos);
+int neu_snapshot_load_node_setting(neu_snapshot_t *snapshot, const char *node,
+                                   const char **const setting);
+int neu_snapshot_load_groups(neu_snapshot_t *snapshot, const char *node,
+                             UT_array *group_infos);
+int neu_snapshot_load_tags(neu_snapshot_t *snapshot, const char *node,
+                           const char *group, UT_array *tags);
+int neu_snapshot_load_subscriptions(neu_snapshot_t *snapshot, const char *app,
+                                    UT_array *subscription_infos);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
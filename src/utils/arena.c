@@ -0,0 +1,165 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils/arena.h"
+
+#define ARENA_ALIGN 8
+
+typedef struct arena_block {
+    struct arena_block *next;
+    size_t              size;
+    size_t              used;
+    uint8_t             data[];
+} arena_block_t;
+
+struct neu_arena {
+    arena_block_t *head; // blocks being filled first, the oldest last
+    size_t         block_size;
+    size_t         used;
+    size_t         size;
+};
+
+static arena_block_t *block_new(neu_arena_t *arena, size_t size)
+{
+    arena_block_t *block = malloc(sizeof(arena_block_t) + size);
+    if (NULL == block) {
+        return NULL;
+    }
+
+    block->size = size;
+    block->used = 0;
+    arena->size += size;
+    return block;
+}
+
+neu_arena_t *neu_arena_new(size_t block_size)
+{
+    neu_arena_t *arena = calloc(1, sizeof(neu_arena_t));
+    if (NULL == arena) {
+        return NULL;
+    }
+
+    arena->block_size = block_size < 256 ? 256 : block_size;
+    return arena;
+}
+
+void neu_arena_free(neu_arena_t *arena)
+{
+    if (NULL == arena) {
+        return;
+    }
+
+    arena_block_t *block = arena->head;
+    while (block) {
+        arena_block_t *next = block->next;
+        free(block);
+        block = next;
+    }
+    free(arena);
+}
+
+void *neu_arena_alloc(neu_arena_t *arena, size_t size)
+{
+    arena_block_t *block = arena->head;
+
+    size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+
+    if (size > arena->block_size / 4) {
+        // behind the head, so that it keeps filling the current block
+        arena_block_t *big = block_new(arena, size);
+        if (NULL == big) {
+            return NULL;
+        }
+        big->used = size;
+        if (block) {
+            big->next   = block->next;
+            block->next = big;
+        } else {
+            big->next   = NULL;
+            arena->head = big;
+        }
+        arena->used += size;
+        return big->data;
+    }
+
+    if (NULL == block || block->size - block->used < size) {
+        block = block_new(arena, arena->block_size);
+        if (NULL == block) {
+            return NULL;
+        }
+        block->next = arena->head;
+        arena->head = block;
+    }
+
+    void *ptr = block->data + block->used;
+    block->used += size;
+    arena->used += size;
+    return ptr;
+}
+
+char *neu_arena_strdup(neu_arena_t *arena, const char *str)
+{
+    size_t len = strlen(str) + 1;
+    char * dst = neu_arena_alloc(arena, len);
+
+    if (dst) {
+        memcpy(dst, str, len);
+    }
+    return dst;
+}
+
+void neu_arena_reset(neu_arena_t *arena)
+{
+    arena_block_t *keep  = NULL;
+    arena_block_t *block = arena->head;
+
+    // keep the oldest block of the regular size, it is the last of the list
+    while (block) {
+        arena_block_t *next = block->next;
+        if (NULL == next && block->size == arena->block_size) {
+            keep = block;
+        } else {
+            free(block);
+        }
+        block = next;
+    }
+
+    arena->head = keep;
+    arena->used = 0;
+    arena->size = 0;
+    if (keep) {
+        keep->used  = 0;
+        keep->next  = NULL;
+        arena->size = keep->size;
+    }
+}
+
+size_t neu_arena_used(const neu_arena_t *arena)
+{
+    return arena->used;
+}
+
+size_t neu_arena_size(const neu_arena_t *arena)
+{
+    return arena->size;
+}
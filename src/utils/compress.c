@@ -0,0 +1,96 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#include <limits.h>
+#include <stdbool.h>
+
+#include <zlib.h>
+
+#include "utils/compress.h"
+
+// 15 bits window, plus 16 to write a gzip instead of a zlib wrapper
+#define GZIP_WINDOW_BITS (15 + 16)
+#define DEFAULT_MEM_LEVEL 8
+
+struct neu_deflate {
+    z_stream strm;
+};
+
+neu_deflate_t *neu_deflate_new(int level)
+{
+    if (level < NEU_DEFLATE_LEVEL_MIN || level > NEU_DEFLATE_LEVEL_MAX) {
+        return NULL;
+    }
+
+    neu_deflate_t *d = calloc(1, sizeof(*d));
+    if (NULL == d) {
+        return NULL;
+    }
+
+    if (Z_OK !=
+        deflateInit2(&d->strm, level, Z_DEFLATED, GZIP_WINDOW_BITS,
+                     DEFAULT_MEM_LEVEL, Z_DEFAULT_STRATEGY)) {
+        free(d);
+        return NULL;
+    }
+
+    return d;
+}
+
+void neu_deflate_free(neu_deflate_t *d)
+{
+    if (NULL != d) {
+        deflateEnd(&d->strm);
+        free(d);
+    }
+}
+
+int neu_deflate(neu_deflate_t *d, const void *in, size_t len, uint8_t **out,
+                size_t *out_len)
+{
+    if (len > UINT_MAX) {
+        return -1;
+    }
+
+    // bound accounts for the gzip wrapper, a single deflate call suffices
+    size_t   bound = deflateBound(&d->strm, len);
+    uint8_t *buf   = malloc(bound);
+    if (NULL == buf) {
+        return -1;
+    }
+
+    d->strm.next_in   = (Bytef *) in;
+    d->strm.avail_in  = len;
+    d->strm.next_out  = buf;
+    d->strm.avail_out = bound;
+
+    int  rv = deflate(&d->strm, Z_FINISH);
+    bool ok = Z_STREAM_END == rv;
+
+    *out_len = d->strm.total_out;
+    deflateReset(&d->strm);
+
+    if (!ok) {
+        free(buf);
+        return -1;
+    }
+
+    *out = buf;
+    return 0;
+}
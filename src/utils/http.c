@@ -288,6 +288,7 @@ int neu_http_response(nng_aio *aio, neu_err_code_e code, char *content)
     case NEU_ERR_LICENSE_DISABLED:
     case NEU_ERR_LICENSE_MAX_NODES:
     case NEU_ERR_LICENSE_MAX_TAGS:
+    case NEU_ERR_NODE_MEMORY_LIMIT:
     case NEU_ERR_LICENSE_TOKEN_NOT_MATCH:
     case NEU_ERR_GROUP_ALREADY_SUBSCRIBED:
     case NEU_ERR_PLUGIN_TAG_TYPE_MISMATCH:
@@ -0,0 +1,525 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "json/json_writer.h"
+
+#define WRITER_DEFAULT_CAP 256
+
+static const char digits_lut[] = "00010203040506070809"
+                                 "10111213141516171819"
+                                 "20212223242526272829"
+                                 "30313233343536373839"
+                                 "40414243444546474849"
+                                 "50515253545556575859"
+                                 "60616263646566676869"
+                                 "70717273747576777879"
+                                 "80818283848586878889"
+                                 "90919293949596979899";
+
+static const uint64_t pow10_lut[] = {
+    1ULL,
+    10ULL,
+    100ULL,
+    1000ULL,
+    10000ULL,
+    100000ULL,
+    1000000ULL,
+    10000000ULL,
+    100000000ULL,
+    1000000000ULL,
+    10000000000ULL,
+    100000000000ULL,
+    1000000000000ULL,
+    10000000000000ULL,
+    100000000000000ULL,
+    1000000000000000ULL,
+};
+
+// doubles below 2^53 hold integers exactly
+#define EXACT_INTEGER_LIMIT 9007199254740992.0
+
+static inline bool reserve(neu_json_writer_t *w, size_t n)
+{
+    if (w->error) {
+        return false;
+    }
+
+    // always keep one spare byte for the terminating NUL
+    if (NULL != w->buf && w->len + n + 1 <= w->cap) {
+        return true;
+    }
+
+    size_t cap = w->cap > 0 ? w->cap : WRITER_DEFAULT_CAP;
+    while (cap < w->len + n + 1) {
+        cap *= 2;
+    }
+
+    char *buf = realloc(w->buf, cap);
+    if (NULL == buf) {
+        w->error = true;
+        return false;
+    }
+
+    w->buf = buf;
+    w->cap = cap;
+    return true;
+}
+
+static inline void put_c(neu_json_writer_t *w, char c)
+{
+    if (reserve(w, 1)) {
+        w->buf[w->len++] = c;
+    }
+}
+
+static inline void put_n(neu_json_writer_t *w, const char *s, size_t n)
+{
+    if (n > 0 && reserve(w, n)) {
+        memcpy(w->buf + w->len, s, n);
+        w->len += n;
+    }
+}
+
+#define PUT_LITERAL(w, s) put_n(w, s, sizeof(s) - 1)
+
+// write value separator if needed
+static inline void sep(neu_json_writer_t *w)
+{
+    uint32_t bit = 1U << w->depth;
+
+    if (w->key) {
+        w->key = false;
+    } else if (w->first & bit) {
+        w->first &= ~bit;
+    } else {
+        put_c(w, ',');
+    }
+}
+
+// format `v` backwards ending at `end`, return pointer to the first digit
+static inline char *format_u64(uint64_t v, char *end)
+{
+    char *p = end;
+
+    while (v >= 100) {
+        unsigned i = (v % 100) * 2;
+        v /= 100;
+        p -= 2;
+        memcpy(p, digits_lut + i, 2);
+    }
+
+    if (v < 10) {
+        *--p = '0' + v;
+    } else {
+        p -= 2;
+        memcpy(p, digits_lut + v * 2, 2);
+    }
+
+    return p;
+}
+
+static inline void put_u64(neu_json_writer_t *w, uint64_t v, bool neg)
+{
+    char  tmp[24];
+    char *end = tmp + sizeof(tmp);
+    char *p   = format_u64(v, end);
+
+    if (neg) {
+        *--p = '-';
+    }
+    put_n(w, p, end - p);
+}
+
+static void put_string(neu_json_writer_t *w, const char *s)
+{
+    static const char    hex[] = "0123456789abcdef";
+    const unsigned char *p     = (const unsigned char *) s;
+    const unsigned char *start = p;
+
+    put_c(w, '"');
+    for (; *p; ++p) {
+        if (*p >= 0x20 && '"' != *p && '\\' != *p) {
+            continue;
+        }
+
+        put_n(w, (const char *) start, p - start);
+        start = p + 1;
+
+        switch (*p) {
+        case '"':
+            PUT_LITERAL(w, "\\\"");
+            break;
+        case '\\':
+            PUT_LITERAL(w, "\\\\");
+            break;
+        case '\b':
+            PUT_LITERAL(w, "\\b");
+            break;
+        case '\f':
+            PUT_LITERAL(w, "\\f");
+            break;
+        case '\n':
+            PUT_LITERAL(w, "\\n");
+            break;
+        case '\r':
+            PUT_LITERAL(w, "\\r");
+            break;
+        case '\t':
+            PUT_LITERAL(w, "\\t");
+            break;
+        default: {
+            char u[6] = { '\\', 'u', '0', '0', hex[*p >> 4], hex[*p & 0xF] };
+            put_n(w, u, sizeof(u));
+            break;
+        }
+        }
+    }
+    put_n(w, (const char *) start, p - start);
+    put_c(w, '"');
+}
+
+void neu_json_writer_init(neu_json_writer_t *w, size_t cap)
+{
+    memset(w, 0, sizeof(*w));
+    w->cap   = cap;
+    w->first = 1;
+}
+
+void neu_json_writer_fini(neu_json_writer_t *w)
+{
+    free(w->buf);
+    memset(w, 0, sizeof(*w));
+}
+
+void neu_json_writer_reset(neu_json_writer_t *w)
+{
+    w->len   = 0;
+    w->error = false;
+    w->key   = false;
+    w->depth = 0;
+    w->first = 1;
+}
+
+const char *neu_json_writer_str(neu_json_writer_t *w)
+{
+    if (!reserve(w, 0)) {
+        return NULL;
+    }
+
+    w->buf[w->len] = '\0';
+    return w->buf;
+}
+
+size_t neu_json_writer_len(const neu_json_writer_t *w)
+{
+    return w->len;
+}
+
+char *neu_json_writer_detach(neu_json_writer_t *w)
+{
+    char *buf = (char *) neu_json_writer_str(w);
+
+    if (NULL == buf) {
+        return NULL;
+    }
+
+    // keep capacity as a hint for the next buffer
+    w->buf = NULL;
+    neu_json_writer_reset(w);
+    return buf;
+}
+
+static inline void container_begin(neu_json_writer_t *w, char c)
+{
+    sep(w);
+    if (w->depth + 1 >= NEU_JSON_WRITER_MAX_DEPTH) {
+        w->error = true;
+        return;
+    }
+    put_c(w, c);
+    w->depth += 1;
+    w->first |= 1U << w->depth;
+}
+
+static inline void container_end(neu_json_writer_t *w, char c)
+{
+    if (w->depth > 0) {
+        w->depth -= 1;
+    }
+    put_c(w, c);
+}
+
+void neu_json_writer_object_begin(neu_json_writer_t *w)
+{
+    container_begin(w, '{');
+}
+
+void neu_json_writer_object_end(neu_json_writer_t *w)
+{
+    container_end(w, '}');
+}
+
+void neu_json_writer_array_begin(neu_json_writer_t *w)
+{
+    container_begin(w, '[');
+}
+
+void neu_json_writer_array_end(neu_json_writer_t *w)
+{
+    container_end(w, ']');
+}
+
+void neu_json_writer_key(neu_json_writer_t *w, const char *key)
+{
+    sep(w);
+    put_string(w, key);
+    put_c(w, ':');
+    w->key = true;
+}
+
+void neu_json_writer_null(neu_json_writer_t *w)
+{
+    sep(w);
+    PUT_LITERAL(w, "null");
+}
+
+void neu_json_writer_bool(neu_json_writer_t *w, bool v)
+{
+    sep(w);
+    if (v) {
+        PUT_LITERAL(w, "true");
+    } else {
+        PUT_LITERAL(w, "false");
+    }
+}
+
+void neu_json_writer_int(neu_json_writer_t *w, int64_t v)
+{
+    sep(w);
+    // negate in unsigned arithmetic to cope with INT64_MIN
+    put_u64(w, v < 0 ? 0 - (uint64_t) v : (uint64_t) v, v < 0);
+}
+
+void neu_json_writer_uint(neu_json_writer_t *w, uint64_t v)
+{
+    sep(w);
+    put_u64(w, v, false);
+}
+
+void neu_json_writer_str_value(neu_json_writer_t *w, const char *s)
+{
+    sep(w);
+    put_string(w, s);
+}
+
+static void put_fixed(neu_json_writer_t *w, double v, uint8_t precision)
+{
+    double scaled = v * (double) pow10_lut[precision];
+
+    if (fabs(scaled) >= EXACT_INTEGER_LIMIT) {
+        char tmp[512];
+        int  n = snprintf(tmp, sizeof(tmp), "%.*f", precision, v);
+        put_n(w, tmp, n < (int) sizeof(tmp) ? n : (int) sizeof(tmp) - 1);
+        return;
+    }
+
+    bool     neg = scaled < 0;
+    uint64_t u   = (uint64_t) llround(fabs(scaled));
+    char     tmp[48];
+    char *   end = tmp + sizeof(tmp);
+    char *   p   = format_u64(u % pow10_lut[precision], end);
+
+    // zero pad the fraction
+    while (end - p < precision) {
+        *--p = '0';
+    }
+    *--p = '.';
+    p    = format_u64(u / pow10_lut[precision], p);
+    if (neg && 0 != u) {
+        *--p = '-';
+    }
+
+    put_n(w, p, end - p);
+}
+
+static void put_shortest(neu_json_writer_t *w, double v)
+{
+    if (fabs(v) < 1e15 && v == (double) (int64_t) v) {
+        put_u64(w, fabs(v), signbit(v));
+        PUT_LITERAL(w, ".0");
+        return;
+    }
+
+    // same as jansson dumping with JSON_REAL_PRECISION(16)
+    char tmp[32];
+    int  n = snprintf(tmp, sizeof(tmp), "%.16g", v);
+    put_n(w, tmp, n);
+    if (NULL == memchr(tmp, '.', n) && NULL == memchr(tmp, 'e', n)) {
+        PUT_LITERAL(w, ".0");
+    }
+}
+
+void neu_json_writer_double(neu_json_writer_t *w, double v, uint8_t precision)
+{
+    sep(w);
+
+    if (!isfinite(v)) {
+        PUT_LITERAL(w, "null");
+    } else if (0 == precision) {
+        put_shortest(w, v);
+    } else if (precision < sizeof(pow10_lut) / sizeof(pow10_lut[0])) {
+        put_fixed(w, v, precision);
+    } else {
+        char tmp[512];
+        int  n = snprintf(tmp, sizeof(tmp), "%.*f", precision, v);
+        put_n(w, tmp, n < (int) sizeof(tmp) ? n : (int) sizeof(tmp) - 1);
+    }
+}
+
+static inline bool has_json_value(neu_type_e type)
+{
+    switch (type) {
+    case NEU_TYPE_INT8:
+    case NEU_TYPE_UINT8:
+    case NEU_TYPE_INT16:
+    case NEU_TYPE_UINT16:
+    case NEU_TYPE_INT32:
+    case NEU_TYPE_UINT32:
+    case NEU_TYPE_INT64:
+    case NEU_TYPE_UINT64:
+    case NEU_TYPE_FLOAT:
+    case NEU_TYPE_DOUBLE:
+    case NEU_TYPE_BIT:
+    case NEU_TYPE_BOOL:
+    case NEU_TYPE_STRING:
+    case NEU_TYPE_ERROR:
+    case NEU_TYPE_WORD:
+    case NEU_TYPE_DWORD:
+    case NEU_TYPE_LWORD:
+        return true;
+    case NEU_TYPE_BYTES:
+    default:
+        return false;
+    }
+}
+
+int neu_json_writer_tag_value(neu_json_writer_t *w, const neu_dvalue_t *value)
+{
+    switch (value->type) {
+    case NEU_TYPE_INT8:
+        neu_json_writer_int(w, value->value.i8);
+        break;
+    case NEU_TYPE_UINT8:
+    case NEU_TYPE_BIT:
+        neu_json_writer_uint(w, value->value.u8);
+        break;
+    case NEU_TYPE_INT16:
+        neu_json_writer_int(w, value->value.i16);
+        break;
+    case NEU_TYPE_WORD:
+    case NEU_TYPE_UINT16:
+        neu_json_writer_uint(w, value->value.u16);
+        break;
+    case NEU_TYPE_INT32:
+    case NEU_TYPE_ERROR:
+        neu_json_writer_int(w, value->value.i32);
+        break;
+    case NEU_TYPE_DWORD:
+    case NEU_TYPE_UINT32:
+        neu_json_writer_uint(w, value->value.u32);
+        break;
+    case NEU_TYPE_INT64:
+        neu_json_writer_int(w, value->value.i64);
+        break;
+    case NEU_TYPE_LWORD:
+    case NEU_TYPE_UINT64:
+        neu_json_writer_uint(w, value->value.u64);
+        break;
+    case NEU_TYPE_FLOAT:
+        neu_json_writer_double(w, value->value.f32, value->precision);
+        break;
+    case NEU_TYPE_DOUBLE:
+        neu_json_writer_double(w, value->value.d64, value->precision);
+        break;
+    case NEU_TYPE_BOOL:
+        neu_json_writer_bool(w, value->value.boolean);
+        break;
+    case NEU_TYPE_STRING:
+        neu_json_writer_str_value(w, value->value.str);
+        break;
+    case NEU_TYPE_BYTES:
+    default:
+        return -1;
+    }
+
+    return 0;
+}
+
+void neu_json_writer_tags_values(neu_json_writer_t *         w,
+                                 const neu_resp_tag_value_t *tags, uint32_t n)
+{
+    neu_json_writer_key(w, "values");
+    neu_json_writer_object_begin(w);
+    for (uint32_t i = 0; i < n; ++i) {
+        if (NEU_TYPE_ERROR != tags[i].value.type &&
+            has_json_value(tags[i].value.type)) {
+            neu_json_writer_key(w, tags[i].tag);
+            neu_json_writer_tag_value(w, &tags[i].value);
+        }
+    }
+    neu_json_writer_object_end(w);
+
+    neu_json_writer_key(w, "errors");
+    neu_json_writer_object_begin(w);
+    for (uint32_t i = 0; i < n; ++i) {
+        if (NEU_TYPE_ERROR == tags[i].value.type) {
+            neu_json_writer_key(w, tags[i].tag);
+            neu_json_writer_int(w, tags[i].value.value.i32);
+        }
+    }
+    neu_json_writer_object_end(w);
+}
+
+void neu_json_writer_tags_array(neu_json_writer_t *         w,
+                                const neu_resp_tag_value_t *tags, uint32_t n)
+{
+    neu_json_writer_key(w, "tags");
+    neu_json_writer_array_begin(w);
+    for (uint32_t i = 0; i < n; ++i) {
+        if (!has_json_value(tags[i].value.type)) {
+            continue;
+        }
+
+        neu_json_writer_object_begin(w);
+        neu_json_writer_key(w, "name");
+        neu_json_writer_str_value(w, tags[i].tag);
+        if (NEU_TYPE_ERROR == tags[i].value.type) {
+            neu_json_writer_key(w, "error");
+        } else {
+            neu_json_writer_key(w, "value");
+        }
+        neu_json_writer_tag_value(w, &tags[i].value);
+        neu_json_writer_object_end(w);
+    }
+    neu_json_writer_array_end(w);
+}
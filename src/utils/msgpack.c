@@ -0,0 +1,479 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#include <string.h>
+
+#include "utils/msgpack.h"
+
+#define WRITER_DEFAULT_CAP 256
+
+static inline bool reserve(neu_msgpack_writer_t *w, size_t n)
+{
+    if (w->error) {
+        return false;
+    }
+
+    if (NULL != w->buf && w->len + n <= w->cap) {
+        return true;
+    }
+
+    size_t cap = w->cap > 0 ? w->cap : WRITER_DEFAULT_CAP;
+    while (cap < w->len + n) {
+        cap *= 2;
+    }
+
+    uint8_t *buf = realloc(w->buf, cap);
+    if (NULL == buf) {
+        w->error = true;
+        return false;
+    }
+
+    w->buf = buf;
+    w->cap = cap;
+    return true;
+}
+
+static inline void put_u8(neu_msgpack_writer_t *w, uint8_t v)
+{
+    if (reserve(w, 1)) {
+        w->buf[w->len++] = v;
+    }
+}
+
+// marker followed by `n` bytes of `v` in big endian
+static inline void put_be(neu_msgpack_writer_t *w, uint8_t marker, uint64_t v,
+                          int n)
+{
+    if (reserve(w, 1 + n)) {
+        uint8_t *p = w->buf + w->len;
+
+        p[0] = marker;
+        for (int i = n; i > 0; --i) {
+            p[i] = v & 0xFF;
+            v >>= 8;
+        }
+        w->len += 1 + n;
+    }
+}
+
+void neu_msgpack_writer_init(neu_msgpack_writer_t *w, size_t cap)
+{
+    memset(w, 0, sizeof(*w));
+    w->cap = cap;
+}
+
+void neu_msgpack_writer_fini(neu_msgpack_writer_t *w)
+{
+    free(w->buf);
+    memset(w, 0, sizeof(*w));
+}
+
+void neu_msgpack_writer_reset(neu_msgpack_writer_t *w)
+{
+    w->len   = 0;
+    w->error = false;
+}
+
+size_t neu_msgpack_writer_len(const neu_msgpack_writer_t *w)
+{
+    return w->len;
+}
+
+uint8_t *neu_msgpack_writer_detach(neu_msgpack_writer_t *w)
+{
+    uint8_t *buf = w->buf;
+
+    if (w->error || NULL == buf) {
+        return NULL;
+    }
+
+    // keep capacity as a hint for the next buffer
+    w->buf = NULL;
+    neu_msgpack_writer_reset(w);
+    return buf;
+}
+
+static inline void put_header(neu_msgpack_writer_t *w, uint8_t fix,
+                              uint8_t fix_max, uint8_t m16, uint8_t m32,
+                              uint32_t n)
+{
+    if (n <= fix_max) {
+        put_u8(w, fix | n);
+    } else if (n <= UINT16_MAX) {
+        put_be(w, m16, n, 2);
+    } else {
+        put_be(w, m32, n, 4);
+    }
+}
+
+void neu_msgpack_write_map(neu_msgpack_writer_t *w, uint32_t n)
+{
+    put_header(w, 0x80, 15, 0xde, 0xdf, n);
+}
+
+void neu_msgpack_write_array(neu_msgpack_writer_t *w, uint32_t n)
+{
+    put_header(w, 0x90, 15, 0xdc, 0xdd, n);
+}
+
+void neu_msgpack_write_nil(neu_msgpack_writer_t *w)
+{
+    put_u8(w, 0xc0);
+}
+
+void neu_msgpack_write_bool(neu_msgpack_writer_t *w, bool v)
+{
+    put_u8(w, v ? 0xc3 : 0xc2);
+}
+
+void neu_msgpack_write_uint(neu_msgpack_writer_t *w, uint64_t v)
+{
+    if (v <= 0x7F) {
+        put_u8(w, (uint8_t) v);
+    } else if (v <= UINT8_MAX) {
+        put_be(w, 0xcc, v, 1);
+    } else if (v <= UINT16_MAX) {
+        put_be(w, 0xcd, v, 2);
+    } else if (v <= UINT32_MAX) {
+        put_be(w, 0xce, v, 4);
+    } else {
+        put_be(w, 0xcf, v, 8);
+    }
+}
+
+void neu_msgpack_write_int(neu_msgpack_writer_t *w, int64_t v)
+{
+    if (v >= 0) {
+        neu_msgpack_write_uint(w, v);
+    } else if (v >= -32) {
+        put_u8(w, (uint8_t) v);
+    } else if (v >= INT8_MIN) {
+        put_be(w, 0xd0, (uint64_t) v, 1);
+    } else if (v >= INT16_MIN) {
+        put_be(w, 0xd1, (uint64_t) v, 2);
+    } else if (v >= INT32_MIN) {
+        put_be(w, 0xd2, (uint64_t) v, 4);
+    } else {
+        put_be(w, 0xd3, (uint64_t) v, 8);
+    }
+}
+
+void neu_msgpack_write_float(neu_msgpack_writer_t *w, float v)
+{
+    uint32_t bits = 0;
+
+    memcpy(&bits, &v, sizeof(bits));
+    put_be(w, 0xca, bits, 4);
+}
+
+void neu_msgpack_write_double(neu_msgpack_writer_t *w, double v)
+{
+    uint64_t bits = 0;
+
+    memcpy(&bits, &v, sizeof(bits));
+    put_be(w, 0xcb, bits, 8);
+}
+
+void neu_msgpack_write_str(neu_msgpack_writer_t *w, const char *s)
+{
+    size_t n = strlen(s);
+
+    if (n <= 31) {
+        put_u8(w, 0xa0 | n);
+    } else if (n <= UINT8_MAX) {
+        put_be(w, 0xd9, n, 1);
+    } else if (n <= UINT16_MAX) {
+        put_be(w, 0xda, n, 2);
+    } else {
+        put_be(w, 0xdb, n, 4);
+    }
+
+    if (n > 0 && reserve(w, n)) {
+        memcpy(w->buf + w->len, s, n);
+        w->len += n;
+    }
+}
+
+int neu_msgpack_write_tag_value(neu_msgpack_writer_t *w,
+                                const neu_dvalue_t *  value)
+{
+    switch (value->type) {
+    case NEU_TYPE_INT8:
+        neu_msgpack_write_int(w, value->value.i8);
+        break;
+    case NEU_TYPE_UINT8:
+    case NEU_TYPE_BIT:
+        neu_msgpack_write_uint(w, value->value.u8);
+        break;
+    case NEU_TYPE_INT16:
+        neu_msgpack_write_int(w, value->value.i16);
+        break;
+    case NEU_TYPE_WORD:
+    case NEU_TYPE_UINT16:
+        neu_msgpack_write_uint(w, value->value.u16);
+        break;
+    case NEU_TYPE_INT32:
+    case NEU_TYPE_ERROR:
+        neu_msgpack_write_int(w, value->value.i32);
+        break;
+    case NEU_TYPE_DWORD:
+    case NEU_TYPE_UINT32:
+        neu_msgpack_write_uint(w, value->value.u32);
+        break;
+    case NEU_TYPE_INT64:
+        neu_msgpack_write_int(w, value->value.i64);
+        break;
+    case NEU_TYPE_LWORD:
+    case NEU_TYPE_UINT64:
+        neu_msgpack_write_uint(w, value->value.u64);
+        break;
+    case NEU_TYPE_FLOAT:
+        neu_msgpack_write_float(w, value->value.f32);
+        break;
+    case NEU_TYPE_DOUBLE:
+        neu_msgpack_write_double(w, value->value.d64);
+        break;
+    case NEU_TYPE_BOOL:
+        neu_msgpack_write_bool(w, value->value.boolean);
+        break;
+    case NEU_TYPE_STRING:
+        neu_msgpack_write_str(w, value->value.str);
+        break;
+    case NEU_TYPE_BYTES:
+    default:
+        return -1;
+    }
+
+    return 0;
+}
+
+static inline bool has_msgpack_value(neu_type_e type)
+{
+    return NEU_TYPE_BYTES != type;
+}
+
+void neu_msgpack_write_tags_values(neu_msgpack_writer_t *      w,
+                                   const neu_resp_tag_value_t *tags, uint32_t n)
+{
+    uint32_t n_value = 0;
+    uint32_t n_error = 0;
+
+    // map headers carry the count, so tally before writing
+    for (uint32_t i = 0; i < n; ++i) {
+        if (NEU_TYPE_ERROR == tags[i].value.type) {
+            n_error += 1;
+        } else if (has_msgpack_value(tags[i].value.type)) {
+            n_value += 1;
+        }
+    }
+
+    neu_msgpack_write_str(w, "values");
+    neu_msgpack_write_map(w, n_value);
+    for (uint32_t i = 0; i < n; ++i) {
+        if (NEU_TYPE_ERROR != tags[i].value.type &&
+            has_msgpack_value(tags[i].value.type)) {
+            neu_msgpack_write_str(w, tags[i].tag);
+            neu_msgpack_write_tag_value(w, &tags[i].value);
+        }
+    }
+
+    neu_msgpack_write_str(w, "errors");
+    neu_msgpack_write_map(w, n_error);
+    for (uint32_t i = 0; i < n; ++i) {
+        if (NEU_TYPE_ERROR == tags[i].value.type) {
+            neu_msgpack_write_str(w, tags[i].tag);
+            neu_msgpack_write_int(w, tags[i].value.value.i32);
+        }
+    }
+}
+
+void neu_msgpack_reader_init(neu_msgpack_reader_t *r, const void *buf,
+                             size_t len)
+{
+    r->p   = buf;
+    r->end = r->p + len;
+}
+
+static inline int get_be(neu_msgpack_reader_t *r, int n, uint64_t *v)
+{
+    if (r->end - r->p < n) {
+        return -1;
+    }
+
+    *v = 0;
+    for (uint32_t i = 0; i < n; ++i) {
+        *v = (*v << 8) | r->p[i];
+    }
+    r->p += n;
+    return 0;
+}
+
+static inline int get_str(neu_msgpack_reader_t *r, uint64_t len,
+                          neu_msgpack_value_t *v)
+{
+    if ((uint64_t)(r->end - r->p) < len) {
+        return -1;
+    }
+
+    v->type      = NEU_MSGPACK_STR;
+    v->v.str.ptr = (const char *) r->p;
+    v->v.str.len = (uint32_t) len;
+    r->p += len;
+    return 0;
+}
+
+// sign extend the low `n` bytes of `v`
+static inline int64_t sext(uint64_t v, int n)
+{
+    int shift = 64 - n * 8;
+    return (int64_t)(v << shift) >> shift;
+}
+
+int neu_msgpack_read(neu_msgpack_reader_t *r, neu_msgpack_value_t *v)
+{
+    uint64_t u = 0;
+
+    if (r->p >= r->end) {
+        return -1;
+    }
+
+    uint8_t m = *r->p++;
+
+    if (m <= 0x7f) {
+        v->type  = NEU_MSGPACK_UINT;
+        v->v.u64 = m;
+        return 0;
+    }
+    if (m >= 0xe0) {
+        v->type  = NEU_MSGPACK_INT;
+        v->v.i64 = (int8_t) m;
+        return 0;
+    }
+    if ((m & 0xf0) == 0x80) {
+        v->type = NEU_MSGPACK_MAP;
+        v->v.n  = m & 0x0f;
+        return 0;
+    }
+    if ((m & 0xf0) == 0x90) {
+        v->type = NEU_MSGPACK_ARRAY;
+        v->v.n  = m & 0x0f;
+        return 0;
+    }
+    if ((m & 0xe0) == 0xa0) {
+        return get_str(r, m & 0x1f, v);
+    }
+
+    switch (m) {
+    case 0xc0:
+        v->type = NEU_MSGPACK_NIL;
+        return 0;
+    case 0xc2:
+    case 0xc3:
+        v->type      = NEU_MSGPACK_BOOL;
+        v->v.boolean = 0xc3 == m;
+        return 0;
+    case 0xcc:
+    case 0xcd:
+    case 0xce:
+    case 0xcf:
+        v->type = NEU_MSGPACK_UINT;
+        return get_be(r, 1 << (m - 0xcc), &v->v.u64);
+    case 0xd0:
+    case 0xd1:
+    case 0xd2:
+    case 0xd3: {
+        int n = 1 << (m - 0xd0);
+
+        if (0 != get_be(r, n, &u)) {
+            return -1;
+        }
+        v->type  = NEU_MSGPACK_INT;
+        v->v.i64 = sext(u, n);
+        return 0;
+    }
+    case 0xca: {
+        uint32_t bits = 0;
+        float    f    = 0;
+
+        if (0 != get_be(r, 4, &u)) {
+            return -1;
+        }
+        bits = (uint32_t) u;
+        memcpy(&f, &bits, sizeof(f));
+        v->type  = NEU_MSGPACK_DOUBLE;
+        v->v.d64 = f;
+        return 0;
+    }
+    case 0xcb:
+        if (0 != get_be(r, 8, &u)) {
+            return -1;
+        }
+        v->type = NEU_MSGPACK_DOUBLE;
+        memcpy(&v->v.d64, &u, sizeof(v->v.d64));
+        return 0;
+    case 0xd9:
+    case 0xda:
+    case 0xdb:
+        if (0 != get_be(r, 1 << (m - 0xd9), &u)) {
+            return -1;
+        }
+        return get_str(r, u, v);
+    case 0xdc:
+    case 0xdd:
+        if (0 != get_be(r, 0xdc == m ? 2 : 4, &u)) {
+            return -1;
+        }
+        v->type = NEU_MSGPACK_ARRAY;
+        v->v.n  = (uint32_t) u;
+        return 0;
+    case 0xde:
+    case 0xdf:
+        if (0 != get_be(r, 0xde == m ? 2 : 4, &u)) {
+            return -1;
+        }
+        v->type = NEU_MSGPACK_MAP;
+        v->v.n  = (uint32_t) u;
+        return 0;
+    default:
+        // bin, ext and the reserved marker are not used by neuron
+        return -1;
+    }
+}
+
+int neu_msgpack_skip(neu_msgpack_reader_t *r)
+{
+    neu_msgpack_value_t v     = { 0 };
+    uint64_t            count = 1;
+
+    // iterative, so hostile nesting can not exhaust the stack
+    while (count > 0) {
+        if (0 != neu_msgpack_read(r, &v)) {
+            return -1;
+        }
+        count -= 1;
+
+        if (NEU_MSGPACK_ARRAY == v.type) {
+            count += v.v.n;
+        } else if (NEU_MSGPACK_MAP == v.type) {
+            count += (uint64_t) v.v.n * 2;
+        }
+    }
+
+    return 0;
+}
@@ -20,16 +20,58 @@
 #include <assert.h>
 #include <dirent.h>
 #include <errno.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/time.h>
 
 #include <jwt.h>
+#include <openssl/evp.h>
 
 #include "errcodes.h"
 #include "utils/log.h"
 #include "utils/neu_jwt.h"
+#include "utils/uthash.h"
+#include "utils/utlist.h"
+
+#define JWT_DIGEST_LEN 32
+
+/*
+ * Tokens that passed the signature check, keyed by their SHA-256 digest.
+ *
+ * Verified entries are kept in LRU order and evicted beyond
+ * NEU_JWT_CACHE_SIZE. An entry is pending while one thread verifies the
+ * token, other requests with the same token wait for its result rather than
+ * checking the signature again. Revoked entries are kept apart until the
+ * token expires; if there are too many of them, every token issued so far is
+ * revoked instead.
+ */
+typedef struct jwt_entry {
+    uint8_t digest[JWT_DIGEST_LEN];
+    int64_t iat;
+    int64_t exp;
+    bool    pending;
+    bool    revoked;
+
+    UT_hash_handle    hh;
+    struct jwt_entry *prev;
+    struct jwt_entry *next;
+} jwt_entry_t;
+
+static struct {
+    pthread_mutex_t mtx;
+    pthread_cond_t  cond;
+    jwt_entry_t *   entries; // hash of all entries
+    jwt_entry_t *   lru;     // verified entries, least recently used first
+    jwt_entry_t *   revoked;
+    int             n_lru;
+    int             n_revoked;
+    int64_t         revoked_before; // tokens issued earlier are revoked
+} jwt_cache = {
+    .mtx  = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+};
 
 struct public_key_store {
     struct {
@@ -273,17 +315,10 @@ static void *neu_jwt_decode(char *token)
     return jwt;
 }
 
-int neu_jwt_validate(char *b_token)
+static int jwt_verify(char *token, int64_t *iat, int64_t *exp)
 {
     jwt_valid_t *jwt_valid = NULL;
     jwt_alg_t    opt_alg   = JWT_ALG_RS256;
-    char *       token     = NULL;
-
-    if (b_token == NULL || strlen(b_token) <= strlen("Bearar ")) {
-        return NEU_ERR_NEED_TOKEN;
-    }
-
-    token = &b_token[strlen("Bearar ")];
 
     jwt_t *jwt = (jwt_t *) neu_jwt_decode(token);
 
@@ -327,13 +362,270 @@ int neu_jwt_validate(char *b_token)
         }
     }
 
+    *iat = jwt_get_grant_int(jwt, "iat");
+    *exp = jwt_get_grant_int(jwt, "exp");
+
     jwt_valid_free(jwt_valid);
     jwt_free(jwt);
 
     return NEU_ERR_SUCCESS;
 }
 
+static char *jwt_token(char *b_token)
+{
+    if (b_token == NULL || strlen(b_token) <= strlen("Bearar ")) {
+        return NULL;
+    }
+
+    return &b_token[strlen("Bearar ")];
+}
+
+static void jwt_digest(const char *token, uint8_t *digest)
+{
+    unsigned int len = JWT_DIGEST_LEN;
+
+    EVP_Digest(token, strlen(token), digest, &len, EVP_sha256(), NULL);
+}
+
+static void cache_remove(jwt_entry_t *entry)
+{
+    HASH_DEL(jwt_cache.entries, entry);
+    if (entry->revoked && !entry->pending) {
+        DL_DELETE(jwt_cache.revoked, entry);
+        jwt_cache.n_revoked -= 1;
+    } else if (!entry->pending) {
+        DL_DELETE(jwt_cache.lru, entry);
+        jwt_cache.n_lru -= 1;
+    }
+    free(entry);
+}
+
+static void cache_revoke_all(int64_t before)
+{
+    jwt_entry_t *entry = NULL, *tmp = NULL;
+
+    if (before > jwt_cache.revoked_before) {
+        jwt_cache.revoked_before = before;
+    }
+    HASH_ITER(hh, jwt_cache.entries, entry, tmp)
+    {
+        if (entry->pending) {
+            // the verifying thread checks revoked_before when done
+            continue;
+        }
+        cache_remove(entry);
+    }
+}
+
+// move a verified, not pending entry to the revoked list
+static void cache_mark_revoked(jwt_entry_t *entry, int64_t now)
+{
+    jwt_entry_t *el = NULL, *tmp = NULL;
+
+    DL_FOREACH_SAFE(jwt_cache.revoked, el, tmp)
+    {
+        if (el->exp <= now) {
+            cache_remove(el);
+        }
+    }
+
+    if (jwt_cache.n_revoked >= NEU_JWT_CACHE_SIZE) {
+        // make sure the token at hand is covered, even if issued this second
+        zlog_warn(neuron, "too many revoked tokens, revoke all tokens");
+        cache_revoke_all(entry->iat + 1 > now ? entry->iat + 1 : now);
+        return;
+    }
+
+    DL_DELETE(jwt_cache.lru, entry);
+    jwt_cache.n_lru -= 1;
+    entry->revoked = true;
+    DL_APPEND(jwt_cache.revoked, entry);
+    jwt_cache.n_revoked += 1;
+}
+
+static int cache_check(const jwt_entry_t *entry, int64_t now)
+{
+    if (entry->revoked || entry->iat < jwt_cache.revoked_before) {
+        return NEU_ERR_INVALID_TOKEN;
+    }
+
+    if (now >= entry->exp) {
+        return NEU_ERR_EXPIRED_TOKEN;
+    }
+
+    return NEU_ERR_SUCCESS;
+}
+
+/*
+ * Find the entry of a token, waiting while another thread verifies it.
+ * Returns NULL with a new pending entry in *pending if the caller is to
+ * verify the token. Called with the cache locked.
+ */
+static jwt_entry_t *cache_lookup(const uint8_t *digest, jwt_entry_t **pending)
+{
+    jwt_entry_t *entry = NULL;
+
+    *pending = NULL;
+    for (;;) {
+        HASH_FIND(hh, jwt_cache.entries, digest, JWT_DIGEST_LEN, entry);
+        if (entry == NULL) {
+            entry = calloc(1, sizeof(jwt_entry_t));
+            if (entry != NULL) {
+                memcpy(entry->digest, digest, JWT_DIGEST_LEN);
+                entry->pending = true;
+                HASH_ADD(hh, jwt_cache.entries, digest, JWT_DIGEST_LEN, entry);
+            }
+            *pending = entry;
+            return NULL;
+        }
+
+        if (!entry->pending) {
+            return entry;
+        }
+
+        pthread_cond_wait(&jwt_cache.cond, &jwt_cache.mtx);
+    }
+}
+
+// settle a pending entry after verification, called with the cache locked
+static void cache_settle(jwt_entry_t *entry, int ret, int64_t now)
+{
+    entry->pending = false;
+
+    if (ret != NEU_ERR_SUCCESS || entry->exp <= now ||
+        entry->iat < jwt_cache.revoked_before) {
+        // not worth caching, or revoked meanwhile by a password change
+        HASH_DEL(jwt_cache.entries, entry);
+        free(entry);
+    } else {
+        DL_APPEND(jwt_cache.lru, entry);
+        jwt_cache.n_lru += 1;
+        if (entry->revoked) {
+            entry->revoked = false;
+            cache_mark_revoked(entry, now);
+        } else if (jwt_cache.n_lru > NEU_JWT_CACHE_SIZE) {
+            cache_remove(jwt_cache.lru);
+        }
+    }
+
+    pthread_cond_broadcast(&jwt_cache.cond);
+}
+
+int neu_jwt_validate(char *b_token)
+{
+    uint8_t      digest[JWT_DIGEST_LEN] = { 0 };
+    jwt_entry_t *entry                  = NULL;
+    jwt_entry_t *pending                = NULL;
+    int64_t      iat = 0, exp = 0;
+    char *       token = jwt_token(b_token);
+    int          ret   = NEU_ERR_SUCCESS;
+
+    if (token == NULL) {
+        return NEU_ERR_NEED_TOKEN;
+    }
+
+    jwt_digest(token, digest);
+
+    pthread_mutex_lock(&jwt_cache.mtx);
+    entry = cache_lookup(digest, &pending);
+    if (entry != NULL) {
+        int64_t now = time(NULL);
+
+        ret = cache_check(entry, now);
+        if (ret == NEU_ERR_SUCCESS) {
+            DL_DELETE(jwt_cache.lru, entry);
+            DL_APPEND(jwt_cache.lru, entry);
+        } else if (ret == NEU_ERR_EXPIRED_TOKEN) {
+            cache_remove(entry);
+        }
+        pthread_mutex_unlock(&jwt_cache.mtx);
+        return ret;
+    }
+    pthread_mutex_unlock(&jwt_cache.mtx);
+
+    // the signature check runs unlocked, only requests carrying this very
+    // token wait for it
+    ret = jwt_verify(token, &iat, &exp);
+
+    if (pending != NULL) {
+        pthread_mutex_lock(&jwt_cache.mtx);
+        pending->iat = iat;
+        pending->exp = exp;
+        if (ret == NEU_ERR_SUCCESS && iat < jwt_cache.revoked_before) {
+            ret = NEU_ERR_INVALID_TOKEN;
+        }
+        cache_settle(pending, ret, time(NULL));
+        pthread_mutex_unlock(&jwt_cache.mtx);
+    }
+
+    return ret;
+}
+
+int neu_jwt_revoke(char *b_token)
+{
+    uint8_t      digest[JWT_DIGEST_LEN] = { 0 };
+    jwt_entry_t *entry                  = NULL;
+    jwt_entry_t *pending                = NULL;
+    int64_t      iat = 0, exp = 0;
+    char *       token = jwt_token(b_token);
+    int          ret   = NEU_ERR_SUCCESS;
+
+    if (token == NULL) {
+        return NEU_ERR_NEED_TOKEN;
+    }
+
+    jwt_digest(token, digest);
+
+    pthread_mutex_lock(&jwt_cache.mtx);
+    entry = cache_lookup(digest, &pending);
+    if (entry != NULL) {
+        if (!entry->revoked) {
+            cache_mark_revoked(entry, time(NULL));
+        }
+        pthread_mutex_unlock(&jwt_cache.mtx);
+        return NEU_ERR_SUCCESS;
+    }
+    pthread_mutex_unlock(&jwt_cache.mtx);
+
+    ret = jwt_verify(token, &iat, &exp);
+
+    if (pending != NULL) {
+        pthread_mutex_lock(&jwt_cache.mtx);
+        pending->iat     = iat;
+        pending->exp     = exp;
+        pending->revoked = true;
+        cache_settle(pending, ret, time(NULL));
+        pthread_mutex_unlock(&jwt_cache.mtx);
+    } else if (ret == NEU_ERR_SUCCESS) {
+        // out of memory, fall back to revoking every token
+        int64_t now = time(NULL);
+
+        pthread_mutex_lock(&jwt_cache.mtx);
+        cache_revoke_all(iat + 1 > now ? iat + 1 : now);
+        pthread_mutex_unlock(&jwt_cache.mtx);
+    }
+
+    // an invalid token needs no revocation
+    return NEU_ERR_SUCCESS;
+}
+
+void neu_jwt_revoke_all()
+{
+    pthread_mutex_lock(&jwt_cache.mtx);
+    cache_revoke_all(time(NULL));
+    pthread_mutex_unlock(&jwt_cache.mtx);
+}
+
 void neu_jwt_destroy()
 {
-    // memset(token_local, 0, sizeof(token_local));
+    jwt_entry_t *entry = NULL, *tmp = NULL;
+
+    pthread_mutex_lock(&jwt_cache.mtx);
+    HASH_ITER(hh, jwt_cache.entries, entry, tmp)
+    {
+        if (!entry->pending) {
+            cache_remove(entry);
+        }
+    }
+    pthread_mutex_unlock(&jwt_cache.mtx);
 }
@@ -0,0 +1,592 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <zlib.h>
+
+#include "utils/log.h"
+#include "utils/seg_log.h"
+
+#define SEG_MAGIC "NEUSEG01"
+#define SEG_HDR_LEN 8
+#define REC_HDR_LEN 8
+#define REC_CONSUMED 0x80000000U
+#define REC_LEN_MASK 0x7FFFFFFFU
+#define SEG_MIN_SIZE (64 * 1024)
+#define SEG_NAME_FMT "%016" PRIx64 ".seg"
+
+typedef struct {
+    uint64_t id;
+    uint8_t *map; // NULL if not mapped
+    size_t   size;
+    size_t   end;       // end of the valid records
+    size_t   n_pending; // records not consumed
+} segment_t;
+
+struct neu_seg_log {
+    char *     dir;
+    size_t     seg_size;
+    size_t     max_bytes;
+    segment_t *segs; // oldest first, the last one is written
+    size_t     n_seg;
+    size_t     cap_seg;
+    size_t     read_off; // offset of the first pending record in segs[0]
+    uint64_t   head_seq;
+    size_t     cur_off; // read cursor, never leaves segs[0]
+    uint64_t   cur_seq;
+    uint64_t   next_id;
+    size_t     count;
+    size_t     bytes;
+    size_t     disk_bytes;
+    uint64_t   evicted;
+};
+
+static inline size_t rec_size(size_t len)
+{
+    // keep headers 4 bytes aligned
+    return REC_HDR_LEN + ((len + 3) & ~(size_t) 3);
+}
+
+static inline uint32_t load_u32(const uint8_t *p)
+{
+    uint32_t v = 0;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline void store_u32(uint8_t *p, uint32_t v)
+{
+    memcpy(p, &v, sizeof(v));
+}
+
+static void seg_path(const neu_seg_log_t *log, uint64_t id, char *buf,
+                     size_t size)
+{
+    int n = snprintf(buf, size, "%s/", log->dir);
+    snprintf(buf + n, size - n, SEG_NAME_FMT, id);
+}
+
+static int seg_map(const neu_seg_log_t *log, segment_t *seg, bool create)
+{
+    char path[PATH_MAX];
+    int  flags = O_RDWR | (create ? O_CREAT | O_EXCL : 0);
+
+    if (NULL != seg->map) {
+        return 0;
+    }
+
+    seg_path(log, seg->id, path, sizeof(path));
+    int fd = open(path, flags, 0644);
+    if (fd < 0) {
+        nlog_error("open %s fail: %s", path, strerror(errno));
+        return -1;
+    }
+
+    if (create && 0 != ftruncate(fd, seg->size)) {
+        nlog_error("ftruncate %s fail: %s", path, strerror(errno));
+        close(fd);
+        unlink(path);
+        return -1;
+    }
+
+    void *map =
+        mmap(NULL, seg->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    // the mapping stays valid after close
+    close(fd);
+    if (MAP_FAILED == map) {
+        nlog_error("mmap %s fail: %s", path, strerror(errno));
+        if (create) {
+            unlink(path);
+        }
+        return -1;
+    }
+
+    seg->map = map;
+    return 0;
+}
+
+static void seg_unmap(segment_t *seg)
+{
+    if (NULL != seg->map) {
+        munmap(seg->map, seg->size);
+        seg->map = NULL;
+    }
+}
+
+// scan the records of a mapped segment, return false if it is not a segment
+static bool seg_scan(segment_t *seg, size_t *first_pending, size_t *bytes)
+{
+    size_t off = SEG_HDR_LEN;
+
+    if (seg->size < SEG_HDR_LEN ||
+        0 != memcmp(seg->map, SEG_MAGIC, SEG_HDR_LEN)) {
+        return false;
+    }
+
+    *first_pending = 0;
+    *bytes         = 0;
+    seg->n_pending = 0;
+
+    while (off + REC_HDR_LEN <= seg->size) {
+        uint32_t hdr = load_u32(seg->map + off);
+        uint32_t len = hdr & REC_LEN_MASK;
+
+        if (0 == len || off + rec_size(len) > seg->size ||
+            load_u32(seg->map + off + 4) !=
+                crc32(0, seg->map + off + REC_HDR_LEN, len)) {
+            // end of log, or a torn record
+            break;
+        }
+
+        if (!(hdr & REC_CONSUMED)) {
+            if (0 == seg->n_pending) {
+                *first_pending = off;
+            }
+            seg->n_pending += 1;
+            *bytes += len;
+        }
+        off += rec_size(len);
+    }
+
+    seg->end = off;
+    if (0 == seg->n_pending) {
+        *first_pending = off;
+    }
+    return true;
+}
+
+static void seg_remove(neu_seg_log_t *log, size_t i)
+{
+    char path[PATH_MAX];
+
+    seg_unmap(&log->segs[i]);
+    seg_path(log, log->segs[i].id, path, sizeof(path));
+    if (0 != unlink(path)) {
+        nlog_warn("unlink %s fail: %s", path, strerror(errno));
+    }
+
+    log->disk_bytes -= log->segs[i].size;
+    memmove(&log->segs[i], &log->segs[i + 1],
+            (log->n_seg - i - 1) * sizeof(segment_t));
+    log->n_seg -= 1;
+}
+
+// drop the head segment, pending records included
+static void evict_head(neu_seg_log_t *log)
+{
+    segment_t *seg = &log->segs[0];
+
+    if (seg->n_pending > 0) {
+        log->evicted += seg->n_pending;
+        log->head_seq += seg->n_pending;
+        log->count -= seg->n_pending;
+
+        // the remaining payload bytes are only known by walking the records
+        if (0 == seg_map(log, seg, false)) {
+            for (size_t off = log->read_off; off < seg->end;) {
+                uint32_t len = load_u32(seg->map + off) & REC_LEN_MASK;
+                log->bytes -= len;
+                off += rec_size(len);
+            }
+        }
+    }
+
+    seg_remove(log, 0);
+    log->read_off = SEG_HDR_LEN;
+}
+
+static int seg_push(neu_seg_log_t *log, uint64_t id, size_t size)
+{
+    if (log->n_seg == log->cap_seg) {
+        size_t     cap  = log->cap_seg ? log->cap_seg * 2 : 8;
+        segment_t *segs = realloc(log->segs, cap * sizeof(segment_t));
+        if (NULL == segs) {
+            return -1;
+        }
+        log->segs    = segs;
+        log->cap_seg = cap;
+    }
+
+    segment_t *seg = &log->segs[log->n_seg++];
+    memset(seg, 0, sizeof(*seg));
+    seg->id   = id;
+    seg->size = size;
+    seg->end  = SEG_HDR_LEN;
+    log->disk_bytes += size;
+    return 0;
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *) a;
+    uint64_t y = *(const uint64_t *) b;
+    return x < y ? -1 : x > y;
+}
+
+static int load_dir(neu_seg_log_t *log)
+{
+    uint64_t *ids   = NULL;
+    size_t    n_ids = 0, cap_ids = 0;
+    DIR *     d     = opendir(log->dir);
+
+    if (NULL == d) {
+        nlog_error("opendir %s fail: %s", log->dir, strerror(errno));
+        return -1;
+    }
+
+    for (struct dirent *e = readdir(d); NULL != e; e = readdir(d)) {
+        uint64_t id  = 0;
+        char     ext = 0;
+        if (2 != sscanf(e->d_name, "%16" SCNx64 ".se%c", &id, &ext) ||
+            'g' != ext) {
+            continue;
+        }
+        if (n_ids == cap_ids) {
+            cap_ids       = cap_ids ? cap_ids * 2 : 16;
+            uint64_t *tmp = realloc(ids, cap_ids * sizeof(uint64_t));
+            if (NULL == tmp) {
+                closedir(d);
+                free(ids);
+                return -1;
+            }
+            ids = tmp;
+        }
+        ids[n_ids++] = id;
+    }
+    closedir(d);
+
+    qsort(ids, n_ids, sizeof(uint64_t), cmp_u64);
+
+    for (size_t i = 0; i < n_ids; ++i) {
+        char        path[PATH_MAX];
+        struct stat st;
+        size_t      first = 0, bytes = 0;
+
+        seg_path(log, ids[i], path, sizeof(path));
+        if (0 != stat(path, &st) || 0 != seg_push(log, ids[i], st.st_size)) {
+            continue;
+        }
+
+        segment_t *seg = &log->segs[log->n_seg - 1];
+        if (0 != seg_map(log, seg, false) || !seg_scan(seg, &first, &bytes)) {
+            nlog_warn("drop invalid segment %s", path);
+            seg_remove(log, log->n_seg - 1);
+            continue;
+        }
+
+        if (1 == log->n_seg) {
+            log->read_off = first;
+        }
+        log->count += seg->n_pending;
+        log->bytes += bytes;
+        log->next_id = seg->id + 1;
+        seg_unmap(seg);
+    }
+    free(ids);
+
+    // drop consumed segments left by a crash, keep the tail for appending
+    while (log->n_seg > 1 && 0 == log->segs[0].n_pending) {
+        seg_remove(log, 0);
+        log->read_off = SEG_HDR_LEN;
+        if (0 == seg_map(log, &log->segs[0], false)) {
+            size_t first = 0, bytes = 0;
+            seg_scan(&log->segs[0], &first, &bytes);
+            log->read_off = first;
+            seg_unmap(&log->segs[0]);
+        }
+    }
+
+    // the budget may have been reduced
+    while (log->n_seg > 0 && log->disk_bytes > log->max_bytes) {
+        evict_head(log);
+    }
+
+    return 0;
+}
+
+static int mkdirs(const char *dir)
+{
+    char  path[PATH_MAX];
+    char *p = NULL;
+
+    snprintf(path, sizeof(path), "%s", dir);
+    for (p = path + 1; *p; ++p) {
+        if ('/' == *p) {
+            *p = '\0';
+            if (0 != mkdir(path, 0755) && EEXIST != errno) {
+                return -1;
+            }
+            *p = '/';
+        }
+    }
+
+    return (0 != mkdir(path, 0755) && EEXIST != errno) ? -1 : 0;
+}
+
+neu_seg_log_t *neu_seg_log_open(const char *dir, size_t seg_size,
+                                size_t max_bytes)
+{
+    neu_seg_log_t *log = calloc(1, sizeof(*log));
+    if (NULL == log) {
+        return NULL;
+    }
+
+    log->dir       = strdup(dir);
+    log->seg_size  = seg_size > SEG_MIN_SIZE ? seg_size : SEG_MIN_SIZE;
+    log->max_bytes = max_bytes;
+    log->read_off  = SEG_HDR_LEN;
+
+    if (NULL == log->dir || 0 != mkdirs(dir) || 0 != load_dir(log)) {
+        nlog_error("open segment log %s fail", dir);
+        neu_seg_log_close(log);
+        return NULL;
+    }
+
+    nlog_notice("segment log %s, %zu segments, %zu records pending", dir,
+                log->n_seg, log->count);
+    return log;
+}
+
+void neu_seg_log_close(neu_seg_log_t *log)
+{
+    if (NULL == log) {
+        return;
+    }
+
+    for (size_t i = 0; i < log->n_seg; ++i) {
+        if (NULL != log->segs[i].map) {
+            msync(log->segs[i].map, log->segs[i].size, MS_ASYNC);
+        }
+        seg_unmap(&log->segs[i]);
+    }
+    free(log->segs);
+    free(log->dir);
+    free(log);
+}
+
+static int roll(neu_seg_log_t *log, size_t need)
+{
+    size_t size = SEG_HDR_LEN + need;
+
+    // oversized records get a segment of their own
+    if (size < log->seg_size) {
+        size = log->seg_size;
+    }
+
+    if (size > log->max_bytes) {
+        return -1;
+    }
+
+    while (log->n_seg > 0 && log->disk_bytes + size > log->max_bytes) {
+        evict_head(log);
+    }
+
+    if (log->n_seg > 1) {
+        // the old tail is neither read nor written any more
+        segment_t *tail = &log->segs[log->n_seg - 1];
+        msync(tail->map, tail->size, MS_ASYNC);
+        seg_unmap(tail);
+    }
+
+    if (0 != seg_push(log, log->next_id, size)) {
+        return -1;
+    }
+
+    segment_t *seg = &log->segs[log->n_seg - 1];
+    if (0 != seg_map(log, seg, true)) {
+        log->n_seg -= 1;
+        log->disk_bytes -= size;
+        return -1;
+    }
+
+    memcpy(seg->map, SEG_MAGIC, SEG_HDR_LEN);
+    log->next_id += 1;
+    if (1 == log->n_seg) {
+        log->read_off = SEG_HDR_LEN;
+    }
+    return 0;
+}
+
+int neu_seg_log_append(neu_seg_log_t *log, const void *data, size_t len)
+{
+    size_t     need = rec_size(len);
+    segment_t *tail = NULL;
+
+    if (0 == len || len > REC_LEN_MASK) {
+        return -1;
+    }
+
+    if (log->n_seg > 0) {
+        tail = &log->segs[log->n_seg - 1];
+    }
+
+    if (NULL == tail || tail->end + need > tail->size) {
+        if (0 != roll(log, need)) {
+            return -1;
+        }
+        tail = &log->segs[log->n_seg - 1];
+    } else if (0 != seg_map(log, tail, false)) {
+        return -1;
+    }
+
+    uint8_t *p = tail->map + tail->end;
+    memcpy(p + REC_HDR_LEN, data, len);
+    store_u32(p + 4, crc32(0, data, len));
+    if (tail->end + need + REC_HDR_LEN <= tail->size) {
+        // terminate, whatever a previous run left behind is not a record
+        memset(p + need, 0, REC_HDR_LEN);
+    }
+    // the length goes last, a crash before it leaves no partial record
+    store_u32(p, len);
+
+    tail->end += need;
+    tail->n_pending += 1;
+    log->count += 1;
+    log->bytes += len;
+    return 0;
+}
+
+// make segs[0] the segment holding the first pending record, if any
+static segment_t *head_seg(neu_seg_log_t *log)
+{
+    while (log->n_seg > 0) {
+        segment_t *seg = &log->segs[0];
+
+        if (log->read_off < seg->end) {
+            return 0 == seg_map(log, seg, false) ? seg : NULL;
+        }
+
+        if (1 == log->n_seg) {
+            break;
+        }
+
+        // fully consumed
+        seg_remove(log, 0);
+        log->read_off = SEG_HDR_LEN;
+    }
+
+    return NULL;
+}
+
+int neu_seg_log_peek(neu_seg_log_t *log, uint64_t *seq, const void **data,
+                     size_t *len)
+{
+    segment_t *seg = head_seg(log);
+
+    if (NULL == seg) {
+        return -1;
+    }
+
+    *seq  = log->head_seq;
+    *len  = load_u32(seg->map + log->read_off) & REC_LEN_MASK;
+    *data = seg->map + log->read_off + REC_HDR_LEN;
+    return 0;
+}
+
+int neu_seg_log_next(neu_seg_log_t *log, uint64_t *seq, const void **data,
+                     size_t *len)
+{
+    segment_t *seg = head_seg(log);
+
+    if (NULL == seg) {
+        return -1;
+    }
+
+    if (log->cur_seq <= log->head_seq) {
+        // records handed out were popped or evicted
+        neu_seg_log_rewind(log);
+    }
+
+    if (log->cur_off >= seg->end) {
+        // wait for the head segment to drain
+        return -1;
+    }
+
+    *seq  = log->cur_seq;
+    *len  = load_u32(seg->map + log->cur_off) & REC_LEN_MASK;
+    *data = seg->map + log->cur_off + REC_HDR_LEN;
+    log->cur_off += rec_size(*len);
+    log->cur_seq += 1;
+    return 0;
+}
+
+void neu_seg_log_rewind(neu_seg_log_t *log)
+{
+    log->cur_off = log->read_off;
+    log->cur_seq = log->head_seq;
+}
+
+void neu_seg_log_pop(neu_seg_log_t *log, uint64_t seq)
+{
+    const void *data = NULL;
+    size_t      len  = 0;
+    uint64_t    head = 0;
+
+    if (0 != neu_seg_log_peek(log, &head, &data, &len) || head != seq) {
+        return;
+    }
+
+    segment_t *seg = &log->segs[0];
+    uint8_t *  p   = seg->map + log->read_off;
+
+    store_u32(p, load_u32(p) | REC_CONSUMED);
+    log->read_off += rec_size(len);
+    log->head_seq += 1;
+    log->count -= 1;
+    log->bytes -= len;
+    seg->n_pending -= 1;
+
+    if (log->read_off >= seg->end && log->n_seg > 1) {
+        // give the disk space back as soon as possible
+        seg_remove(log, 0);
+        log->read_off = SEG_HDR_LEN;
+    }
+}
+
+size_t neu_seg_log_count(const neu_seg_log_t *log)
+{
+    return log->count;
+}
+
+size_t neu_seg_log_bytes(const neu_seg_log_t *log)
+{
+    return log->bytes;
+}
+
+size_t neu_seg_log_disk_bytes(const neu_seg_log_t *log)
+{
+    return log->disk_bytes;
+}
+
+uint64_t neu_seg_log_evicted(const neu_seg_log_t *log)
+{
+    return log->evicted;
+}
@@ -0,0 +1,160 @@
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+#include <gtest/gtest.h>
+#include <zlib.h>
+
+#include "utils/compress.h"
+#include "json/json_writer.h"
+
+#include "utils/log.h"
+
+zlog_category_t *neuron = NULL;
+
+static std::string gunzip(const uint8_t *in, size_t len)
+{
+    z_stream    strm = {};
+    std::string out;
+    uint8_t     buf[4096];
+
+    EXPECT_EQ(Z_OK, inflateInit2(&strm, 15 + 16));
+    strm.next_in  = (Bytef *) in;
+    strm.avail_in = len;
+
+    int rv = Z_OK;
+    while (Z_OK == rv) {
+        strm.next_out  = buf;
+        strm.avail_out = sizeof(buf);
+        rv             = inflate(&strm, Z_NO_FLUSH);
+        out.append((char *) buf, sizeof(buf) - strm.avail_out);
+    }
+    EXPECT_EQ(Z_STREAM_END, rv);
+    inflateEnd(&strm);
+
+    return out;
+}
+
+// upload payload of `n` tags in values format, as the MQTT plugin sends it
+static std::string upload_payload(int n, int cycle)
+{
+    neu_json_writer_t w;
+    char              name[NEU_TAG_NAME_LEN];
+
+    neu_json_writer_init(&w, 0);
+    neu_json_writer_object_begin(&w);
+    neu_json_writer_key(&w, "node");
+    neu_json_writer_str_value(&w, "modbus-tcp-node-1");
+    neu_json_writer_key(&w, "group");
+    neu_json_writer_str_value(&w, "group-1s");
+    neu_json_writer_key(&w, "timestamp");
+    neu_json_writer_int(&w, 1649776722631 + cycle * 1000);
+    neu_json_writer_key(&w, "values");
+    neu_json_writer_object_begin(&w);
+    for (int i = 0; i < n; ++i) {
+        snprintf(name, sizeof(name), "tag%d", i);
+        neu_json_writer_key(&w, name);
+        if (i % 3) {
+            neu_json_writer_int(&w, (i * 37 + cycle) % 1000);
+        } else {
+            neu_json_writer_double(&w, 20.0 + (i + cycle) % 17 / 8.0, 2);
+        }
+    }
+    neu_json_writer_object_end(&w);
+    neu_json_writer_key(&w, "errors");
+    neu_json_writer_object_begin(&w);
+    neu_json_writer_object_end(&w);
+    neu_json_writer_object_end(&w);
+
+    std::string s(neu_json_writer_str(&w));
+    neu_json_writer_fini(&w);
+    return s;
+}
+
+TEST(CompressTest, RoundTrip)
+{
+    neu_deflate_t *d = neu_deflate_new(6);
+    ASSERT_NE(nullptr, d);
+
+    // the same stream is reused across payloads
+    for (int cycle = 0; cycle < 3; ++cycle) {
+        std::string in      = upload_payload(50, cycle);
+        uint8_t *   out     = NULL;
+        size_t      out_len = 0;
+
+        ASSERT_EQ(0, neu_deflate(d, in.data(), in.size(), &out, &out_len));
+        ASSERT_GT(out_len, 2U);
+        EXPECT_EQ(0x1f, out[0]);
+        EXPECT_EQ(0x8b, out[1]);
+        EXPECT_LT(out_len, in.size());
+        EXPECT_EQ(in, gunzip(out, out_len));
+        free(out);
+    }
+
+    neu_deflate_free(d);
+}
+
+TEST(CompressTest, Empty)
+{
+    neu_deflate_t *d       = neu_deflate_new(1);
+    uint8_t *      out     = NULL;
+    size_t         out_len = 0;
+
+    ASSERT_EQ(0, neu_deflate(d, "", 0, &out, &out_len));
+    EXPECT_EQ("", gunzip(out, out_len));
+    free(out);
+
+    neu_deflate_free(d);
+}
+
+TEST(CompressTest, Level)
+{
+    EXPECT_EQ(nullptr, neu_deflate_new(0));
+    EXPECT_EQ(nullptr, neu_deflate_new(10));
+    neu_deflate_free(NULL);
+}
+
+TEST(CompressBench, UploadPayload)
+{
+    const int n_round = 200;
+
+    // a single report, and a batch of 10 cycles as the batching stage sends
+    for (int n_cycle : { 1, 10 }) {
+        std::string in;
+        if (n_cycle > 1) {
+            in += '[';
+        }
+        for (int c = 0; c < n_cycle; ++c) {
+            in += (c ? "," : "") + upload_payload(100, c);
+        }
+        if (n_cycle > 1) {
+            in += ']';
+        }
+
+        for (int level : { 1, 6, 9 }) {
+            neu_deflate_t *d       = neu_deflate_new(level);
+            size_t         out_len = 0;
+
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < n_round; ++i) {
+                uint8_t *out = NULL;
+                ASSERT_EQ(0,
+                          neu_deflate(d, in.data(), in.size(), &out, &out_len));
+                free(out);
+            }
+            auto end = std::chrono::steady_clock::now();
+
+            double us =
+                std::chrono::duration<double, std::micro>(end - start).count() /
+                n_round;
+            printf("[ bench    ] %2d report(s) level %d: %zu -> %zu bytes "
+                   "(%.1fx), %.1f us, %.1f ns/byte saved\n",
+                   n_cycle, level, in.size(), out_len,
+                   (double) in.size() / out_len, us,
+                   us * 1000 / (in.size() - out_len));
+
+            neu_deflate_free(d);
+        }
+    }
+}
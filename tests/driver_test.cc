@@ -0,0 +1,573 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <map>
+#include <string>
+
+#include <gtest/gtest.h>
+
+extern "C" {
+#include "adapter.h"
+#include "adapter/adapter_internal.h"
+#include "adapter/driver/cache.h"
+#include "adapter/driver/driver_internal.h"
+#include "argparse.h"
+#include "errcodes.h"
+#include "metrics.h"
+}
+
+zlog_category_t *neuron           = NULL;
+int64_t          global_timestamp = 0;
+
+size_t g_node_memory_soft_limit = 0;
+size_t g_node_memory_hard_limit = 0;
+
+// what the driver asked of the adapter and of its events
+static neu_event_timer_param_t report;
+static neu_event_timer_param_t group_read;
+static int                     n_sent   = 0;
+static uint64_t                memory   = 0;
+static int                     response = -1;
+// tags of the last report sent
+static std::map<std::string, neu_dvalue_t> sent;
+
+extern "C" {
+void adapter_storage_add_group(const char *node, const char *group,
+                               uint32_t interval)
+{
+    (void) node;
+    (void) group;
+    (void) interval;
+}
+
+void adapter_storage_update_tag_value(const char *node, const char *group,
+                                      const neu_datatag_t *tag)
+{
+    (void) node;
+    (void) group;
+    (void) tag;
+}
+
+neu_event_timer_t *neu_adapter_add_timer(neu_adapter_t *         adapter,
+                                         neu_event_timer_param_t param)
+{
+    (void) adapter;
+    report = param;
+    return NULL;
+}
+
+void neu_adapter_del_timer(neu_adapter_t *adapter, neu_event_timer_t *timer)
+{
+    (void) adapter;
+    (void) timer;
+}
+
+neu_event_timer_t *neu_event_add_timer(neu_events_t *          events,
+                                       neu_event_timer_param_t param)
+{
+    (void) events;
+    group_read = param;
+    return (neu_event_timer_t *) &group_read;
+}
+
+int neu_event_del_timer(neu_events_t *events, neu_event_timer_t *timer)
+{
+    (void) events;
+    (void) timer;
+    return 0;
+}
+
+int neu_adapter_register_group_metric(neu_adapter_t *adapter,
+                                      const char *group_name, const char *name,
+                                      const char *help, neu_metric_type_e type,
+                                      uint64_t init)
+{
+    (void) adapter;
+    (void) group_name;
+    (void) name;
+    (void) help;
+    (void) type;
+    (void) init;
+    return 0;
+}
+
+int neu_adapter_update_group_metric(neu_adapter_t *adapter,
+                                    const char *   group_name,
+                                    const char *metric_name, uint64_t n)
+{
+    (void) adapter;
+    (void) group_name;
+    (void) metric_name;
+    (void) n;
+    return 0;
+}
+
+void neu_adapter_del_group_metrics(neu_adapter_t *adapter,
+                                   const char *   group_name)
+{
+    (void) adapter;
+    (void) group_name;
+}
+
+int neu_adapter_send_trans_data(neu_adapter_t *adapter, nng_msg *msg)
+{
+    neu_reqresp_head_t *      header = (neu_reqresp_head_t *) nng_msg_body(msg);
+    neu_reqresp_trans_data_t *data   = (neu_reqresp_trans_data_t *) &header[1];
+
+    (void) adapter;
+    n_sent += 1;
+    sent.clear();
+    for (uint32_t i = 0; i < data->n_tag; ++i) {
+        sent[data->tags[i].tag] = data->tags[i].value;
+    }
+    nng_msg_free(msg);
+    return 0;
+}
+}
+
+static int update_metric(neu_adapter_t *adapter, const char *metric_name,
+                         uint64_t n, const char *group)
+{
+    (void) adapter;
+    (void) group;
+    if (strcmp(metric_name, NEU_METRIC_MEMORY_BYTES) == 0) {
+        memory = n;
+    }
+    return 0;
+}
+
+static int respond(neu_adapter_t *adapter, neu_reqresp_head_t *head,
+                   void *data)
+{
+    (void) adapter;
+    (void) head;
+    response = ((neu_resp_error_t *) data)->error;
+    return 0;
+}
+
+static int validate_tag(neu_plugin_t *plugin, neu_datatag_t *tag)
+{
+    (void) plugin;
+    (void) tag;
+    return NEU_ERR_SUCCESS;
+}
+
+static int group_timer(neu_plugin_t *plugin, neu_plugin_group_t *group)
+{
+    (void) plugin;
+    (void) group;
+    return 0;
+}
+
+static int write_tag(neu_plugin_t *plugin, void *req, neu_datatag_t *tag,
+                     neu_value_u value)
+{
+    (void) plugin;
+    (void) req;
+    (void) tag;
+    (void) value;
+    return NEU_ERR_SUCCESS;
+}
+
+static neu_plugin_intf_funs_t funs   = {};
+static neu_plugin_module_t    module = {
+    .version   = 0,
+    .intf_funs = &funs,
+};
+
+class DriverTest : public testing::Test {
+protected:
+    void SetUp() override
+    {
+        funs.driver.validate_tag = validate_tag;
+        funs.driver.write_tag    = write_tag;
+        funs.driver.group_timer  = group_timer;
+
+        global_timestamp         = 10000;
+        g_node_memory_soft_limit = 0;
+        g_node_memory_hard_limit = 0;
+        n_sent                   = 0;
+        response                 = -1;
+
+        driver                         = neu_adapter_driver_create();
+        adapter                        = (neu_adapter_t *) driver;
+        adapter->name                  = strdup("driver");
+        adapter->state                 = NEU_NODE_RUNNING_STATE_RUNNING;
+        adapter->module                = &module;
+        adapter->cb_funs.update_metric = update_metric;
+        adapter->cb_funs.response      = respond;
+
+        // never read while testing
+        ASSERT_EQ(NEU_ERR_SUCCESS,
+                  neu_adapter_driver_add_group(driver, "group", 3600000));
+        ASSERT_EQ(NEU_ERR_SUCCESS, add_tag("tag0", "0", ""));
+    }
+
+    void TearDown() override
+    {
+        neu_adapter_driver_uninit(driver);
+        neu_adapter_driver_destroy(driver);
+        free(adapter->name);
+        free(driver);
+    }
+
+    int add_tag(const char *name, const char *address, const char *description,
+                const neu_tag_report_t *report = NULL)
+    {
+        neu_datatag_t tag = {};
+
+        tag.name        = (char *) name;
+        tag.address     = (char *) address;
+        tag.description = (char *) description;
+        tag.type        = NEU_TYPE_INT32;
+        tag.attribute =
+            (neu_attribute_e)(NEU_ATTRIBUTE_READ | NEU_ATTRIBUTE_WRITE);
+        if (NULL != report) {
+            tag.attribute =
+                (neu_attribute_e)(NEU_ATTRIBUTE_READ | NEU_ATTRIBUTE_SUBSCRIBE);
+            tag.report = *report;
+        }
+        return neu_adapter_driver_add_tag(driver, "group", &tag);
+    }
+
+    uint32_t n_tag()
+    {
+        UT_array *tags = NULL;
+        uint32_t  n    = 0;
+
+        EXPECT_EQ(NEU_ERR_SUCCESS,
+                  neu_adapter_driver_get_tag(driver, "group", &tags));
+        n = utarray_len(tags);
+        utarray_free(tags);
+        return n;
+    }
+
+    // the report timer recounts once a second
+    void report_later()
+    {
+        global_timestamp += 1000;
+        report.cb(report.usr_data);
+    }
+
+    neu_adapter_driver_t *driver  = NULL;
+    neu_adapter_t *       adapter = NULL;
+};
+
+class DriverMemory : public DriverTest {};
+
+TEST_F(DriverMemory, AddOverHardLimit)
+{
+    g_node_memory_hard_limit = memory + 1;
+
+    EXPECT_EQ(NEU_ERR_NODE_MEMORY_LIMIT, add_tag("tag1", "1", ""));
+    EXPECT_EQ(1, n_tag());
+
+    neu_datatag_t tags[2] = {};
+    uint32_t      index   = 2;
+    for (int i = 0; i < 2; ++i) {
+        tags[i].name        = (char *) (i == 0 ? "tag1" : "tag2");
+        tags[i].address     = (char *) "1";
+        tags[i].description = (char *) "";
+        tags[i].type        = NEU_TYPE_INT32;
+        tags[i].attribute   = NEU_ATTRIBUTE_READ;
+    }
+    EXPECT_EQ(NEU_ERR_NODE_MEMORY_LIMIT,
+              neu_adapter_driver_add_tags(driver, "group", tags, 2, &index));
+    EXPECT_EQ(0, index);
+    EXPECT_EQ(1, n_tag());
+
+    EXPECT_EQ(NEU_ERR_NODE_MEMORY_LIMIT,
+              neu_adapter_driver_add_group(driver, "other", 1000));
+    EXPECT_EQ(NEU_ERR_GROUP_NOT_EXIST,
+              neu_adapter_driver_group_exist(driver, "other"));
+
+    // growing a tag is refused, the tag is left as it was
+    neu_datatag_t tag = {};
+    tag.name          = (char *) "tag0";
+    tag.address       = (char *) "0";
+    tag.description   = (char *) "a description longer than before";
+    tag.type          = NEU_TYPE_INT32;
+    tag.attribute =
+        (neu_attribute_e)(NEU_ATTRIBUTE_READ | NEU_ATTRIBUTE_WRITE);
+    EXPECT_EQ(NEU_ERR_NODE_MEMORY_LIMIT,
+              neu_adapter_driver_update_tag(driver, "group", &tag));
+
+    UT_array *tags_p = NULL;
+    neu_adapter_driver_get_tag(driver, "group", &tags_p);
+    EXPECT_STREQ("", ((neu_datatag_t *) utarray_front(tags_p))->description);
+    utarray_free(tags_p);
+
+    // room is given back as tags go
+    g_node_memory_hard_limit = 0;
+    ASSERT_EQ(NEU_ERR_SUCCESS, add_tag("tag1", "1", ""));
+    uint64_t two_tags        = memory;
+    g_node_memory_hard_limit = two_tags;
+    EXPECT_EQ(NEU_ERR_SUCCESS,
+              neu_adapter_driver_del_tag(driver, "group", "tag1"));
+    EXPECT_LT(memory, two_tags);
+    EXPECT_EQ(NEU_ERR_SUCCESS, add_tag("tag1", "1", ""));
+    EXPECT_EQ(2, n_tag());
+}
+
+TEST_F(DriverMemory, WriteOverHardLimit)
+{
+    neu_reqresp_head_t *req = (neu_reqresp_head_t *) calloc(
+        1, sizeof(neu_reqresp_head_t) + sizeof(neu_req_write_tag_t));
+    neu_req_write_tag_t *cmd = (neu_req_write_tag_t *) &req[1];
+
+    strcpy(cmd->driver, "driver");
+    strcpy(cmd->group, "group");
+    strcpy(cmd->tag, "tag0");
+    cmd->value.type      = NEU_TYPE_INT32;
+    cmd->value.value.i32 = 1;
+
+    g_node_memory_hard_limit = 1;
+    report_later();
+    neu_adapter_driver_write_tag(driver, req);
+    EXPECT_EQ(NEU_ERR_NODE_MEMORY_LIMIT, response);
+}
+
+TEST_F(DriverMemory, ReportHalvedOverSoftLimit)
+{
+    neu_dvalue_t value = {};
+
+    value.type      = NEU_TYPE_INT32;
+    value.value.i32 = 1;
+    adapter->cb_funs.driver.update(adapter, "group", "tag0", value);
+
+    for (int i = 0; i < 4; ++i) {
+        report.cb(report.usr_data);
+    }
+    EXPECT_EQ(4, n_sent);
+
+    n_sent                   = 0;
+    g_node_memory_soft_limit = 1;
+    report_later();
+    for (int i = 0; i < 3; ++i) {
+        report.cb(report.usr_data);
+    }
+    EXPECT_EQ(2, n_sent);
+}
+
+static neu_dvalue_t int32_value(int32_t v)
+{
+    neu_dvalue_t value = {};
+
+    value.type      = NEU_TYPE_INT32;
+    value.value.i32 = v;
+    return value;
+}
+
+static neu_dvalue_t error_value(int32_t error)
+{
+    neu_dvalue_t value = {};
+
+    value.type      = NEU_TYPE_ERROR;
+    value.value.i32 = error;
+    return value;
+}
+
+class DriverCache : public testing::Test {
+protected:
+    void SetUp() override
+    {
+        cache = neu_driver_cache_new();
+        neu_driver_cache_add(cache, "group", "tag", int32_value(0));
+    }
+
+    void TearDown() override { neu_driver_cache_destroy(cache); }
+
+    bool report(const neu_dvalue_t &value, int64_t now)
+    {
+        return neu_driver_cache_report_test(cache, "group", "tag", &settings,
+                                            &value, now);
+    }
+
+    neu_driver_cache_t *cache    = NULL;
+    neu_tag_report_t    settings = {};
+};
+
+TEST_F(DriverCache, ReportEveryChange)
+{
+    EXPECT_TRUE(report(int32_value(1), 0));
+    EXPECT_FALSE(report(int32_value(1), 10));
+    EXPECT_TRUE(report(int32_value(2), 20));
+}
+
+TEST_F(DriverCache, AbsoluteDeadband)
+{
+    settings.deadband = 5;
+
+    EXPECT_TRUE(report(int32_value(100), 0));
+    EXPECT_FALSE(report(int32_value(104), 10));
+    EXPECT_FALSE(report(int32_value(105), 20));
+    EXPECT_FALSE(report(int32_value(95), 30));
+    EXPECT_TRUE(report(int32_value(106), 40));
+
+    // against the last reported value, a slow drift gets out eventually
+    EXPECT_FALSE(report(int32_value(103), 50));
+    EXPECT_FALSE(report(int32_value(110), 60));
+    EXPECT_TRUE(report(int32_value(112), 70));
+}
+
+TEST_F(DriverCache, PercentDeadband)
+{
+    settings.deadband      = 10;
+    settings.deadband_type = NEU_DEADBAND_PERCENT;
+
+    EXPECT_TRUE(report(int32_value(100), 0));
+    EXPECT_FALSE(report(int32_value(110), 10));
+    EXPECT_FALSE(report(int32_value(90), 20));
+    EXPECT_TRUE(report(int32_value(111), 30));
+
+    // no band around 0, any change is beyond it
+    EXPECT_TRUE(report(int32_value(0), 40));
+    EXPECT_FALSE(report(int32_value(0), 50));
+    EXPECT_TRUE(report(int32_value(1), 60));
+}
+
+TEST_F(DriverCache, Heartbeat)
+{
+    settings.deadband  = 5;
+    settings.heartbeat = 1000;
+
+    EXPECT_TRUE(report(int32_value(100), 0));
+    EXPECT_FALSE(report(int32_value(100), 999));
+    EXPECT_FALSE(report(int32_value(101), 999));
+    EXPECT_TRUE(report(int32_value(101), 1000));
+
+    // counted from the last report
+    EXPECT_FALSE(report(int32_value(101), 1999));
+    EXPECT_TRUE(report(int32_value(101), 2000));
+}
+
+TEST_F(DriverCache, MinInterval)
+{
+    settings.min_interval = 500;
+
+    EXPECT_TRUE(report(int32_value(1), 0));
+    EXPECT_FALSE(report(int32_value(2), 499));
+    EXPECT_TRUE(report(int32_value(2), 500));
+
+    // a change held back is reported once the interval is over
+    EXPECT_FALSE(report(int32_value(3), 600));
+    EXPECT_TRUE(report(int32_value(3), 1000));
+}
+
+TEST_F(DriverCache, ErrorChangeReported)
+{
+    settings.deadband = 1000000;
+
+    EXPECT_TRUE(report(int32_value(3000), 0));
+    EXPECT_TRUE(report(error_value(3000), 10));
+    EXPECT_FALSE(report(error_value(3000), 20));
+    EXPECT_TRUE(report(error_value(3001), 30));
+    EXPECT_TRUE(report(int32_value(3000), 40));
+}
+
+TEST_F(DriverCache, StringAndBytesHashed)
+{
+    neu_dvalue_t value = {};
+
+    value.type = NEU_TYPE_STRING;
+    strcpy(value.value.str, "abc");
+    EXPECT_TRUE(report(value, 0));
+    EXPECT_FALSE(report(value, 10));
+    strcpy(value.value.str, "abd");
+    EXPECT_TRUE(report(value, 20));
+    // the bytes after the terminator are not part of a string
+    value.value.str[10] = 'x';
+    EXPECT_FALSE(report(value, 30));
+
+    value                = {};
+    value.type           = NEU_TYPE_BYTES;
+    value.value.bytes[0] = 1;
+    EXPECT_TRUE(report(value, 40));
+    EXPECT_FALSE(report(value, 50));
+    value.value.bytes[sizeof(value.value.bytes) - 1] = 1;
+    EXPECT_TRUE(report(value, 60));
+}
+
+TEST_F(DriverCache, UnknownTagReported)
+{
+    neu_dvalue_t value = int32_value(1);
+
+    EXPECT_TRUE(neu_driver_cache_report_test(cache, "group", "other",
+                                             &settings, &value, 0));
+    EXPECT_TRUE(neu_driver_cache_report_test(cache, "group", "other",
+                                             &settings, &value, 10));
+}
+
+class DriverReport : public DriverTest {
+protected:
+    void SetUp() override
+    {
+        DriverTest::SetUp();
+
+        neu_tag_report_t settings = {};
+        settings.deadband         = 5;
+        settings.heartbeat        = 10000;
+        ASSERT_EQ(NEU_ERR_SUCCESS, add_tag("rbe", "1", "", &settings));
+        // the read timer takes the tags into the cache
+        group_read.cb(group_read.usr_data);
+    }
+
+    void update(const char *tag, const neu_dvalue_t &value)
+    {
+        adapter->cb_funs.driver.update(adapter, "group", tag, value);
+    }
+
+    void report_at(int64_t timestamp)
+    {
+        global_timestamp = timestamp;
+        sent.clear();
+        report.cb(report.usr_data);
+    }
+};
+
+TEST_F(DriverReport, Deadband)
+{
+    update("tag0", int32_value(1));
+    update("rbe", int32_value(100));
+    report_at(10000);
+    ASSERT_EQ(2, sent.size());
+    EXPECT_EQ(100, sent["rbe"].value.i32);
+
+    // the other tags are reported every time
+    update("rbe", int32_value(105));
+    report_at(10100);
+    EXPECT_EQ(1, sent.size());
+    EXPECT_EQ(1, sent.count("tag0"));
+
+    update("rbe", int32_value(106));
+    report_at(10200);
+    ASSERT_EQ(2, sent.size());
+    EXPECT_EQ(106, sent["rbe"].value.i32);
+
+    // unchanged but silent for the heartbeat
+    report_at(20199);
+    EXPECT_EQ(0, sent.count("rbe"));
+    report_at(20200);
+    EXPECT_EQ(1, sent.count("rbe"));
+}
+
+TEST_F(DriverReport, ErrorReported)
+{
+    update("rbe", int32_value(100));
+    report_at(10000);
+    EXPECT_EQ(1, sent.count("rbe"));
+
+    update("rbe", error_value(NEU_ERR_PLUGIN_READ_FAILURE));
+    report_at(10100);
+    ASSERT_EQ(1, sent.count("rbe"));
+    EXPECT_EQ(NEU_TYPE_ERROR, sent["rbe"].type);
+    EXPECT_EQ(NEU_ERR_PLUGIN_READ_FAILURE, sent["rbe"].value.i32);
+
+    report_at(10200);
+    EXPECT_EQ(0, sent.count("rbe"));
+
+    update("rbe", int32_value(100));
+    report_at(10300);
+    ASSERT_EQ(1, sent.count("rbe"));
+    EXPECT_EQ(100, sent["rbe"].value.i32);
+}
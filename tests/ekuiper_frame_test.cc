@@ -0,0 +1,326 @@
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+
+#include <gtest/gtest.h>
+
+#include "json/json_writer.h"
+
+#include "frame.h"
+#include "utils/log.h"
+
+zlog_category_t *neuron = NULL;
+
+#define MAX_TAG 128
+
+static neu_reqresp_trans_data_t *new_data()
+{
+    return (neu_reqresp_trans_data_t *) calloc(
+        1,
+        sizeof(neu_reqresp_trans_data_t) +
+            MAX_TAG * sizeof(neu_resp_tag_value_t));
+}
+
+static void set_tag(neu_resp_tag_value_t *tag, const char *name,
+                    neu_type_e type)
+{
+    memset(tag, 0, sizeof(*tag));
+    strcpy(tag->tag, name);
+    tag->value.type = type;
+}
+
+static neu_reqresp_trans_data_t *fill_data(int n)
+{
+    char                      name[NEU_TAG_NAME_LEN] = { 0 };
+    neu_reqresp_trans_data_t *data                   = new_data();
+
+    strcpy(data->driver, "node0");
+    strcpy(data->group, "grp0");
+    data->n_tag = n;
+
+    for (int i = 0; i < n; i++) {
+        neu_resp_tag_value_t *tag = &data->tags[i];
+        snprintf(name, sizeof(name), "tag%d", i);
+        switch (i % 6) {
+        case 0:
+            set_tag(tag, name, NEU_TYPE_INT32);
+            tag->value.value.i32 = -123456 * i;
+            break;
+        case 1:
+            set_tag(tag, name, NEU_TYPE_UINT16);
+            tag->value.value.u16 = 65535 - i;
+            break;
+        case 2:
+            set_tag(tag, name, NEU_TYPE_DOUBLE);
+            tag->value.value.d64 = 1024.5 * i;
+            break;
+        case 3:
+            set_tag(tag, name, NEU_TYPE_BOOL);
+            tag->value.value.boolean = i % 2;
+            break;
+        case 4:
+            set_tag(tag, name, NEU_TYPE_STRING);
+            snprintf(tag->value.value.str, NEU_VALUE_SIZE, "str %d", i);
+            break;
+        case 5:
+            set_tag(tag, name, NEU_TYPE_ERROR);
+            tag->value.value.i32 = 3000 + i;
+            break;
+        }
+    }
+
+    return data;
+}
+
+static void expect_tag_eq(const neu_resp_tag_value_t *a,
+                          const neu_resp_tag_value_t *b)
+{
+    EXPECT_STREQ(a->tag, b->tag);
+    ASSERT_EQ(a->value.type, b->value.type);
+    switch (a->value.type) {
+    case NEU_TYPE_INT32:
+    case NEU_TYPE_ERROR:
+        EXPECT_EQ(a->value.value.i32, b->value.value.i32);
+        break;
+    case NEU_TYPE_UINT16:
+        EXPECT_EQ(a->value.value.u16, b->value.value.u16);
+        break;
+    case NEU_TYPE_DOUBLE:
+        EXPECT_EQ(a->value.value.d64, b->value.value.d64);
+        break;
+    case NEU_TYPE_BOOL:
+        EXPECT_EQ(a->value.value.boolean, b->value.value.boolean);
+        break;
+    case NEU_TYPE_STRING:
+        EXPECT_STREQ(a->value.value.str, b->value.value.str);
+        break;
+    default:
+        break;
+    }
+}
+
+TEST(EkuiperFrameTest, Hello)
+{
+    frame_encoder_t enc;
+
+    frame_encoder_init(&enc);
+    ASSERT_EQ(0, frame_encode_hello(&enc, FRAME_VERSION));
+    ASSERT_EQ((size_t) FRAME_HEADER_LEN, enc.len);
+    EXPECT_TRUE(frame_is(enc.buf, enc.len, FRAME_HELLO));
+    EXPECT_FALSE(frame_is(enc.buf, enc.len, FRAME_VALUES));
+    EXPECT_FALSE(frame_is((const uint8_t *) "{\"a\"", 4, FRAME_HELLO));
+    frame_encoder_fini(&enc);
+}
+
+TEST(EkuiperFrameTest, RoundTrip)
+{
+    frame_encoder_t           enc;
+    frame_decoder_t           dec;
+    neu_reqresp_trans_data_t *in        = NULL;
+    neu_reqresp_trans_data_t *out       = new_data();
+    uint32_t                  schema_id = 0;
+
+    in = fill_data(12);
+    set_tag(&in->tags[11], "bytes", NEU_TYPE_BYTES);
+    frame_encoder_init(&enc);
+    frame_decoder_init(&dec);
+
+    ASSERT_EQ(0, frame_encode_values(&enc, in, 1649776722631, &schema_id));
+    EXPECT_NE(0U, schema_id);
+    ASSERT_EQ(0,
+              frame_decode_values(&dec, enc.buf, enc.len, out, MAX_TAG));
+
+    EXPECT_STREQ("node0", out->driver);
+    EXPECT_STREQ("grp0", out->group);
+    EXPECT_EQ(1649776722631, out->timestamp);
+    ASSERT_EQ(11, out->n_tag); // the bytes tag is left out
+    for (int i = 0; i < 11; i++) {
+        expect_tag_eq(&in->tags[i], &out->tags[i]);
+    }
+
+    // truncated frames are rejected
+    for (size_t len = 0; len < enc.len; len++) {
+        EXPECT_EQ(-1,
+                  frame_decode_values(&dec, enc.buf, len, out, MAX_TAG));
+    }
+    EXPECT_EQ(-1, frame_decode_values(&dec, enc.buf, enc.len, out, 5));
+
+    frame_encoder_fini(&enc);
+    frame_decoder_fini(&dec);
+    free(in);
+    free(out);
+}
+
+TEST(EkuiperFrameTest, SchemaInlineUntilDelivered)
+{
+    frame_encoder_t           enc;
+    frame_decoder_t           dec;
+    neu_reqresp_trans_data_t *in        = NULL;
+    neu_reqresp_trans_data_t *out       = new_data();
+    uint32_t                  schema_id = 0;
+    size_t                    len_full  = 0;
+
+    in = fill_data(24);
+    frame_encoder_init(&enc);
+    frame_decoder_init(&dec);
+
+    // not delivered yet, the schema stays inline
+    ASSERT_EQ(0, frame_encode_values(&enc, in, 1, &schema_id));
+    uint32_t first = schema_id;
+    ASSERT_EQ(0, frame_encode_values(&enc, in, 2, &schema_id));
+    EXPECT_EQ(first, schema_id);
+    len_full = enc.len;
+    ASSERT_EQ(0,
+              frame_decode_values(&dec, enc.buf, enc.len, out, MAX_TAG));
+
+    frame_encoder_delivered(&enc, "node0", "grp0", schema_id);
+    ASSERT_EQ(0, frame_encode_values(&enc, in, 3, &schema_id));
+    EXPECT_EQ(0U, schema_id);
+    EXPECT_LT(enc.len, len_full);
+    ASSERT_EQ(0,
+              frame_decode_values(&dec, enc.buf, enc.len, out, MAX_TAG));
+    EXPECT_EQ(3, out->timestamp);
+    EXPECT_EQ(24, out->n_tag);
+
+    // a missing tag is only absent, the schema is kept
+    in->tags[0] = in->tags[23];
+    in->n_tag   = 23;
+    ASSERT_EQ(0, frame_encode_values(&enc, in, 4, &schema_id));
+    EXPECT_EQ(0U, schema_id);
+    ASSERT_EQ(0,
+              frame_decode_values(&dec, enc.buf, enc.len, out, MAX_TAG));
+    ASSERT_EQ(23, out->n_tag);
+    EXPECT_STREQ("tag1", out->tags[0].tag);
+
+    // a new decoder does not know the schema
+    frame_decoder_t dec2;
+    frame_decoder_init(&dec2);
+    EXPECT_EQ(-1,
+              frame_decode_values(&dec2, enc.buf, enc.len, out, MAX_TAG));
+    frame_decoder_fini(&dec2);
+
+    // after a reset, the schema is sent again with a new id
+    frame_encoder_reset(&enc);
+    ASSERT_EQ(0, frame_encode_values(&enc, in, 5, &schema_id));
+    EXPECT_GT(schema_id, first);
+
+    frame_encoder_fini(&enc);
+    frame_decoder_fini(&dec);
+    free(in);
+    free(out);
+}
+
+TEST(EkuiperFrameTest, SchemaChange)
+{
+    frame_encoder_t           enc;
+    frame_decoder_t           dec;
+    neu_reqresp_trans_data_t *in        = NULL;
+    neu_reqresp_trans_data_t *out       = new_data();
+    uint32_t                  schema_id = 0, first = 0;
+
+    in = fill_data(6);
+    frame_encoder_init(&enc);
+    frame_decoder_init(&dec);
+
+    ASSERT_EQ(0, frame_encode_values(&enc, in, 1, &first));
+    ASSERT_EQ(0,
+              frame_decode_values(&dec, enc.buf, enc.len, out, MAX_TAG));
+    frame_encoder_delivered(&enc, "node0", "grp0", first);
+
+    // an error keeps the type of the column
+    set_tag(&in->tags[0], "tag0", NEU_TYPE_ERROR);
+    in->tags[0].value.value.i32 = 2001;
+    ASSERT_EQ(0, frame_encode_values(&enc, in, 2, &schema_id));
+    EXPECT_EQ(0U, schema_id);
+    ASSERT_EQ(0,
+              frame_decode_values(&dec, enc.buf, enc.len, out, MAX_TAG));
+    EXPECT_EQ(NEU_TYPE_ERROR, out->tags[0].value.type);
+    EXPECT_EQ(2001, out->tags[0].value.value.i32);
+
+    // a new type changes the schema
+    set_tag(&in->tags[0], "tag0", NEU_TYPE_FLOAT);
+    in->tags[0].value.value.f32 = 1.5;
+    ASSERT_EQ(0, frame_encode_values(&enc, in, 3, &schema_id));
+    EXPECT_GT(schema_id, first);
+    ASSERT_EQ(0,
+              frame_decode_values(&dec, enc.buf, enc.len, out, MAX_TAG));
+    EXPECT_EQ(NEU_TYPE_FLOAT, out->tags[0].value.type);
+    EXPECT_EQ(1.5, out->tags[0].value.value.f32);
+
+    // a delivery notification of the old schema changes nothing
+    frame_encoder_delivered(&enc, "node0", "grp0", first);
+    ASSERT_EQ(0, frame_encode_values(&enc, in, 4, &first));
+    EXPECT_EQ(schema_id, first);
+
+    // so does a new tag
+    frame_encoder_delivered(&enc, "node0", "grp0", schema_id);
+    set_tag(&in->tags[6], "new", NEU_TYPE_INT64);
+    in->tags[6].value.value.i64 = -1;
+    in->n_tag                   = 7;
+    ASSERT_EQ(0, frame_encode_values(&enc, in, 5, &first));
+    EXPECT_GT(first, schema_id);
+    ASSERT_EQ(0,
+              frame_decode_values(&dec, enc.buf, enc.len, out, MAX_TAG));
+    ASSERT_EQ(7, out->n_tag);
+    EXPECT_STREQ("new", out->tags[6].tag);
+    EXPECT_EQ(-1, out->tags[6].value.value.i64);
+
+    frame_encoder_fini(&enc);
+    frame_decoder_fini(&dec);
+    free(in);
+    free(out);
+}
+
+TEST(EkuiperFrameBench, ValuesEncode)
+{
+    const int                 n_tag   = 100;
+    const int                 n_round = 2000;
+    neu_json_writer_t         jw;
+    frame_encoder_t           enc;
+    neu_reqresp_trans_data_t *in        = NULL;
+    uint32_t                  schema_id = 0;
+    size_t                    bytes_json = 0, bytes_frame = 0;
+
+    in = fill_data(n_tag);
+    neu_json_writer_init(&jw, 0);
+    frame_encoder_init(&enc);
+    frame_encode_values(&enc, in, 0, &schema_id);
+    frame_encoder_delivered(&enc, "node0", "grp0", schema_id);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < n_round; i++) {
+        // as json_encode_read_resp of the plugin
+        neu_json_writer_reset(&jw);
+        neu_json_writer_object_begin(&jw);
+        neu_json_writer_key(&jw, "node_name");
+        neu_json_writer_str_value(&jw, in->driver);
+        neu_json_writer_key(&jw, "group_name");
+        neu_json_writer_str_value(&jw, in->group);
+        neu_json_writer_key(&jw, "timestamp");
+        neu_json_writer_int(&jw, 1649776722631 + i);
+        neu_json_writer_tags_values(&jw, in->tags, in->n_tag);
+        neu_json_writer_object_end(&jw);
+        bytes_json += neu_json_writer_len(&jw);
+    }
+    auto mid = std::chrono::steady_clock::now();
+    for (int i = 0; i < n_round; i++) {
+        frame_encode_values(&enc, in, 1649776722631 + i, &schema_id);
+        bytes_frame += enc.len;
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double ns_json =
+        std::chrono::duration<double, std::nano>(mid - start).count();
+    double ns_frame =
+        std::chrono::duration<double, std::nano>(end - mid).count();
+
+    printf("[ bench    ] ekuiper json: %.1f ns/tag %zu bytes, "
+           "frame: %.1f ns/tag %zu bytes\n",
+           ns_json / (n_round * n_tag), bytes_json / n_round,
+           ns_frame / (n_round * n_tag), bytes_frame / n_round);
+    EXPECT_LT(bytes_frame, bytes_json);
+
+    neu_json_writer_fini(&jw);
+    frame_encoder_fini(&enc);
+    free(in);
+}
@@ -0,0 +1,134 @@
+#include <chrono>
+#include <stdlib.h>
+
+#include <atomic>
+
+#include <gtest/gtest.h>
+
+#include "adapter.h"
+#include "base/group.h"
+#include "define.h"
+#include "errcodes.h"
+
+/*
+ * Benches of the driver report cycle.
+ *
+ * Built on its own, not run by ctest: malloc, calloc and realloc are replaced
+ * for the whole binary to count allocations, which relies on glibc.
+ *
+ * ./group_bench
+ */
+
+static std::atomic<bool> counting(false);
+static std::atomic<long> n_alloc(0);
+
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t n, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+
+void *malloc(size_t size)
+{
+    if (counting.load(std::memory_order_relaxed)) {
+        n_alloc.fetch_add(1, std::memory_order_relaxed);
+    }
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size)
+{
+    if (counting.load(std::memory_order_relaxed)) {
+        n_alloc.fetch_add(1, std::memory_order_relaxed);
+    }
+    return __libc_calloc(n, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    if (counting.load(std::memory_order_relaxed)) {
+        n_alloc.fetch_add(1, std::memory_order_relaxed);
+    }
+    return __libc_realloc(ptr, size);
+}
+}
+
+static void add_tag(neu_group_t *group, const char *name)
+{
+    neu_datatag_t tag = { 0 };
+
+    tag.name        = (char *) name;
+    tag.address     = (char *) "1!400001";
+    tag.description = (char *) "a rather long description of the tag";
+    tag.attribute   = NEU_ATTRIBUTE_READ;
+    tag.type        = NEU_TYPE_INT16;
+
+    EXPECT_EQ(0, neu_group_add_tag(group, &tag));
+}
+
+// stop the compiler from dropping writes to memory freed right after
+static void keep(void *p)
+{
+    asm volatile("" : : "g"(p) : "memory");
+}
+
+// what a driver report cycle allocates, a malloc standing for the message
+TEST(GroupBench, ReportCycle)
+{
+    const int    n_tag   = 1000;
+    const int    n_round = 1000;
+    const size_t size    = sizeof(neu_reqresp_trans_data_t) +
+        n_tag * sizeof(neu_resp_tag_value_t);
+    neu_group_t *group = neu_group_new("grp", 1000);
+    char         name[32];
+
+    for (int i = 0; i < n_tag; ++i) {
+        snprintf(name, sizeof(name), "tag%04d", i);
+        add_tag(group, name);
+    }
+    // the first borrow builds the array kept by the group
+    neu_group_read_tags(group);
+
+    // tags copied, trans data built aside then copied into the message
+    n_alloc    = 0;
+    counting   = true;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < n_round; ++i) {
+        UT_array *tags = neu_group_get_read_tag(group);
+        void *    data = calloc(1, size);
+        void *    msg  = malloc(size);
+        memcpy(msg, data, size);
+        keep(msg);
+        free(msg);
+        free(data);
+        utarray_free(tags);
+    }
+    auto mid        = std::chrono::steady_clock::now();
+    long old_allocs = n_alloc.exchange(0);
+
+    // tags borrowed, trans data built in the message
+    for (int i = 0; i < n_round; ++i) {
+        UT_array *tags = neu_group_read_tags(group);
+        void *    msg  = malloc(size);
+        memset(msg, 0, sizeof(neu_resp_tag_value_t) * utarray_len(tags));
+        keep(msg);
+        free(msg);
+    }
+    auto end        = std::chrono::steady_clock::now();
+    long new_allocs = n_alloc.exchange(0);
+    counting        = false;
+
+    double ns_old =
+        std::chrono::duration<double, std::nano>(mid - start).count();
+    double ns_new = std::chrono::duration<double, std::nano>(end - mid).count();
+
+    printf("[ bench    ] %d tags report cycle, copied: %.2f us %.1f allocs, "
+           "in place: %.2f us %.1f allocs\n",
+           n_tag, ns_old / n_round / 1000, (double) old_allocs / n_round,
+           ns_new / n_round / 1000, (double) new_allocs / n_round);
+
+    // the message alone
+    EXPECT_EQ(n_round, new_allocs);
+    EXPECT_GT(old_allocs, new_allocs);
+
+    neu_group_destroy(group);
+}
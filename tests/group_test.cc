@@ -0,0 +1,424 @@
+#include <malloc.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "adapter.h"
+#include "base/group.h"
+#include "define.h"
+#include "errcodes.h"
+
+static void add_tag(neu_group_t *group, const char *name, int attribute)
+{
+    neu_datatag_t tag = { 0 };
+
+    tag.name        = (char *) name;
+    tag.address     = (char *) "1!400001";
+    tag.description = (char *) "a rather long description of the tag";
+    tag.attribute   = (neu_attribute_e) attribute;
+    tag.type        = NEU_TYPE_INT16;
+
+    EXPECT_EQ(0, neu_group_add_tag(group, &tag));
+}
+
+static std::vector<std::string> names(UT_array *tags)
+{
+    std::vector<std::string> v;
+
+    utarray_foreach(tags, neu_datatag_t *, tag) { v.push_back(tag->name); }
+
+    return v;
+}
+
+TEST(GroupTest, QueryTagPage)
+{
+    neu_group_t *group = neu_group_new("grp", 1000);
+    const char * order[] = { "t3", "t0", "x1", "t4", "t1", "t2" };
+
+    for (const char *name : order) {
+        add_tag(group, name, NEU_ATTRIBUTE_READ);
+    }
+
+    neu_group_tag_query_t query = { 0 };
+    char                  next[NEU_TAG_NAME_LEN];
+    uint32_t              total = 0;
+
+    query.prefix = "t";
+    query.limit  = 2;
+
+    UT_array *tags = neu_group_query_tag_page(group, &query, &total, next);
+    EXPECT_EQ(std::vector<std::string>({ "t0", "t1" }), names(tags));
+    EXPECT_EQ(5, total);
+    EXPECT_STREQ("t1", next);
+    utarray_free(tags);
+
+    // a tag added before the cursor does not shift the next page
+    add_tag(group, "t00", NEU_ATTRIBUTE_READ);
+    std::string cursor = next;
+    query.cursor       = cursor.c_str();
+
+    tags = neu_group_query_tag_page(group, &query, &total, next);
+    EXPECT_EQ(std::vector<std::string>({ "t2", "t3" }), names(tags));
+    EXPECT_EQ(6, total);
+    EXPECT_STREQ("t3", next);
+    utarray_free(tags);
+
+    cursor = next;
+    tags   = neu_group_query_tag_page(group, &query, &total, next);
+    EXPECT_EQ(std::vector<std::string>({ "t4" }), names(tags));
+    EXPECT_STREQ("", next);
+    utarray_free(tags);
+
+    neu_group_destroy(group);
+}
+
+TEST(GroupTest, QueryTagFilterProjection)
+{
+    neu_group_t *group = neu_group_new("grp", 1000);
+
+    add_tag(group, "b", NEU_ATTRIBUTE_READ);
+    add_tag(group, "a", NEU_ATTRIBUTE_READ | NEU_ATTRIBUTE_WRITE);
+    add_tag(group, "c", NEU_ATTRIBUTE_WRITE);
+
+    neu_group_tag_query_t query = { 0 };
+    char                  next[NEU_TAG_NAME_LEN];
+    uint32_t              total = 0;
+
+    // no limit nor cursor keeps the insertion order
+    query.attribute = NEU_ATTRIBUTE_READ;
+    query.fields    = NEU_TAG_FIELD_NAME | NEU_TAG_FIELD_ADDRESS;
+
+    UT_array *tags = neu_group_query_tag_page(group, &query, &total, next);
+    EXPECT_EQ(std::vector<std::string>({ "b", "a" }), names(tags));
+    EXPECT_EQ(2, total);
+    EXPECT_STREQ("", next);
+    utarray_foreach(tags, neu_datatag_t *, tag)
+    {
+        EXPECT_STREQ("1!400001", tag->address);
+        EXPECT_STREQ("", tag->description);
+    }
+    utarray_free(tags);
+
+    neu_group_destroy(group);
+}
+
+TEST(GroupTest, AddTags)
+{
+    neu_group_t * group = neu_group_new("grp", 1000);
+    neu_datatag_t tags[4];
+    const char *  order[] = { "a", "b", "c", "a" };
+    uint32_t      n_added = 0;
+
+    for (int i = 0; i < 4; ++i) {
+        tags[i]             = { 0 };
+        tags[i].name        = (char *) order[i];
+        tags[i].address     = (char *) "1!400001";
+        tags[i].description = (char *) "";
+        tags[i].attribute   = NEU_ATTRIBUTE_READ;
+        tags[i].type        = NEU_TYPE_INT16;
+    }
+
+    EXPECT_FALSE(neu_group_is_change(group, 0));
+
+    // stops at the duplicate within the batch, keeping the tags before it
+    EXPECT_EQ(NEU_ERR_TAG_NAME_CONFLICT,
+              neu_group_add_tags(group, tags, 4, &n_added));
+    EXPECT_EQ(3, n_added);
+    EXPECT_EQ(3, neu_group_tag_size(group));
+    EXPECT_TRUE(neu_group_is_change(group, 0));
+
+    UT_array *all = neu_group_get_tag(group);
+    EXPECT_EQ(std::vector<std::string>({ "a", "b", "c" }), names(all));
+    utarray_free(all);
+
+    EXPECT_EQ(NEU_ERR_TAG_NAME_CONFLICT,
+              neu_group_add_tags(group, &tags[1], 1, &n_added));
+    EXPECT_EQ(0, n_added);
+
+    neu_group_destroy(group);
+}
+
+static neu_datatag_t make_tag(const char *name, const char *address,
+                              const char *description)
+{
+    neu_datatag_t tag = {};
+
+    tag.name        = (char *) name;
+    tag.address     = (char *) address;
+    tag.description = (char *) description;
+    tag.attribute   = NEU_ATTRIBUTE_READ;
+    tag.type        = NEU_TYPE_INT16;
+
+    return tag;
+}
+
+TEST(GroupTest, TagSizeBeyond16Bits)
+{
+    neu_group_t *              group = neu_group_new("grp", 1000);
+    std::vector<std::string>   names(70000);
+    std::vector<neu_datatag_t> tags(names.size());
+    uint32_t                   n_added = 0;
+
+    for (size_t i = 0; i < names.size(); ++i) {
+        names[i] = "tag" + std::to_string(i);
+        tags[i]  = make_tag(names[i].c_str(), "1!400001", "");
+    }
+
+    EXPECT_EQ(0, neu_group_add_tags(group, tags.data(), tags.size(), &n_added));
+    EXPECT_EQ(70000, n_added);
+    EXPECT_EQ(70000, neu_group_tag_size(group));
+
+    neu_group_destroy(group);
+}
+
+TEST(GroupTest, UpdateDeleteCompact)
+{
+    neu_group_t *group = neu_group_new("grp", 1000);
+    char         name[32], address[32];
+
+    for (int i = 0; i < 2000; ++i) {
+        snprintf(name, sizeof(name), "tag%04d", i);
+        snprintf(address, sizeof(address), "1!4%05d", i);
+        neu_datatag_t tag = make_tag(name, address, "shared description");
+        ASSERT_EQ(0, neu_group_add_tag(group, &tag));
+    }
+
+    neu_datatag_t tag = make_tag("static", "", "");
+    neu_value_u   v   = {};
+    tag.attribute     = NEU_ATTRIBUTE_STATIC;
+    v.i16             = 42;
+    neu_tag_set_static_value(&tag, &v);
+    ASSERT_EQ(0, neu_group_add_tag(group, &tag));
+    neu_tag_clear_static_value(&tag);
+
+    // rewrite then delete most tags, leaving the arena mostly garbage
+    for (int i = 0; i < 2000; ++i) {
+        snprintf(name, sizeof(name), "tag%04d", i);
+        snprintf(address, sizeof(address), "1!3%05d", i);
+        neu_datatag_t t = make_tag(name, address, "other description");
+        ASSERT_EQ(0, neu_group_update_tag(group, &t));
+    }
+    for (int i = 0; i < 2000; ++i) {
+        if (i % 100 != 0) {
+            snprintf(name, sizeof(name), "tag%04d", i);
+            ASSERT_EQ(0, neu_group_del_tag(group, name));
+        }
+    }
+
+    EXPECT_EQ(21, neu_group_tag_size(group));
+
+    UT_array *tags = neu_group_get_tag(group);
+    EXPECT_EQ(21, utarray_len(tags));
+    EXPECT_STREQ("tag0000", ((neu_datatag_t *) utarray_front(tags))->name);
+    EXPECT_STREQ("static", ((neu_datatag_t *) utarray_back(tags))->name);
+    utarray_free(tags);
+
+    const neu_datatag_t *found = neu_group_find_tag(group, "tag1900");
+    ASSERT_NE(nullptr, found);
+    EXPECT_STREQ("1!301900", found->address);
+    EXPECT_STREQ("other description", found->description);
+
+    found = neu_group_find_tag(group, "static");
+    ASSERT_NE(nullptr, found);
+    v = {};
+    EXPECT_EQ(0, neu_tag_get_static_value(found, &v));
+    EXPECT_EQ(42, v.i16);
+
+    // deleted elements are reused
+    tag = make_tag("tag0001", "1!400001", "");
+    EXPECT_EQ(0, neu_group_add_tag(group, &tag));
+    EXPECT_EQ(nullptr, neu_group_find_tag(group, "tag0002"));
+    EXPECT_STREQ("1!400001", neu_group_find_tag(group, "tag0001")->address);
+
+    neu_group_destroy(group);
+}
+
+// the driver thread copies the tags while the adapter thread compacts them
+TEST(GroupTest, CopyWhileCompacting)
+{
+    neu_group_t *     group = neu_group_new("grp", 1000);
+    std::atomic<bool> done(false);
+    char              name[32], address[32];
+
+    for (int i = 0; i < 500; ++i) {
+        snprintf(name, sizeof(name), "tag%04d", i);
+        snprintf(address, sizeof(address), "1!4%05d", i);
+        neu_datatag_t tag = make_tag(name, address, "shared description");
+        ASSERT_EQ(0, neu_group_add_tag(group, &tag));
+    }
+
+    std::thread reader([&] {
+        int64_t timestamp = 0;
+
+        while (!done) {
+            UT_array *copies = neu_group_get_read_tag(group);
+            utarray_free(copies);
+            neu_group_change_test(
+                group, timestamp, &timestamp,
+                [](void *arg, int64_t ts, UT_array *static_tags,
+                   UT_array *other_tags, uint32_t) {
+                    *(int64_t *) arg = ts;
+                    utarray_free(static_tags);
+                    utarray_free(other_tags);
+                });
+        }
+    });
+
+    for (int round = 0; round < 20; ++round) {
+        for (int i = 0; i < 500; ++i) {
+            snprintf(name, sizeof(name), "tag%04d", i);
+            snprintf(address, sizeof(address), "1!%d%05d", round % 2, i);
+            neu_datatag_t tag = make_tag(name, address, "shared description");
+            ASSERT_EQ(0, neu_group_update_tag(group, &tag));
+        }
+    }
+
+    done = true;
+    reader.join();
+    EXPECT_EQ(500, neu_group_tag_size(group));
+    neu_group_destroy(group);
+}
+
+TEST(GroupTest, TagMeta)
+{
+    neu_group_t * group = neu_group_new("grp", 1000);
+    neu_datatag_t tag   = make_tag("tag", "1!400001", "");
+    uint32_t      meta  = 0x12345678;
+    uint32_t      out   = 0;
+
+    EXPECT_EQ(-1, neu_tag_get_meta(&tag, &out, sizeof(out)));
+    EXPECT_EQ(-1, neu_tag_set_meta(&tag, &meta, NEU_TAG_META_SIZE));
+    EXPECT_EQ(0, neu_tag_set_meta(&tag, &meta, sizeof(meta)));
+    ASSERT_EQ(0, neu_group_add_tag(group, &tag));
+
+    // kept by the group and by copies
+    const neu_datatag_t *found = neu_group_find_tag(group, "tag");
+    ASSERT_NE(nullptr, found);
+    EXPECT_EQ(0, neu_tag_get_meta(found, &out, sizeof(out)));
+    EXPECT_EQ(meta, out);
+
+    neu_datatag_t *dup = neu_tag_dup(found);
+    out                = 0;
+    EXPECT_EQ(0, neu_tag_get_meta(dup, &out, sizeof(out)));
+    EXPECT_EQ(meta, out);
+    neu_tag_free(dup);
+
+    // an update brings its own meta
+    neu_tag_clear_meta(&tag);
+    tag.address = (char *) "1!400002";
+    ASSERT_EQ(0, neu_group_update_tag(group, &tag));
+    found = neu_group_find_tag(group, "tag");
+    EXPECT_EQ(-1, neu_tag_get_meta(found, &out, sizeof(out)));
+
+    // the meta of static tags holds their value
+    neu_datatag_t st = make_tag("static", "", "");
+    st.attribute     = NEU_ATTRIBUTE_STATIC;
+    EXPECT_EQ(-1, neu_tag_set_meta(&st, &meta, sizeof(meta)));
+
+    neu_group_destroy(group);
+}
+
+TEST(GroupTest, ReadTags)
+{
+    neu_group_t *group = neu_group_new("grp", 1000);
+
+    add_tag(group, "r", NEU_ATTRIBUTE_READ);
+    add_tag(group, "w", NEU_ATTRIBUTE_WRITE);
+    add_tag(group, "s", NEU_ATTRIBUTE_SUBSCRIBE);
+
+    UT_array *copies = neu_group_get_read_tag(group);
+    UT_array *tags   = neu_group_read_tags(group);
+    EXPECT_EQ(names(copies), names(tags));
+    EXPECT_EQ(std::vector<std::string>({ "r", "s" }), names(tags));
+    utarray_free(copies);
+
+    // kept until the tags change
+    EXPECT_EQ(tags, neu_group_read_tags(group));
+    add_tag(group, "rw", NEU_ATTRIBUTE_READ | NEU_ATTRIBUTE_WRITE);
+    EXPECT_EQ(std::vector<std::string>({ "r", "s", "rw" }),
+              names(neu_group_read_tags(group)));
+    EXPECT_EQ(0, neu_group_del_tag(group, "r"));
+    EXPECT_EQ(std::vector<std::string>({ "s", "rw" }),
+              names(neu_group_read_tags(group)));
+
+    neu_group_destroy(group);
+}
+
+TEST(GroupTest, Memory)
+{
+    neu_group_t *group = neu_group_new("grp", 1000);
+    size_t       empty = neu_group_memory(group);
+
+    for (int i = 0; i < 100; ++i) {
+        add_tag(group, ("tag" + std::to_string(i)).c_str(),
+                NEU_ATTRIBUTE_READ);
+    }
+
+    // the strings of every tag at least
+    size_t tags = neu_group_memory(group);
+    EXPECT_GT(tags, empty + 100 * strlen("a rather long description"));
+
+    // the array handed out for reports is the group's too
+    neu_group_read_tags(group);
+    EXPECT_EQ(tags + 100 * sizeof(neu_datatag_t), neu_group_memory(group));
+
+    neu_group_destroy(group);
+}
+
+static size_t heap_used()
+{
+    struct mallinfo info = mallinfo();
+    return (size_t) info.uordblks + (size_t) info.hblkhd;
+}
+
+// ./group_test --gtest_also_run_disabled_tests --gtest_filter=*Footprint
+TEST(GroupTest, DISABLED_MemoryFootprint)
+{
+    const int n_group = 10, n_tag = 30000;
+    char      name[32], address[32];
+
+    malloc_trim(0);
+    size_t base = heap_used();
+
+    // one heap copy per tag, as groups used to hold them
+    std::vector<neu_datatag_t *> copies;
+    for (int i = 0; i < n_group * n_tag; ++i) {
+        snprintf(name, sizeof(name), "tag%06d", i);
+        snprintf(address, sizeof(address), "1!4%05d", i % n_tag);
+        neu_datatag_t tag = make_tag(name, address, "");
+        copies.push_back(neu_tag_dup(&tag));
+    }
+    size_t dup_bytes = heap_used() - base;
+    for (neu_datatag_t *tag : copies) {
+        neu_tag_free(tag);
+    }
+    copies = std::vector<neu_datatag_t *>();
+    malloc_trim(0);
+
+    base = heap_used();
+    std::vector<neu_group_t *> groups;
+    for (int g = 0; g < n_group; ++g) {
+        snprintf(name, sizeof(name), "group%d", g);
+        groups.push_back(neu_group_new(name, 1000));
+        for (int i = 0; i < n_tag; ++i) {
+            snprintf(name, sizeof(name), "tag%06d", g * n_tag + i);
+            snprintf(address, sizeof(address), "1!4%05d", i);
+            neu_datatag_t tag = make_tag(name, address, "");
+            ASSERT_EQ(0, neu_group_add_tag(groups.back(), &tag));
+        }
+    }
+    size_t group_bytes = heap_used() - base;
+
+    printf("%d tags, heap copies: %zu bytes (%zu per tag), index aside\n",
+           n_group * n_tag, dup_bytes, dup_bytes / (n_group * n_tag));
+    printf("%d tags, groups: %zu bytes (%zu per tag), index included\n",
+           n_group * n_tag, group_bytes, group_bytes / (n_group * n_tag));
+
+    for (neu_group_t *group : groups) {
+        neu_group_destroy(group);
+    }
+}
@@ -0,0 +1,306 @@
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <gtest/gtest.h>
+#include <jansson.h>
+
+#include "json/json.h"
+#include "json/json_writer.h"
+#include "json/neu_json_fn.h"
+#include "json/neu_json_rw.h"
+
+#include "utils/log.h"
+
+zlog_category_t *neuron = NULL;
+
+static void set_tag(neu_resp_tag_value_t *tag, const char *name,
+                    neu_type_e type)
+{
+    memset(tag, 0, sizeof(*tag));
+    strcpy(tag->tag, name);
+    tag->value.type = type;
+}
+
+static const char *encode_upload(neu_json_writer_t *         w,
+                                 const neu_resp_tag_value_t *tags, int n,
+                                 bool values_format)
+{
+    neu_json_writer_reset(w);
+    neu_json_writer_object_begin(w);
+    neu_json_writer_key(w, "node");
+    neu_json_writer_str_value(w, "node0");
+    neu_json_writer_key(w, "group");
+    neu_json_writer_str_value(w, "grp0");
+    neu_json_writer_key(w, "timestamp");
+    neu_json_writer_int(w, 1649776722631);
+    if (values_format) {
+        neu_json_writer_tags_values(w, tags, n);
+    } else {
+        neu_json_writer_tags_array(w, tags, n);
+    }
+    neu_json_writer_object_end(w);
+    return neu_json_writer_str(w);
+}
+
+// the jansson based encoder the writer replaces
+static char *encode_upload_jansson(const neu_resp_tag_value_t *tags, int n,
+                                   bool values_format)
+{
+    char *                   result = NULL;
+    neu_json_read_resp_t     json   = { 0 };
+    neu_json_read_periodic_t header = {
+        .group     = (char *) "grp0",
+        .node      = (char *) "node0",
+        .timestamp = 1649776722631,
+    };
+
+    json.n_tag = n;
+    json.tags  = (neu_json_read_resp_tag_t *) calloc(
+        n, sizeof(neu_json_read_resp_tag_t));
+
+    for (int i = 0; i < n; i++) {
+        const neu_dvalue_t *v = &tags[i].value;
+
+        json.tags[i].name = (char *) tags[i].tag;
+        switch (v->type) {
+        case NEU_TYPE_ERROR:
+            json.tags[i].t             = NEU_JSON_INT;
+            json.tags[i].value.val_int = v->value.i32;
+            json.tags[i].error         = v->value.i32;
+            break;
+        case NEU_TYPE_INT32:
+            json.tags[i].t             = NEU_JSON_INT;
+            json.tags[i].value.val_int = v->value.i32;
+            break;
+        case NEU_TYPE_UINT16:
+            json.tags[i].t             = NEU_JSON_INT;
+            json.tags[i].value.val_int = v->value.u16;
+            break;
+        case NEU_TYPE_DOUBLE:
+            json.tags[i].t                = NEU_JSON_DOUBLE;
+            json.tags[i].value.val_double = v->value.d64;
+            json.tags[i].precision        = v->precision;
+            break;
+        case NEU_TYPE_BOOL:
+            json.tags[i].t              = NEU_JSON_BOOL;
+            json.tags[i].value.val_bool = v->value.boolean;
+            break;
+        case NEU_TYPE_STRING:
+            json.tags[i].t             = NEU_JSON_STR;
+            json.tags[i].value.val_str = (char *) v->value.str;
+            break;
+        default:
+            break;
+        }
+    }
+
+    neu_json_encode_with_mqtt(&json,
+                              values_format ? neu_json_encode_read_resp1
+                                            : neu_json_encode_read_resp,
+                              &header, neu_json_encode_read_periodic_resp,
+                              &result);
+    free(json.tags);
+    return result;
+}
+
+// one tag of every type handled by the jansson encoder above
+static int fill_tags(neu_resp_tag_value_t *tags, int n)
+{
+    char name[NEU_TAG_NAME_LEN] = { 0 };
+
+    for (int i = 0; i < n; i++) {
+        snprintf(name, sizeof(name), "tag%d", i);
+        switch (i % 6) {
+        case 0:
+            set_tag(&tags[i], name, NEU_TYPE_INT32);
+            tags[i].value.value.i32 = -123456 * i;
+            break;
+        case 1:
+            set_tag(&tags[i], name, NEU_TYPE_UINT16);
+            tags[i].value.value.u16 = 65535 - i;
+            break;
+        case 2:
+            set_tag(&tags[i], name, NEU_TYPE_DOUBLE);
+            tags[i].value.value.d64 = 1024.0 * i;
+            break;
+        case 3:
+            set_tag(&tags[i], name, NEU_TYPE_BOOL);
+            tags[i].value.value.boolean = i % 2;
+            break;
+        case 4:
+            set_tag(&tags[i], name, NEU_TYPE_STRING);
+            snprintf(tags[i].value.value.str, NEU_VALUE_SIZE, "str \"%d\"", i);
+            break;
+        case 5:
+            set_tag(&tags[i], name, NEU_TYPE_ERROR);
+            tags[i].value.value.i32 = 3000 + i;
+            break;
+        }
+    }
+
+    return n;
+}
+
+TEST(JsonWriterTest, ValuesFormat)
+{
+    neu_json_writer_t    w;
+    neu_resp_tag_value_t tags[3];
+
+    set_tag(&tags[0], "tag0", NEU_TYPE_INT16);
+    tags[0].value.value.i16 = -1;
+    set_tag(&tags[1], "tag1", NEU_TYPE_ERROR);
+    tags[1].value.value.i32 = 3000;
+    set_tag(&tags[2], "tag2", NEU_TYPE_BIT);
+    tags[2].value.value.u8 = 1;
+
+    neu_json_writer_init(&w, 0);
+    EXPECT_STREQ("{\"node\":\"node0\",\"group\":\"grp0\",\"timestamp\":"
+                 "1649776722631,\"values\":{\"tag0\":-1,\"tag2\":1},"
+                 "\"errors\":{\"tag1\":3000}}",
+                 encode_upload(&w, tags, 3, true));
+    neu_json_writer_fini(&w);
+}
+
+TEST(JsonWriterTest, TagsFormat)
+{
+    neu_json_writer_t    w;
+    neu_resp_tag_value_t tags[3];
+
+    set_tag(&tags[0], "tag0", NEU_TYPE_UINT64);
+    tags[0].value.value.u64 = UINT64_MAX;
+    set_tag(&tags[1], "tag1", NEU_TYPE_ERROR);
+    tags[1].value.value.i32 = 3000;
+    set_tag(&tags[2], "tag2", NEU_TYPE_BYTES);
+
+    neu_json_writer_init(&w, 0);
+    EXPECT_STREQ("{\"node\":\"node0\",\"group\":\"grp0\",\"timestamp\":"
+                 "1649776722631,\"tags\":[{\"name\":\"tag0\",\"value\":"
+                 "18446744073709551615},{\"name\":\"tag1\",\"error\":3000}]}",
+                 encode_upload(&w, tags, 3, false));
+    neu_json_writer_fini(&w);
+}
+
+TEST(JsonWriterTest, Escape)
+{
+    neu_json_writer_t w;
+
+    neu_json_writer_init(&w, 0);
+    neu_json_writer_str_value(&w, "a\"b\\c\n\t\x01/");
+    EXPECT_STREQ("\"a\\\"b\\\\c\\n\\t\\u0001/\"", neu_json_writer_str(&w));
+    neu_json_writer_fini(&w);
+}
+
+TEST(JsonWriterTest, Double)
+{
+    neu_json_writer_t w;
+
+    struct {
+        double      v;
+        uint8_t     precision;
+        const char *expect;
+    } cases[] = {
+        { 0.0, 0, "0.0" },          { 2.5, 0, "2.5" },
+        { 1e20, 0, "1e+20" },       { 3.14159, 2, "3.14" },
+        { -3.14159, 3, "-3.142" },  { 0.05, 1, "0.1" },
+        { 12.0, 4, "12.0000" },     { -0.001, 2, "0.00" },
+        { INFINITY, 0, "null" },    { 123456789.123, 2, "123456789.12" },
+        { 0.000001, 6, "0.000001" }, { 1e17, 1, "100000000000000000.0" },
+    };
+
+    neu_json_writer_init(&w, 0);
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        neu_json_writer_reset(&w);
+        neu_json_writer_double(&w, cases[i].v, cases[i].precision);
+        EXPECT_STREQ(cases[i].expect, neu_json_writer_str(&w));
+    }
+    neu_json_writer_fini(&w);
+}
+
+TEST(JsonWriterTest, Detach)
+{
+    neu_json_writer_t w;
+
+    neu_json_writer_init(&w, 0);
+    neu_json_writer_array_begin(&w);
+    for (int i = 0; i < 1000; i++) {
+        neu_json_writer_int(&w, i);
+    }
+    neu_json_writer_array_end(&w);
+
+    size_t cap = w.cap;
+    char * str = neu_json_writer_detach(&w);
+    EXPECT_EQ(0, strncmp(str, "[0,1,2,", 7));
+    EXPECT_EQ(NULL, w.buf);
+    EXPECT_EQ(cap, w.cap);
+    free(str);
+
+    neu_json_writer_bool(&w, true);
+    EXPECT_STREQ("true", neu_json_writer_str(&w));
+    neu_json_writer_fini(&w);
+}
+
+TEST(JsonWriterTest, SameAsJansson)
+{
+    neu_json_writer_t    w;
+    neu_resp_tag_value_t tags[60];
+    int                  n = fill_tags(tags, 60);
+
+    neu_json_writer_init(&w, 0);
+    for (int format = 0; format < 2; format++) {
+        char *  expect = encode_upload_jansson(tags, n, format);
+        json_t *a      = json_loads(expect, 0, NULL);
+        json_t *b      = json_loads(encode_upload(&w, tags, n, format), 0, NULL);
+
+        ASSERT_NE(nullptr, a);
+        ASSERT_NE(nullptr, b);
+        EXPECT_TRUE(json_equal(a, b));
+
+        json_decref(a);
+        json_decref(b);
+        free(expect);
+    }
+    neu_json_writer_fini(&w);
+}
+
+TEST(JsonWriterBench, UploadEncode)
+{
+    const int            n_tag   = 100;
+    const int            n_round = 2000;
+    neu_json_writer_t    w;
+    neu_resp_tag_value_t tags[n_tag];
+
+    fill_tags(tags, n_tag);
+    neu_json_writer_init(&w, 0);
+
+    for (int format = 0; format < 2; format++) {
+        size_t bytes_old = 0, bytes_new = 0;
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < n_round; i++) {
+            char *s = encode_upload_jansson(tags, n_tag, format);
+            bytes_old += strlen(s);
+            free(s);
+        }
+        auto mid = std::chrono::steady_clock::now();
+        for (int i = 0; i < n_round; i++) {
+            encode_upload(&w, tags, n_tag, format);
+            bytes_new += neu_json_writer_len(&w);
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        double ns_old =
+            std::chrono::duration<double, std::nano>(mid - start).count();
+        double ns_new =
+            std::chrono::duration<double, std::nano>(end - mid).count();
+
+        printf("[ bench    ] %s-format jansson: %.1f ns/tag %zu bytes, "
+               "writer: %.1f ns/tag %zu bytes\n",
+               format ? "values" : "tags", ns_old / (n_round * n_tag),
+               bytes_old / n_round, ns_new / (n_round * n_tag),
+               bytes_new / n_round);
+    }
+
+    neu_json_writer_fini(&w);
+}
@@ -2,6 +2,7 @@
 
 #include <gtest/gtest.h>
 
+#include "errcodes.h"
 #include "jwt.h"
 #include "utils/neu_jwt.h"
 
@@ -34,6 +35,27 @@ TEST(JwtTest, JwtValidate)
 
     jwt_free_str(token);
 }
+
+TEST(JwtTest, JwtRevoke)
+{
+    char *token         = NULL;
+    char  b_token[1024] = { 0 };
+
+    EXPECT_EQ(0, neu_jwt_init((char *) "./config"));
+    EXPECT_EQ(0, neu_jwt_new(&token));
+
+    snprintf(b_token, sizeof(b_token), "Bearer %s", token);
+
+    // the second time is answered from the cache
+    EXPECT_EQ(0, neu_jwt_validate(b_token));
+    EXPECT_EQ(0, neu_jwt_validate(b_token));
+
+    EXPECT_EQ(0, neu_jwt_revoke(b_token));
+    EXPECT_EQ(NEU_ERR_INVALID_TOKEN, neu_jwt_validate(b_token));
+
+    jwt_free_str(token);
+}
+
 int main(int argc, char **argv)
 {
     zlog_init("./config/dev.conf");
@@ -0,0 +1,67 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <gtest/gtest.h>
+
+#include "mqtt_topic.h"
+
+TEST(MqttTopicTest, Expand)
+{
+    char *topic = mqtt_topic_expand("/neuron/{app}/{node}/{group}/{tag}",
+                                    "app", "node", "group", NULL);
+    EXPECT_STREQ("/neuron/app/node/group/{tag}", topic);
+    free(topic);
+}
+
+TEST(MqttTopicTest, ListedTags)
+{
+    mqtt_tag_topics_t topics = { 0 };
+    char *            tags[] = { (char *) "t1", (char *) "t2" };
+
+    EXPECT_EQ(0, mqtt_tag_topics_init(&topics, strdup("/t/{tag}"), tags, 2));
+    EXPECT_STREQ("/t/t1", mqtt_tag_topics_get(&topics, "t1"));
+    EXPECT_STREQ("/t/t2", mqtt_tag_topics_get(&topics, "t2"));
+    EXPECT_EQ(NULL, mqtt_tag_topics_get(&topics, "t3"));
+
+    mqtt_tag_topics_clear(&topics);
+    EXPECT_STREQ("/t/t1", mqtt_tag_topics_get(&topics, "t1"));
+
+    mqtt_tag_topics_fini(&topics);
+}
+
+// topics of tags no longer reported are dropped, those in use are kept
+TEST(MqttTopicTest, AnyTagBounded)
+{
+    mqtt_tag_topics_t topics = { 0 };
+    char              tag[32];
+
+    EXPECT_EQ(0, mqtt_tag_topics_init(&topics, strdup("/t/{tag}"), NULL, 0));
+
+    // tags renamed over and over, one of them always reported
+    for (int i = 0; i < 100 * MQTT_TAG_TOPICS_MIN; ++i) {
+        mqtt_tag_topics_next(&topics);
+        snprintf(tag, sizeof(tag), "tag%d", i);
+        const char *topic = mqtt_tag_topics_get(&topics, tag);
+        ASSERT_NE(nullptr, topic);
+        EXPECT_EQ(0, strcmp(topic + 3, tag));
+        EXPECT_STREQ("/t/kept", mqtt_tag_topics_get(&topics, "kept"));
+
+        EXPECT_LE(HASH_COUNT(topics.tbl), (size_t) MQTT_TAG_TOPICS_MIN + 1);
+    }
+
+    // the tags in use grow past the minimum
+    for (int round = 0; round < 3; ++round) {
+        mqtt_tag_topics_next(&topics);
+        for (int i = 0; i < 4 * MQTT_TAG_TOPICS_MIN; ++i) {
+            snprintf(tag, sizeof(tag), "live%d", i);
+            EXPECT_NE(nullptr, mqtt_tag_topics_get(&topics, tag));
+        }
+    }
+    EXPECT_GE(HASH_COUNT(topics.tbl), (size_t) 4 * MQTT_TAG_TOPICS_MIN);
+    EXPECT_LE(HASH_COUNT(topics.tbl), (size_t) 8 * MQTT_TAG_TOPICS_MIN);
+
+    mqtt_tag_topics_clear(&topics);
+    EXPECT_EQ(0, HASH_COUNT(topics.tbl));
+
+    mqtt_tag_topics_fini(&topics);
+}
@@ -0,0 +1,75 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <gtest/gtest.h>
+#include <nng/nng.h>
+
+#include "adapter.h"
+
+static void fill_tag(neu_resp_tag_value_t *tag, const char *name, int32_t v)
+{
+    // as read_report_group does, the message is not zeroed
+    memset(tag, 0, sizeof(*tag));
+    strcpy(tag->tag, name);
+    tag->value.type      = NEU_TYPE_INT32;
+    tag->value.value.i32 = v;
+}
+
+static void fill_data(neu_reqresp_trans_data_t *data)
+{
+    strcpy(data->driver, "driver");
+    strcpy(data->group, "group");
+    data->timestamp = 1234567;
+    data->n_tag     = 2;
+    fill_tag(&data->tags[0], "tag0", 1);
+    fill_tag(&data->tags[1], "tag1", -1);
+}
+
+// a report filled in place is what neu_msg_gen made of a copied report
+TEST(MsgTest, TransDataInPlace)
+{
+    neu_reqresp_head_t header = {};
+    header.type               = NEU_REQRESP_TRANS_DATA;
+    strcpy(header.sender, "driver");
+
+    neu_reqresp_trans_data_t *copy = (neu_reqresp_trans_data_t *) calloc(
+        1, sizeof(neu_reqresp_trans_data_t) + 3 * sizeof(neu_resp_tag_value_t));
+    fill_data(copy);
+    nng_msg *expect = (nng_msg *) neu_msg_gen(&header, copy);
+    free(copy);
+
+    // room for 3 tags, one of them without a value
+    neu_reqresp_trans_data_t *data = NULL;
+    nng_msg *msg = (nng_msg *) neu_trans_data_msg_alloc(3, &data);
+    ASSERT_NE(nullptr, msg);
+    memset(&data->tags[2], 0xff, sizeof(data->tags[2]));
+    fill_data(data);
+
+    neu_reqresp_head_t *head = (neu_reqresp_head_t *) nng_msg_body(msg);
+    EXPECT_EQ(NEU_REQRESP_TRANS_DATA, head->type);
+    EXPECT_EQ((void *) &head[1], (void *) data);
+    strcpy(head->sender, "driver");
+    neu_trans_data_msg_trim(msg);
+
+    ASSERT_EQ(nng_msg_len(expect), nng_msg_len(msg));
+    EXPECT_EQ(0,
+              memcmp(nng_msg_body(expect), nng_msg_body(msg),
+                     nng_msg_len(msg)));
+
+    nng_msg_free(expect);
+    nng_msg_free(msg);
+}
+
+TEST(MsgTest, TransDataNoTag)
+{
+    neu_reqresp_trans_data_t *data = NULL;
+    nng_msg *msg = (nng_msg *) neu_trans_data_msg_alloc(0, &data);
+
+    ASSERT_NE(nullptr, msg);
+    EXPECT_EQ(0, data->n_tag);
+    neu_trans_data_msg_trim(msg);
+    EXPECT_EQ(sizeof(neu_reqresp_head_t) + sizeof(neu_reqresp_trans_data_t),
+              nng_msg_len(msg));
+
+    nng_msg_free(msg);
+}
@@ -0,0 +1,369 @@
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+
+#include <gtest/gtest.h>
+
+#include "utils/msgpack.h"
+#include "json/json_writer.h"
+
+#include "utils/log.h"
+
+zlog_category_t *neuron = NULL;
+
+static void set_tag(neu_resp_tag_value_t *tag, const char *name,
+                    neu_type_e type)
+{
+    memset(tag, 0, sizeof(*tag));
+    strcpy(tag->tag, name);
+    tag->value.type = type;
+}
+
+static int fill_tags(neu_resp_tag_value_t *tags, int n)
+{
+    char name[NEU_TAG_NAME_LEN] = { 0 };
+
+    for (int i = 0; i < n; i++) {
+        snprintf(name, sizeof(name), "tag%d", i);
+        switch (i % 6) {
+        case 0:
+            set_tag(&tags[i], name, NEU_TYPE_INT32);
+            tags[i].value.value.i32 = -123456 * i;
+            break;
+        case 1:
+            set_tag(&tags[i], name, NEU_TYPE_UINT16);
+            tags[i].value.value.u16 = 65535 - i;
+            break;
+        case 2:
+            set_tag(&tags[i], name, NEU_TYPE_DOUBLE);
+            tags[i].value.value.d64 = 1024.0 * i;
+            break;
+        case 3:
+            set_tag(&tags[i], name, NEU_TYPE_BOOL);
+            tags[i].value.value.boolean = i % 2;
+            break;
+        case 4:
+            set_tag(&tags[i], name, NEU_TYPE_STRING);
+            snprintf(tags[i].value.value.str, NEU_VALUE_SIZE, "str \"%d\"", i);
+            break;
+        case 5:
+            set_tag(&tags[i], name, NEU_TYPE_ERROR);
+            tags[i].value.value.i32 = 3000 + i;
+            break;
+        }
+    }
+
+    return n;
+}
+
+static void encode_upload(neu_msgpack_writer_t *      w,
+                          const neu_resp_tag_value_t *tags, int n)
+{
+    neu_msgpack_writer_reset(w);
+    neu_msgpack_write_map(w, 5);
+    neu_msgpack_write_str(w, "node");
+    neu_msgpack_write_str(w, "node0");
+    neu_msgpack_write_str(w, "group");
+    neu_msgpack_write_str(w, "grp0");
+    neu_msgpack_write_str(w, "timestamp");
+    neu_msgpack_write_int(w, 1649776722631);
+    neu_msgpack_write_tags_values(w, tags, n);
+}
+
+static void encode_upload_json(neu_json_writer_t *         w,
+                               const neu_resp_tag_value_t *tags, int n)
+{
+    neu_json_writer_reset(w);
+    neu_json_writer_object_begin(w);
+    neu_json_writer_key(w, "node");
+    neu_json_writer_str_value(w, "node0");
+    neu_json_writer_key(w, "group");
+    neu_json_writer_str_value(w, "grp0");
+    neu_json_writer_key(w, "timestamp");
+    neu_json_writer_int(w, 1649776722631);
+    neu_json_writer_tags_values(w, tags, n);
+    neu_json_writer_object_end(w);
+}
+
+static bool str_eq(const neu_msgpack_value_t *v, const char *s)
+{
+    return NEU_MSGPACK_STR == v->type && strlen(s) == v->v.str.len &&
+        0 == memcmp(v->v.str.ptr, s, v->v.str.len);
+}
+
+TEST(MsgpackTest, Integers)
+{
+    neu_msgpack_writer_t w;
+    neu_msgpack_writer_init(&w, 0);
+
+    neu_msgpack_write_uint(&w, 127);
+    neu_msgpack_write_uint(&w, 128);
+    neu_msgpack_write_uint(&w, 65536);
+    neu_msgpack_write_int(&w, -1);
+    neu_msgpack_write_int(&w, -33);
+    neu_msgpack_write_int(&w, -32769);
+    neu_msgpack_write_int(&w, INT64_MIN);
+
+    const uint8_t expect[] = {
+        0x7f, 0xcc, 0x80, 0xce, 0x00, 0x01, 0x00, 0x00, 0xff, 0xd0, 0xdf,
+        0xd2, 0xff, 0xff, 0x7f, 0xff, 0xd3, 0x80, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00,
+    };
+    ASSERT_EQ(sizeof(expect), neu_msgpack_writer_len(&w));
+    EXPECT_EQ(0, memcmp(expect, w.buf, sizeof(expect)));
+
+    neu_msgpack_reader_t r;
+    neu_msgpack_value_t  v;
+    neu_msgpack_reader_init(&r, w.buf, w.len);
+
+    const int64_t ints[] = { 127, 128, 65536, -1, -33, -32769, INT64_MIN };
+    for (int64_t i : ints) {
+        ASSERT_EQ(0, neu_msgpack_read(&r, &v));
+        if (NEU_MSGPACK_UINT == v.type) {
+            EXPECT_EQ((uint64_t) i, v.v.u64);
+        } else {
+            ASSERT_EQ(NEU_MSGPACK_INT, v.type);
+            EXPECT_EQ(i, v.v.i64);
+        }
+    }
+    EXPECT_EQ(-1, neu_msgpack_read(&r, &v));
+
+    neu_msgpack_writer_fini(&w);
+}
+
+TEST(MsgpackTest, Strings)
+{
+    neu_msgpack_writer_t w;
+    neu_msgpack_reader_t r;
+    neu_msgpack_value_t  v;
+    char                 s[300];
+
+    neu_msgpack_writer_init(&w, 0);
+
+    memset(s, 'a', sizeof(s) - 1);
+    s[sizeof(s) - 1] = '\0';
+
+    neu_msgpack_write_str(&w, "");
+    neu_msgpack_write_str(&w, "tag0");
+    s[32] = '\0';
+    neu_msgpack_write_str(&w, s);
+    s[32] = 'a';
+    neu_msgpack_write_str(&w, s);
+
+    EXPECT_EQ(0xa0, w.buf[0]);
+    EXPECT_EQ(0xa4, w.buf[1]);
+    EXPECT_EQ(0xd9, w.buf[6]);
+    EXPECT_EQ(32, w.buf[7]);
+    EXPECT_EQ(0xda, w.buf[8 + 32]);
+
+    neu_msgpack_reader_init(&r, w.buf, w.len);
+    ASSERT_EQ(0, neu_msgpack_read(&r, &v));
+    EXPECT_TRUE(str_eq(&v, ""));
+    ASSERT_EQ(0, neu_msgpack_read(&r, &v));
+    EXPECT_TRUE(str_eq(&v, "tag0"));
+    ASSERT_EQ(0, neu_msgpack_read(&r, &v));
+    EXPECT_EQ(32U, v.v.str.len);
+    ASSERT_EQ(0, neu_msgpack_read(&r, &v));
+    EXPECT_TRUE(str_eq(&v, s));
+
+    // truncated payload
+    neu_msgpack_reader_init(&r, w.buf, w.len - 1);
+    EXPECT_EQ(0, neu_msgpack_skip(&r));
+    EXPECT_EQ(0, neu_msgpack_skip(&r));
+    EXPECT_EQ(0, neu_msgpack_skip(&r));
+    EXPECT_EQ(-1, neu_msgpack_read(&r, &v));
+
+    neu_msgpack_writer_fini(&w);
+}
+
+TEST(MsgpackTest, Floats)
+{
+    neu_msgpack_writer_t w;
+    neu_msgpack_reader_t r;
+    neu_msgpack_value_t  v;
+
+    neu_msgpack_writer_init(&w, 0);
+    neu_msgpack_write_float(&w, 1.5f);
+    neu_msgpack_write_double(&w, 0.1);
+
+    const uint8_t expect[] = { 0xca, 0x3f, 0xc0, 0x00, 0x00 };
+    EXPECT_EQ(0, memcmp(expect, w.buf, sizeof(expect)));
+    EXPECT_EQ(5U + 9U, neu_msgpack_writer_len(&w));
+
+    neu_msgpack_reader_init(&r, w.buf, w.len);
+    ASSERT_EQ(0, neu_msgpack_read(&r, &v));
+    EXPECT_EQ(NEU_MSGPACK_DOUBLE, v.type);
+    EXPECT_EQ(1.5, v.v.d64);
+    ASSERT_EQ(0, neu_msgpack_read(&r, &v));
+    EXPECT_EQ(0.1, v.v.d64);
+
+    neu_msgpack_writer_fini(&w);
+}
+
+TEST(MsgpackTest, Upload)
+{
+    neu_msgpack_writer_t w;
+    neu_msgpack_reader_t r;
+    neu_msgpack_value_t  v;
+    neu_resp_tag_value_t tags[12];
+
+    fill_tags(tags, 12);
+    set_tag(&tags[11], "bytes", NEU_TYPE_BYTES);
+
+    neu_msgpack_writer_init(&w, 0);
+    encode_upload(&w, tags, 12);
+
+    neu_msgpack_reader_init(&r, w.buf, w.len);
+    ASSERT_EQ(0, neu_msgpack_read(&r, &v));
+    ASSERT_EQ(NEU_MSGPACK_MAP, v.type);
+    EXPECT_EQ(5U, v.v.n);
+
+    ASSERT_EQ(0, neu_msgpack_read(&r, &v));
+    EXPECT_TRUE(str_eq(&v, "node"));
+    ASSERT_EQ(0, neu_msgpack_read(&r, &v));
+    EXPECT_TRUE(str_eq(&v, "node0"));
+    ASSERT_EQ(0, neu_msgpack_skip(&r));
+    ASSERT_EQ(0, neu_msgpack_skip(&r));
+    ASSERT_EQ(0, neu_msgpack_skip(&r));
+    ASSERT_EQ(0, neu_msgpack_read(&r, &v));
+    EXPECT_EQ(1649776722631, v.v.i64);
+
+    ASSERT_EQ(0, neu_msgpack_read(&r, &v));
+    EXPECT_TRUE(str_eq(&v, "values"));
+    ASSERT_EQ(0, neu_msgpack_read(&r, &v));
+    ASSERT_EQ(NEU_MSGPACK_MAP, v.type);
+    EXPECT_EQ(10U, v.v.n); // one error and one bytes tag left out
+
+    ASSERT_EQ(0, neu_msgpack_read(&r, &v));
+    EXPECT_TRUE(str_eq(&v, "tag0"));
+    ASSERT_EQ(0, neu_msgpack_read(&r, &v));
+    EXPECT_EQ(0U, v.v.u64);
+    ASSERT_EQ(0, neu_msgpack_read(&r, &v));
+    EXPECT_TRUE(str_eq(&v, "tag1"));
+    ASSERT_EQ(0, neu_msgpack_read(&r, &v));
+    EXPECT_EQ(65534U, v.v.u64);
+    ASSERT_EQ(0, neu_msgpack_read(&r, &v));
+    EXPECT_TRUE(str_eq(&v, "tag2"));
+    ASSERT_EQ(0, neu_msgpack_read(&r, &v));
+    EXPECT_EQ(2048.0, v.v.d64);
+    ASSERT_EQ(0, neu_msgpack_read(&r, &v));
+    EXPECT_TRUE(str_eq(&v, "tag3"));
+    ASSERT_EQ(0, neu_msgpack_read(&r, &v));
+    EXPECT_EQ(NEU_MSGPACK_BOOL, v.type);
+    EXPECT_TRUE(v.v.boolean);
+    ASSERT_EQ(0, neu_msgpack_read(&r, &v));
+    EXPECT_TRUE(str_eq(&v, "tag4"));
+    ASSERT_EQ(0, neu_msgpack_read(&r, &v));
+    EXPECT_TRUE(str_eq(&v, "str \"4\""));
+    for (int i = 0; i < 5 * 2; ++i) {
+        ASSERT_EQ(0, neu_msgpack_skip(&r));
+    }
+
+    ASSERT_EQ(0, neu_msgpack_read(&r, &v));
+    EXPECT_TRUE(str_eq(&v, "errors"));
+    ASSERT_EQ(0, neu_msgpack_read(&r, &v));
+    ASSERT_EQ(NEU_MSGPACK_MAP, v.type);
+    EXPECT_EQ(1U, v.v.n);
+    ASSERT_EQ(0, neu_msgpack_read(&r, &v));
+    EXPECT_TRUE(str_eq(&v, "tag5"));
+    ASSERT_EQ(0, neu_msgpack_read(&r, &v));
+    EXPECT_EQ(3005U, v.v.u64);
+    EXPECT_EQ(r.end, r.p);
+
+    neu_msgpack_writer_fini(&w);
+}
+
+TEST(MsgpackTest, Skip)
+{
+    neu_msgpack_writer_t w;
+    neu_msgpack_reader_t r;
+    neu_msgpack_value_t  v;
+
+    neu_msgpack_writer_init(&w, 0);
+    neu_msgpack_write_map(&w, 2);
+    neu_msgpack_write_str(&w, "a");
+    neu_msgpack_write_array(&w, 20);
+    for (int i = 0; i < 20; ++i) {
+        neu_msgpack_write_map(&w, 1);
+        neu_msgpack_write_nil(&w);
+        neu_msgpack_write_bool(&w, false);
+    }
+    neu_msgpack_write_str(&w, "b");
+    neu_msgpack_write_uint(&w, 1);
+    neu_msgpack_write_uint(&w, 2);
+
+    EXPECT_EQ(0xdc, w.buf[3]);
+
+    neu_msgpack_reader_init(&r, w.buf, w.len);
+    EXPECT_EQ(0, neu_msgpack_skip(&r));
+    ASSERT_EQ(0, neu_msgpack_read(&r, &v));
+    EXPECT_EQ(2U, v.v.u64);
+    EXPECT_EQ(-1, neu_msgpack_skip(&r));
+
+    // unsupported bin marker
+    const uint8_t bin[] = { 0xc4, 0x01, 0x00 };
+    neu_msgpack_reader_init(&r, bin, sizeof(bin));
+    EXPECT_EQ(-1, neu_msgpack_read(&r, &v));
+
+    neu_msgpack_writer_fini(&w);
+}
+
+TEST(MsgpackTest, Detach)
+{
+    neu_msgpack_writer_t w;
+
+    neu_msgpack_writer_init(&w, 0);
+    EXPECT_EQ(NULL, neu_msgpack_writer_detach(&w));
+
+    neu_msgpack_write_nil(&w);
+    uint8_t *buf = neu_msgpack_writer_detach(&w);
+    ASSERT_NE(nullptr, buf);
+    EXPECT_EQ(0xc0, buf[0]);
+    EXPECT_EQ(0U, neu_msgpack_writer_len(&w));
+    free(buf);
+
+    neu_msgpack_write_bool(&w, true);
+    EXPECT_EQ(0xc3, w.buf[0]);
+
+    neu_msgpack_writer_fini(&w);
+}
+
+TEST(MsgpackBench, UploadEncode)
+{
+    const int            n_tag   = 100;
+    const int            n_round = 2000;
+    neu_json_writer_t    jw;
+    neu_msgpack_writer_t mw;
+    neu_resp_tag_value_t tags[n_tag];
+    size_t               bytes_json = 0, bytes_msgpack = 0;
+
+    fill_tags(tags, n_tag);
+    neu_json_writer_init(&jw, 0);
+    neu_msgpack_writer_init(&mw, 0);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < n_round; i++) {
+        encode_upload_json(&jw, tags, n_tag);
+        bytes_json += neu_json_writer_len(&jw);
+    }
+    auto mid = std::chrono::steady_clock::now();
+    for (int i = 0; i < n_round; i++) {
+        encode_upload(&mw, tags, n_tag);
+        bytes_msgpack += neu_msgpack_writer_len(&mw);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double ns_json =
+        std::chrono::duration<double, std::nano>(mid - start).count();
+    double ns_msgpack =
+        std::chrono::duration<double, std::nano>(end - mid).count();
+
+    printf("[ bench    ] values-format json: %.1f ns/tag %zu bytes, "
+           "msgpack: %.1f ns/tag %zu bytes\n",
+           ns_json / (n_round * n_tag), bytes_json / n_round,
+           ns_msgpack / (n_round * n_tag), bytes_msgpack / n_round);
+    EXPECT_LT(bytes_msgpack, bytes_json);
+
+    neu_json_writer_fini(&jw);
+    neu_msgpack_writer_fini(&mw);
+}
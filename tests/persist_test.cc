@@ -0,0 +1,308 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include "persist/persist.h"
+#include "tag.h"
+#include "utils/time.h"
+
+#include "utils/log.h"
+
+zlog_category_t *neuron = NULL;
+
+class PersistTest : public testing::Test {
+protected:
+    void SetUp() override
+    {
+        remove("persistence/sqlite.db");
+        remove("persistence/sqlite.db-wal");
+        remove("persistence/sqlite.db-shm");
+        ASSERT_EQ(0, neu_persister_create("persistence"));
+    }
+
+    void TearDown() override { neu_persister_destroy(); }
+};
+
+TEST_F(PersistTest, WriteBehind)
+{
+    neu_persist_node_info_t  node  = { (char *) "modbus", 1,
+                                     (char *) "Modbus TCP", 1 };
+    neu_persist_group_info_t group = { 100, (char *) "group" };
+    neu_datatag_t            tags[300];
+    char                     names[300][16];
+
+    memset(tags, 0, sizeof(tags));
+    for (int i = 0; i < 300; ++i) {
+        snprintf(names[i], sizeof(names[i]), "tag%d", i);
+        tags[i].name        = names[i];
+        tags[i].address     = (char *) "1!400001";
+        tags[i].description = (char *) "";
+        tags[i].attribute   = NEU_ATTRIBUTE_READ;
+        tags[i].type        = NEU_TYPE_INT16;
+    }
+
+    EXPECT_EQ(0, neu_persister_store_node(&node));
+    EXPECT_EQ(0, neu_persister_store_group("modbus", &group));
+    EXPECT_EQ(0, neu_persister_store_tags("modbus", "group", tags, 300));
+    for (int i = 0; i < 500; ++i) {
+        EXPECT_EQ(0, neu_persister_update_node_state("modbus", 1 + i % 2));
+    }
+    EXPECT_EQ(0, neu_persister_flush());
+
+    // reads see every change queued before
+    UT_array *loaded = NULL;
+    EXPECT_EQ(0, neu_persister_load_tags("modbus", "group", &loaded));
+    EXPECT_EQ(300, utarray_len(loaded));
+    utarray_free(loaded);
+
+    neu_persist_stats_t stats = {};
+    neu_persister_stats(&stats);
+    EXPECT_EQ(0, stats.queued_ops);
+    EXPECT_EQ(503, stats.ops_total);
+    EXPECT_EQ(0, stats.errors_total);
+    // changes share transactions
+    EXPECT_LT(stats.batches_total, 503);
+}
+
+TEST_F(PersistTest, FailedChangeIsolated)
+{
+    neu_persist_node_info_t  node  = { (char *) "modbus", 1,
+                                     (char *) "Modbus TCP", 1 };
+    neu_persist_group_info_t group = { 100, (char *) "group" };
+
+    EXPECT_EQ(0, neu_persister_store_node(&node));
+    // no such node, fails on commit
+    EXPECT_EQ(0, neu_persister_store_group("opcua", &group));
+    EXPECT_EQ(0, neu_persister_store_group("modbus", &group));
+    EXPECT_NE(0, neu_persister_flush());
+    EXPECT_EQ(0, neu_persister_flush());
+
+    UT_array *groups = NULL;
+    EXPECT_EQ(0, neu_persister_load_groups("modbus", &groups));
+    EXPECT_EQ(1, utarray_len(groups));
+    utarray_free(groups);
+
+    neu_persist_stats_t stats = {};
+    neu_persister_stats(&stats);
+    EXPECT_EQ(1, stats.errors_total);
+}
+
+// run with --gtest_also_run_disabled_tests
+TEST_F(PersistTest, DISABLED_Benchmark100kTags)
+{
+    const int                n     = 100000;
+    neu_persist_node_info_t  node  = { (char *) "modbus", 1,
+                                     (char *) "Modbus TCP", 1 };
+    neu_persist_group_info_t group = { 100, (char *) "group" };
+    neu_datatag_t *          tags  = (neu_datatag_t *) calloc(n, sizeof(*tags));
+
+    for (int i = 0; i < n; ++i) {
+        char name[16];
+        snprintf(name, sizeof(name), "tag%d", i);
+        tags[i].name        = strdup(name);
+        tags[i].address     = strdup("1!400001");
+        tags[i].description = strdup("");
+        tags[i].attribute   = NEU_ATTRIBUTE_READ;
+        tags[i].type        = NEU_TYPE_INT16;
+    }
+
+    EXPECT_EQ(0, neu_persister_store_node(&node));
+    EXPECT_EQ(0, neu_persister_store_group("modbus", &group));
+
+    int64_t start = neu_time_ms();
+    for (int i = 0; i < n; ++i) {
+        EXPECT_EQ(0, neu_persister_store_tag("modbus", "group", &tags[i]));
+    }
+    EXPECT_EQ(0, neu_persister_flush());
+    printf("store  %d tags: %" PRId64 " ms\n", n, neu_time_ms() - start);
+
+    start = neu_time_ms();
+    for (int i = 0; i < n; ++i) {
+        tags[i].precision = 2;
+        EXPECT_EQ(0, neu_persister_update_tag("modbus", "group", &tags[i]));
+    }
+    EXPECT_EQ(0, neu_persister_flush());
+    printf("update %d tags: %" PRId64 " ms\n", n, neu_time_ms() - start);
+
+    UT_array *loaded = NULL;
+    start            = neu_time_ms();
+    EXPECT_EQ(0, neu_persister_load_tags("modbus", "group", &loaded));
+    printf("load   %d tags: %" PRId64 " ms\n", n, neu_time_ms() - start);
+    EXPECT_EQ(n, utarray_len(loaded));
+    utarray_free(loaded);
+
+    // cold start from the snapshot written on shutdown
+    neu_persister_destroy();
+    ASSERT_EQ(0, neu_persister_create("persistence"));
+    start = neu_time_ms();
+    EXPECT_EQ(0, neu_persister_load_tags("modbus", "group", &loaded));
+    printf("load   %d tags from snapshot: %" PRId64 " ms\n", n,
+           neu_time_ms() - start);
+    EXPECT_EQ(n, utarray_len(loaded));
+    utarray_free(loaded);
+
+    for (int i = 0; i < n; ++i) {
+        neu_tag_fini(&tags[i]);
+    }
+    free(tags);
+}
+
+static void store_config()
+{
+    neu_persist_node_info_t  node  = { (char *) "modbus", 1,
+                                     (char *) "Modbus TCP", 1 };
+    neu_persist_node_info_t  app   = { (char *) "mqtt", 2, (char *) "MQTT", 1 };
+    neu_persist_group_info_t group = { 100, (char *) "group" };
+    neu_datatag_t            tag   = { 0 };
+
+    tag.name        = (char *) "tag";
+    tag.address     = (char *) "1!400001";
+    tag.description = (char *) "desc";
+    tag.attribute   = NEU_ATTRIBUTE_READ;
+    tag.type        = NEU_TYPE_INT16;
+
+    EXPECT_EQ(0, neu_persister_store_node(&node));
+    EXPECT_EQ(0, neu_persister_store_node(&app));
+    EXPECT_EQ(0, neu_persister_store_node_setting("modbus", "{}"));
+    EXPECT_EQ(0, neu_persister_store_group("modbus", &group));
+    EXPECT_EQ(0, neu_persister_store_tag("modbus", "group", &tag));
+    EXPECT_EQ(0,
+              neu_persister_store_subscription("mqtt", "modbus", "group", NULL));
+    EXPECT_EQ(0, neu_persister_flush());
+}
+
+static void check_config(const char *description)
+{
+    UT_array *  nodes = NULL, *groups = NULL, *tags = NULL, *subs = NULL;
+    const char *setting = NULL;
+
+    EXPECT_EQ(0, neu_persister_load_nodes(&nodes));
+    ASSERT_EQ(2, utarray_len(nodes));
+    neu_persist_node_info_t *node =
+        (neu_persist_node_info_t *) utarray_front(nodes);
+    EXPECT_STREQ("modbus", node->name);
+    EXPECT_STREQ("Modbus TCP", node->plugin_name);
+    EXPECT_EQ(1, node->type);
+    utarray_free(nodes);
+
+    EXPECT_EQ(0, neu_persister_load_node_setting("modbus", &setting));
+    EXPECT_STREQ("{}", setting);
+    free((char *) setting);
+    EXPECT_NE(0, neu_persister_load_node_setting("mqtt", &setting));
+
+    EXPECT_EQ(0, neu_persister_load_groups("modbus", &groups));
+    ASSERT_EQ(1, utarray_len(groups));
+    EXPECT_EQ(100,
+              ((neu_persist_group_info_t *) utarray_front(groups))->interval);
+    utarray_free(groups);
+
+    EXPECT_EQ(0, neu_persister_load_tags("modbus", "group", &tags));
+    ASSERT_EQ(1, utarray_len(tags));
+    neu_datatag_t *tag = (neu_datatag_t *) utarray_front(tags);
+    EXPECT_STREQ("1!400001", tag->address);
+    EXPECT_STREQ(description, tag->description);
+    utarray_free(tags);
+
+    EXPECT_EQ(0, neu_persister_load_subscriptions("mqtt", &subs));
+    ASSERT_EQ(1, utarray_len(subs));
+    neu_persist_subscription_info_t *sub =
+        (neu_persist_subscription_info_t *) utarray_front(subs);
+    EXPECT_STREQ("group", sub->group_name);
+    EXPECT_EQ(NULL, sub->params);
+    utarray_free(subs);
+}
+
+TEST_F(PersistTest, SnapshotRestart)
+{
+    store_config();
+
+    // the snapshot is written on shutdown at the latest
+    neu_persister_destroy();
+    EXPECT_EQ(0, access("persistence/snapshot.bin", R_OK));
+    ASSERT_EQ(0, neu_persister_create("persistence"));
+    check_config("desc");
+
+    // changes after the snapshot are read from the database
+    neu_datatag_t tag = { 0 };
+    tag.name          = (char *) "tag";
+    tag.address       = (char *) "1!400001";
+    tag.description   = (char *) "changed";
+    tag.attribute     = NEU_ATTRIBUTE_READ;
+    tag.type          = NEU_TYPE_INT16;
+    EXPECT_EQ(0, neu_persister_update_tag("modbus", "group", &tag));
+    check_config("changed");
+
+    neu_persister_destroy();
+    ASSERT_EQ(0, neu_persister_create("persistence"));
+    check_config("changed");
+}
+
+TEST_F(PersistTest, SnapshotKeptByNodeStates)
+{
+    neu_persist_node_info_t  node  = { (char *) "opcua", 1, (char *) "OPC UA",
+                                     1 };
+    neu_persist_group_info_t group = { 200, (char *) "other" };
+
+    store_config();
+    EXPECT_EQ(0, neu_persister_store_node(&node));
+    EXPECT_EQ(0, neu_persister_store_group("opcua", &group));
+    EXPECT_EQ(0, neu_persister_flush());
+    neu_persister_destroy();
+    ASSERT_EQ(0, neu_persister_create("persistence"));
+
+    // as on startup, each adapter stores its state once loaded
+    UT_array *nodes = NULL, *groups = NULL;
+    EXPECT_EQ(0, neu_persister_load_nodes(&nodes));
+    EXPECT_EQ(3, utarray_len(nodes));
+    utarray_free(nodes);
+    EXPECT_EQ(0, neu_persister_load_groups("modbus", &groups));
+    EXPECT_EQ(1, utarray_len(groups));
+    utarray_free(groups);
+    EXPECT_EQ(0, neu_persister_update_node_state("modbus", 2));
+    EXPECT_EQ(0, neu_persister_load_groups("opcua", &groups));
+    ASSERT_EQ(1, utarray_len(groups));
+    EXPECT_EQ(200,
+              ((neu_persist_group_info_t *) utarray_front(groups))->interval);
+    utarray_free(groups);
+    EXPECT_EQ(0, neu_persister_update_node_state("opcua", 2));
+
+    neu_persist_stats_t stats = {};
+    neu_persister_stats(&stats);
+    EXPECT_EQ(3, stats.snapshot_loads);
+
+    // but node states are read from the database
+    EXPECT_EQ(0, neu_persister_load_nodes(&nodes));
+    utarray_foreach(nodes, neu_persist_node_info_t *, info)
+    {
+        EXPECT_EQ(strcmp(info->name, "mqtt") == 0 ? 1 : 2, info->state);
+    }
+    utarray_free(nodes);
+    neu_persister_stats(&stats);
+    EXPECT_EQ(3, stats.snapshot_loads);
+
+    // other changes retire the snapshot
+    EXPECT_EQ(0, neu_persister_delete_node("opcua"));
+    EXPECT_EQ(0, neu_persister_load_groups("modbus", &groups));
+    EXPECT_EQ(1, utarray_len(groups));
+    utarray_free(groups);
+    neu_persister_stats(&stats);
+    EXPECT_EQ(3, stats.snapshot_loads);
+}
+
+TEST_F(PersistTest, SnapshotCorrupt)
+{
+    store_config();
+    neu_persister_destroy();
+
+    FILE *fp = fopen("persistence/snapshot.bin", "r+b");
+    ASSERT_NE(nullptr, fp);
+    fseek(fp, -8, SEEK_END);
+    fputc('x', fp);
+    fclose(fp);
+
+    // falls back to the database
+    ASSERT_EQ(0, neu_persister_create("persistence"));
+    check_config("desc");
+}
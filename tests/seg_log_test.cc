@@ -0,0 +1,285 @@
+#include <dirent.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include "utils/seg_log.h"
+
+#include "utils/log.h"
+
+zlog_category_t *neuron = NULL;
+
+#define SEG_SIZE (64 * 1024)
+
+static std::string make_dir(const char *name)
+{
+    std::string dir = std::string("/tmp/neu_seg_log_") + name;
+    std::string cmd = "rm -rf " + dir;
+    EXPECT_EQ(0, system(cmd.c_str()));
+    return dir;
+}
+
+static std::string record(int i, size_t len)
+{
+    std::string s(len, 'a' + i % 26);
+    snprintf(&s[0], len, "%d", i);
+    return s;
+}
+
+static void expect_pop(neu_seg_log_t *log, const std::string &expect)
+{
+    uint64_t    seq  = 0;
+    const void *data = NULL;
+    size_t      len  = 0;
+
+    ASSERT_EQ(0, neu_seg_log_peek(log, &seq, &data, &len));
+    EXPECT_EQ(expect, std::string((const char *) data, len));
+    neu_seg_log_pop(log, seq);
+}
+
+TEST(SegLogTest, AppendPop)
+{
+    std::string    dir = make_dir("append");
+    neu_seg_log_t *log = neu_seg_log_open(dir.c_str(), SEG_SIZE, 1 << 20);
+    ASSERT_NE(nullptr, log);
+
+    EXPECT_EQ(-1, neu_seg_log_append(log, "", 0));
+    for (int i = 0; i < 1000; ++i) {
+        std::string r = record(i, 1 + i % 300);
+        ASSERT_EQ(0, neu_seg_log_append(log, r.data(), r.size()));
+    }
+    EXPECT_EQ(1000U, neu_seg_log_count(log));
+    EXPECT_LE(neu_seg_log_disk_bytes(log), 1U << 20);
+
+    for (int i = 0; i < 1000; ++i) {
+        expect_pop(log, record(i, 1 + i % 300));
+    }
+
+    uint64_t    seq  = 0;
+    const void *data = NULL;
+    size_t      len  = 0;
+    EXPECT_EQ(-1, neu_seg_log_peek(log, &seq, &data, &len));
+    EXPECT_EQ(0U, neu_seg_log_count(log));
+    EXPECT_EQ(0U, neu_seg_log_bytes(log));
+    // consumed segments are deleted, only the tail is left
+    EXPECT_EQ((size_t) SEG_SIZE, neu_seg_log_disk_bytes(log));
+
+    neu_seg_log_close(log);
+}
+
+TEST(SegLogTest, Evict)
+{
+    std::string    dir = make_dir("evict");
+    size_t         max = 4 * SEG_SIZE;
+    neu_seg_log_t *log = neu_seg_log_open(dir.c_str(), SEG_SIZE, max);
+    ASSERT_NE(nullptr, log);
+
+    int n = 0;
+    for (; n < 10000; ++n) {
+        std::string r = record(n, 100);
+        ASSERT_EQ(0, neu_seg_log_append(log, r.data(), r.size()));
+        ASSERT_LE(neu_seg_log_disk_bytes(log), max);
+    }
+
+    EXPECT_GT(neu_seg_log_evicted(log), 0U);
+    EXPECT_EQ((size_t) n, neu_seg_log_count(log) + neu_seg_log_evicted(log));
+    EXPECT_EQ(neu_seg_log_count(log) * 100, neu_seg_log_bytes(log));
+
+    // the newest records survive, in order
+    for (int i = (int) neu_seg_log_evicted(log); i < n; ++i) {
+        expect_pop(log, record(i, 100));
+    }
+    EXPECT_EQ(0U, neu_seg_log_count(log));
+
+    // larger than the budget
+    std::string big(max, 'x');
+    EXPECT_EQ(-1, neu_seg_log_append(log, big.data(), big.size()));
+
+    neu_seg_log_close(log);
+}
+
+TEST(SegLogTest, StalePop)
+{
+    std::string    dir = make_dir("stale");
+    neu_seg_log_t *log = neu_seg_log_open(dir.c_str(), SEG_SIZE, 2 * SEG_SIZE);
+    ASSERT_NE(nullptr, log);
+
+    std::string r = record(0, 1000);
+    ASSERT_EQ(0, neu_seg_log_append(log, r.data(), r.size()));
+
+    uint64_t    seq  = 0;
+    const void *data = NULL;
+    size_t      len  = 0;
+    ASSERT_EQ(0, neu_seg_log_peek(log, &seq, &data, &len));
+
+    // evict the record being peeked
+    for (int i = 1; i < 200; ++i) {
+        std::string r = record(i, 1000);
+        ASSERT_EQ(0, neu_seg_log_append(log, r.data(), r.size()));
+    }
+    ASSERT_GT(neu_seg_log_evicted(log), 0U);
+
+    size_t count = neu_seg_log_count(log);
+    neu_seg_log_pop(log, seq);
+    EXPECT_EQ(count, neu_seg_log_count(log));
+
+    neu_seg_log_close(log);
+}
+
+TEST(SegLogTest, Recover)
+{
+    std::string    dir = make_dir("recover");
+    neu_seg_log_t *log = neu_seg_log_open(dir.c_str(), SEG_SIZE, 1 << 20);
+    ASSERT_NE(nullptr, log);
+
+    for (int i = 0; i < 2000; ++i) {
+        std::string r = record(i, 200);
+        ASSERT_EQ(0, neu_seg_log_append(log, r.data(), r.size()));
+    }
+    for (int i = 0; i < 500; ++i) {
+        expect_pop(log, record(i, 200));
+    }
+    size_t disk = neu_seg_log_disk_bytes(log);
+    neu_seg_log_close(log);
+
+    log = neu_seg_log_open(dir.c_str(), SEG_SIZE, 1 << 20);
+    ASSERT_NE(nullptr, log);
+    EXPECT_EQ(1500U, neu_seg_log_count(log));
+    EXPECT_EQ(1500U * 200, neu_seg_log_bytes(log));
+    EXPECT_EQ(disk, neu_seg_log_disk_bytes(log));
+
+    // appending continues after the recovered records
+    std::string r = record(2000, 200);
+    ASSERT_EQ(0, neu_seg_log_append(log, r.data(), r.size()));
+    for (int i = 500; i <= 2000; ++i) {
+        expect_pop(log, record(i, 200));
+    }
+    EXPECT_EQ(0U, neu_seg_log_count(log));
+    neu_seg_log_close(log);
+
+    // a smaller budget evicts on open
+    log = neu_seg_log_open(dir.c_str(), SEG_SIZE, 1 << 20);
+    for (int i = 0; i < 1000; ++i) {
+        std::string r = record(i, 200);
+        ASSERT_EQ(0, neu_seg_log_append(log, r.data(), r.size()));
+    }
+    neu_seg_log_close(log);
+    log = neu_seg_log_open(dir.c_str(), SEG_SIZE, 2 * SEG_SIZE);
+    ASSERT_NE(nullptr, log);
+    EXPECT_LE(neu_seg_log_disk_bytes(log), 2U * SEG_SIZE);
+    EXPECT_EQ(1000U, neu_seg_log_count(log) + neu_seg_log_evicted(log));
+    neu_seg_log_close(log);
+}
+
+TEST(SegLogTest, TornTail)
+{
+    std::string    dir = make_dir("torn");
+    neu_seg_log_t *log = neu_seg_log_open(dir.c_str(), SEG_SIZE, 1 << 20);
+    ASSERT_NE(nullptr, log);
+
+    for (int i = 0; i < 10; ++i) {
+        std::string r = record(i, 100);
+        ASSERT_EQ(0, neu_seg_log_append(log, r.data(), r.size()));
+    }
+    neu_seg_log_close(log);
+
+    // corrupt the payload of the last record
+    std::string path = dir + "/0000000000000000.seg";
+    FILE *      fp   = fopen(path.c_str(), "r+");
+    ASSERT_NE(nullptr, fp);
+    fseek(fp, 8 + 9 * 108 + 8 + 50, SEEK_SET);
+    fputc('!', fp);
+    fclose(fp);
+
+    // and drop a file that is not a segment
+    std::string junk = dir + "/0000000000000100.seg";
+    fp               = fopen(junk.c_str(), "w");
+    fputs("junk", fp);
+    fclose(fp);
+
+    log = neu_seg_log_open(dir.c_str(), SEG_SIZE, 1 << 20);
+    ASSERT_NE(nullptr, log);
+    EXPECT_EQ(9U, neu_seg_log_count(log));
+    EXPECT_NE(0, access(junk.c_str(), F_OK));
+
+    std::string r = record(10, 100);
+    ASSERT_EQ(0, neu_seg_log_append(log, r.data(), r.size()));
+    for (int i = 0; i < 9; ++i) {
+        expect_pop(log, record(i, 100));
+    }
+    expect_pop(log, record(10, 100));
+    EXPECT_EQ(0U, neu_seg_log_count(log));
+    neu_seg_log_close(log);
+}
+
+TEST(SegLogTest, LargeRecord)
+{
+    std::string    dir = make_dir("large");
+    neu_seg_log_t *log = neu_seg_log_open(dir.c_str(), SEG_SIZE, 1 << 20);
+    ASSERT_NE(nullptr, log);
+
+    std::string small = record(0, 10);
+    std::string big   = record(1, 3 * SEG_SIZE);
+    ASSERT_EQ(0, neu_seg_log_append(log, small.data(), small.size()));
+    ASSERT_EQ(0, neu_seg_log_append(log, big.data(), big.size()));
+    ASSERT_EQ(0, neu_seg_log_append(log, small.data(), small.size()));
+    EXPECT_LE(neu_seg_log_disk_bytes(log), 1U << 20);
+
+    expect_pop(log, small);
+    expect_pop(log, big);
+    expect_pop(log, small);
+    neu_seg_log_close(log);
+}
+
+TEST(SegLogTest, Cursor)
+{
+    std::string    dir = make_dir("cursor");
+    neu_seg_log_t *log = neu_seg_log_open(dir.c_str(), SEG_SIZE, 1 << 20);
+    ASSERT_NE(nullptr, log);
+
+    for (int i = 0; i < 2000; ++i) {
+        std::string r = record(i, 100);
+        ASSERT_EQ(0, neu_seg_log_append(log, r.data(), r.size()));
+    }
+
+    uint64_t    seqs[4] = { 0 };
+    const void *data    = NULL;
+    size_t      len     = 0;
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_EQ(0, neu_seg_log_next(log, &seqs[i], &data, &len));
+        EXPECT_EQ(record(i, 100), std::string((const char *) data, len));
+    }
+
+    // a failure rewinds to the oldest record not popped
+    neu_seg_log_pop(log, seqs[0]);
+    neu_seg_log_rewind(log);
+    uint64_t seq = 0;
+    ASSERT_EQ(0, neu_seg_log_next(log, &seq, &data, &len));
+    EXPECT_EQ(seqs[1], seq);
+    EXPECT_EQ(record(1, 100), std::string((const char *) data, len));
+    neu_seg_log_pop(log, seq);
+
+    // the cursor stops at the end of the head segment until it drains
+    int n = 2;
+    std::vector<uint64_t> inflight;
+    while (n < 2000) {
+        while (0 == neu_seg_log_next(log, &seq, &data, &len)) {
+            EXPECT_EQ(record(n, 100), std::string((const char *) data, len));
+            inflight.push_back(seq);
+            ++n;
+        }
+        ASSERT_FALSE(inflight.empty());
+        for (uint64_t s : inflight) {
+            neu_seg_log_pop(log, s);
+        }
+        inflight.clear();
+    }
+    EXPECT_EQ(0U, neu_seg_log_count(log));
+
+    neu_seg_log_close(log);
+}
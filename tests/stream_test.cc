@@ -0,0 +1,468 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+extern "C" {
+#include <nng/nng.h>
+#include <nng/supplemental/http/http.h>
+#include <nng/supplemental/util/platform.h>
+
+#include "errcodes.h"
+#include "plugin.h"
+#include "utils/http.h"
+
+#include "stream_handle.h"
+}
+
+zlog_category_t *neuron           = NULL;
+int64_t          global_timestamp = 0;
+bool             disable_jwt      = true;
+
+/*
+ * The streams are driven without a server: nng and the http helpers are
+ * replaced, writes complete when the test says so, and the requests sent to
+ * the core are recorded instead.
+ */
+
+struct nng_aio {
+    void (*cb)(void *);
+    void *          arg;
+    int             result;
+    nng_iov         iov;
+    nng_http_conn * conn;                      // handle_stream input
+    std::map<std::string, std::string> params; // handle_stream query
+};
+
+struct nng_http_conn {
+    std::string written;
+    nng_aio *   pending; // write in progress
+    bool        closed;
+};
+
+// a request sent to the core
+struct sent_req {
+    neu_reqresp_type_e type;
+    void *             ctx;
+    std::string        driver;
+    std::string        group;
+};
+
+static neu_plugin_common_t   common;
+static std::vector<sent_req> sent;
+static int                   op_rv     = 0;
+static int                   http_code = 0;
+
+extern "C" {
+void *neu_rest_get_plugin()
+{
+    return &common;
+}
+
+int neu_plugin_op(neu_plugin_t *plugin, neu_reqresp_head_t head, void *data)
+{
+    (void) plugin;
+    // subscribe and unsubscribe start alike
+    neu_req_unsubscribe_t *cmd = (neu_req_unsubscribe_t *) data;
+    if (0 == op_rv) {
+        sent.push_back({ head.type, head.ctx, cmd->driver, cmd->group });
+    }
+    return op_rv;
+}
+
+const char *neu_http_get_header(nng_aio *aio, char *name)
+{
+    (void) aio;
+    (void) name;
+    return NULL;
+}
+
+const char *neu_http_get_param(nng_aio *aio, const char *name, size_t *len)
+{
+    auto it = aio->params.find(name);
+    if (it == aio->params.end()) {
+        return NULL;
+    }
+    if (NULL != len) {
+        *len = it->second.size();
+    }
+    return it->second.c_str();
+}
+
+ssize_t neu_http_get_param_str(nng_aio *aio, const char *name, char *buf,
+                               size_t size)
+{
+    const char *v = neu_http_get_param(aio, name, NULL);
+    if (NULL == v) {
+        return -1;
+    }
+    snprintf(buf, size, "%s", v);
+    return strlen(v);
+}
+
+int neu_http_get_param_uint32(nng_aio *aio, const char *name, uint32_t *param)
+{
+    const char *v = neu_http_get_param(aio, name, NULL);
+    if (NULL == v) {
+        return -1;
+    }
+    *param = strtoul(v, NULL, 10);
+    return 0;
+}
+
+int neu_http_response(nng_aio *aio, neu_err_code_e code, char *content)
+{
+    (void) aio;
+    (void) content;
+    http_code = code;
+    return 0;
+}
+
+int nng_mtx_alloc(nng_mtx **mtx)
+{
+    *mtx = (nng_mtx *) &common;
+    return 0;
+}
+
+void nng_mtx_free(nng_mtx *mtx)
+{
+    (void) mtx;
+}
+
+void nng_mtx_lock(nng_mtx *mtx)
+{
+    (void) mtx;
+}
+
+void nng_mtx_unlock(nng_mtx *mtx)
+{
+    (void) mtx;
+}
+
+int nng_aio_alloc(nng_aio **aio, void (*cb)(void *), void *arg)
+{
+    *aio        = new nng_aio();
+    (*aio)->cb  = cb;
+    (*aio)->arg = arg;
+    return 0;
+}
+
+void nng_aio_free(nng_aio *aio)
+{
+    delete aio;
+}
+
+void nng_aio_cancel(nng_aio *aio)
+{
+    (void) aio;
+}
+
+int nng_aio_result(nng_aio *aio)
+{
+    return aio->result;
+}
+
+void nng_aio_finish(nng_aio *aio, int rv)
+{
+    aio->result = rv;
+}
+
+void *nng_aio_get_input(nng_aio *aio, unsigned index)
+{
+    return 2 == index ? aio->conn : NULL;
+}
+
+int nng_aio_set_iov(nng_aio *aio, unsigned n, const nng_iov *iov)
+{
+    (void) n;
+    aio->iov = iov[0];
+    return 0;
+}
+
+void nng_sleep_aio(nng_duration ms, nng_aio *aio)
+{
+    (void) ms;
+    (void) aio;
+}
+
+int nng_http_hijack(nng_http_conn *conn)
+{
+    (void) conn;
+    return 0;
+}
+
+const char *nng_strerror(int rv)
+{
+    (void) rv;
+    return "error";
+}
+
+// written at once, completed by the test
+void nng_http_conn_write_all(nng_http_conn *conn, nng_aio *aio)
+{
+    conn->written.append((const char *) aio->iov.iov_buf, aio->iov.iov_len);
+    conn->pending = aio;
+}
+
+void nng_http_conn_close(nng_http_conn *conn)
+{
+    conn->closed = true;
+}
+}
+
+class StreamTest : public testing::Test {
+  protected:
+    void SetUp() override
+    {
+        strcpy(common.name, "app");
+        sent.clear();
+        op_rv     = 0;
+        http_code = 0;
+        handle_stream_init();
+    }
+
+    void TearDown() override
+    {
+        handle_stream_uninit();
+        for (nng_http_conn *conn : conns) {
+            delete conn;
+        }
+    }
+
+    // a client connecting to the stream of the group
+    nng_http_conn *open(const char *driver, const char *group)
+    {
+        nng_aio        aio  = {};
+        nng_http_conn *conn = new nng_http_conn();
+
+        conns.push_back(conn);
+        aio.conn            = conn;
+        aio.params["node"]  = driver;
+        aio.params["group"] = group;
+        handle_stream(&aio);
+        complete(conn, 0);
+        return conn;
+    }
+
+    // complete the write in progress, and those it leads to
+    void complete(nng_http_conn *conn, int rv)
+    {
+        while (NULL != conn->pending) {
+            nng_aio *aio  = conn->pending;
+            conn->pending = NULL;
+            aio->result   = conn->closed ? NNG_ECLOSED : rv;
+            aio->cb(aio->arg);
+        }
+    }
+
+    // the core response to a request sent for the streams
+    void respond(void *ctx, int error)
+    {
+        neu_resp_error_t resp = { 0 };
+
+        ASSERT_TRUE(handle_stream_ctx(ctx));
+        resp.error = error;
+        handle_stream_resp(ctx, NEU_RESP_ERROR, &resp);
+        EXPECT_FALSE(handle_stream_ctx(ctx));
+    }
+
+    void report(const char *driver, const char *group, const char *tag,
+                int32_t value)
+    {
+        neu_reqresp_trans_data_t *data = (neu_reqresp_trans_data_t *) calloc(
+            1, sizeof(*data) + sizeof(neu_resp_tag_value_t));
+
+        strcpy(data->driver, driver);
+        strcpy(data->group, group);
+        data->n_tag = 1;
+        strcpy(data->tags[0].tag, tag);
+        data->tags[0].value.type      = NEU_TYPE_INT32;
+        data->tags[0].value.value.i32 = value;
+        handle_stream_trans_data(data);
+        free(data);
+    }
+
+    static int count(const std::string &s, const char *what)
+    {
+        int n = 0;
+        for (size_t pos = s.find(what); std::string::npos != pos;
+             pos        = s.find(what, pos + 1)) {
+            ++n;
+        }
+        return n;
+    }
+
+    std::vector<nng_http_conn *> conns;
+};
+
+TEST_F(StreamTest, Subscribe)
+{
+    nng_http_conn *c1 = open("modbus", "grp");
+
+    ASSERT_EQ(1, sent.size());
+    EXPECT_EQ(NEU_REQ_SUBSCRIBE_GROUP, sent[0].type);
+    EXPECT_EQ("modbus", sent[0].driver);
+    EXPECT_EQ("grp", sent[0].group);
+    EXPECT_EQ(0, c1->written.find("HTTP/1.1 200 OK"));
+
+    // the group is subscribed once for all its clients
+    nng_http_conn *c2 = open("modbus", "grp");
+    EXPECT_EQ(1, sent.size());
+    EXPECT_FALSE(c2->closed);
+
+    respond(sent[0].ctx, NEU_ERR_SUCCESS);
+    EXPECT_FALSE(c1->closed);
+    EXPECT_FALSE(c2->closed);
+}
+
+TEST_F(StreamTest, SubscribeFail)
+{
+    op_rv             = NEU_ERR_IS_BUSY;
+    nng_http_conn *c1 = open("modbus", "grp");
+
+    EXPECT_EQ(0, sent.size());
+    EXPECT_NE(std::string::npos, c1->written.find("event: error"));
+    EXPECT_TRUE(c1->closed);
+}
+
+TEST_F(StreamTest, BadParams)
+{
+    nng_aio aio = {};
+
+    aio.params["node"] = "modbus";
+    handle_stream(&aio);
+    EXPECT_EQ(NEU_ERR_PARAM_IS_WRONG, http_code);
+    EXPECT_EQ(0, sent.size());
+}
+
+TEST_F(StreamTest, GroupFiltering)
+{
+    nng_http_conn *c1 = open("modbus", "grp1");
+    nng_http_conn *c2 = open("modbus", "grp2");
+    respond(sent[0].ctx, NEU_ERR_SUCCESS);
+    respond(sent[1].ctx, NEU_ERR_SUCCESS);
+
+    report("modbus", "grp1", "tag1", 1);
+    complete(c1, 0);
+    complete(c2, 0);
+    EXPECT_EQ(1, count(c1->written, "event: values"));
+    EXPECT_NE(std::string::npos, c1->written.find("\"grp1\""));
+    EXPECT_EQ(0, count(c2->written, "event:"));
+
+    // not streamed
+    report("modbus", "grp3", "tag1", 1);
+    report("other", "grp1", "tag1", 1);
+    complete(c1, 0);
+    complete(c2, 0);
+    EXPECT_EQ(1, count(c1->written, "event:"));
+    EXPECT_EQ(0, count(c2->written, "event:"));
+
+    // unchanged values are not sent again
+    report("modbus", "grp1", "tag1", 1);
+    complete(c1, 0);
+    EXPECT_EQ(1, count(c1->written, "event:"));
+
+    report("modbus", "grp1", "tag1", 2);
+    report("modbus", "grp2", "tag1", 2);
+    complete(c1, 0);
+    complete(c2, 0);
+    EXPECT_EQ(2, count(c1->written, "event: values"));
+    EXPECT_EQ(1, count(c2->written, "event: values"));
+    EXPECT_NE(std::string::npos, c2->written.find("\"grp2\""));
+}
+
+// a client busy writing skips events, then catches up with all the values
+TEST_F(StreamTest, Snapshot)
+{
+    nng_http_conn *c1 = open("modbus", "grp");
+    respond(sent[0].ctx, NEU_ERR_SUCCESS);
+
+    report("modbus", "grp", "tag1", 1);
+    report("modbus", "grp", "tag2", 1);
+    report("modbus", "grp", "tag1", 2);
+    complete(c1, 0);
+
+    EXPECT_EQ(1, count(c1->written, "event: values"));
+    EXPECT_EQ(1, count(c1->written, "event: snapshot"));
+    EXPECT_NE(std::string::npos, c1->written.find("tag2"));
+}
+
+TEST_F(StreamTest, TeardownOwned)
+{
+    nng_http_conn *c1 = open("modbus", "grp");
+    nng_http_conn *c2 = open("modbus", "grp");
+    respond(sent[0].ctx, NEU_ERR_SUCCESS);
+
+    // the group is kept for the remaining client
+    report("modbus", "grp", "tag1", 1);
+    complete(c1, NNG_ECLOSED);
+    EXPECT_TRUE(c1->closed);
+    EXPECT_EQ(1, sent.size());
+
+    report("modbus", "grp", "tag1", 2);
+    complete(c2, NNG_ECLOSED);
+    EXPECT_TRUE(c2->closed);
+    ASSERT_EQ(2, sent.size());
+    EXPECT_EQ(NEU_REQ_UNSUBSCRIBE_GROUP, sent[1].type);
+    EXPECT_EQ("modbus", sent[1].driver);
+    EXPECT_EQ("grp", sent[1].group);
+    respond(sent[1].ctx, NEU_ERR_SUCCESS);
+}
+
+// a group the app had subscribed to on its own is left subscribed
+TEST_F(StreamTest, TeardownNotOwned)
+{
+    nng_http_conn *c1 = open("modbus", "grp");
+    respond(sent[0].ctx, NEU_ERR_GROUP_ALREADY_SUBSCRIBED);
+    EXPECT_FALSE(c1->closed);
+
+    report("modbus", "grp", "tag1", 1);
+    complete(c1, NNG_ECLOSED);
+    EXPECT_TRUE(c1->closed);
+    EXPECT_EQ(1, sent.size());
+}
+
+// the clients left before the group was subscribed
+TEST_F(StreamTest, TeardownBeforeSubscribed)
+{
+    nng_http_conn *c1 = open("modbus", "grp");
+
+    report("modbus", "grp", "tag1", 1);
+    complete(c1, NNG_ECLOSED);
+    EXPECT_EQ(1, sent.size());
+
+    respond(sent[0].ctx, NEU_ERR_SUCCESS);
+    ASSERT_EQ(2, sent.size());
+    EXPECT_EQ(NEU_REQ_UNSUBSCRIBE_GROUP, sent[1].type);
+    respond(sent[1].ctx, NEU_ERR_SUCCESS);
+
+    // a new stream of the group subscribes again
+    open("modbus", "grp");
+    ASSERT_EQ(3, sent.size());
+    EXPECT_EQ(NEU_REQ_SUBSCRIBE_GROUP, sent[2].type);
+}
+
+// the group is gone, its clients are closed and nothing is unsubscribed
+TEST_F(StreamTest, Unsubscribed)
+{
+    nng_http_conn *       c1    = open("modbus", "grp");
+    neu_req_unsubscribe_t unsub = { 0 };
+    respond(sent[0].ctx, NEU_ERR_SUCCESS);
+
+    strcpy(unsub.driver, "modbus");
+    strcpy(unsub.group, "grp");
+    handle_stream_unsubscribe(&unsub);
+    complete(c1, 0);
+
+    EXPECT_TRUE(c1->closed);
+    EXPECT_EQ(1, sent.size());
+
+    // the clients of other groups are not affected
+    nng_http_conn *c2 = open("modbus", "grp2");
+    handle_stream_unsubscribe(&unsub);
+    EXPECT_FALSE(c2->closed);
+}